@@ -38,6 +38,12 @@ struct JLevelDBData
 {
 	leveldb_t* db;
 
+	/**
+	 * The block cache and filter policy, which have to outlive the database.
+	 **/
+	leveldb_cache_t* cache;
+	leveldb_filterpolicy_t* filter_policy;
+
 	leveldb_readoptions_t* read_options;
 	leveldb_writeoptions_t* write_options;
 	leveldb_writeoptions_t* write_options_sync;
@@ -270,15 +276,45 @@ backend_init(gchar const* path, gpointer* backend_data)
 {
 	JLevelDBData* bd;
 	leveldb_options_t* options;
+	g_auto(GStrv) split = NULL;
 	g_autofree gchar* dirname = NULL;
 	gint const compressions[] = { leveldb_snappy_compression, leveldb_no_compression };
+	guint64 block_cache = 0;
+	guint64 bloom_bits = 10;
+	guint64 write_buffer = 0;
 
 	g_return_val_if_fail(path != NULL, FALSE);
 
-	dirname = g_path_get_dirname(path);
+	/* Path syntax: [path](:[option])*
+	   e.g.: /var/lib/julea/leveldb:block-cache=1024:bloom-bits=10:write-buffer=64 */
+	split = g_strsplit(path, ":", 0);
+
+	for (guint i = 1; split[i] != NULL; i++)
+	{
+		if (g_str_has_prefix(split[i], "block-cache="))
+		{
+			block_cache = g_ascii_strtoull(split[i] + strlen("block-cache="), NULL, 10);
+		}
+		else if (g_str_has_prefix(split[i], "bloom-bits="))
+		{
+			bloom_bits = g_ascii_strtoull(split[i] + strlen("bloom-bits="), NULL, 10);
+		}
+		else if (g_str_has_prefix(split[i], "write-buffer="))
+		{
+			write_buffer = g_ascii_strtoull(split[i] + strlen("write-buffer="), NULL, 10);
+		}
+		else
+		{
+			g_warning("Unknown option %s", split[i]);
+		}
+	}
+
+	dirname = g_path_get_dirname(split[0]);
 	g_mkdir_with_parents(dirname, 0700);
 
 	bd = g_slice_new(JLevelDBData);
+	bd->cache = (block_cache > 0) ? leveldb_cache_create_lru(block_cache * 1024 * 1024) : NULL;
+	bd->filter_policy = (bloom_bits > 0) ? leveldb_filterpolicy_create_bloom(bloom_bits) : NULL;
 	bd->read_options = leveldb_readoptions_create();
 	bd->write_options = leveldb_writeoptions_create();
 	bd->write_options_sync = leveldb_writeoptions_create();
@@ -287,12 +323,27 @@ backend_init(gchar const* path, gpointer* backend_data)
 	options = leveldb_options_create();
 	leveldb_options_set_create_if_missing(options, 1);
 
+	if (bd->cache != NULL)
+	{
+		leveldb_options_set_cache(options, bd->cache);
+	}
+
+	if (bd->filter_policy != NULL)
+	{
+		leveldb_options_set_filter_policy(options, bd->filter_policy);
+	}
+
+	if (write_buffer > 0)
+	{
+		leveldb_options_set_write_buffer_size(options, write_buffer * 1024 * 1024);
+	}
+
 	for (guint i = 0; i < G_N_ELEMENTS(compressions); i++)
 	{
 		g_autofree gchar* error = NULL;
 
 		leveldb_options_set_compression(options, compressions[i]);
-		bd->db = leveldb_open(options, path, &error);
+		bd->db = leveldb_open(options, split[0], &error);
 
 		if (bd->db != NULL)
 		{
@@ -321,6 +372,16 @@ backend_fini(gpointer backend_data)
 		leveldb_close(bd->db);
 	}
 
+	if (bd->filter_policy != NULL)
+	{
+		leveldb_filterpolicy_destroy(bd->filter_policy);
+	}
+
+	if (bd->cache != NULL)
+	{
+		leveldb_cache_destroy(bd->cache);
+	}
+
 	g_slice_free(JLevelDBData, bd);
 }
 
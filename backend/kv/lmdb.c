@@ -25,9 +25,75 @@
 
 #include <julea.h>
 
+/*
+ * LMDB only allows a single write transaction at a time, while read-only transactions do not block each other or the writer.
+ * Batches therefore start their transaction lazily: Gets use a read-only transaction, puts and deletes use a write transaction.
+ * Read-only transactions are reset and kept in a pool to be renewed later, which avoids allocating them for every batch.
+ * The environment is opened using MDB_NOTLS, so that read-only transactions can be used by any thread.
+ *
+ * Each namespace is stored in its own named database, so keys can be used as they are.
+ * Databases using the previous layout, which stored all namespaces in the unnamed database using namespace:key keys, are migrated when the backend is initialized.
+ * When a write transaction runs out of space, the map is grown and the batch's operations are replayed.
+ * The map can only be resized while no transactions are active, which is ensured using a read-write lock.
+ * Iterators only hold the lock while advancing, so growing the map does not have to wait for them to finish.
+ */
+
+/**
+ * The default maximum number of namespaces, can be changed using the max-dbs option.
+ **/
+#define J_LMDB_MAX_DBS 256
+
+/**
+ * The number of entries migrated per transaction.
+ **/
+#define J_LMDB_MIGRATE_BATCH 1024
+
+/**
+ * A put or delete that might have to be replayed after growing the map.
+ * The server keeps keys and values alive until the batch has been executed, so they do not have to be copied.
+ **/
+struct JLMDBOperation
+{
+	gchar const* key;
+
+	/**
+	 * The value, NULL for deletes.
+	 **/
+	gconstpointer value;
+	guint32 len;
+};
+
+typedef struct JLMDBOperation JLMDBOperation;
+
 struct JLMDBBatch
 {
+	/**
+	 * The transaction, NULL until the first operation.
+	 **/
 	MDB_txn* txn;
+	gboolean read_only;
+
+	/**
+	 * Whether the resize lock is held.
+	 **/
+	gboolean locked;
+
+	/**
+	 * The namespace's database.
+	 **/
+	MDB_dbi dbi;
+
+	/**
+	 * Whether puts should try to append, which is faster for monotonically increasing keys.
+	 **/
+	gboolean append;
+
+	/**
+	 * The puts and deletes performed so far.
+	 * Contains #JLMDBOperation elements.
+	 **/
+	GArray* operations;
+
 	gchar* namespace;
 	JSemantics* semantics;
 };
@@ -37,36 +103,331 @@ typedef struct JLMDBBatch JLMDBBatch;
 struct JLMDBData
 {
 	MDB_env* env;
-	MDB_dbi dbi;
+
+	/**
+	 * The databases of all namespaces used so far.
+	 **/
+	GHashTable* dbis;
+	GMutex dbi_mutex[1];
+
+	/**
+	 * Held for reading by all transactions and for writing while growing the map.
+	 **/
+	GRWLock resize_lock[1];
+
+	/**
+	 * The reset read-only transactions.
+	 **/
+	GAsyncQueue* read_txns;
+
+	guint max_dbs;
 };
 
 typedef struct JLMDBData JLMDBData;
 
 struct JLMDBIterator
 {
-	MDB_cursor* cursor;
-	MDB_txn* txn;
+	MDB_dbi dbi;
 	gboolean first;
+
+	/**
+	 * The prefix, NULL if all keys are returned.
+	 **/
 	gchar* prefix;
-	gsize namespace_len;
+
+	/**
+	 * Copies of the current entry, which stay valid after the transaction has been reset.
+	 **/
+	gchar* key;
+	GByteArray* value;
 };
 
 typedef struct JLMDBIterator JLMDBIterator;
 
+/**
+ * Returns the database of a namespace, creating it if necessary.
+ **/
+static gboolean
+backend_get_dbi(JLMDBData* bd, gchar const* namespace, MDB_dbi* dbi)
+{
+	gboolean ret = FALSE;
+	gpointer cached_dbi;
+	gint open_ret = 0;
+
+	// Databases must not be opened concurrently
+	g_mutex_lock(bd->dbi_mutex);
+
+	if (g_hash_table_lookup_extended(bd->dbis, namespace, NULL, &cached_dbi))
+	{
+		*dbi = GPOINTER_TO_UINT(cached_dbi);
+		ret = TRUE;
+	}
+	else
+	{
+		MDB_txn* txn;
+
+		g_rw_lock_reader_lock(bd->resize_lock);
+
+		if (mdb_txn_begin(bd->env, NULL, 0, &txn) == 0)
+		{
+			if ((open_ret = mdb_dbi_open(txn, namespace, MDB_CREATE, dbi)) == 0)
+			{
+				// The handle can only be used by other transactions after this one has been committed
+				ret = (mdb_txn_commit(txn) == 0);
+			}
+			else
+			{
+				mdb_txn_abort(txn);
+			}
+		}
+
+		g_rw_lock_reader_unlock(bd->resize_lock);
+
+		if (ret)
+		{
+			g_hash_table_insert(bd->dbis, g_strdup(namespace), GUINT_TO_POINTER(*dbi));
+		}
+		else if (open_ret == MDB_DBS_FULL)
+		{
+			g_critical("Could not open database for namespace %s, the maximum number of namespaces (%u) has been reached. Use the max-dbs option to increase it.", namespace, bd->max_dbs);
+		}
+		else
+		{
+			g_warning("Could not open database for namespace %s.", namespace);
+		}
+	}
+
+	g_mutex_unlock(bd->dbi_mutex);
+
+	return ret;
+}
+
+static MDB_txn*
+backend_read_txn_begin(JLMDBData* bd)
+{
+	MDB_txn* txn;
+
+	txn = g_async_queue_try_pop(bd->read_txns);
+
+	if (txn != NULL)
+	{
+		if (mdb_txn_renew(txn) == 0)
+		{
+			return txn;
+		}
+
+		mdb_txn_abort(txn);
+	}
+
+	if (mdb_txn_begin(bd->env, NULL, MDB_RDONLY, &txn) != 0)
+	{
+		return NULL;
+	}
+
+	return txn;
+}
+
+static void
+backend_read_txn_end(JLMDBData* bd, MDB_txn* txn)
+{
+	mdb_txn_reset(txn);
+	g_async_queue_push(bd->read_txns, txn);
+}
+
+/**
+ * Makes sure the batch has a transaction suitable for the next operation.
+ * Read-only transactions are replaced with a write transaction once the first put or delete is performed.
+ **/
+static gboolean
+backend_batch_txn(JLMDBData* bd, JLMDBBatch* batch, gboolean read_only)
+{
+	if (batch->txn != NULL && (read_only || !batch->read_only))
+	{
+		return TRUE;
+	}
+
+	if (batch->txn != NULL)
+	{
+		backend_read_txn_end(bd, batch->txn);
+		batch->txn = NULL;
+	}
+
+	if (!batch->locked)
+	{
+		g_rw_lock_reader_lock(bd->resize_lock);
+		batch->locked = TRUE;
+	}
+
+	if (read_only)
+	{
+		batch->txn = backend_read_txn_begin(bd);
+	}
+	else if (mdb_txn_begin(bd->env, NULL, 0, &(batch->txn)) != 0)
+	{
+		batch->txn = NULL;
+	}
+
+	batch->read_only = read_only;
+
+	if (batch->txn == NULL)
+	{
+		g_rw_lock_reader_unlock(bd->resize_lock);
+		batch->locked = FALSE;
+	}
+
+	return (batch->txn != NULL);
+}
+
+static gint
+backend_batch_perform(JLMDBBatch* batch, JLMDBOperation const* operation)
+{
+	MDB_val m_key;
+	MDB_val m_value;
+	gint ret;
+
+	m_key.mv_size = strlen(operation->key) + 1;
+	m_key.mv_data = (gpointer)operation->key;
+
+	if (operation->value == NULL)
+	{
+		return mdb_del(batch->txn, batch->dbi, &m_key, NULL);
+	}
+
+	m_value.mv_size = operation->len;
+	m_value.mv_data = (gpointer)operation->value;
+
+	if (batch->append)
+	{
+		ret = mdb_put(batch->txn, batch->dbi, &m_key, &m_value, MDB_APPEND);
+
+		// The key is not larger than all existing ones
+		if (ret != MDB_KEYEXIST)
+		{
+			return ret;
+		}
+
+		batch->append = FALSE;
+	}
+
+	return mdb_put(batch->txn, batch->dbi, &m_key, &m_value, 0);
+}
+
+/**
+ * Doubles the map size after the batch's write transaction has run out of space.
+ * The transaction is restarted and all previous operations are replayed.
+ **/
+static gboolean
+backend_batch_grow(JLMDBData* bd, JLMDBBatch* batch)
+{
+	while (TRUE)
+	{
+		MDB_envinfo info;
+		gsize map_size;
+		gint ret = 0;
+
+		mdb_env_info(bd->env, &info);
+		map_size = info.me_mapsize;
+
+		if (batch->txn != NULL)
+		{
+			mdb_txn_abort(batch->txn);
+			batch->txn = NULL;
+		}
+
+		if (batch->locked)
+		{
+			g_rw_lock_reader_unlock(bd->resize_lock);
+			batch->locked = FALSE;
+		}
+
+		g_rw_lock_writer_lock(bd->resize_lock);
+
+		mdb_env_info(bd->env, &info);
+
+		// Another batch might already have grown the map
+		if (info.me_mapsize == map_size)
+		{
+			g_debug("Growing LMDB map from %" G_GSIZE_FORMAT " to %" G_GSIZE_FORMAT " bytes.", map_size, map_size * 2);
+			mdb_env_set_mapsize(bd->env, map_size * 2);
+		}
+
+		g_rw_lock_writer_unlock(bd->resize_lock);
+
+		if (!backend_batch_txn(bd, batch, FALSE))
+		{
+			return FALSE;
+		}
+
+		for (guint i = 0; i < batch->operations->len && ret == 0; i++)
+		{
+			ret = backend_batch_perform(batch, &g_array_index(batch->operations, JLMDBOperation, i));
+		}
+
+		if (ret == 0)
+		{
+			return TRUE;
+		}
+
+		if (ret != MDB_MAP_FULL)
+		{
+			mdb_txn_abort(batch->txn);
+			batch->txn = NULL;
+
+			return FALSE;
+		}
+	}
+}
+
+static gboolean
+backend_batch_write(JLMDBData* bd, JLMDBBatch* batch, gchar const* key, gconstpointer value, guint32 len)
+{
+	JLMDBOperation operation;
+	gint ret;
+
+	if (!backend_batch_txn(bd, batch, FALSE))
+	{
+		return FALSE;
+	}
+
+	operation.key = key;
+	operation.value = value;
+	operation.len = len;
+
+	while ((ret = backend_batch_perform(batch, &operation)) == MDB_MAP_FULL)
+	{
+		if (!backend_batch_grow(bd, batch))
+		{
+			return FALSE;
+		}
+	}
+
+	if (ret == 0)
+	{
+		g_array_append_val(batch->operations, operation);
+	}
+
+	return (ret == 0);
+}
+
 static gboolean
 backend_batch_start(gpointer backend_data, gchar const* namespace, JSemantics* semantics, gpointer* data)
 {
 	JLMDBData* bd = backend_data;
 	JLMDBBatch* batch = NULL;
-	MDB_txn* txn;
+	MDB_dbi dbi;
 
 	g_return_val_if_fail(namespace != NULL, FALSE);
 	g_return_val_if_fail(data != NULL, FALSE);
 
-	if (mdb_txn_begin(bd->env, NULL, 0, &txn) == 0)
+	if (backend_get_dbi(bd, namespace, &dbi))
 	{
 		batch = g_slice_new(JLMDBBatch);
-		batch->txn = txn;
+		batch->txn = NULL;
+		batch->read_only = TRUE;
+		batch->locked = FALSE;
+		batch->dbi = dbi;
+		batch->append = TRUE;
+		batch->operations = g_array_new(FALSE, FALSE, sizeof(JLMDBOperation));
 		batch->namespace = g_strdup(namespace);
 		batch->semantics = j_semantics_ref(semantics);
 	}
@@ -79,23 +440,48 @@ backend_batch_start(gpointer backend_data, gchar const* namespace, JSemantics* s
 static gboolean
 backend_batch_execute(gpointer backend_data, gpointer data)
 {
-	gboolean ret = FALSE;
+	gboolean ret = TRUE;
 
+	JLMDBData* bd = backend_data;
 	JLMDBBatch* batch = data;
 
-	(void)backend_data;
-
 	g_return_val_if_fail(data != NULL, FALSE);
 
 	// FIXME do something with batch->semantics
 
-	if (mdb_txn_commit(batch->txn) == 0)
+	if (batch->txn != NULL)
 	{
-		ret = TRUE;
+		if (batch->read_only)
+		{
+			backend_read_txn_end(bd, batch->txn);
+			batch->txn = NULL;
+		}
+		else
+		{
+			gint commit_ret;
+
+			while (TRUE)
+			{
+				// Committing frees the transaction even if it fails
+				commit_ret = mdb_txn_commit(batch->txn);
+				batch->txn = NULL;
+
+				if (commit_ret != MDB_MAP_FULL || !backend_batch_grow(bd, batch))
+				{
+					break;
+				}
+			}
+
+			ret = (commit_ret == 0);
+		}
 	}
 
-	// FIXME free txn
+	if (batch->locked)
+	{
+		g_rw_lock_reader_unlock(bd->resize_lock);
+	}
 
+	g_array_unref(batch->operations);
 	j_semantics_unref(batch->semantics);
 	g_free(batch->namespace);
 	g_slice_free(JLMDBBatch, batch);
@@ -108,22 +494,12 @@ backend_put(gpointer backend_data, gpointer data, gchar const* key, gconstpointe
 {
 	JLMDBData* bd = backend_data;
 	JLMDBBatch* batch = data;
-	MDB_val m_key;
-	MDB_val m_value;
-	g_autofree gchar* nskey = NULL;
 
 	g_return_val_if_fail(data != NULL, FALSE);
 	g_return_val_if_fail(key != NULL, FALSE);
 	g_return_val_if_fail(value != NULL, FALSE);
 
-	nskey = g_strdup_printf("%s:%s", batch->namespace, key);
-
-	m_key.mv_size = strlen(nskey) + 1;
-	m_key.mv_data = nskey;
-	m_value.mv_size = len;
-	m_value.mv_data = value;
-
-	return (mdb_put(batch->txn, bd->dbi, &m_key, &m_value, 0) == 0);
+	return backend_batch_write(bd, batch, key, value, len);
 }
 
 static gboolean
@@ -131,194 +507,510 @@ backend_delete(gpointer backend_data, gpointer data, gchar const* key)
 {
 	JLMDBData* bd = backend_data;
 	JLMDBBatch* batch = data;
-	MDB_val m_key;
-	g_autofree gchar* nskey = NULL;
 
 	g_return_val_if_fail(data != NULL, FALSE);
 	g_return_val_if_fail(key != NULL, FALSE);
 
-	nskey = g_strdup_printf("%s:%s", batch->namespace, key);
-
-	m_key.mv_size = strlen(nskey) + 1;
-	m_key.mv_data = nskey;
-
-	return (mdb_del(batch->txn, bd->dbi, &m_key, NULL) == 0);
+	return backend_batch_write(bd, batch, key, NULL, 0);
 }
 
 static gboolean
-backend_get(gpointer backend_data, gpointer data, gchar const* key, gpointer* value, guint32* len)
+backend_get_static(gpointer backend_data, gpointer data, gchar const* key, gconstpointer* value, guint32* len)
 {
-	gboolean ret = FALSE;
-
 	JLMDBData* bd = backend_data;
 	JLMDBBatch* batch = data;
 	MDB_val m_key;
 	MDB_val m_value;
-	g_autofree gchar* nskey = NULL;
 
 	g_return_val_if_fail(data != NULL, FALSE);
 	g_return_val_if_fail(key != NULL, FALSE);
 	g_return_val_if_fail(value != NULL, FALSE);
 	g_return_val_if_fail(len != NULL, FALSE);
 
-	nskey = g_strdup_printf("%s:%s", batch->namespace, key);
+	if (!backend_batch_txn(bd, batch, TRUE))
+	{
+		return FALSE;
+	}
 
-	m_key.mv_size = strlen(nskey) + 1;
-	m_key.mv_data = nskey;
+	m_key.mv_size = strlen(key) + 1;
+	m_key.mv_data = (gpointer)key;
 
-	if (mdb_get(batch->txn, bd->dbi, &m_key, &m_value) == 0)
+	if (mdb_get(batch->txn, batch->dbi, &m_key, &m_value) != 0)
 	{
-		// FIXME check whether copies can be avoided
-		*value = g_memdup(m_value.mv_data, m_value.mv_size);
-		*len = m_value.mv_size;
+		return FALSE;
+	}
 
-		ret = TRUE;
+	// The value points into the memory map and stays valid until the transaction ends
+	*value = m_value.mv_data;
+	*len = m_value.mv_size;
+
+	return TRUE;
+}
+
+static gboolean
+backend_get(gpointer backend_data, gpointer data, gchar const* key, gpointer* value, guint32* len)
+{
+	gconstpointer m_value;
+
+	g_return_val_if_fail(value != NULL, FALSE);
+	g_return_val_if_fail(len != NULL, FALSE);
+
+	if (!backend_get_static(backend_data, data, key, &m_value, len))
+	{
+		return FALSE;
 	}
 
-	return ret;
+	*value = g_memdup(m_value, *len);
+
+	return TRUE;
+}
+
+static gint
+backend_key_compare(gconstpointer a, gconstpointer b, gpointer user_data)
+{
+	gchar const* const* keys = user_data;
+	guint32 index_a = *(guint32 const*)a;
+	guint32 index_b = *(guint32 const*)b;
+
+	return strcmp(keys[index_a], keys[index_b]);
 }
 
 static gboolean
-backend_get_all(gpointer backend_data, gchar const* namespace, gpointer* data)
+backend_get_many(gpointer backend_data, gpointer data, gchar const* const* keys, guint32 count, gconstpointer* values, guint32* lens)
 {
 	JLMDBData* bd = backend_data;
-	JLMDBIterator* iterator = NULL;
+	JLMDBBatch* batch = data;
+	MDB_cursor* cursor;
+	g_autofree guint32* order = NULL;
+	gboolean ret = TRUE;
 
-	g_return_val_if_fail(namespace != NULL, FALSE);
 	g_return_val_if_fail(data != NULL, FALSE);
+	g_return_val_if_fail(keys != NULL, FALSE);
+	g_return_val_if_fail(values != NULL, FALSE);
+	g_return_val_if_fail(lens != NULL, FALSE);
+
+	for (guint32 i = 0; i < count; i++)
+	{
+		values[i] = NULL;
+		lens[i] = 0;
+	}
+
+	if (!backend_batch_txn(bd, batch, TRUE))
+	{
+		return FALSE;
+	}
+
+	if (mdb_cursor_open(batch->txn, batch->dbi, &cursor) != 0)
+	{
+		return FALSE;
+	}
+
+	// LMDB's default comparison matches strcmp for NUL-terminated keys
+	order = g_new(guint32, count);
+
+	for (guint32 i = 0; i < count; i++)
+	{
+		order[i] = i;
+	}
+
+	g_qsort_with_data(order, count, sizeof(guint32), backend_key_compare, (gpointer)keys);
+
+	// Positioning the cursor in key order avoids descending the tree again for keys on the current page
+	for (guint32 i = 0; i < count; i++)
+	{
+		guint32 index = order[i];
+		MDB_val m_key;
+		MDB_val m_value;
+
+		m_key.mv_size = strlen(keys[index]) + 1;
+		m_key.mv_data = (gpointer)keys[index];
+
+		if (mdb_cursor_get(cursor, &m_key, &m_value, MDB_SET) != 0)
+		{
+			ret = FALSE;
+			continue;
+		}
+
+		// The value points into the memory map and stays valid until the transaction ends
+		values[index] = m_value.mv_data;
+		lens[index] = m_value.mv_size;
+	}
+
+	mdb_cursor_close(cursor);
+
+	return ret;
+}
+
+static gboolean
+backend_iterator_new(JLMDBData* bd, gchar const* namespace, gchar const* prefix, gpointer* data)
+{
+	JLMDBIterator* iterator;
+	MDB_dbi dbi;
+
+	if (!backend_get_dbi(bd, namespace, &dbi))
+	{
+		return FALSE;
+	}
 
+	// Transactions are only started while advancing the iterator
 	iterator = g_slice_new(JLMDBIterator);
+	iterator->dbi = dbi;
 	iterator->first = TRUE;
-	iterator->prefix = g_strdup_printf("%s:", namespace);
-	iterator->namespace_len = strlen(namespace) + 1;
-
-	mdb_txn_begin(bd->env, NULL, 0, &(iterator->txn));
-	mdb_cursor_open(iterator->txn, bd->dbi, &(iterator->cursor));
+	iterator->prefix = g_strdup(prefix);
+	iterator->key = NULL;
+	iterator->value = g_byte_array_new();
 
 	*data = iterator;
 
-	return (iterator != NULL);
+	return TRUE;
+}
+
+static void
+backend_iterator_free(JLMDBIterator* iterator)
+{
+	g_byte_array_unref(iterator->value);
+	g_free(iterator->key);
+	g_free(iterator->prefix);
+	g_slice_free(JLMDBIterator, iterator);
 }
 
 static gboolean
-backend_get_by_prefix(gpointer backend_data, gchar const* namespace, gchar const* prefix, gpointer* data)
+backend_get_all(gpointer backend_data, gchar const* namespace, gpointer* data)
 {
 	JLMDBData* bd = backend_data;
-	JLMDBIterator* iterator = NULL;
 
 	g_return_val_if_fail(namespace != NULL, FALSE);
-	g_return_val_if_fail(prefix != NULL, FALSE);
 	g_return_val_if_fail(data != NULL, FALSE);
 
-	iterator = g_slice_new(JLMDBIterator);
-	iterator->first = TRUE;
-	iterator->prefix = g_strdup_printf("%s:%s", namespace, prefix);
-	iterator->namespace_len = strlen(namespace) + 1;
+	return backend_iterator_new(bd, namespace, NULL, data);
+}
 
-	mdb_txn_begin(bd->env, NULL, 0, &(iterator->txn));
-	mdb_cursor_open(iterator->txn, bd->dbi, &(iterator->cursor));
+static gboolean
+backend_get_by_prefix(gpointer backend_data, gchar const* namespace, gchar const* prefix, gpointer* data)
+{
+	JLMDBData* bd = backend_data;
 
-	*data = iterator;
+	g_return_val_if_fail(namespace != NULL, FALSE);
+	g_return_val_if_fail(prefix != NULL, FALSE);
+	g_return_val_if_fail(data != NULL, FALSE);
 
-	return (iterator != NULL);
+	return backend_iterator_new(bd, namespace, prefix, data);
 }
 
 static gboolean
 backend_iterate(gpointer backend_data, gpointer data, gchar const** key, gconstpointer* value, guint32* len)
 {
+	JLMDBData* bd = backend_data;
 	JLMDBIterator* iterator = data;
-	MDB_cursor_op cursor_op = MDB_NEXT;
+	MDB_cursor* cursor = NULL;
+	MDB_cursor_op cursor_op = MDB_FIRST;
+	MDB_txn* txn;
 	MDB_val m_key;
 	MDB_val m_value;
-
-	(void)backend_data;
+	gint ret;
 
 	g_return_val_if_fail(data != NULL, FALSE);
 	g_return_val_if_fail(value != NULL, FALSE);
 	g_return_val_if_fail(len != NULL, FALSE);
 
-	if (iterator->first)
-	{
-		// FIXME check +1
-		m_key.mv_size = strlen(iterator->prefix) + 1;
-		m_key.mv_data = iterator->prefix;
+	// Holding the lock only while advancing allows the map to be grown between iterations, for example, when putting while iterating
+	g_rw_lock_reader_lock(bd->resize_lock);
 
-		cursor_op = MDB_SET_RANGE;
+	// The transaction is renewed, so it sees the current map size
+	txn = backend_read_txn_begin(bd);
 
-		iterator->first = FALSE;
+	if (txn == NULL || mdb_cursor_open(txn, iterator->dbi, &cursor) != 0)
+	{
+		goto out;
 	}
 
-	if (mdb_cursor_get(iterator->cursor, &m_key, &m_value, cursor_op) == 0)
+	if (iterator->first)
 	{
-		if (!g_str_has_prefix(m_key.mv_data, iterator->prefix))
+		if (iterator->prefix != NULL)
 		{
-			// FIXME check whether we can completely terminate
-			goto out;
+			m_key.mv_size = strlen(iterator->prefix);
+			m_key.mv_data = iterator->prefix;
+
+			cursor_op = MDB_SET_RANGE;
 		}
 
-		*key = (gchar const*)m_key.mv_data + iterator->namespace_len;
-		*value = m_value.mv_data;
-		*len = m_value.mv_size;
+		iterator->first = FALSE;
+	}
+	else
+	{
+		// Continue after the previous key, which might have been deleted in the meantime
+		m_key.mv_size = strlen(iterator->key) + 1;
+		m_key.mv_data = iterator->key;
 
-		return TRUE;
+		cursor_op = MDB_SET_RANGE;
+	}
+
+	ret = mdb_cursor_get(cursor, &m_key, &m_value, cursor_op);
+
+	if (ret == 0 && iterator->key != NULL && strcmp(m_key.mv_data, iterator->key) == 0)
+	{
+		ret = mdb_cursor_get(cursor, &m_key, &m_value, MDB_NEXT);
+	}
+
+	// Keys are sorted, that is, no further keys can match
+	if (ret != 0 || (iterator->prefix != NULL && !g_str_has_prefix(m_key.mv_data, iterator->prefix)))
+	{
+		goto out;
 	}
 
+	g_free(iterator->key);
+	iterator->key = g_strdup(m_key.mv_data);
+
+	g_byte_array_set_size(iterator->value, 0);
+	g_byte_array_append(iterator->value, m_value.mv_data, m_value.mv_size);
+
+	mdb_cursor_close(cursor);
+	backend_read_txn_end(bd, txn);
+
+	g_rw_lock_reader_unlock(bd->resize_lock);
+
+	*key = iterator->key;
+	*value = iterator->value->data;
+	*len = iterator->value->len;
+
+	return TRUE;
+
 out:
-	mdb_txn_commit(iterator->txn);
+	if (cursor != NULL)
+	{
+		mdb_cursor_close(cursor);
+	}
 
-	g_free(iterator->prefix);
-	g_slice_free(JLMDBIterator, iterator);
+	if (txn != NULL)
+	{
+		backend_read_txn_end(bd, txn);
+	}
+
+	g_rw_lock_reader_unlock(bd->resize_lock);
+
+	backend_iterator_free(iterator);
 
 	return FALSE;
 }
 
+/**
+ * Moves the entries of the previous layout from the unnamed database into the namespaces' named databases.
+ * Entries are migrated in chunks to limit the memory usage, the map is grown if necessary.
+ **/
 static gboolean
-backend_init(gchar const* path, gpointer* backend_data)
+backend_migrate(JLMDBData* bd)
 {
-	JLMDBData* bd;
-	MDB_txn* txn;
+	guint64 migrated = 0;
 
-	g_return_val_if_fail(path != NULL, FALSE);
+	while (TRUE)
+	{
+		g_autoptr(GPtrArray) keys = NULL;
+		g_autoptr(GPtrArray) values = NULL;
+		MDB_txn* txn;
+		MDB_cursor* cursor;
+		MDB_dbi main_dbi;
+		MDB_val m_key;
+		MDB_val m_value;
+		gint ret;
 
-	g_mkdir_with_parents(path, 0700);
+		if (mdb_txn_begin(bd->env, NULL, 0, &txn) != 0)
+		{
+			return FALSE;
+		}
 
-	bd = g_slice_new(JLMDBData);
+		if (mdb_dbi_open(txn, NULL, 0, &main_dbi) != 0 || mdb_cursor_open(txn, main_dbi, &cursor) != 0)
+		{
+			mdb_txn_abort(txn);
+			return FALSE;
+		}
 
-	if (mdb_env_create(&(bd->env)) == 0)
-	{
-		// FIXME grow mapsize dynamically (default is 10 MiB)
-		if (mdb_env_set_mapsize(bd->env, (gsize)4 * 1024 * 1024 * 1024) != 0)
+		keys = g_ptr_array_new_with_free_func(g_free);
+		values = g_ptr_array_new_with_free_func((GDestroyNotify)g_bytes_unref);
+
+		ret = mdb_cursor_get(cursor, &m_key, &m_value, MDB_FIRST);
+
+		while (ret == 0 && keys->len < J_LMDB_MIGRATE_BATCH)
 		{
-			goto error;
+			gchar const* key = m_key.mv_data;
+
+			// Keys of the previous layout include the terminating null byte, while the names of named databases do not
+			if (m_key.mv_size > 0 && key[m_key.mv_size - 1] == '\0' && strchr(key, ':') != NULL)
+			{
+				// Values point into the map and become invalid once the entry has been deleted
+				g_ptr_array_add(keys, g_strdup(key));
+				g_ptr_array_add(values, g_bytes_new(m_value.mv_data, m_value.mv_size));
+			}
+
+			ret = mdb_cursor_get(cursor, &m_key, &m_value, MDB_NEXT);
 		}
 
-		if (mdb_env_open(bd->env, path, 0, 0600) != 0)
+		mdb_cursor_close(cursor);
+
+		if (keys->len == 0)
 		{
-			goto error;
+			mdb_txn_abort(txn);
+			break;
 		}
 
-		if (mdb_txn_begin(bd->env, NULL, 0, &txn) != 0)
+		ret = 0;
+
+		for (guint i = 0; i < keys->len && ret == 0; i++)
+		{
+			gchar* key = g_ptr_array_index(keys, i);
+			gchar* separator;
+			MDB_dbi dbi;
+
+			m_key.mv_size = strlen(key) + 1;
+			m_key.mv_data = key;
+
+			if ((ret = mdb_del(txn, main_dbi, &m_key, NULL)) != 0)
+			{
+				break;
+			}
+
+			separator = strchr(key, ':');
+			*separator = '\0';
+
+			if ((ret = mdb_dbi_open(txn, key, MDB_CREATE, &dbi)) != 0)
+			{
+				break;
+			}
+
+			m_key.mv_size = strlen(separator + 1) + 1;
+			m_key.mv_data = separator + 1;
+			m_value.mv_data = (gpointer)g_bytes_get_data(g_ptr_array_index(values, i), &(m_value.mv_size));
+
+			ret = mdb_put(txn, dbi, &m_key, &m_value, 0);
+		}
+
+		if (ret == 0)
+		{
+			ret = mdb_txn_commit(txn);
+		}
+		else
+		{
+			mdb_txn_abort(txn);
+		}
+
+		if (ret == MDB_MAP_FULL)
 		{
-			goto error;
+			MDB_envinfo info;
+
+			// No transactions are active during initialization
+			mdb_env_info(bd->env, &info);
+			mdb_env_set_mapsize(bd->env, info.me_mapsize * 2);
+
+			continue;
 		}
 
-		if (mdb_dbi_open(txn, NULL, 0, &(bd->dbi)) != 0)
+		if (ret == MDB_DBS_FULL)
 		{
-			goto error;
+			g_critical("Could not migrate LMDB database, it contains more than %u namespaces. Use the max-dbs option to increase the limit.", bd->max_dbs);
 		}
 
-		if (mdb_txn_commit(txn) != 0)
+		if (ret != 0)
 		{
-			goto error;
+			return FALSE;
 		}
+
+		migrated += keys->len;
+	}
+
+	if (migrated > 0)
+	{
+		g_message("Migrated %" G_GUINT64_FORMAT " LMDB entries to per-namespace databases.", migrated);
+	}
+
+	return TRUE;
+}
+
+static gboolean
+backend_init(gchar const* path, gpointer* backend_data)
+{
+	JLMDBData* bd;
+	g_auto(GStrv) split = NULL;
+	gsize map_size = (gsize)4 * 1024 * 1024 * 1024;
+
+	g_return_val_if_fail(path != NULL, FALSE);
+
+	/* Path syntax: [path](:[option])*
+	   e.g.: /var/lib/julea:map-size=1024:max-dbs=1024 */
+	split = g_strsplit(path, ":", 0);
+
+	bd = g_slice_new(JLMDBData);
+	bd->env = NULL;
+	bd->dbis = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+	g_mutex_init(bd->dbi_mutex);
+	g_rw_lock_init(bd->resize_lock);
+	bd->read_txns = g_async_queue_new();
+	bd->max_dbs = J_LMDB_MAX_DBS;
+
+	for (guint i = 1; split[i] != NULL; i++)
+	{
+		if (g_str_has_prefix(split[i], "map-size="))
+		{
+			map_size = MAX(g_ascii_strtoull(split[i] + strlen("map-size="), NULL, 10), 1) * 1024 * 1024;
+		}
+		else if (g_str_has_prefix(split[i], "max-dbs="))
+		{
+			bd->max_dbs = MAX(g_ascii_strtoull(split[i] + strlen("max-dbs="), NULL, 10), 1);
+		}
+		else
+		{
+			g_warning("Unknown option %s", split[i]);
+		}
+	}
+
+	g_mkdir_with_parents(split[0], 0700);
+
+	if (mdb_env_create(&(bd->env)) != 0)
+	{
+		bd->env = NULL;
+		goto error;
+	}
+
+	// The map is grown when it is full (the default is 10 MiB)
+	if (mdb_env_set_mapsize(bd->env, map_size) != 0)
+	{
+		goto error;
+	}
+
+	if (mdb_env_set_maxdbs(bd->env, bd->max_dbs) != 0)
+	{
+		goto error;
+	}
+
+	// Every concurrent get and every advancing iterator uses a reader slot (the default is 126)
+	if (mdb_env_set_maxreaders(bd->env, 1024) != 0)
+	{
+		goto error;
+	}
+
+	if (mdb_env_open(bd->env, split[0], MDB_NOTLS, 0600) != 0)
+	{
+		goto error;
+	}
+
+	if (!backend_migrate(bd))
+	{
+		g_critical("Could not migrate LMDB database %s to per-namespace databases.", split[0]);
+		goto error;
 	}
 
 	*backend_data = bd;
 
-	return (bd->env != NULL);
+	return TRUE;
 
 error:
-	mdb_env_close(bd->env);
+	if (bd->env != NULL)
+	{
+		mdb_env_close(bd->env);
+	}
+
+	g_async_queue_unref(bd->read_txns);
+	g_rw_lock_clear(bd->resize_lock);
+	g_mutex_clear(bd->dbi_mutex);
+	g_hash_table_unref(bd->dbis);
 	g_slice_free(JLMDBData, bd);
 
 	return FALSE;
@@ -328,12 +1020,24 @@ static void
 backend_fini(gpointer backend_data)
 {
 	JLMDBData* bd = backend_data;
+	MDB_txn* txn;
+
+	while ((txn = g_async_queue_try_pop(bd->read_txns)) != NULL)
+	{
+		mdb_txn_abort(txn);
+	}
+
+	g_async_queue_unref(bd->read_txns);
 
 	if (bd->env != NULL)
 	{
 		mdb_env_close(bd->env);
 	}
 
+	g_rw_lock_clear(bd->resize_lock);
+	g_mutex_clear(bd->dbi_mutex);
+	g_hash_table_unref(bd->dbis);
+
 	g_slice_free(JLMDBData, bd);
 }
 
@@ -348,6 +1052,8 @@ static JBackend lmdb_backend = {
 		.backend_put = backend_put,
 		.backend_delete = backend_delete,
 		.backend_get = backend_get,
+		.backend_get_static = backend_get_static,
+		.backend_get_many = backend_get_many,
 		.backend_get_all = backend_get_all,
 		.backend_get_by_prefix = backend_get_by_prefix,
 		.backend_iterate = backend_iterate }
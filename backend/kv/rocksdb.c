@@ -25,11 +25,28 @@
 
 #include <julea.h>
 
+/**
+ * The number of entries moved per write batch when migrating the old single keyspace layout.
+ **/
+#define J_ROCKSDB_MIGRATION_BATCH 1000
+
+/**
+ * The prefix of column family names.
+ * It keeps namespaces from clashing with RocksDB's default column family.
+ **/
+#define J_ROCKSDB_COLUMN_FAMILY_PREFIX "julea:"
+
 struct JRocksDBBatch
 {
 	rocksdb_writebatch_t* batch;
+	rocksdb_column_family_handle_t* column_family;
 	gchar* namespace;
 	JSemantics* semantics;
+
+	/**
+	 * The values returned by backend_get_many, freed when the batch is executed.
+	 **/
+	GPtrArray* values;
 };
 
 typedef struct JRocksDBBatch JRocksDBBatch;
@@ -38,7 +55,25 @@ struct JRocksDBData
 {
 	rocksdb_t* db;
 
+	/**
+	 * The options used to create new column families.
+	 **/
+	rocksdb_options_t* options;
+
+	/**
+	 * The column families, one per namespace.
+	 * Maps namespaces to rocksdb_column_family_handle_t.
+	 **/
+	GHashTable* column_families;
+	GMutex column_families_mutex;
+
+	/**
+	 * The length of the fixed key prefix used for prefix bloom filters, 0 if disabled.
+	 **/
+	guint32 prefix_length;
+
 	rocksdb_readoptions_t* read_options;
+	rocksdb_readoptions_t* read_options_prefix;
 	rocksdb_writeoptions_t* write_options;
 	rocksdb_writeoptions_t* write_options_sync;
 };
@@ -50,17 +85,57 @@ struct JRocksDBIterator
 	rocksdb_iterator_t* iterator;
 	gboolean first;
 	gchar* prefix;
-	gsize namespace_len;
 };
 
 typedef struct JRocksDBIterator JRocksDBIterator;
 
+/**
+ * Returns the column family of a namespace.
+ *
+ * \param bd        The backend data.
+ * \param namespace A namespace.
+ * \param create    Whether to create the column family if it does not exist.
+ *
+ * \return The column family or NULL if it does not exist.
+ **/
+static rocksdb_column_family_handle_t*
+backend_get_column_family(JRocksDBData* bd, gchar const* namespace, gboolean create)
+{
+	rocksdb_column_family_handle_t* column_family;
+
+	g_mutex_lock(&(bd->column_families_mutex));
+
+	column_family = g_hash_table_lookup(bd->column_families, namespace);
+
+	if (column_family == NULL && create)
+	{
+		g_autofree gchar* error = NULL;
+		g_autofree gchar* name = NULL;
+
+		name = g_strconcat(J_ROCKSDB_COLUMN_FAMILY_PREFIX, namespace, NULL);
+		column_family = rocksdb_create_column_family(bd->db, bd->options, name, &error);
+
+		if (error != NULL)
+		{
+			g_warning("Could not create column family %s: %s", namespace, error);
+			column_family = NULL;
+		}
+		else
+		{
+			g_hash_table_insert(bd->column_families, g_strdup(namespace), column_family);
+		}
+	}
+
+	g_mutex_unlock(&(bd->column_families_mutex));
+
+	return column_family;
+}
+
 static gboolean
 backend_batch_start(gpointer backend_data, gchar const* namespace, JSemantics* semantics, gpointer* backend_batch)
 {
 	JRocksDBBatch* batch;
-
-	(void)backend_data;
+	JRocksDBData* bd = backend_data;
 
 	g_return_val_if_fail(namespace != NULL, FALSE);
 	g_return_val_if_fail(backend_batch != NULL, FALSE);
@@ -68,8 +143,11 @@ backend_batch_start(gpointer backend_data, gchar const* namespace, JSemantics* s
 	batch = g_slice_new(JRocksDBBatch);
 
 	batch->batch = rocksdb_writebatch_create();
+	// The column family is looked up lazily to avoid creating it for read-only batches
+	batch->column_family = backend_get_column_family(bd, namespace, FALSE);
 	batch->namespace = g_strdup(namespace);
 	batch->semantics = j_semantics_ref(semantics);
+	batch->values = NULL;
 
 	*backend_batch = batch;
 
@@ -95,6 +173,11 @@ backend_batch_execute(gpointer backend_data, gpointer backend_batch)
 
 	rocksdb_write(bd->db, write_options, batch->batch, &rocksdb_error);
 
+	if (batch->values != NULL)
+	{
+		g_ptr_array_unref(batch->values);
+	}
+
 	j_semantics_unref(batch->semantics);
 	g_free(batch->namespace);
 	rocksdb_writebatch_destroy(batch->batch);
@@ -107,16 +190,23 @@ static gboolean
 backend_put(gpointer backend_data, gpointer backend_batch, gchar const* key, gconstpointer value, guint32 len)
 {
 	JRocksDBBatch* batch = backend_batch;
-	g_autofree gchar* nskey = NULL;
-
-	(void)backend_data;
+	JRocksDBData* bd = backend_data;
 
 	g_return_val_if_fail(backend_batch != NULL, FALSE);
 	g_return_val_if_fail(key != NULL, FALSE);
 	g_return_val_if_fail(value != NULL, FALSE);
 
-	nskey = g_strdup_printf("%s:%s", batch->namespace, key);
-	rocksdb_writebatch_put(batch->batch, nskey, strlen(nskey) + 1, value, len);
+	if (batch->column_family == NULL)
+	{
+		batch->column_family = backend_get_column_family(bd, batch->namespace, TRUE);
+
+		if (batch->column_family == NULL)
+		{
+			return FALSE;
+		}
+	}
+
+	rocksdb_writebatch_put_cf(batch->batch, batch->column_family, key, strlen(key) + 1, value, len);
 
 	return TRUE;
 }
@@ -125,15 +215,24 @@ static gboolean
 backend_delete(gpointer backend_data, gpointer backend_batch, gchar const* key)
 {
 	JRocksDBBatch* batch = backend_batch;
-	g_autofree gchar* nskey = NULL;
-
-	(void)backend_data;
+	JRocksDBData* bd = backend_data;
 
 	g_return_val_if_fail(backend_batch != NULL, FALSE);
 	g_return_val_if_fail(key != NULL, FALSE);
 
-	nskey = g_strdup_printf("%s:%s", batch->namespace, key);
-	rocksdb_writebatch_delete(batch->batch, nskey, strlen(nskey) + 1);
+	// The column family might have been created by another batch in the meantime
+	if (batch->column_family == NULL)
+	{
+		batch->column_family = backend_get_column_family(bd, batch->namespace, FALSE);
+
+		// Nothing to delete if the namespace has never been written to
+		if (batch->column_family == NULL)
+		{
+			return TRUE;
+		}
+	}
+
+	rocksdb_writebatch_delete_cf(batch->batch, batch->column_family, key, strlen(key) + 1);
 
 	return TRUE;
 }
@@ -143,7 +242,6 @@ backend_get(gpointer backend_data, gpointer backend_batch, gchar const* key, gpo
 {
 	JRocksDBBatch* batch = backend_batch;
 	JRocksDBData* bd = backend_data;
-	g_autofree gchar* nskey = NULL;
 	g_autofree gpointer result = NULL;
 	gsize result_len;
 
@@ -152,8 +250,17 @@ backend_get(gpointer backend_data, gpointer backend_batch, gchar const* key, gpo
 	g_return_val_if_fail(value != NULL, FALSE);
 	g_return_val_if_fail(len != NULL, FALSE);
 
-	nskey = g_strdup_printf("%s:%s", batch->namespace, key);
-	result = rocksdb_get(bd->db, bd->read_options, nskey, strlen(nskey) + 1, &result_len, NULL);
+	if (batch->column_family == NULL)
+	{
+		batch->column_family = backend_get_column_family(bd, batch->namespace, FALSE);
+
+		if (batch->column_family == NULL)
+		{
+			return FALSE;
+		}
+	}
+
+	result = rocksdb_get_cf(bd->db, bd->read_options, batch->column_family, key, strlen(key) + 1, &result_len, NULL);
 
 	if (result != NULL)
 	{
@@ -165,56 +272,129 @@ backend_get(gpointer backend_data, gpointer backend_batch, gchar const* key, gpo
 }
 
 static gboolean
-backend_get_all(gpointer backend_data, gchar const* namespace, gpointer* backend_iterator)
+backend_get_many(gpointer backend_data, gpointer backend_batch, gchar const* const* keys, guint32 count, gconstpointer* values, guint32* lens)
 {
+	JRocksDBBatch* batch = backend_batch;
 	JRocksDBData* bd = backend_data;
-	JRocksDBIterator* iterator = NULL;
-	rocksdb_iterator_t* it;
+	g_autofree rocksdb_column_family_handle_t const** column_families = NULL;
+	g_autofree gsize* key_lens = NULL;
+	g_autofree gchar** results = NULL;
+	g_autofree gsize* result_lens = NULL;
+	g_autofree gchar** errors = NULL;
+	gboolean ret = TRUE;
 
-	g_return_val_if_fail(namespace != NULL, FALSE);
-	g_return_val_if_fail(backend_iterator != NULL, FALSE);
+	g_return_val_if_fail(backend_batch != NULL, FALSE);
+	g_return_val_if_fail(keys != NULL, FALSE);
+	g_return_val_if_fail(values != NULL, FALSE);
+	g_return_val_if_fail(lens != NULL, FALSE);
 
-	it = rocksdb_create_iterator(bd->db, bd->read_options);
+	for (guint32 i = 0; i < count; i++)
+	{
+		values[i] = NULL;
+		lens[i] = 0;
+	}
 
-	if (it != NULL)
+	if (batch->column_family == NULL)
 	{
-		iterator = g_slice_new(JRocksDBIterator);
-		iterator->iterator = it;
-		iterator->first = TRUE;
-		iterator->prefix = g_strdup_printf("%s:", namespace);
-		iterator->namespace_len = strlen(namespace) + 1;
+		batch->column_family = backend_get_column_family(bd, batch->namespace, FALSE);
 
-		*backend_iterator = iterator;
+		if (batch->column_family == NULL)
+		{
+			return FALSE;
+		}
 	}
 
-	return (iterator != NULL);
+	if (batch->values == NULL)
+	{
+		batch->values = g_ptr_array_new_with_free_func(rocksdb_free);
+	}
+
+	column_families = g_new(rocksdb_column_family_handle_t const*, count);
+	key_lens = g_new(gsize, count);
+	results = g_new(gchar*, count);
+	result_lens = g_new(gsize, count);
+	errors = g_new(gchar*, count);
+
+	for (guint32 i = 0; i < count; i++)
+	{
+		column_families[i] = batch->column_family;
+		key_lens[i] = strlen(keys[i]) + 1;
+	}
+
+	// MultiGet looks up all keys using a single snapshot and batches the block reads
+	rocksdb_multi_get_cf(bd->db, bd->read_options, column_families, count, keys, key_lens, results, result_lens, errors);
+
+	for (guint32 i = 0; i < count; i++)
+	{
+		if (errors[i] != NULL)
+		{
+			rocksdb_free(errors[i]);
+		}
+
+		if (results[i] == NULL)
+		{
+			ret = FALSE;
+			continue;
+		}
+
+		// The results are kept until the batch is executed to avoid copying them
+		g_ptr_array_add(batch->values, results[i]);
+
+		values[i] = results[i];
+		lens[i] = result_lens[i];
+	}
+
+	return ret;
+}
+
+static JRocksDBIterator*
+backend_iterator_new(JRocksDBData* bd, gchar const* namespace, gchar const* prefix)
+{
+	JRocksDBIterator* iterator;
+	rocksdb_column_family_handle_t* column_family;
+	rocksdb_readoptions_t* read_options = bd->read_options;
+
+	column_family = backend_get_column_family(bd, namespace, FALSE);
+
+	// Restrict the iterator to the prefix so the prefix bloom filters can be used
+	if (bd->prefix_length > 0 && strlen(prefix) >= bd->prefix_length)
+	{
+		read_options = bd->read_options_prefix;
+	}
+
+	iterator = g_slice_new(JRocksDBIterator);
+	iterator->iterator = (column_family != NULL) ? rocksdb_create_iterator_cf(bd->db, read_options, column_family) : NULL;
+	iterator->first = TRUE;
+	iterator->prefix = g_strdup(prefix);
+
+	return iterator;
 }
 
 static gboolean
-backend_get_by_prefix(gpointer backend_data, gchar const* namespace, gchar const* prefix, gpointer* backend_iterator)
+backend_get_all(gpointer backend_data, gchar const* namespace, gpointer* backend_iterator)
 {
 	JRocksDBData* bd = backend_data;
-	JRocksDBIterator* iterator = NULL;
-	rocksdb_iterator_t* it;
 
 	g_return_val_if_fail(namespace != NULL, FALSE);
-	g_return_val_if_fail(prefix != NULL, FALSE);
 	g_return_val_if_fail(backend_iterator != NULL, FALSE);
 
-	it = rocksdb_create_iterator(bd->db, bd->read_options);
+	*backend_iterator = backend_iterator_new(bd, namespace, "");
 
-	if (it != NULL)
-	{
-		iterator = g_slice_new(JRocksDBIterator);
-		iterator->iterator = it;
-		iterator->first = TRUE;
-		iterator->prefix = g_strdup_printf("%s:%s", namespace, prefix);
-		iterator->namespace_len = strlen(namespace) + 1;
+	return TRUE;
+}
 
-		*backend_iterator = iterator;
-	}
+static gboolean
+backend_get_by_prefix(gpointer backend_data, gchar const* namespace, gchar const* prefix, gpointer* backend_iterator)
+{
+	JRocksDBData* bd = backend_data;
 
-	return (iterator != NULL);
+	g_return_val_if_fail(namespace != NULL, FALSE);
+	g_return_val_if_fail(prefix != NULL, FALSE);
+	g_return_val_if_fail(backend_iterator != NULL, FALSE);
+
+	*backend_iterator = backend_iterator_new(bd, namespace, prefix);
+
+	return TRUE;
 }
 
 static gboolean
@@ -228,6 +408,11 @@ backend_iterate(gpointer backend_data, gpointer backend_iterator, gchar const**
 	g_return_val_if_fail(value != NULL, FALSE);
 	g_return_val_if_fail(len != NULL, FALSE);
 
+	if (iterator->iterator == NULL)
+	{
+		goto out;
+	}
+
 	if (iterator->first)
 	{
 		rocksdb_iter_seek(iterator->iterator, iterator->prefix, strlen(iterator->prefix));
@@ -250,7 +435,7 @@ backend_iterate(gpointer backend_data, gpointer backend_iterator, gchar const**
 			goto out;
 		}
 
-		*key = key_ + iterator->namespace_len;
+		*key = key_;
 		*value = rocksdb_iter_value(iterator->iterator, &tmp);
 		*len = tmp;
 
@@ -259,52 +444,273 @@ backend_iterate(gpointer backend_data, gpointer backend_iterator, gchar const**
 
 out:
 	g_free(iterator->prefix);
-	rocksdb_iter_destroy(iterator->iterator);
+
+	if (iterator->iterator != NULL)
+	{
+		rocksdb_iter_destroy(iterator->iterator);
+	}
+
 	g_slice_free(JRocksDBIterator, iterator);
 
 	return FALSE;
 }
 
+/**
+ * Moves key-value pairs stored in the default column family as namespace:key into per-namespace column families.
+ *
+ * \param bd The backend data.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+backend_migrate(JRocksDBData* bd)
+{
+	rocksdb_iterator_t* it;
+	rocksdb_writebatch_t* batch;
+	gboolean ret = TRUE;
+	guint count = 0;
+
+	it = rocksdb_create_iterator(bd->db, bd->read_options);
+	batch = rocksdb_writebatch_create();
+
+	for (rocksdb_iter_seek_to_first(it); rocksdb_iter_valid(it); rocksdb_iter_next(it))
+	{
+		rocksdb_column_family_handle_t* column_family;
+		g_autofree gchar* namespace = NULL;
+		gchar const* nskey;
+		gchar const* separator;
+		gconstpointer value;
+		gsize nskey_len;
+		gsize value_len;
+
+		nskey = rocksdb_iter_key(it, &nskey_len);
+		value = rocksdb_iter_value(it, &value_len);
+		separator = memchr(nskey, ':', nskey_len);
+
+		if (separator == NULL)
+		{
+			continue;
+		}
+
+		namespace = g_strndup(nskey, separator - nskey);
+		column_family = backend_get_column_family(bd, namespace, TRUE);
+
+		if (column_family == NULL)
+		{
+			ret = FALSE;
+			break;
+		}
+
+		rocksdb_writebatch_put_cf(batch, column_family, separator + 1, nskey_len - (separator + 1 - nskey), value, value_len);
+		rocksdb_writebatch_delete(batch, nskey, nskey_len);
+		count++;
+
+		if (count % J_ROCKSDB_MIGRATION_BATCH == 0)
+		{
+			g_autofree gchar* error = NULL;
+
+			rocksdb_write(bd->db, bd->write_options_sync, batch, &error);
+			rocksdb_writebatch_clear(batch);
+
+			if (error != NULL)
+			{
+				ret = FALSE;
+				break;
+			}
+		}
+	}
+
+	if (ret && count % J_ROCKSDB_MIGRATION_BATCH != 0)
+	{
+		g_autofree gchar* error = NULL;
+
+		rocksdb_write(bd->db, bd->write_options_sync, batch, &error);
+		ret = (error == NULL);
+	}
+
+	if (count > 0)
+	{
+		g_debug("Migrated %u key-value pairs to column families", count);
+	}
+
+	rocksdb_writebatch_destroy(batch);
+	rocksdb_iter_destroy(it);
+
+	return ret;
+}
+
 static gboolean
 backend_init(gchar const* path, gpointer* backend_data)
 {
 	JRocksDBData* bd;
-	rocksdb_options_t* options;
+	rocksdb_block_based_table_options_t* table_options;
+	g_auto(GStrv) split = NULL;
 	g_autofree gchar* dirname = NULL;
+	gchar** column_family_list = NULL;
+	gchar const* default_column_family[] = { "default" };
+	gchar const* const* column_family_names = default_column_family;
+	gsize column_family_count = 1;
 	gint const compressions[] = { rocksdb_lz4_compression, rocksdb_snappy_compression, rocksdb_no_compression };
+	guint64 block_cache = 0;
+	guint64 bloom_bits = 10;
+	guint64 write_buffer = 0;
+	guint64 background_jobs = 0;
+	guint64 prefix_length = 0;
 
 	g_return_val_if_fail(path != NULL, FALSE);
 
-	dirname = g_path_get_dirname(path);
+	/* Path syntax: [path](:[option])*
+	   e.g.: /var/lib/julea/rocksdb:block-cache=1024:bloom-bits=10:write-buffer=64:background-jobs=4:prefix-length=8 */
+	split = g_strsplit(path, ":", 0);
+
+	for (guint i = 1; split[i] != NULL; i++)
+	{
+		if (g_str_has_prefix(split[i], "block-cache="))
+		{
+			block_cache = g_ascii_strtoull(split[i] + strlen("block-cache="), NULL, 10);
+		}
+		else if (g_str_has_prefix(split[i], "bloom-bits="))
+		{
+			bloom_bits = g_ascii_strtoull(split[i] + strlen("bloom-bits="), NULL, 10);
+		}
+		else if (g_str_has_prefix(split[i], "write-buffer="))
+		{
+			write_buffer = g_ascii_strtoull(split[i] + strlen("write-buffer="), NULL, 10);
+		}
+		else if (g_str_has_prefix(split[i], "background-jobs="))
+		{
+			background_jobs = g_ascii_strtoull(split[i] + strlen("background-jobs="), NULL, 10);
+		}
+		else if (g_str_has_prefix(split[i], "prefix-length="))
+		{
+			prefix_length = g_ascii_strtoull(split[i] + strlen("prefix-length="), NULL, 10);
+		}
+		else
+		{
+			g_warning("Unknown option %s", split[i]);
+		}
+	}
+
+	dirname = g_path_get_dirname(split[0]);
 	g_mkdir_with_parents(dirname, 0700);
 
 	bd = g_slice_new(JRocksDBData);
+	bd->db = NULL;
+	bd->column_families = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)rocksdb_column_family_handle_destroy);
+	g_mutex_init(&(bd->column_families_mutex));
+	bd->prefix_length = prefix_length;
 	bd->read_options = rocksdb_readoptions_create();
+	bd->read_options_prefix = rocksdb_readoptions_create();
+	rocksdb_readoptions_set_prefix_same_as_start(bd->read_options_prefix, 1);
 	bd->write_options = rocksdb_writeoptions_create();
 	bd->write_options_sync = rocksdb_writeoptions_create();
 	rocksdb_writeoptions_set_sync(bd->write_options_sync, 1);
 
-	options = rocksdb_options_create();
-	rocksdb_options_set_create_if_missing(options, 1);
+	bd->options = rocksdb_options_create();
+	rocksdb_options_set_create_if_missing(bd->options, 1);
+	rocksdb_options_set_create_missing_column_families(bd->options, 1);
+
+	// The table factory copies the table options and takes a reference to the cache
+	table_options = rocksdb_block_based_options_create();
+
+	if (block_cache > 0)
+	{
+		rocksdb_cache_t* cache;
+
+		cache = rocksdb_cache_create_lru(block_cache * 1024 * 1024);
+		rocksdb_block_based_options_set_block_cache(table_options, cache);
+		rocksdb_cache_destroy(cache);
+	}
+
+	if (bloom_bits > 0)
+	{
+		rocksdb_block_based_options_set_filter_policy(table_options, rocksdb_filterpolicy_create_bloom(bloom_bits));
+	}
+
+	rocksdb_options_set_block_based_table_factory(bd->options, table_options);
+	rocksdb_block_based_options_destroy(table_options);
+
+	if (write_buffer > 0)
+	{
+		rocksdb_options_set_write_buffer_size(bd->options, write_buffer * 1024 * 1024);
+	}
+
+	if (background_jobs > 0)
+	{
+		rocksdb_options_set_max_background_jobs(bd->options, background_jobs);
+	}
+
+	if (prefix_length > 0)
+	{
+		rocksdb_options_set_prefix_extractor(bd->options, rocksdb_slicetransform_create_fixed_prefix(prefix_length));
+		rocksdb_options_set_memtable_prefix_bloom_size_ratio(bd->options, 0.1);
+		// Iterators without a sufficiently long prefix have to see all keys
+		rocksdb_readoptions_set_total_order_seek(bd->read_options, 1);
+	}
+
+	{
+		g_autofree gchar* error = NULL;
+		gsize count = 0;
+
+		// Fails for new databases, which only have the default column family
+		column_family_list = rocksdb_list_column_families(bd->options, split[0], &count, &error);
+
+		if (column_family_list != NULL)
+		{
+			column_family_names = (gchar const* const*)column_family_list;
+			column_family_count = count;
+		}
+	}
 
 	for (guint i = 0; i < G_N_ELEMENTS(compressions); i++)
 	{
 		g_autofree gchar* error = NULL;
+		g_autofree rocksdb_options_t const** column_family_options = NULL;
+		g_autofree rocksdb_column_family_handle_t** column_family_handles = NULL;
 
-		rocksdb_options_set_compression(options, compressions[i]);
-		bd->db = rocksdb_open(options, path, &error);
+		rocksdb_options_set_compression(bd->options, compressions[i]);
+
+		column_family_options = g_new(rocksdb_options_t const*, column_family_count);
+		column_family_handles = g_new0(rocksdb_column_family_handle_t*, column_family_count);
+
+		for (gsize j = 0; j < column_family_count; j++)
+		{
+			column_family_options[j] = bd->options;
+		}
+
+		bd->db = rocksdb_open_column_families(bd->options, split[0], column_family_count, column_family_names, column_family_options, column_family_handles, &error);
 
 		if (bd->db != NULL)
 		{
+			for (gsize j = 0; j < column_family_count; j++)
+			{
+				if (!g_str_has_prefix(column_family_names[j], J_ROCKSDB_COLUMN_FAMILY_PREFIX))
+				{
+					// The default column family is only used for migration and does not have to be kept
+					rocksdb_column_family_handle_destroy(column_family_handles[j]);
+					continue;
+				}
+
+				g_hash_table_insert(bd->column_families, g_strdup(column_family_names[j] + strlen(J_ROCKSDB_COLUMN_FAMILY_PREFIX)), column_family_handles[j]);
+			}
+
 			break;
 		}
 	}
 
-	rocksdb_options_destroy(options);
+	if (column_family_list != NULL)
+	{
+		rocksdb_list_column_families_destroy(column_family_list, column_family_count);
+	}
 
 	*backend_data = bd;
 
-	return (bd->db != NULL);
+	if (bd->db == NULL)
+	{
+		return FALSE;
+	}
+
+	return backend_migrate(bd);
 }
 
 static void
@@ -312,7 +718,12 @@ backend_fini(gpointer backend_data)
 {
 	JRocksDBData* bd = backend_data;
 
+	// Column family handles have to be destroyed before the database is closed
+	g_hash_table_unref(bd->column_families);
+	g_mutex_clear(&(bd->column_families_mutex));
+
 	rocksdb_readoptions_destroy(bd->read_options);
+	rocksdb_readoptions_destroy(bd->read_options_prefix);
 	rocksdb_writeoptions_destroy(bd->write_options);
 	rocksdb_writeoptions_destroy(bd->write_options_sync);
 
@@ -321,6 +732,8 @@ backend_fini(gpointer backend_data)
 		rocksdb_close(bd->db);
 	}
 
+	rocksdb_options_destroy(bd->options);
+
 	g_slice_free(JRocksDBData, bd);
 }
 
@@ -335,6 +748,7 @@ static JBackend rocksdb_backend = {
 		.backend_put = backend_put,
 		.backend_delete = backend_delete,
 		.backend_get = backend_get,
+		.backend_get_many = backend_get_many,
 		.backend_get_all = backend_get_all,
 		.backend_get_by_prefix = backend_get_by_prefix,
 		.backend_iterate = backend_iterate }
@@ -21,40 +21,227 @@
 #include <glib.h>
 #include <gmodule.h>
 
+#include <string.h>
+
 #include <sqlite3.h>
 
 #include <julea.h>
 
+/*
+ * Each thread uses its own connection with prepared statements for puts, deletes and gets, which are reused for all batches.
+ * The database uses write-ahead logging, which allows readers to proceed concurrently with a writer.
+ * The synchronous mode is set according to the batch's safety semantics.
+ */
+
+/**
+ * The number of keys looked up per query by backend_get_many.
+ **/
+#define J_SQLITE_GET_MANY_KEYS 100
+
 struct JSQLiteBatch
 {
 	gchar* namespace;
 	JSemantics* semantics;
+
+	/**
+	 * The values returned by backend_get_many, freed when the batch is executed.
+	 **/
+	GPtrArray* values;
 };
 
 typedef struct JSQLiteBatch JSQLiteBatch;
 
 struct JSQLiteData
 {
-	sqlite3* db;
+	gchar* path;
 };
 
 typedef struct JSQLiteData JSQLiteData;
 
+/**
+ * A thread's connection.
+ **/
+struct JSQLiteConnection
+{
+	sqlite3* db;
+
+	/**
+	 * The cached prepared statements.
+	 **/
+	sqlite3_stmt* stmt_put;
+	sqlite3_stmt* stmt_delete;
+	sqlite3_stmt* stmt_get;
+	sqlite3_stmt* stmt_get_many;
+
+	/**
+	 * The current synchronous mode, -1 if unknown.
+	 **/
+	gint synchronous;
+};
+
+typedef struct JSQLiteConnection JSQLiteConnection;
+
+static void backend_connection_free(gpointer);
+
+static GPrivate backend_connection = G_PRIVATE_INIT(backend_connection_free);
+
+static void
+backend_connection_free(gpointer data)
+{
+	JSQLiteConnection* connection = data;
+
+	if (connection == NULL)
+	{
+		return;
+	}
+
+	// Finalizing NULL statements is a no-op
+	sqlite3_finalize(connection->stmt_put);
+	sqlite3_finalize(connection->stmt_delete);
+	sqlite3_finalize(connection->stmt_get);
+	sqlite3_finalize(connection->stmt_get_many);
+	sqlite3_close(connection->db);
+
+	g_slice_free(JSQLiteConnection, connection);
+}
+
+static sqlite3*
+backend_open(gchar const* path)
+{
+	sqlite3* db = NULL;
+
+	if (sqlite3_open(path, &db) != SQLITE_OK)
+	{
+		sqlite3_close(db);
+		return NULL;
+	}
+
+	// Wait for other connections instead of failing immediately
+	sqlite3_busy_timeout(db, 60 * 1000);
+
+	return db;
+}
+
+/**
+ * Returns the calling thread's connection, opening it if necessary.
+ **/
+static JSQLiteConnection*
+backend_get_connection(JSQLiteData* bd)
+{
+	JSQLiteConnection* connection;
+	g_autoptr(GString) get_many = NULL;
+
+	connection = g_private_get(&backend_connection);
+
+	if (connection != NULL)
+	{
+		return connection;
+	}
+
+	get_many = g_string_new("SELECT key, value FROM julea_kv WHERE namespace = ? AND key IN (?");
+
+	for (guint i = 1; i < J_SQLITE_GET_MANY_KEYS; i++)
+	{
+		g_string_append(get_many, ", ?");
+	}
+
+	g_string_append(get_many, ");");
+
+	connection = g_slice_new0(JSQLiteConnection);
+	connection->synchronous = -1;
+
+	if ((connection->db = backend_open(bd->path)) == NULL)
+	{
+		goto error;
+	}
+
+	if (sqlite3_prepare_v2(connection->db, "INSERT OR REPLACE INTO julea_kv (namespace, key, value) VALUES (?, ?, ?);", -1, &(connection->stmt_put), NULL) != SQLITE_OK
+	    || sqlite3_prepare_v2(connection->db, "DELETE FROM julea_kv WHERE namespace = ? AND key = ?;", -1, &(connection->stmt_delete), NULL) != SQLITE_OK
+	    || sqlite3_prepare_v2(connection->db, "SELECT value FROM julea_kv WHERE namespace = ? AND key = ?;", -1, &(connection->stmt_get), NULL) != SQLITE_OK
+	    || sqlite3_prepare_v2(connection->db, get_many->str, -1, &(connection->stmt_get_many), NULL) != SQLITE_OK)
+	{
+		goto error;
+	}
+
+	g_private_set(&backend_connection, connection);
+
+	return connection;
+
+error:
+	g_warning("Could not open SQLite connection: %s", (connection->db != NULL) ? sqlite3_errmsg(connection->db) : "unknown error");
+	backend_connection_free(connection);
+
+	return NULL;
+}
+
+/**
+ * Sets the connection's synchronous mode according to the safety semantics.
+ **/
+static void
+backend_set_synchronous(JSQLiteConnection* connection, JSemantics* semantics)
+{
+	gint synchronous = 1;
+
+	if (semantics != NULL)
+	{
+		switch (j_semantics_get(semantics, J_SEMANTICS_SAFETY))
+		{
+			case J_SEMANTICS_SAFETY_NONE:
+				// OFF
+				synchronous = 0;
+				break;
+			case J_SEMANTICS_SAFETY_NETWORK:
+				// NORMAL, which only syncs at checkpoints in WAL mode
+				synchronous = 1;
+				break;
+			case J_SEMANTICS_SAFETY_STORAGE:
+				// FULL
+				synchronous = 2;
+				break;
+			default:
+				g_warn_if_reached();
+		}
+	}
+
+	if (connection->synchronous != synchronous)
+	{
+		g_autofree gchar* pragma = NULL;
+
+		pragma = g_strdup_printf("PRAGMA synchronous = %d;", synchronous);
+
+		if (sqlite3_exec(connection->db, pragma, NULL, NULL, NULL) == SQLITE_OK)
+		{
+			connection->synchronous = synchronous;
+		}
+	}
+}
+
 static gboolean
 backend_batch_start(gpointer backend_data, gchar const* namespace, JSemantics* semantics, gpointer* backend_batch)
 {
 	JSQLiteBatch* batch = NULL;
 	JSQLiteData* bd = backend_data;
+	JSQLiteConnection* connection;
 
 	g_return_val_if_fail(namespace != NULL, FALSE);
 	g_return_val_if_fail(backend_batch != NULL, FALSE);
 
-	if (sqlite3_exec(bd->db, "BEGIN TRANSACTION;", NULL, NULL, NULL) == SQLITE_OK)
+	if ((connection = backend_get_connection(bd)) == NULL)
+	{
+		*backend_batch = NULL;
+		return FALSE;
+	}
+
+	// The synchronous mode cannot be changed inside a transaction
+	backend_set_synchronous(connection, semantics);
+
+	if (sqlite3_exec(connection->db, "BEGIN TRANSACTION;", NULL, NULL, NULL) == SQLITE_OK)
 	{
 		batch = g_slice_new(JSQLiteBatch);
 
 		batch->namespace = g_strdup(namespace);
 		batch->semantics = j_semantics_ref(semantics);
+		batch->values = NULL;
 	}
 
 	*backend_batch = batch;
@@ -69,14 +256,28 @@ backend_batch_execute(gpointer backend_data, gpointer backend_batch)
 
 	JSQLiteBatch* batch = backend_batch;
 	JSQLiteData* bd = backend_data;
+	JSQLiteConnection* connection;
 
 	g_return_val_if_fail(backend_batch != NULL, FALSE);
 
-	// FIXME do something with batch->semantics
+	connection = backend_get_connection(bd);
 
-	if (sqlite3_exec(bd->db, "COMMIT;", NULL, NULL, NULL) == SQLITE_OK)
+	if (connection != NULL)
 	{
-		ret = TRUE;
+		if (sqlite3_exec(connection->db, "COMMIT;", NULL, NULL, NULL) == SQLITE_OK)
+		{
+			ret = TRUE;
+		}
+		else
+		{
+			g_warning("Could not commit transaction: %s", sqlite3_errmsg(connection->db));
+			sqlite3_exec(connection->db, "ROLLBACK;", NULL, NULL, NULL);
+		}
+	}
+
+	if (batch->values != NULL)
+	{
+		g_ptr_array_unref(batch->values);
 	}
 
 	j_semantics_unref(batch->semantics);
@@ -91,22 +292,29 @@ backend_put(gpointer backend_data, gpointer backend_batch, gchar const* key, gco
 {
 	JSQLiteBatch* batch = backend_batch;
 	JSQLiteData* bd = backend_data;
+	JSQLiteConnection* connection;
 	sqlite3_stmt* stmt;
+	gint ret;
 
 	g_return_val_if_fail(backend_batch != NULL, FALSE);
 	g_return_val_if_fail(key != NULL, FALSE);
 	g_return_val_if_fail(value != NULL, FALSE);
 
-	sqlite3_prepare_v2(bd->db, "INSERT OR REPLACE INTO julea (namespace, key, value) VALUES (?, ?, ?);", -1, &stmt, NULL);
-	sqlite3_bind_text(stmt, 1, batch->namespace, -1, NULL);
-	sqlite3_bind_text(stmt, 2, key, -1, NULL);
-	sqlite3_bind_blob(stmt, 3, value, len, NULL);
+	if ((connection = backend_get_connection(bd)) == NULL)
+	{
+		return FALSE;
+	}
 
-	sqlite3_step(stmt);
-	sqlite3_finalize(stmt);
+	stmt = connection->stmt_put;
 
-	// FIXME
-	return TRUE;
+	sqlite3_bind_text(stmt, 1, batch->namespace, -1, SQLITE_STATIC);
+	sqlite3_bind_text(stmt, 2, key, -1, SQLITE_STATIC);
+	sqlite3_bind_blob(stmt, 3, value, len, SQLITE_STATIC);
+
+	ret = sqlite3_step(stmt);
+	sqlite3_reset(stmt);
+
+	return (ret == SQLITE_DONE);
 }
 
 static gboolean
@@ -114,20 +322,27 @@ backend_delete(gpointer backend_data, gpointer backend_batch, gchar const* key)
 {
 	JSQLiteBatch* batch = backend_batch;
 	JSQLiteData* bd = backend_data;
+	JSQLiteConnection* connection;
 	sqlite3_stmt* stmt;
+	gint ret;
 
 	g_return_val_if_fail(backend_batch != NULL, FALSE);
 	g_return_val_if_fail(key != NULL, FALSE);
 
-	sqlite3_prepare_v2(bd->db, "DELETE FROM julea WHERE namespace = ? AND key = ?;", -1, &stmt, NULL);
-	sqlite3_bind_text(stmt, 1, batch->namespace, -1, NULL);
-	sqlite3_bind_text(stmt, 2, key, -1, NULL);
+	if ((connection = backend_get_connection(bd)) == NULL)
+	{
+		return FALSE;
+	}
+
+	stmt = connection->stmt_delete;
 
-	sqlite3_step(stmt);
-	sqlite3_finalize(stmt);
+	sqlite3_bind_text(stmt, 1, batch->namespace, -1, SQLITE_STATIC);
+	sqlite3_bind_text(stmt, 2, key, -1, SQLITE_STATIC);
 
-	// FIXME
-	return TRUE;
+	ret = sqlite3_step(stmt);
+	sqlite3_reset(stmt);
+
+	return (ret == SQLITE_DONE);
 }
 
 static gboolean
@@ -135,49 +350,157 @@ backend_get(gpointer backend_data, gpointer backend_batch, gchar const* key, gpo
 {
 	JSQLiteBatch* batch = backend_batch;
 	JSQLiteData* bd = backend_data;
+	JSQLiteConnection* connection;
 	sqlite3_stmt* stmt;
-	gint ret;
-	gconstpointer result = NULL;
-	gsize result_len;
+	gboolean ret = FALSE;
 
 	g_return_val_if_fail(backend_batch != NULL, FALSE);
 	g_return_val_if_fail(key != NULL, FALSE);
 	g_return_val_if_fail(value != NULL, FALSE);
 	g_return_val_if_fail(len != NULL, FALSE);
 
-	sqlite3_prepare_v2(bd->db, "SELECT value FROM julea WHERE namespace = ? AND key = ?;", -1, &stmt, NULL);
-	sqlite3_bind_text(stmt, 1, batch->namespace, -1, NULL);
-	sqlite3_bind_text(stmt, 2, key, -1, NULL);
+	if ((connection = backend_get_connection(bd)) == NULL)
+	{
+		return FALSE;
+	}
 
-	ret = sqlite3_step(stmt);
+	stmt = connection->stmt_get;
 
-	if (ret == SQLITE_ROW)
+	sqlite3_bind_text(stmt, 1, batch->namespace, -1, SQLITE_STATIC);
+	sqlite3_bind_text(stmt, 2, key, -1, SQLITE_STATIC);
+
+	if (sqlite3_step(stmt) == SQLITE_ROW)
 	{
+		gconstpointer result;
+		gsize result_len;
+
 		result = sqlite3_column_blob(stmt, 0);
 		result_len = sqlite3_column_bytes(stmt, 0);
 
-		// FIXME check whether copies can be avoided
 		*value = g_memdup(result, result_len);
 		*len = result_len;
+
+		ret = TRUE;
 	}
 
-	sqlite3_finalize(stmt);
+	sqlite3_reset(stmt);
+
+	return ret;
+}
+
+static gboolean
+backend_get_many(gpointer backend_data, gpointer backend_batch, gchar const* const* keys, guint32 count, gconstpointer* values, guint32* lens)
+{
+	JSQLiteBatch* batch = backend_batch;
+	JSQLiteData* bd = backend_data;
+	JSQLiteConnection* connection;
+	sqlite3_stmt* stmt;
+	gboolean ret = TRUE;
+
+	g_return_val_if_fail(backend_batch != NULL, FALSE);
+	g_return_val_if_fail(keys != NULL, FALSE);
+	g_return_val_if_fail(values != NULL, FALSE);
+	g_return_val_if_fail(lens != NULL, FALSE);
+
+	for (guint32 i = 0; i < count; i++)
+	{
+		values[i] = NULL;
+		lens[i] = 0;
+	}
+
+	if ((connection = backend_get_connection(bd)) == NULL)
+	{
+		return FALSE;
+	}
+
+	if (batch->values == NULL)
+	{
+		batch->values = g_ptr_array_new_with_free_func(g_free);
+	}
+
+	stmt = connection->stmt_get_many;
+
+	for (guint32 offset = 0; offset < count; offset += J_SQLITE_GET_MANY_KEYS)
+	{
+		g_autoptr(GHashTable) indexes = NULL;
+		guint32 n = MIN(count - offset, J_SQLITE_GET_MANY_KEYS);
+		gint step;
+
+		// Maps each key to its first index
+		indexes = g_hash_table_new(g_str_hash, g_str_equal);
+
+		sqlite3_bind_text(stmt, 1, batch->namespace, -1, SQLITE_STATIC);
+
+		for (guint32 i = 0; i < J_SQLITE_GET_MANY_KEYS; i++)
+		{
+			// Unused parameters repeat the last key so the statement can be reused for partial chunks
+			guint32 index = offset + MIN(i, n - 1);
+
+			sqlite3_bind_text(stmt, i + 2, keys[index], -1, SQLITE_STATIC);
+
+			if (i < n && !g_hash_table_contains(indexes, keys[index]))
+			{
+				g_hash_table_insert(indexes, (gpointer)keys[index], GUINT_TO_POINTER(index));
+			}
+		}
+
+		while ((step = sqlite3_step(stmt)) == SQLITE_ROW)
+		{
+			gchar const* key;
+			gpointer value;
+			guint32 index;
+
+			key = (gchar const*)sqlite3_column_text(stmt, 0);
+			index = GPOINTER_TO_UINT(g_hash_table_lookup(indexes, key));
+
+			// Column values are only valid until the next step
+			value = g_memdup(sqlite3_column_blob(stmt, 1), sqlite3_column_bytes(stmt, 1));
+			g_ptr_array_add(batch->values, value);
+
+			values[index] = value;
+			lens[index] = sqlite3_column_bytes(stmt, 1);
+		}
+
+		sqlite3_reset(stmt);
 
-	return (result != NULL);
+		if (step != SQLITE_DONE)
+		{
+			return FALSE;
+		}
+
+		// Duplicate keys share the value of their first occurrence
+		for (guint32 i = offset; i < offset + n; i++)
+		{
+			guint32 index = GPOINTER_TO_UINT(g_hash_table_lookup(indexes, keys[i]));
+
+			values[i] = values[index];
+			lens[i] = lens[index];
+
+			if (values[i] == NULL)
+			{
+				ret = FALSE;
+			}
+		}
+	}
+
+	return ret;
 }
 
 static gboolean
 backend_get_all(gpointer backend_data, gchar const* namespace, gpointer* backend_iterator)
 {
 	JSQLiteData* bd = backend_data;
+	JSQLiteConnection* connection;
 	sqlite3_stmt* stmt = NULL;
 
 	g_return_val_if_fail(namespace != NULL, FALSE);
 	g_return_val_if_fail(backend_iterator != NULL, FALSE);
 
-	if (sqlite3_prepare_v2(bd->db, "SELECT key, value FROM julea WHERE namespace = ?;", -1, &stmt, NULL) == SQLITE_OK)
+	// Iterators use the connection of the thread that created them
+	if ((connection = backend_get_connection(bd)) != NULL
+	    && sqlite3_prepare_v2(connection->db, "SELECT key, value FROM julea_kv WHERE namespace = ?;", -1, &stmt, NULL) == SQLITE_OK)
 	{
-		sqlite3_bind_text(stmt, 1, namespace, -1, NULL);
+		sqlite3_bind_text(stmt, 1, namespace, -1, SQLITE_TRANSIENT);
 	}
 
 	*backend_iterator = stmt;
@@ -189,16 +512,25 @@ static gboolean
 backend_get_by_prefix(gpointer backend_data, gchar const* namespace, gchar const* prefix, gpointer* backend_iterator)
 {
 	JSQLiteData* bd = backend_data;
+	JSQLiteConnection* connection;
 	sqlite3_stmt* stmt = NULL;
 
 	g_return_val_if_fail(namespace != NULL, FALSE);
 	g_return_val_if_fail(prefix != NULL, FALSE);
 	g_return_val_if_fail(backend_iterator != NULL, FALSE);
 
-	if (sqlite3_prepare_v2(bd->db, "SELECT key, value FROM julea WHERE namespace = ? AND key LIKE ? || '%';", -1, &stmt, NULL) == SQLITE_OK)
+	// Range queries can use the primary key, unlike LIKE, which also treats % and _ in the prefix as wildcards
+	if ((connection = backend_get_connection(bd)) != NULL
+	    && sqlite3_prepare_v2(connection->db, "SELECT key, value FROM julea_kv WHERE namespace = ? AND key >= ? AND key < ?;", -1, &stmt, NULL) == SQLITE_OK)
 	{
-		sqlite3_bind_text(stmt, 1, namespace, -1, NULL);
-		sqlite3_bind_text(stmt, 2, prefix, -1, NULL);
+		g_autofree gchar* upper = NULL;
+
+		// Keys are compared bytewise and no valid UTF-8 string contains 0xff
+		upper = g_strconcat(prefix, "\xff", NULL);
+
+		sqlite3_bind_text(stmt, 1, namespace, -1, SQLITE_TRANSIENT);
+		sqlite3_bind_text(stmt, 2, prefix, -1, SQLITE_TRANSIENT);
+		sqlite3_bind_text(stmt, 3, upper, -1, SQLITE_TRANSIENT);
 	}
 
 	*backend_iterator = stmt;
@@ -235,6 +567,7 @@ static gboolean
 backend_init(gchar const* path, gpointer* backend_data)
 {
 	JSQLiteData* bd;
+	sqlite3* db;
 	g_autofree gchar* dirname = NULL;
 
 	g_return_val_if_fail(path != NULL, FALSE);
@@ -242,30 +575,48 @@ backend_init(gchar const* path, gpointer* backend_data)
 	dirname = g_path_get_dirname(path);
 	g_mkdir_with_parents(dirname, 0700);
 
-	bd = g_slice_new(JSQLiteData);
+	if ((db = backend_open(path)) == NULL)
+	{
+		return FALSE;
+	}
 
-	if (sqlite3_open(path, &(bd->db)) != SQLITE_OK)
+	// The journal mode is persistent, the other connections will also use WAL
+	if (sqlite3_exec(db, "PRAGMA journal_mode = WAL;", NULL, NULL, NULL) != SQLITE_OK)
 	{
 		goto error;
 	}
 
-	if (sqlite3_exec(bd->db, "CREATE TABLE IF NOT EXISTS julea (namespace TEXT NOT NULL, key TEXT NOT NULL, value BLOB NOT NULL);", NULL, NULL, NULL) != SQLITE_OK)
+	if (sqlite3_exec(db, "CREATE TABLE IF NOT EXISTS julea_kv (namespace TEXT NOT NULL, key TEXT NOT NULL, value BLOB NOT NULL, PRIMARY KEY (namespace, key)) WITHOUT ROWID;", NULL, NULL, NULL) != SQLITE_OK)
 	{
 		goto error;
 	}
 
-	if (sqlite3_exec(bd->db, "CREATE UNIQUE INDEX IF NOT EXISTS julea_namespace_key ON julea (namespace, key);", NULL, NULL, NULL) != SQLITE_OK)
+	// Move entries from the old table, which used a separate index (it is created empty if it does not exist)
+	if (sqlite3_exec(db,
+			 "BEGIN TRANSACTION;"
+			 "CREATE TABLE IF NOT EXISTS julea (namespace TEXT NOT NULL, key TEXT NOT NULL, value BLOB NOT NULL);"
+			 "INSERT OR REPLACE INTO julea_kv (namespace, key, value) SELECT namespace, key, value FROM julea;"
+			 "DROP TABLE julea;"
+			 "COMMIT;",
+			 NULL, NULL, NULL)
+	    != SQLITE_OK)
 	{
+		sqlite3_exec(db, "ROLLBACK;", NULL, NULL, NULL);
 		goto error;
 	}
 
+	sqlite3_close(db);
+
+	bd = g_slice_new(JSQLiteData);
+	bd->path = g_strdup(path);
+
 	*backend_data = bd;
 
-	return (bd->db != NULL);
+	return TRUE;
 
 error:
-	sqlite3_close(bd->db);
-	g_slice_free(JSQLiteData, bd);
+	g_warning("Could not initialize SQLite database: %s", sqlite3_errmsg(db));
+	sqlite3_close(db);
 
 	return FALSE;
 }
@@ -275,11 +626,11 @@ backend_fini(gpointer backend_data)
 {
 	JSQLiteData* bd = backend_data;
 
-	if (bd->db != NULL)
-	{
-		sqlite3_close(bd->db);
-	}
+	// Close the calling thread's connection, the other ones are closed when their threads exit
+	backend_connection_free(g_private_get(&backend_connection));
+	g_private_set(&backend_connection, NULL);
 
+	g_free(bd->path);
 	g_slice_free(JSQLiteData, bd);
 }
 
@@ -294,6 +645,7 @@ static JBackend sqlite_backend = {
 		.backend_put = backend_put,
 		.backend_delete = backend_delete,
 		.backend_get = backend_get,
+		.backend_get_many = backend_get_many,
 		.backend_get_all = backend_get_all,
 		.backend_get_by_prefix = backend_get_by_prefix,
 		.backend_iterate = backend_iterate }
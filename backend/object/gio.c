@@ -215,6 +215,21 @@ backend_sync(gpointer backend_data, gpointer backend_object)
 	return ret;
 }
 
+static gboolean
+backend_truncate(gpointer backend_data, gpointer backend_object, guint64 size)
+{
+	JBackendObject* bo = backend_object;
+	gboolean ret;
+
+	(void)backend_data;
+
+	j_trace_file_begin(bo->path, J_TRACE_FILE_TRUNCATE);
+	ret = g_seekable_truncate(G_SEEKABLE(bo->stream), size, NULL, NULL);
+	j_trace_file_end(bo->path, J_TRACE_FILE_TRUNCATE, 0, size);
+
+	return ret;
+}
+
 static gboolean
 backend_read(gpointer backend_data, gpointer backend_object, gpointer buffer, guint64 length, guint64 offset, guint64* bytes_read)
 {
@@ -312,6 +327,7 @@ static JBackend gio_backend = {
 		.backend_close = backend_close,
 		.backend_status = backend_status,
 		.backend_sync = backend_sync,
+		.backend_truncate = backend_truncate,
 		.backend_read = backend_read,
 		.backend_write = backend_write }
 };
@@ -123,6 +123,19 @@ backend_sync(gpointer backend_data, gpointer backend_object)
 	return TRUE;
 }
 
+static gboolean
+backend_truncate(gpointer backend_data, gpointer backend_object, guint64 size)
+{
+	gchar const* full_path = backend_object;
+
+	(void)backend_data;
+
+	j_trace_file_begin(full_path, J_TRACE_FILE_TRUNCATE);
+	j_trace_file_end(full_path, J_TRACE_FILE_TRUNCATE, 0, size);
+
+	return TRUE;
+}
+
 static gboolean
 backend_read(gpointer backend_data, gpointer backend_object, gpointer buffer, guint64 length, guint64 offset, guint64* bytes_read)
 {
@@ -188,6 +201,7 @@ static JBackend null_backend = {
 		.backend_close = backend_close,
 		.backend_status = backend_status,
 		.backend_sync = backend_sync,
+		.backend_truncate = backend_truncate,
 		.backend_read = backend_read,
 		.backend_write = backend_write }
 };
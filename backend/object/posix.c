@@ -16,23 +16,37 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+// Required for O_DIRECT and pwritev()
+#define _GNU_SOURCE
+
 #include <julea-config.h>
 
 #include <glib.h>
 #include <glib/gstdio.h>
 #include <gmodule.h>
 
+#include <errno.h>
 #include <fcntl.h>
+#include <string.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
+#ifdef HAVE_LIBURING
+#include <liburing.h>
+#endif
+
 #include <julea.h>
 
 struct JBackendData
 {
 	gchar* path;
-	// FIXME check whether hash tables can stay global
+
+	/**
+	 * Whether objects are accessed using direct I/O, bypassing the page cache.
+	 **/
+	gboolean direct;
 };
 
 typedef struct JBackendData JBackendData;
@@ -41,200 +55,309 @@ struct JBackendObject
 {
 	gchar* path;
 	gint fd;
+
+	/**
+	 * The number of users.
+	 * Objects without users are kept open and are part of their shard's LRU list.
+	 **/
 	guint ref_count;
+
+	/**
+	 * Whether the object is part of the cache.
+	 * Deleted objects are closed as soon as they do not have any users left.
+	 **/
+	gboolean cached;
+
+	/**
+	 * The link within the shard's LRU list.
+	 **/
+	GList lru;
+
+	/**
+	 * Serializes the read-modify-write cycles of unaligned direct I/O writes.
+	 * Unaligned writes hold the lock exclusively, all other direct I/O writes share it.
+	 **/
+	GRWLock lock[1];
 };
 
 typedef struct JBackendObject JBackendObject;
 
-static guint jd_num_backends = 0;
-
-static GHashTable* jd_backend_file_cache = NULL;
+/*
+ * Open objects are shared by all threads using a cache that is split into multiple shards to reduce lock contention.
+ * Objects without users stay open until they are evicted in LRU order once the shard's number of open file descriptors exceeds its limit.
+ */
 
-G_LOCK_DEFINE_STATIC(jd_backend_file_cache);
+#define J_POSIX_CACHE_SHARDS 16
+#define J_POSIX_CACHE_MAX_DEFAULT 1024
 
-static void
-jd_backend_files_free(gpointer data)
+struct JBackendCacheShard
 {
-	GHashTable* files = data;
+	GMutex mutex[1];
 
-	g_hash_table_destroy(files);
-}
+	GHashTable* objects;
 
-// FIXME not deleted?
-static GPrivate jd_backend_files = G_PRIVATE_INIT(jd_backend_files_free);
+	/**
+	 * Objects without users, the most recently used one first.
+	 **/
+	GQueue lru[1];
 
-static void
-backend_file_unref(gpointer data)
-{
-	JBackendObject* bo = data;
+	/**
+	 * The number of objects deleted from this shard.
+	 * Objects are opened without holding the shard's lock and are only cached if no deletion happened in the meantime.
+	 **/
+	guint64 deletions;
 
-	g_return_if_fail(bo != NULL);
+	guint64 hits;
+	guint64 misses;
+};
 
-	G_LOCK(jd_backend_file_cache);
+typedef struct JBackendCacheShard JBackendCacheShard;
 
-	if (g_atomic_int_dec_and_test(&(bo->ref_count)))
-	{
-		g_hash_table_remove(jd_backend_file_cache, bo->path);
+static guint jd_num_backends = 0;
+
+static JBackendCacheShard jd_backend_cache[J_POSIX_CACHE_SHARDS];
+static guint jd_backend_cache_shard_max = J_POSIX_CACHE_MAX_DEFAULT / J_POSIX_CACHE_SHARDS;
+
+static JBackendCacheShard*
+jd_backend_cache_get_shard(gchar const* path)
+{
+	return &(jd_backend_cache[g_str_hash(path) % J_POSIX_CACHE_SHARDS]);
+}
 
+static void
+jd_backend_object_free(JBackendObject* bo)
+{
+	if (bo->fd != -1)
+	{
 		j_trace_file_begin(bo->path, J_TRACE_FILE_CLOSE);
 		close(bo->fd);
 		j_trace_file_end(bo->path, J_TRACE_FILE_CLOSE, 0, 0);
-
-		g_free(bo->path);
-		g_slice_free(JBackendObject, bo);
 	}
 
-	G_UNLOCK(jd_backend_file_cache);
+	g_rw_lock_clear(bo->lock);
+	g_free(bo->path);
+	g_slice_free(JBackendObject, bo);
 }
 
-static GHashTable*
-jd_backend_files_get_thread(void)
+/*
+ * Closes objects without users until the shard is within its limit again.
+ * The shard has to be locked.
+ */
+static void
+jd_backend_cache_evict(JBackendCacheShard* shard)
 {
-	GHashTable* files;
+	while (g_hash_table_size(shard->objects) > jd_backend_cache_shard_max && !g_queue_is_empty(shard->lru))
+	{
+		JBackendObject* bo;
 
-	files = g_private_get(&jd_backend_files);
+		bo = g_queue_pop_tail_link(shard->lru)->data;
+		g_hash_table_remove(shard->objects, bo->path);
 
-	if (G_UNLIKELY(files == NULL))
-	{
-		files = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, backend_file_unref);
-		g_private_replace(&jd_backend_files, files);
+		jd_backend_object_free(bo);
 	}
-
-	return files;
 }
 
+/*
+ * Returns the object for the given path, opening it if it is not cached.
+ * Takes ownership of path.
+ */
 static JBackendObject*
-backend_file_get(GHashTable* files, gchar const* key)
+jd_backend_cache_acquire(JBackendData* bd, gchar* path, gboolean create)
 {
+	JBackendCacheShard* shard;
 	JBackendObject* bo;
+	JBackendObject* cached_bo;
+	guint64 deletions;
+	gint flags;
+
+	shard = jd_backend_cache_get_shard(path);
 
-	if ((bo = g_hash_table_lookup(files, key)) != NULL)
+	g_mutex_lock(shard->mutex);
+
+	if ((bo = g_hash_table_lookup(shard->objects, path)) != NULL)
 	{
-		goto end;
+		if (bo->ref_count == 0)
+		{
+			g_queue_unlink(shard->lru, &(bo->lru));
+		}
+
+		bo->ref_count++;
+		shard->hits++;
+
+		g_mutex_unlock(shard->mutex);
+
+		g_free(path);
+
+		return bo;
 	}
 
-	G_LOCK(jd_backend_file_cache);
+	shard->misses++;
+	deletions = shard->deletions;
+
+	g_mutex_unlock(shard->mutex);
+
+	flags = O_RDWR | ((bd->direct) ? O_DIRECT : 0);
+
+	bo = g_slice_new(JBackendObject);
+	bo->path = path;
+	bo->ref_count = 1;
+	bo->cached = FALSE;
+	bo->lru.data = bo;
+	bo->lru.next = NULL;
+	bo->lru.prev = NULL;
+	g_rw_lock_init(bo->lock);
+
+	// Opening might block, so the shard is not locked to allow other objects to be accessed concurrently
+	if (create)
+	{
+		g_autofree gchar* parent = NULL;
+
+		j_trace_file_begin(path, J_TRACE_FILE_CREATE);
 
-	if ((bo = g_hash_table_lookup(jd_backend_file_cache, key)) != NULL)
+		parent = g_path_get_dirname(path);
+		g_mkdir_with_parents(parent, 0700);
+
+		bo->fd = open(path, flags | O_CREAT, 0600);
+
+		j_trace_file_end(path, J_TRACE_FILE_CREATE, 0, 0);
+	}
+	else
 	{
-		g_atomic_int_inc(&(bo->ref_count));
-		g_hash_table_insert(files, bo->path, bo);
-		G_UNLOCK(jd_backend_file_cache);
+		j_trace_file_begin(path, J_TRACE_FILE_OPEN);
+		bo->fd = open(path, flags);
+		j_trace_file_end(path, J_TRACE_FILE_OPEN, 0, 0);
 	}
 
-	/* Attention: The caller must call backend_file_add() if NULL is returned! */
+	// Objects that could not be opened are not cached
+	if (bo->fd == -1)
+	{
+		return bo;
+	}
 
-end:
-	return bo;
-}
+	g_mutex_lock(shard->mutex);
 
-static void
-backend_file_add(GHashTable* files, JBackendObject* object)
-{
-	g_hash_table_insert(jd_backend_file_cache, object->path, object);
-	g_hash_table_insert(files, object->path, object);
+	if ((cached_bo = g_hash_table_lookup(shard->objects, path)) != NULL)
+	{
+		// Another user has opened the object concurrently, use its file descriptor
+		if (cached_bo->ref_count == 0)
+		{
+			g_queue_unlink(shard->lru, &(cached_bo->lru));
+		}
 
-	G_UNLOCK(jd_backend_file_cache);
-}
+		cached_bo->ref_count++;
 
-static gboolean
-backend_create(gpointer backend_data, gchar const* namespace, gchar const* path, gpointer* backend_object)
-{
-	JBackendData* bd = backend_data;
-	GHashTable* files = jd_backend_files_get_thread();
+		g_mutex_unlock(shard->mutex);
 
-	JBackendObject* bo = NULL;
-	g_autofree gchar* parent = NULL;
-	gchar* full_path;
-	gint fd;
+		jd_backend_object_free(bo);
 
-	full_path = g_build_filename(bd->path, namespace, path, NULL);
+		return cached_bo;
+	}
 
-	if ((bo = backend_file_get(files, full_path)) != NULL)
+	// The file might have been deleted after it has been opened, the object is then closed as soon as it is released
+	if (shard->deletions == deletions)
 	{
-		g_free(full_path);
-
-		// FIXME
-		fd = bo->fd;
+		bo->cached = TRUE;
+		g_hash_table_insert(shard->objects, bo->path, bo);
 
-		goto end;
+		jd_backend_cache_evict(shard);
 	}
 
-	j_trace_file_begin(full_path, J_TRACE_FILE_CREATE);
+	g_mutex_unlock(shard->mutex);
 
-	parent = g_path_get_dirname(full_path);
-	g_mkdir_with_parents(parent, 0700);
+	return bo;
+}
 
-	fd = open(full_path, O_RDWR | O_CREAT, 0600);
+static void
+jd_backend_cache_release(JBackendObject* bo)
+{
+	JBackendCacheShard* shard;
+	gboolean free_object = FALSE;
 
-	j_trace_file_end(full_path, J_TRACE_FILE_CREATE, 0, 0);
+	shard = jd_backend_cache_get_shard(bo->path);
 
-	bo = g_slice_new(JBackendObject);
-	bo->path = full_path;
-	bo->fd = fd;
-	bo->ref_count = 1;
+	g_mutex_lock(shard->mutex);
 
-	backend_file_add(files, bo);
+	bo->ref_count--;
 
-end:
-	*backend_object = bo;
+	if (bo->ref_count == 0)
+	{
+		if (bo->cached)
+		{
+			g_queue_push_head_link(shard->lru, &(bo->lru));
+			jd_backend_cache_evict(shard);
+		}
+		else
+		{
+			free_object = TRUE;
+		}
+	}
+
+	g_mutex_unlock(shard->mutex);
 
-	return (fd != -1);
+	if (free_object)
+	{
+		jd_backend_object_free(bo);
+	}
 }
 
 static gboolean
-backend_open(gpointer backend_data, gchar const* namespace, gchar const* path, gpointer* backend_object)
+backend_create(gpointer backend_data, gchar const* namespace, gchar const* path, gpointer* backend_object)
 {
 	JBackendData* bd = backend_data;
-	GHashTable* files = jd_backend_files_get_thread();
-
-	JBackendObject* bo = NULL;
-	gchar* full_path;
-	gint fd;
 
-	full_path = g_build_filename(bd->path, namespace, path, NULL);
+	JBackendObject* bo;
 
-	if ((bo = backend_file_get(files, full_path)) != NULL)
-	{
-		g_free(full_path);
+	bo = jd_backend_cache_acquire(bd, g_build_filename(bd->path, namespace, path, NULL), TRUE);
 
-		// FIXME
-		fd = bo->fd;
+	*backend_object = bo;
 
-		goto end;
-	}
+	return (bo->fd != -1);
+}
 
-	j_trace_file_begin(full_path, J_TRACE_FILE_OPEN);
-	fd = open(full_path, O_RDWR);
-	j_trace_file_end(full_path, J_TRACE_FILE_OPEN, 0, 0);
+static gboolean
+backend_open(gpointer backend_data, gchar const* namespace, gchar const* path, gpointer* backend_object)
+{
+	JBackendData* bd = backend_data;
 
-	bo = g_slice_new(JBackendObject);
-	bo->path = full_path;
-	bo->fd = fd;
-	bo->ref_count = 1;
+	JBackendObject* bo;
 
-	backend_file_add(files, bo);
+	bo = jd_backend_cache_acquire(bd, g_build_filename(bd->path, namespace, path, NULL), FALSE);
 
-end:
 	*backend_object = bo;
 
-	return (fd != -1);
+	return (bo->fd != -1);
 }
 
 static gboolean
 backend_delete(gpointer backend_data, gpointer backend_object)
 {
 	JBackendObject* bo = backend_object;
-	GHashTable* files = jd_backend_files_get_thread();
+	JBackendCacheShard* shard;
 	gboolean ret;
 
 	(void)backend_data;
 
+	shard = jd_backend_cache_get_shard(bo->path);
+
+	// The shard stays locked until the file is gone, otherwise concurrent users could cache a file descriptor for a deleted file
+	g_mutex_lock(shard->mutex);
+
+	// The object will be closed as soon as all other users are done
+	if (bo->cached)
+	{
+		g_hash_table_remove(shard->objects, bo->path);
+		bo->cached = FALSE;
+	}
+
 	j_trace_file_begin(bo->path, J_TRACE_FILE_DELETE);
 	ret = (g_unlink(bo->path) == 0);
 	j_trace_file_end(bo->path, J_TRACE_FILE_DELETE, 0, 0);
 
-	g_hash_table_remove(files, bo->path);
+	shard->deletions++;
+
+	g_mutex_unlock(shard->mutex);
+
+	jd_backend_cache_release(bo);
 
 	return ret;
 }
@@ -243,14 +366,12 @@ static gboolean
 backend_close(gpointer backend_data, gpointer backend_object)
 {
 	JBackendObject* bo = backend_object;
-	GHashTable* files = jd_backend_files_get_thread();
-	gboolean ret;
 
 	(void)backend_data;
 
-	ret = g_hash_table_remove(files, bo->path);
+	jd_backend_cache_release(bo);
 
-	return ret;
+	return TRUE;
 }
 
 static gboolean
@@ -302,21 +423,52 @@ backend_sync(gpointer backend_data, gpointer backend_object)
 }
 
 static gboolean
-backend_read(gpointer backend_data, gpointer backend_object, gpointer buffer, guint64 length, guint64 offset, guint64* bytes_read)
+backend_allocate(gpointer backend_data, gpointer backend_object, guint64 size)
 {
-	JBackendObject* bo = backend_object;
+	gboolean ret = FALSE;
 
-	gsize nbytes_total = 0;
+	(void)backend_data;
+
+#ifdef HAVE_FALLOCATE
+	{
+		JBackendObject* bo = backend_object;
+
+		// Only reserve the space, the object's size is not changed
+		ret = (fallocate(bo->fd, FALLOC_FL_KEEP_SIZE, 0, size) == 0);
+	}
+#else
+	(void)backend_object;
+	(void)size;
+#endif
+
+	return ret;
+}
+
+static gboolean
+backend_truncate(gpointer backend_data, gpointer backend_object, guint64 size)
+{
+	JBackendObject* bo = backend_object;
+	gboolean ret;
 
 	(void)backend_data;
 
-	j_trace_file_begin(bo->path, J_TRACE_FILE_READ);
+	j_trace_file_begin(bo->path, J_TRACE_FILE_TRUNCATE);
+	ret = (ftruncate(bo->fd, size) == 0);
+	j_trace_file_end(bo->path, J_TRACE_FILE_TRUNCATE, 0, size);
+
+	return ret;
+}
+
+static gsize
+jd_backend_read_all(gint fd, gpointer buffer, guint64 length, guint64 offset)
+{
+	gsize nbytes_total = 0;
 
 	while (nbytes_total < length)
 	{
 		gssize nbytes;
 
-		nbytes = pread(bo->fd, (gchar*)buffer + nbytes_total, length - nbytes_total, offset + nbytes_total);
+		nbytes = pread(fd, (gchar*)buffer + nbytes_total, length - nbytes_total, offset + nbytes_total);
 
 		if (nbytes == 0)
 		{
@@ -328,107 +480,966 @@ backend_read(gpointer backend_data, gpointer backend_object, gpointer buffer, gu
 			{
 				break;
 			}
+
+			continue;
 		}
 
 		nbytes_total += nbytes;
 	}
 
-	j_trace_file_end(bo->path, J_TRACE_FILE_READ, nbytes_total, offset);
-
-	if (bytes_read != NULL)
-	{
-		*bytes_read = nbytes_total;
-	}
-
-	return (nbytes_total == length);
+	return nbytes_total;
 }
 
-static gboolean
-backend_write(gpointer backend_data, gpointer backend_object, gconstpointer buffer, guint64 length, guint64 offset, guint64* bytes_written)
+static gsize
+jd_backend_write_all(gint fd, gconstpointer buffer, guint64 length, guint64 offset)
 {
-	JBackendObject* bo = backend_object;
-
 	gsize nbytes_total = 0;
 
-	(void)backend_data;
-
-	j_trace_file_begin(bo->path, J_TRACE_FILE_WRITE);
-
 	while (nbytes_total < length)
 	{
 		gssize nbytes;
 
-		nbytes = pwrite(bo->fd, (gchar const*)buffer + nbytes_total, length - nbytes_total, offset + nbytes_total);
+		nbytes = pwrite(fd, (gchar const*)buffer + nbytes_total, length - nbytes_total, offset + nbytes_total);
 
 		if (nbytes <= 0)
 		{
-			if (errno != EINTR)
+			if (nbytes < 0 && errno == EINTR)
 			{
-				break;
+				continue;
 			}
+
+			break;
 		}
 
 		nbytes_total += nbytes;
 	}
 
-	j_trace_file_end(bo->path, J_TRACE_FILE_WRITE, nbytes_total, offset);
+	return nbytes_total;
+}
 
-	if (bytes_written != NULL)
+/*
+ * Direct I/O requires buffers, lengths and offsets to be aligned.
+ * Unaligned accesses are handled using an aligned bounce buffer that covers all affected blocks.
+ */
+#define J_POSIX_DIRECT_ALIGNMENT 4096
+
+static gboolean
+jd_backend_is_aligned(gconstpointer buffer, guint64 length, guint64 offset)
+{
+	return (GPOINTER_TO_SIZE(buffer) % J_POSIX_DIRECT_ALIGNMENT == 0 && length % J_POSIX_DIRECT_ALIGNMENT == 0 && offset % J_POSIX_DIRECT_ALIGNMENT == 0);
+}
+
+static gsize
+jd_backend_read_unaligned(gint fd, gpointer buffer, guint64 length, guint64 offset)
+{
+	g_autofree gchar* bounce = NULL;
+	guint64 head;
+	guint64 aligned_offset;
+	guint64 aligned_length;
+	gsize nbytes;
+
+	if (length == 0)
 	{
-		*bytes_written = nbytes_total;
+		return 0;
 	}
 
-	return (nbytes_total == length);
+	head = offset % J_POSIX_DIRECT_ALIGNMENT;
+	aligned_offset = offset - head;
+	aligned_length = (head + length + J_POSIX_DIRECT_ALIGNMENT - 1) / J_POSIX_DIRECT_ALIGNMENT * J_POSIX_DIRECT_ALIGNMENT;
+
+	bounce = j_helper_alloc_aligned(J_POSIX_DIRECT_ALIGNMENT, aligned_length);
+	nbytes = jd_backend_read_all(fd, bounce, aligned_length, aligned_offset);
+
+	if (nbytes <= head)
+	{
+		return 0;
+	}
+
+	nbytes = MIN(nbytes - head, length);
+	memcpy(buffer, bounce + head, nbytes);
+
+	return nbytes;
+}
+
+/*
+ * The object's lock has to be held exclusively, otherwise concurrent writes to the head or tail blocks might be lost.
+ */
+static gsize
+jd_backend_write_unaligned(gint fd, gconstpointer buffer, guint64 length, guint64 offset)
+{
+	g_autofree gchar* bounce = NULL;
+	struct stat buf;
+	guint64 head;
+	guint64 aligned_offset;
+	guint64 aligned_length;
+	gsize nbytes;
+
+	if (length == 0)
+	{
+		return 0;
+	}
+
+	head = offset % J_POSIX_DIRECT_ALIGNMENT;
+	aligned_offset = offset - head;
+	aligned_length = (head + length + J_POSIX_DIRECT_ALIGNMENT - 1) / J_POSIX_DIRECT_ALIGNMENT * J_POSIX_DIRECT_ALIGNMENT;
+
+	if (fstat(fd, &buf) != 0)
+	{
+		return 0;
+	}
+
+	bounce = j_helper_alloc_aligned(J_POSIX_DIRECT_ALIGNMENT, aligned_length);
+
+	// Read the partially overwritten head and tail blocks, blocks beyond the end of the object are zeroed
+	memset(bounce, 0, J_POSIX_DIRECT_ALIGNMENT);
+	memset(bounce + aligned_length - J_POSIX_DIRECT_ALIGNMENT, 0, J_POSIX_DIRECT_ALIGNMENT);
+
+	if (head > 0)
+	{
+		jd_backend_read_all(fd, bounce, J_POSIX_DIRECT_ALIGNMENT, aligned_offset);
+	}
+
+	if ((head + length) % J_POSIX_DIRECT_ALIGNMENT != 0 && (aligned_length > J_POSIX_DIRECT_ALIGNMENT || head == 0))
+	{
+		jd_backend_read_all(fd, bounce + aligned_length - J_POSIX_DIRECT_ALIGNMENT, J_POSIX_DIRECT_ALIGNMENT, aligned_offset + aligned_length - J_POSIX_DIRECT_ALIGNMENT);
+	}
+
+	memcpy(bounce + head, buffer, length);
+
+	nbytes = jd_backend_write_all(fd, bounce, aligned_length, aligned_offset);
+
+	if (nbytes <= head)
+	{
+		return 0;
+	}
+
+	// Writing whole blocks might have extended the object beyond the written data
+	if (aligned_offset + nbytes > (guint64)buf.st_size)
+	{
+		if (ftruncate(fd, MAX((guint64)buf.st_size, offset + length)) != 0)
+		{
+			return 0;
+		}
+	}
+
+	return MIN(nbytes - head, length);
 }
 
 static gboolean
-backend_init(gchar const* path, gpointer* backend_data)
+backend_read(gpointer backend_data, gpointer backend_object, gpointer buffer, guint64 length, guint64 offset, guint64* bytes_read)
 {
-	JBackendData* bd;
+	JBackendData* bd = backend_data;
+	JBackendObject* bo = backend_object;
 
-	bd = g_slice_new(JBackendData);
-	bd->path = g_strdup(path);
+	gsize nbytes_total;
 
-	jd_backend_file_cache = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, NULL);
+	j_trace_file_begin(bo->path, J_TRACE_FILE_READ);
 
-	g_mkdir_with_parents(path, 0700);
+	if (bd->direct && !jd_backend_is_aligned(buffer, length, offset))
+	{
+		nbytes_total = jd_backend_read_unaligned(bo->fd, buffer, length, offset);
+	}
+	else
+	{
+		nbytes_total = jd_backend_read_all(bo->fd, buffer, length, offset);
+	}
 
-	g_atomic_int_inc(&jd_num_backends);
+	j_trace_file_end(bo->path, J_TRACE_FILE_READ, nbytes_total, offset);
 
-	*backend_data = bd;
+	if (bytes_read != NULL)
+	{
+		*bytes_read = nbytes_total;
+	}
 
-	return TRUE;
+	return (nbytes_total == length);
 }
 
-static void
-backend_fini(gpointer backend_data)
+static gboolean
+backend_write(gpointer backend_data, gpointer backend_object, gconstpointer buffer, guint64 length, guint64 offset, guint64* bytes_written)
 {
 	JBackendData* bd = backend_data;
+	JBackendObject* bo = backend_object;
 
-	if (g_atomic_int_dec_and_test(&jd_num_backends))
+	gsize nbytes_total;
+
+	j_trace_file_begin(bo->path, J_TRACE_FILE_WRITE);
+
+	if (bd->direct && !jd_backend_is_aligned(buffer, length, offset))
+	{
+		g_rw_lock_writer_lock(bo->lock);
+		nbytes_total = jd_backend_write_unaligned(bo->fd, buffer, length, offset);
+		g_rw_lock_writer_unlock(bo->lock);
+	}
+	else if (bd->direct)
+	{
+		g_rw_lock_reader_lock(bo->lock);
+		nbytes_total = jd_backend_write_all(bo->fd, buffer, length, offset);
+		g_rw_lock_reader_unlock(bo->lock);
+	}
+	else
 	{
-		g_assert(g_hash_table_size(jd_backend_file_cache) == 0);
-		g_hash_table_destroy(jd_backend_file_cache);
+		nbytes_total = jd_backend_write_all(bo->fd, buffer, length, offset);
 	}
 
-	g_free(bd->path);
-	g_slice_free(JBackendData, bd);
+	j_trace_file_end(bo->path, J_TRACE_FILE_WRITE, nbytes_total, offset);
+
+	if (bytes_written != NULL)
+	{
+		*bytes_written = nbytes_total;
+	}
+
+	return (nbytes_total == length);
 }
 
-static JBackend posix_backend = {
-	.type = J_BACKEND_TYPE_OBJECT,
-	.component = J_BACKEND_COMPONENT_SERVER,
-	.object = {
-		.backend_init = backend_init,
-		.backend_fini = backend_fini,
-		.backend_create = backend_create,
+#ifdef HAVE_PWRITEV
+static gboolean
+backend_write_each(gpointer backend_data, gpointer backend_object, gconstpointer const* buffers, guint64 const* lengths, guint count, guint64 offset, guint64* bytes_written)
+{
+	gboolean ret = TRUE;
+
+	*bytes_written = 0;
+
+	for (guint i = 0; i < count && ret; i++)
+	{
+		guint64 nbytes = 0;
+
+		ret = backend_write(backend_data, backend_object, buffers[i], lengths[i], offset, &nbytes);
+
+		*bytes_written += nbytes;
+		offset += nbytes;
+	}
+
+	return ret;
+}
+
+/*
+ * The number of vectors passed to a single pwritev() call, IOV_MAX is 1024 on Linux.
+ */
+#define J_POSIX_VECTORS_MAX 1024
+
+static gboolean
+backend_writev(gpointer backend_data, gpointer backend_object, gconstpointer const* buffers, guint64 const* lengths, guint count, guint64 offset, guint64* bytes_written)
+{
+	JBackendData* bd = backend_data;
+	JBackendObject* bo = backend_object;
+
+	g_autofree struct iovec* iov = NULL;
+	guint iov_first = 0;
+	gsize length = 0;
+	gsize nbytes_total = 0;
+
+	iov = g_new(struct iovec, count);
+
+	for (guint i = 0; i < count; i++)
+	{
+		// Direct I/O requires every single buffer to be aligned
+		if (bd->direct && !jd_backend_is_aligned(buffers[i], lengths[i], offset + length))
+		{
+			return backend_write_each(backend_data, backend_object, buffers, lengths, count, offset, bytes_written);
+		}
+
+		iov[i].iov_base = (gpointer)buffers[i];
+		iov[i].iov_len = lengths[i];
+		length += lengths[i];
+	}
+
+	j_trace_file_begin(bo->path, J_TRACE_FILE_WRITE);
+
+	if (bd->direct)
+	{
+		g_rw_lock_reader_lock(bo->lock);
+	}
+
+	while (nbytes_total < length)
+	{
+		gssize nbytes;
+
+		nbytes = pwritev(bo->fd, iov + iov_first, MIN(count - iov_first, J_POSIX_VECTORS_MAX), offset + nbytes_total);
+
+		if (nbytes <= 0)
+		{
+			if (nbytes < 0 && errno == EINTR)
+			{
+				continue;
+			}
+
+			break;
+		}
+
+		nbytes_total += nbytes;
+
+		// Skip all completely written vectors and adjust the partially written one
+		while (iov_first < count && (gsize)nbytes >= iov[iov_first].iov_len)
+		{
+			nbytes -= iov[iov_first].iov_len;
+			iov_first++;
+		}
+
+		if (nbytes > 0)
+		{
+			iov[iov_first].iov_base = (gchar*)iov[iov_first].iov_base + nbytes;
+			iov[iov_first].iov_len -= nbytes;
+		}
+	}
+
+	if (bd->direct)
+	{
+		g_rw_lock_reader_unlock(bo->lock);
+	}
+
+	j_trace_file_end(bo->path, J_TRACE_FILE_WRITE, nbytes_total, offset);
+
+	if (bytes_written != NULL)
+	{
+		*bytes_written = nbytes_total;
+	}
+
+	return (nbytes_total == length);
+}
+#endif
+
+#ifdef HAVE_LIBURING
+/*
+ * If io_uring is available, batches are submitted using a ring per thread.
+ * This allows all operations of a message to be handled by the kernel concurrently.
+ * If the ring cannot be set up, batches are handled synchronously.
+ */
+
+#define J_POSIX_RING_ENTRIES 128
+
+struct JBackendRing
+{
+	struct io_uring ring;
+	gboolean initialized;
+
+	/**
+	 * The buffer registered with the ring, NULL if none.
+	 **/
+	gchar* buffer;
+	guint64 buffer_length;
+};
+
+typedef struct JBackendRing JBackendRing;
+
+static void
+jd_backend_ring_free(gpointer data)
+{
+	JBackendRing* ring = data;
+
+	if (ring->initialized)
+	{
+		io_uring_queue_exit(&(ring->ring));
+	}
+
+	g_slice_free(JBackendRing, ring);
+}
+
+static GPrivate jd_backend_ring = G_PRIVATE_INIT(jd_backend_ring_free);
+
+static JBackendRing*
+jd_backend_ring_get_thread(void)
+{
+	JBackendRing* ring;
+
+	ring = g_private_get(&jd_backend_ring);
+
+	if (G_UNLIKELY(ring == NULL))
+	{
+		gint ret;
+
+		ring = g_slice_new0(JBackendRing);
+
+		if ((ret = io_uring_queue_init(J_POSIX_RING_ENTRIES, &(ring->ring), 0)) == 0)
+		{
+			ring->initialized = TRUE;
+		}
+		else
+		{
+			g_debug("Could not set up io_uring, falling back to synchronous I/O: %s", g_strerror(-ret));
+		}
+
+		g_private_replace(&jd_backend_ring, ring);
+	}
+
+	return (ring->initialized) ? ring : NULL;
+}
+
+static gboolean
+jd_backend_ring_is_registered(JBackendRing* ring, gconstpointer buffer, guint64 length)
+{
+	gchar const* start = buffer;
+
+	return (ring->buffer != NULL && start >= ring->buffer && start + length <= ring->buffer + ring->buffer_length);
+}
+
+/*
+ * Sets up the ring again after it has failed.
+ * Entries that are still in the submission queue are discarded, which also unregisters the buffer.
+ * If the ring cannot be set up again, batches are handled synchronously from now on.
+ */
+static void
+jd_backend_ring_reset(JBackendRing* ring)
+{
+	gint ret;
+
+	io_uring_queue_exit(&(ring->ring));
+
+	ring->buffer = NULL;
+	ring->buffer_length = 0;
+
+	if ((ret = io_uring_queue_init(J_POSIX_RING_ENTRIES, &(ring->ring), 0)) != 0)
+	{
+		ring->initialized = FALSE;
+
+		g_critical("Could not set up io_uring again, falling back to synchronous I/O: %s", g_strerror(-ret));
+	}
+}
+
+/*
+ * Waits for a single completion and stores its result.
+ * Negative results of entries with data are stored as errors for the respective entry.
+ */
+static gint
+jd_backend_ring_reap(JBackendRing* ring, guint64* bytes, gint* errors, guint count, gint* result)
+{
+	struct io_uring_cqe* cqe;
+	guint index;
+	gint ret;
+
+	do
+	{
+		ret = io_uring_wait_cqe(&(ring->ring), &cqe);
+	} while (ret == -EINTR);
+
+	if (ret < 0)
+	{
+		return ret;
+	}
+
+	// Indices are shifted by one to distinguish entries without data
+	index = GPOINTER_TO_UINT(io_uring_cqe_get_data(cqe));
+
+	if (index == 0)
+	{
+		*result = cqe->res;
+	}
+	else if (index <= count && cqe->res >= 0)
+	{
+		bytes[index - 1] = cqe->res;
+	}
+	else if (index <= count)
+	{
+		errors[index - 1] = -cqe->res;
+	}
+
+	io_uring_cqe_seen(&(ring->ring), cqe);
+
+	return 0;
+}
+
+/*
+ * Submits all prepared entries and waits for their completion.
+ * The number of bytes transferred is stored in bytes and errors in errors, entries without data (such as fsync) store their result in result.
+ * If the ring fails, it is reset and entries that have not been completed are left untouched, so that they can be completed synchronously.
+ */
+static gboolean
+jd_backend_ring_complete(JBackendRing* ring, guint entries, guint64* bytes, gint* errors, guint count, gint* result)
+{
+	gboolean ret = TRUE;
+	guint submitted = 0;
+	guint completed = 0;
+
+	// Entries without data that do not complete have to be repeated
+	*result = -ECANCELED;
+
+	while (completed < entries)
+	{
+		gint err;
+
+		if (submitted < entries)
+		{
+			// The kernel might consume fewer entries than prepared, the remaining ones stay in the submission queue
+			err = io_uring_submit(&(ring->ring));
+
+			if (err > 0)
+			{
+				submitted += err;
+			}
+			else if (err != -EINTR && completed == submitted)
+			{
+				// Nothing is in flight, so resources will not become available by waiting
+				g_critical("Could not submit to io_uring: %s", g_strerror((err < 0) ? -err : EAGAIN));
+				ret = FALSE;
+				break;
+			}
+
+			if (completed == submitted)
+			{
+				continue;
+			}
+		}
+
+		if ((err = jd_backend_ring_reap(ring, bytes, errors, count, result)) < 0)
+		{
+			g_critical("Could not wait for io_uring: %s", g_strerror(-err));
+			ret = FALSE;
+			break;
+		}
+
+		completed++;
+	}
+
+	if (!ret)
+	{
+		gboolean drained = TRUE;
+
+		// In-flight entries might still access their buffers
+		while (completed < submitted)
+		{
+			if (jd_backend_ring_reap(ring, bytes, errors, count, result) < 0)
+			{
+				drained = FALSE;
+				break;
+			}
+
+			completed++;
+		}
+
+		// Entries left in the submission queue would otherwise be submitted with the next batch
+		if (!drained || submitted < entries)
+		{
+			jd_backend_ring_reset(ring);
+		}
+	}
+
+	return ret;
+}
+
+static gboolean
+backend_read_batch(gpointer backend_data, gpointer backend_object, gpointer const* buffers, guint64 const* lengths, guint64 const* offsets, guint count, guint64* bytes_read)
+{
+	JBackendData* bd = backend_data;
+	JBackendObject* bo = backend_object;
+	JBackendRing* ring;
+
+	g_autofree gint* errors = NULL;
+	gboolean ret = TRUE;
+	guint64 nbytes_total = 0;
+	guint submitted = 0;
+	gint result = 0;
+
+	for (guint i = 0; i < count; i++)
+	{
+		bytes_read[i] = 0;
+	}
+
+	if ((ring = jd_backend_ring_get_thread()) == NULL)
+	{
+		for (guint i = 0; i < count; i++)
+		{
+			ret = backend_read(backend_data, backend_object, buffers[i], lengths[i], offsets[i], bytes_read + i) && ret;
+		}
+
+		return ret;
+	}
+
+	errors = g_new0(gint, count);
+
+	j_trace_file_begin(bo->path, J_TRACE_FILE_READ);
+
+	while (submitted < count)
+	{
+		guint entries = 0;
+
+		while (submitted < count && entries < J_POSIX_RING_ENTRIES)
+		{
+			struct io_uring_sqe* sqe;
+			guint length;
+
+			// Unaligned operations are completed synchronously below
+			if (bd->direct && !jd_backend_is_aligned(buffers[submitted], lengths[submitted], offsets[submitted]))
+			{
+				submitted++;
+				continue;
+			}
+
+			sqe = io_uring_get_sqe(&(ring->ring));
+			// Longer operations are completed below
+			length = MIN(lengths[submitted], G_MAXINT);
+
+			if (jd_backend_ring_is_registered(ring, buffers[submitted], length))
+			{
+				io_uring_prep_read_fixed(sqe, bo->fd, buffers[submitted], length, offsets[submitted], 0);
+			}
+			else
+			{
+				io_uring_prep_read(sqe, bo->fd, buffers[submitted], length, offsets[submitted]);
+			}
+
+			io_uring_sqe_set_data(sqe, GUINT_TO_POINTER(submitted + 1));
+
+			submitted++;
+			entries++;
+		}
+
+		// Remaining operations are completed synchronously below
+		if (!jd_backend_ring_complete(ring, entries, bytes_read, errors, count, &result))
+		{
+			break;
+		}
+	}
+
+	// Complete short and unaligned reads synchronously, short reads usually indicate the end of the object
+	for (guint i = 0; i < count; i++)
+	{
+		if (errors[i] != 0)
+		{
+			ret = FALSE;
+		}
+		else if (bytes_read[i] < lengths[i])
+		{
+			guint64 nbytes = 0;
+
+			ret = backend_read(backend_data, backend_object, (gchar*)buffers[i] + bytes_read[i], lengths[i] - bytes_read[i], offsets[i] + bytes_read[i], &nbytes) && ret;
+			bytes_read[i] += nbytes;
+		}
+
+		nbytes_total += bytes_read[i];
+	}
+
+	j_trace_file_end(bo->path, J_TRACE_FILE_READ, nbytes_total, (count > 0) ? offsets[0] : 0);
+
+	return ret;
+}
+
+static gboolean
+backend_write_batch(gpointer backend_data, gpointer backend_object, gconstpointer const* buffers, guint64 const* lengths, guint64 const* offsets, guint count, gboolean sync, guint64* bytes_written)
+{
+	JBackendData* bd = backend_data;
+	JBackendObject* bo = backend_object;
+	JBackendRing* ring;
+
+	g_autofree gint* errors = NULL;
+	gboolean ret = TRUE;
+	gboolean synced = FALSE;
+	gboolean completed = TRUE;
+	guint64 nbytes_total = 0;
+	guint submitted = 0;
+	gint result = 0;
+
+	for (guint i = 0; i < count; i++)
+	{
+		bytes_written[i] = 0;
+	}
+
+	if ((ring = jd_backend_ring_get_thread()) == NULL)
+	{
+		for (guint i = 0; i < count; i++)
+		{
+			ret = backend_write(backend_data, backend_object, buffers[i], lengths[i], offsets[i], bytes_written + i) && ret;
+		}
+
+		if (sync)
+		{
+			ret = backend_sync(backend_data, backend_object) && ret;
+		}
+
+		return ret;
+	}
+
+	errors = g_new0(gint, count);
+
+	j_trace_file_begin(bo->path, J_TRACE_FILE_WRITE);
+
+	// Unaligned writes are completed below using backend_write, which takes the lock exclusively
+	if (bd->direct)
+	{
+		g_rw_lock_reader_lock(bo->lock);
+	}
+
+	while (submitted < count || (sync && !synced))
+	{
+		guint entries = 0;
+
+		// Leave room for the sync
+		while (submitted < count && entries < J_POSIX_RING_ENTRIES - 1)
+		{
+			struct io_uring_sqe* sqe;
+			guint length;
+
+			// Unaligned operations are completed synchronously below
+			if (bd->direct && !jd_backend_is_aligned(buffers[submitted], lengths[submitted], offsets[submitted]))
+			{
+				submitted++;
+				continue;
+			}
+
+			sqe = io_uring_get_sqe(&(ring->ring));
+			// Longer operations are completed below
+			length = MIN(lengths[submitted], G_MAXINT);
+
+			if (jd_backend_ring_is_registered(ring, buffers[submitted], length))
+			{
+				io_uring_prep_write_fixed(sqe, bo->fd, buffers[submitted], length, offsets[submitted], 0);
+			}
+			else
+			{
+				io_uring_prep_write(sqe, bo->fd, buffers[submitted], length, offsets[submitted]);
+			}
+
+			io_uring_sqe_set_data(sqe, GUINT_TO_POINTER(submitted + 1));
+
+			submitted++;
+			entries++;
+		}
+
+		if (sync && submitted == count)
+		{
+			struct io_uring_sqe* sqe;
+
+			sqe = io_uring_get_sqe(&(ring->ring));
+			io_uring_prep_fsync(sqe, bo->fd, 0);
+			// Draining waits for all previous writes without serializing them like links would
+			io_uring_sqe_set_flags(sqe, IOSQE_IO_DRAIN);
+			io_uring_sqe_set_data(sqe, NULL);
+
+			entries++;
+			synced = TRUE;
+		}
+
+		// Remaining operations are completed synchronously below
+		if (!jd_backend_ring_complete(ring, entries, bytes_written, errors, count, &result))
+		{
+			break;
+		}
+	}
+
+	if (bd->direct)
+	{
+		g_rw_lock_reader_unlock(bo->lock);
+	}
+
+	for (guint i = 0; i < count; i++)
+	{
+		if (errors[i] != 0)
+		{
+			ret = FALSE;
+		}
+		else if (bytes_written[i] < lengths[i])
+		{
+			guint64 nbytes = 0;
+
+			ret = backend_write(backend_data, backend_object, (gchar const*)buffers[i] + bytes_written[i], lengths[i] - bytes_written[i], offsets[i] + bytes_written[i], &nbytes) && ret;
+			bytes_written[i] += nbytes;
+
+			completed = FALSE;
+		}
+
+		nbytes_total += bytes_written[i];
+	}
+
+	j_trace_file_end(bo->path, J_TRACE_FILE_WRITE, nbytes_total, (count > 0) ? offsets[0] : 0);
+
+	// The sync has to be repeated if it failed or writes had to be completed afterwards
+	if (sync && (!synced || result < 0 || !completed))
+	{
+		ret = backend_sync(backend_data, backend_object) && ret;
+	}
+
+	return ret;
+}
+
+static gboolean
+backend_register_buffer(gpointer backend_data, gpointer buffer, guint64 length)
+{
+	JBackendRing* ring;
+	struct iovec iov;
+
+	(void)backend_data;
+
+	if ((ring = jd_backend_ring_get_thread()) == NULL)
+	{
+		return FALSE;
+	}
+
+	if (ring->buffer != NULL)
+	{
+		io_uring_unregister_buffers(&(ring->ring));
+		ring->buffer = NULL;
+		ring->buffer_length = 0;
+	}
+
+	iov.iov_base = buffer;
+	iov.iov_len = length;
+
+	// Registering might fail because of RLIMIT_MEMLOCK, unregistered buffers still work
+	if (io_uring_register_buffers(&(ring->ring), &iov, 1) != 0)
+	{
+		return FALSE;
+	}
+
+	ring->buffer = buffer;
+	ring->buffer_length = length;
+
+	return TRUE;
+}
+
+static void
+backend_unregister_buffer(gpointer backend_data, gpointer buffer)
+{
+	JBackendRing* ring;
+
+	(void)backend_data;
+
+	// Do not create a ring if there is none, for instance, because it has already been freed on thread exit
+	ring = g_private_get(&jd_backend_ring);
+
+	if (ring == NULL || !ring->initialized || ring->buffer != buffer)
+	{
+		return;
+	}
+
+	io_uring_unregister_buffers(&(ring->ring));
+	ring->buffer = NULL;
+	ring->buffer_length = 0;
+}
+#endif
+
+static void
+backend_statistics(gpointer backend_data, JStatistics* statistics)
+{
+	(void)backend_data;
+
+	for (guint i = 0; i < J_POSIX_CACHE_SHARDS; i++)
+	{
+		JBackendCacheShard* shard = &(jd_backend_cache[i]);
+
+		g_mutex_lock(shard->mutex);
+
+		j_statistics_add(statistics, J_STATISTICS_HANDLE_CACHE_HITS, shard->hits);
+		j_statistics_add(statistics, J_STATISTICS_HANDLE_CACHE_MISSES, shard->misses);
+
+		shard->hits = 0;
+		shard->misses = 0;
+
+		g_mutex_unlock(shard->mutex);
+	}
+}
+
+static gboolean
+backend_init(gchar const* path, gpointer* backend_data)
+{
+	JBackendData* bd;
+	g_auto(GStrv) split = NULL;
+
+	g_return_val_if_fail(path != NULL, FALSE);
+
+	/* Path syntax: [path](:[option])*
+	   e.g.: /var/lib/julea:direct:max-fds=4096 */
+	split = g_strsplit(path, ":", 0);
+
+	bd = g_slice_new(JBackendData);
+	bd->path = g_strdup(split[0]);
+	bd->direct = FALSE;
+
+	for (guint i = 1; split[i] != NULL; i++)
+	{
+		if (g_strcmp0(split[i], "direct") == 0)
+		{
+			bd->direct = TRUE;
+		}
+		else if (g_str_has_prefix(split[i], "max-fds="))
+		{
+			guint64 max_fds;
+
+			max_fds = g_ascii_strtoull(split[i] + strlen("max-fds="), NULL, 10);
+			jd_backend_cache_shard_max = MAX(max_fds / J_POSIX_CACHE_SHARDS, 1);
+		}
+		else
+		{
+			g_warning("Unknown option %s", split[i]);
+		}
+	}
+
+	g_mkdir_with_parents(bd->path, 0700);
+
+	if (g_atomic_int_add(&jd_num_backends, 1) == 0)
+	{
+		for (guint i = 0; i < J_POSIX_CACHE_SHARDS; i++)
+		{
+			JBackendCacheShard* shard = &(jd_backend_cache[i]);
+
+			g_mutex_init(shard->mutex);
+			shard->objects = g_hash_table_new(g_str_hash, g_str_equal);
+			g_queue_init(shard->lru);
+			shard->deletions = 0;
+			shard->hits = 0;
+			shard->misses = 0;
+		}
+	}
+
+	*backend_data = bd;
+
+	return TRUE;
+}
+
+static void
+backend_fini(gpointer backend_data)
+{
+	JBackendData* bd = backend_data;
+
+	if (g_atomic_int_dec_and_test(&jd_num_backends))
+	{
+		for (guint i = 0; i < J_POSIX_CACHE_SHARDS; i++)
+		{
+			JBackendCacheShard* shard = &(jd_backend_cache[i]);
+			GList* link;
+
+			while ((link = g_queue_pop_head_link(shard->lru)) != NULL)
+			{
+				JBackendObject* bo = link->data;
+
+				g_hash_table_remove(shard->objects, bo->path);
+				jd_backend_object_free(bo);
+			}
+
+			g_assert(g_hash_table_size(shard->objects) == 0);
+			g_hash_table_destroy(shard->objects);
+			g_mutex_clear(shard->mutex);
+		}
+	}
+
+	g_free(bd->path);
+	g_slice_free(JBackendData, bd);
+}
+
+static JBackend posix_backend = {
+	.type = J_BACKEND_TYPE_OBJECT,
+	.component = J_BACKEND_COMPONENT_SERVER,
+	.object = {
+		.backend_init = backend_init,
+		.backend_fini = backend_fini,
+		.backend_create = backend_create,
 		.backend_delete = backend_delete,
 		.backend_open = backend_open,
 		.backend_close = backend_close,
 		.backend_status = backend_status,
 		.backend_sync = backend_sync,
+		.backend_allocate = backend_allocate,
+		.backend_truncate = backend_truncate,
 		.backend_read = backend_read,
-		.backend_write = backend_write }
+		.backend_write = backend_write,
+#ifdef HAVE_PWRITEV
+		.backend_writev = backend_writev,
+#endif
+#ifdef HAVE_LIBURING
+		.backend_read_batch = backend_read_batch,
+		.backend_write_batch = backend_write_batch,
+		.backend_register_buffer = backend_register_buffer,
+		.backend_unregister_buffer = backend_unregister_buffer,
+#endif
+		.backend_statistics = backend_statistics,
+	}
 };
 
 G_MODULE_EXPORT
@@ -163,6 +163,20 @@ backend_sync(gpointer backend_data, gpointer backend_object)
 	return TRUE;
 }
 
+static gboolean
+backend_truncate(gpointer backend_data, gpointer backend_object, guint64 size)
+{
+	JBackendData* bd = backend_data;
+	JBackendObject* bo = backend_object;
+	gint ret;
+
+	j_trace_file_begin(bo->path, J_TRACE_FILE_TRUNCATE);
+	ret = rados_trunc(bd->backend_io, bo->path, size);
+	j_trace_file_end(bo->path, J_TRACE_FILE_TRUNCATE, 0, size);
+
+	return (ret == 0);
+}
+
 static gboolean
 backend_read(gpointer backend_data, gpointer backend_object, gpointer buffer, guint64 length, guint64 offset, guint64* bytes_read)
 {
@@ -283,6 +297,7 @@ static JBackend rados_backend = {
 		.backend_close = backend_close,
 		.backend_status = backend_status,
 		.backend_sync = backend_sync,
+		.backend_truncate = backend_truncate,
 		.backend_read = backend_read,
 		.backend_write = backend_write }
 };
@@ -19,6 +19,10 @@
 #include <julea-config.h>
 
 #include <glib.h>
+#include <gio/gio.h>
+
+#include <sys/socket.h>
+#include <unistd.h>
 
 #include <julea.h>
 
@@ -114,6 +118,124 @@ benchmark_message_add_operation_large(BenchmarkRun* run)
 	_benchmark_message_add_operation(run, TRUE);
 }
 
+static gpointer
+benchmark_message_sink(gpointer data)
+{
+	gint fd = GPOINTER_TO_INT(data);
+	g_autofree gchar* buf = NULL;
+
+	buf = g_malloc(1024 * 1024);
+
+	while (read(fd, buf, 1024 * 1024) > 0)
+	{
+	}
+
+	return NULL;
+}
+
+/**
+ * Sends messages with the given number of stripes via a local socket.
+ * Writing uses one write call per buffer, while sending gathers all buffers into as few sendmsg calls as possible.
+ * Running the benchmark using strace -c shows the number of system calls per message.
+ **/
+static void
+_benchmark_message_send(BenchmarkRun* run, gboolean vectored, guint stripes, guint64 stripe_size)
+{
+	guint const n = (stripes > 1) ? 100 : 10000;
+
+	g_autoptr(GSocket) socket_ = NULL;
+	g_autoptr(GSocketConnection) connection = NULL;
+	g_autofree gchar* buf = NULL;
+	GOutputStream* output;
+	GThread* thread;
+	gint fds[2];
+
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+	{
+		return;
+	}
+
+	socket_ = g_socket_new_from_fd(fds[0], NULL);
+	connection = g_socket_connection_factory_create_connection(socket_);
+	output = g_io_stream_get_output_stream(G_IO_STREAM(connection));
+	thread = g_thread_new("benchmark-message-sink", benchmark_message_sink, GINT_TO_POINTER(fds[1]));
+	buf = g_malloc0(stripe_size);
+
+	j_benchmark_timer_start(run);
+
+	while (j_benchmark_iterate(run))
+	{
+		for (guint i = 0; i < n; i++)
+		{
+			g_autoptr(JMessage) message = NULL;
+
+			message = j_message_new(J_MESSAGE_OBJECT_WRITE, 0);
+
+			for (guint j = 0; j < stripes; j++)
+			{
+				j_message_add_operation(message, sizeof(guint64));
+				j_message_append_8(message, &stripe_size);
+				j_message_add_send(message, buf, stripe_size);
+			}
+
+			if (vectored)
+			{
+				j_message_send(message, connection);
+			}
+			else
+			{
+				j_message_write(message, output);
+			}
+		}
+	}
+
+	j_benchmark_timer_stop(run);
+
+	// Closing the connection makes the sink thread terminate.
+	g_io_stream_close(G_IO_STREAM(connection), NULL, NULL);
+	g_thread_join(thread);
+	close(fds[1]);
+
+	run->operations = n;
+	run->bytes = n * stripes * stripe_size;
+}
+
+static void
+benchmark_message_write_small(BenchmarkRun* run)
+{
+	_benchmark_message_send(run, FALSE, 1, 4 * 1024);
+}
+
+static void
+benchmark_message_send_small(BenchmarkRun* run)
+{
+	_benchmark_message_send(run, TRUE, 1, 4 * 1024);
+}
+
+static void
+benchmark_message_write_many(BenchmarkRun* run)
+{
+	_benchmark_message_send(run, FALSE, 256, 4 * 1024);
+}
+
+static void
+benchmark_message_send_many(BenchmarkRun* run)
+{
+	_benchmark_message_send(run, TRUE, 256, 4 * 1024);
+}
+
+static void
+benchmark_message_write_large(BenchmarkRun* run)
+{
+	_benchmark_message_send(run, FALSE, 16, 1024 * 1024);
+}
+
+static void
+benchmark_message_send_large(BenchmarkRun* run)
+{
+	_benchmark_message_send(run, TRUE, 16, 1024 * 1024);
+}
+
 void
 benchmark_message(void)
 {
@@ -121,4 +243,10 @@ benchmark_message(void)
 	j_benchmark_add("/message/new-append", benchmark_message_new_append);
 	j_benchmark_add("/message/add-operation-small", benchmark_message_add_operation_small);
 	j_benchmark_add("/message/add-operation-large", benchmark_message_add_operation_large);
+	j_benchmark_add("/message/write-small", benchmark_message_write_small);
+	j_benchmark_add("/message/send-small", benchmark_message_send_small);
+	j_benchmark_add("/message/write-many", benchmark_message_write_many);
+	j_benchmark_add("/message/send-many", benchmark_message_send_many);
+	j_benchmark_add("/message/write-large", benchmark_message_write_large);
+	j_benchmark_add("/message/send-large", benchmark_message_send_large);
 }
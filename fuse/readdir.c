@@ -43,29 +43,26 @@ jfs_readdir(char const* path, void* buf, fuse_fill_dir_t filler, off_t offset, s
 		prefix = g_strdup_printf("%s/", path);
 	}
 
-	it = j_kv_iterator_new("posix", prefix);
+	// The names are part of the keys, so the values do not have to be transferred
+	it = j_kv_iterator_new_keys("posix", prefix);
 
 	while (j_kv_iterator_next(it))
 	{
 		gconstpointer value;
+		gchar const* key;
+		gchar const* name;
 		guint32 len;
-		bson_t tmp[1];
-		bson_iter_t iter;
 
-		j_kv_iterator_get(it, &value, &len);
-		bson_init_static(tmp, value, len);
+		key = j_kv_iterator_get(it, &value, &len);
+		name = key + strlen(prefix);
 
-		if (bson_iter_init_find(&iter, tmp, "name") && bson_iter_type(&iter) == BSON_TYPE_UTF8)
+		// Skip entries of subdirectories
+		if (name[0] == '\0' || strchr(name, '/') != NULL)
 		{
-			gchar const* name;
-
-			name = bson_iter_utf8(&iter, NULL);
-			filler(buf, name, NULL, 0);
-		}
-		else
-		{
-			filler(buf, "???", NULL, 0);
+			continue;
 		}
+
+		filler(buf, name, NULL, 0);
 	}
 
 	j_kv_iterator_free(it);
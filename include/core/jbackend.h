@@ -35,6 +35,7 @@
 #include <bson.h>
 
 #include <core/jsemantics.h>
+#include <core/jstatistics.h>
 
 G_BEGIN_DECLS
 
@@ -146,6 +147,56 @@ struct JBackend
 
 			gboolean (*backend_read)(gpointer, gpointer, gpointer, guint64, guint64, guint64*);
 			gboolean (*backend_write)(gpointer, gpointer, gconstpointer, guint64, guint64, guint64*);
+
+			/**
+			 * Reserves space for the given size without changing the object's size.
+			 * This function is optional.
+			 **/
+			gboolean (*backend_allocate)(gpointer, gpointer, guint64);
+
+			/**
+			 * Changes the object's size.
+			 * This function is optional, objects cannot be truncated if it is not provided.
+			 **/
+			gboolean (*backend_truncate)(gpointer, gpointer, guint64);
+
+			/**
+			 * Writes multiple buffers to consecutive ranges starting at the given offset.
+			 * This function is optional, backends that do not provide it are emulated using backend_write.
+			 **/
+			gboolean (*backend_writev)(gpointer, gpointer, gconstpointer const*, guint64 const*, guint, guint64, guint64*);
+
+			/**
+			 * Reads multiple buffers from arbitrary offsets, the number of bytes read is returned per buffer.
+			 * This function is optional, backends that do not provide it are emulated using backend_read.
+			 **/
+			gboolean (*backend_read_batch)(gpointer, gpointer, gpointer const*, guint64 const*, guint64 const*, guint, guint64*);
+
+			/**
+			 * Writes multiple buffers to arbitrary offsets, the number of bytes written is returned per buffer.
+			 * If requested, the object is synced after all buffers have been written.
+			 * This function is optional, backends that do not provide it are emulated using backend_writev, backend_write and backend_sync.
+			 **/
+			gboolean (*backend_write_batch)(gpointer, gpointer, gconstpointer const*, guint64 const*, guint64 const*, guint, gboolean, guint64*);
+
+			/**
+			 * Registers a buffer that will be used for batches issued by the calling thread.
+			 * This function is optional.
+			 **/
+			gboolean (*backend_register_buffer)(gpointer, gpointer, guint64);
+
+			/**
+			 * Unregisters a buffer previously registered by the calling thread.
+			 * Must be called before the buffer is freed.
+			 * This function is optional.
+			 **/
+			void (*backend_unregister_buffer)(gpointer, gpointer);
+
+			/**
+			 * Adds the statistics collected since the last call to the given statistics.
+			 * This function is optional.
+			 **/
+			void (*backend_statistics)(gpointer, JStatistics*);
 		} object;
 
 		struct
@@ -160,6 +211,21 @@ struct JBackend
 			gboolean (*backend_delete)(gpointer, gpointer, gchar const*);
 			gboolean (*backend_get)(gpointer, gpointer, gchar const*, gpointer*, guint32*);
 
+			/**
+			 * Gets a value without copying it.
+			 * The value is only valid until the batch has been executed.
+			 * This function is optional.
+			 **/
+			gboolean (*backend_get_static)(gpointer, gpointer, gchar const*, gconstpointer*, guint32*);
+
+			/**
+			 * Gets multiple values at once.
+			 * Values of keys that do not exist are set to NULL.
+			 * The values are owned by the backend and only valid until the batch has been executed.
+			 * This function is optional.
+			 **/
+			gboolean (*backend_get_many)(gpointer, gpointer, gchar const* const*, guint32, gconstpointer*, guint32*);
+
 			gboolean (*backend_get_all)(gpointer, gchar const*, gpointer*);
 			gboolean (*backend_get_by_prefix)(gpointer, gchar const*, gchar const*, gpointer*);
 			gboolean (*backend_iterate)(gpointer, gpointer, gchar const**, gconstpointer*, guint32*);
@@ -398,6 +464,18 @@ gboolean j_backend_object_sync(JBackend*, gpointer);
 
 gboolean j_backend_object_read(JBackend*, gpointer, gpointer, guint64, guint64, guint64*);
 gboolean j_backend_object_write(JBackend*, gpointer, gconstpointer, guint64, guint64, guint64*);
+gboolean j_backend_object_allocate(JBackend*, gpointer, guint64);
+gboolean j_backend_object_truncate(JBackend*, gpointer, guint64);
+
+gboolean j_backend_object_writev(JBackend*, gpointer, gconstpointer const*, guint64 const*, guint, guint64, guint64*);
+
+gboolean j_backend_object_read_batch(JBackend*, gpointer, gpointer const*, guint64 const*, guint64 const*, guint, guint64*);
+gboolean j_backend_object_write_batch(JBackend*, gpointer, gconstpointer const*, guint64 const*, guint64 const*, guint, gboolean, guint64*);
+
+gboolean j_backend_object_register_buffer(JBackend*, gpointer, guint64);
+void j_backend_object_unregister_buffer(JBackend*, gpointer);
+
+void j_backend_object_statistics(JBackend*, JStatistics*);
 
 gboolean j_backend_kv_init(JBackend*, gchar const*);
 void j_backend_kv_fini(JBackend*);
@@ -409,6 +487,10 @@ gboolean j_backend_kv_put(JBackend*, gpointer, gchar const*, gconstpointer, guin
 gboolean j_backend_kv_delete(JBackend*, gpointer, gchar const*);
 gboolean j_backend_kv_get(JBackend*, gpointer, gchar const*, gpointer*, guint32*);
 
+gboolean j_backend_kv_get_static(JBackend*, gpointer, gchar const*, gconstpointer*, guint32*);
+gboolean j_backend_kv_has_get_static(JBackend*);
+gboolean j_backend_kv_get_many(JBackend*, gpointer, gchar const* const*, guint32, gconstpointer*, guint32*);
+gboolean j_backend_kv_has_get_many(JBackend*);
 gboolean j_backend_kv_get_all(JBackend*, gchar const*, gpointer*);
 gboolean j_backend_kv_get_by_prefix(JBackend*, gchar const*, gchar const*, gpointer*);
 gboolean j_backend_kv_iterate(JBackend*, gpointer, gchar const**, gconstpointer*, guint32*);
@@ -33,6 +33,9 @@
 
 G_BEGIN_DECLS
 
+G_GNUC_INTERNAL void j_batch_init(guint);
+G_GNUC_INTERNAL void j_batch_fini(void);
+
 G_GNUC_INTERNAL JBatch* j_batch_new_from_batch(JBatch*);
 
 G_GNUC_INTERNAL JList* j_batch_get_operations(JBatch*);
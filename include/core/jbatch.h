@@ -35,6 +35,10 @@ struct JBatch;
 
 typedef struct JBatch JBatch;
 
+struct JBatchQueue;
+
+typedef struct JBatchQueue JBatchQueue;
+
 typedef void (*JBatchAsyncCallback)(JBatch*, gboolean, gpointer);
 
 G_END_DECLS
@@ -60,6 +64,18 @@ gboolean j_batch_execute(JBatch*) G_GNUC_WARN_UNUSED_RESULT;
 void j_batch_execute_async(JBatch*, JBatchAsyncCallback, gpointer);
 void j_batch_wait(JBatch*);
 
+JBatchQueue* j_batch_queue_new(void);
+JBatchQueue* j_batch_queue_ref(JBatchQueue*);
+void j_batch_queue_unref(JBatchQueue*);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(JBatchQueue, j_batch_queue_unref)
+
+void j_batch_execute_queue(JBatch*, JBatchQueue*);
+
+guint j_batch_queue_get_pending(JBatchQueue*);
+JBatch* j_batch_queue_poll(JBatchQueue*, gboolean*) G_GNUC_WARN_UNUSED_RESULT;
+JBatch* j_batch_queue_wait(JBatchQueue*, gboolean*) G_GNUC_WARN_UNUSED_RESULT;
+
 G_END_DECLS
 
 #endif
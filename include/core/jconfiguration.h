@@ -49,14 +49,26 @@ G_DEFINE_AUTOPTR_CLEANUP_FUNC(JConfiguration, j_configuration_unref)
 
 gchar const* j_configuration_get_server(JConfiguration*, JBackendType, guint32);
 guint32 j_configuration_get_server_count(JConfiguration*, JBackendType);
+guint32 j_configuration_get_server_weight(JConfiguration*, JBackendType, guint32);
 
 gchar const* j_configuration_get_backend(JConfiguration*, JBackendType);
 gchar const* j_configuration_get_backend_component(JConfiguration*, JBackendType);
 gchar const* j_configuration_get_backend_path(JConfiguration*, JBackendType);
 
 guint64 j_configuration_get_max_operation_size(JConfiguration*);
+gboolean j_configuration_get_zerocopy(JConfiguration*);
 guint32 j_configuration_get_max_connections(JConfiguration*);
 guint64 j_configuration_get_stripe_size(JConfiguration*);
+gboolean j_configuration_get_multiplex(JConfiguration*);
+guint64 j_configuration_get_read_ahead(JConfiguration*);
+guint64 j_configuration_get_write_behind(JConfiguration*);
+guint32 j_configuration_get_connection_warm_up(JConfiguration*);
+guint32 j_configuration_get_connection_idle_timeout(JConfiguration*);
+gchar const* j_configuration_get_fabric_provider(JConfiguration*);
+gchar const* j_configuration_get_placement(JConfiguration*);
+guint32 j_configuration_get_placement_virtual_nodes(JConfiguration*);
+guint32 j_configuration_get_db_page_size(JConfiguration*);
+guint32 j_configuration_get_kv_page_size(JConfiguration*);
 
 G_END_DECLS
 
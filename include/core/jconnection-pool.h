@@ -31,12 +31,18 @@
 #include <gio/gio.h>
 
 #include <core/jbackend.h>
+#include <core/jmessage.h>
+#include <core/jstatistics.h>
 
 G_BEGIN_DECLS
 
 gpointer j_connection_pool_pop(JBackendType, guint);
 void j_connection_pool_push(JBackendType, guint, gpointer);
 
+gboolean j_connection_pool_send_receive(JBackendType, guint, JMessage*, JMessage*);
+
+JStatistics* j_connection_pool_get_statistics(JBackendType, guint);
+
 G_END_DECLS
 
 #endif
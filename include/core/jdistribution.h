@@ -66,6 +66,7 @@ bson_t* j_distribution_serialize(JDistribution*);
 void j_distribution_set_block_size(JDistribution*, guint64);
 void j_distribution_set(JDistribution*, gchar const*, guint64);
 void j_distribution_set2(JDistribution*, gchar const*, guint64, guint64);
+void j_distribution_set_start_key(JDistribution*, gchar const*);
 
 void j_distribution_reset(JDistribution*, guint64, guint64);
 gboolean j_distribution_distribute(JDistribution*, guint*, guint64*, guint64*, guint64*);
@@ -0,0 +1,80 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2020 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ **/
+
+#ifndef JULEA_FABRIC_H
+#define JULEA_FABRIC_H
+
+#if !defined(JULEA_H) && !defined(JULEA_COMPILATION)
+#error "Only <julea.h> can be included directly."
+#endif
+
+#include <glib.h>
+
+#include <core/jconfiguration.h>
+#include <core/jmessage.h>
+
+G_BEGIN_DECLS
+
+/**
+ * The accesses peers are allowed to perform on a region.
+ **/
+enum JFabricAccess
+{
+	/**
+	 * Peers can read the region, used for data that is written to an object.
+	 **/
+	J_FABRIC_ACCESS_READ,
+	/**
+	 * Peers can write the region, used for data that is read from an object.
+	 **/
+	J_FABRIC_ACCESS_WRITE
+};
+
+typedef enum JFabricAccess JFabricAccess;
+
+struct JFabricRegion;
+
+typedef struct JFabricRegion JFabricRegion;
+
+gboolean j_fabric_init(JConfiguration*);
+void j_fabric_fini(void);
+
+gboolean j_fabric_is_enabled(void);
+
+gsize j_fabric_get_address_length(void);
+void j_fabric_append_address(JMessage*);
+
+JFabricRegion* j_fabric_region_new(gpointer, guint64, JFabricAccess);
+void j_fabric_region_free(JFabricRegion*);
+
+void j_fabric_region_append(JFabricRegion*, JMessage*);
+
+gboolean j_fabric_register_buffer(gpointer, guint64);
+void j_fabric_deregister_buffer(gpointer);
+
+gboolean j_fabric_get_peer(JMessage*, guint64*);
+gboolean j_fabric_read(guint64, gpointer, guint64, guint64, guint64);
+gboolean j_fabric_write(guint64, gconstpointer, guint64, guint64, guint64);
+
+G_END_DECLS
+
+#endif
@@ -35,6 +35,7 @@ G_BEGIN_DECLS
 G_GNUC_INTERNAL void j_helper_get_number_string(gchar*, guint32, guint32);
 // FIXME get rid of GSocketConnection
 G_GNUC_INTERNAL void j_helper_set_cork(GSocketConnection*, gboolean);
+G_GNUC_INTERNAL gboolean j_helper_is_local_host(gchar const*);
 
 G_END_DECLS
 
@@ -40,6 +40,7 @@ guint32 j_helper_hash(gchar const*);
 // FIXME get rid of GSocketConnection
 void j_helper_set_nodelay(GSocketConnection*, gboolean);
 gchar* j_helper_str_replace(gchar const*, gchar const*, gchar const*);
+gchar* j_helper_get_local_socket_path(guint16);
 gpointer j_helper_alloc_aligned(gsize, gsize);
 
 G_END_DECLS
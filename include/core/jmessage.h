@@ -54,7 +54,16 @@ enum JMessageType
 	J_MESSAGE_DB_INSERT,
 	J_MESSAGE_DB_UPDATE,
 	J_MESSAGE_DB_DELETE,
-	J_MESSAGE_DB_QUERY
+	J_MESSAGE_DB_QUERY,
+	J_MESSAGE_OBJECT_READ_RMA,
+	J_MESSAGE_OBJECT_WRITE_RMA,
+	J_MESSAGE_DB_CURSOR_OPEN,
+	J_MESSAGE_DB_CURSOR_FETCH,
+	J_MESSAGE_DB_CURSOR_CLOSE,
+	J_MESSAGE_KV_CURSOR_OPEN,
+	J_MESSAGE_KV_CURSOR_FETCH,
+	J_MESSAGE_KV_CURSOR_CLOSE,
+	J_MESSAGE_OBJECT_TRUNCATE
 };
 
 typedef enum JMessageType JMessageType;
@@ -63,6 +72,8 @@ struct JMessage;
 
 typedef struct JMessage JMessage;
 
+typedef JMessage* (*JMessageLookupFunc)(guint32, gpointer);
+
 G_END_DECLS
 
 #include <core/jsemantics.h>
@@ -78,6 +89,10 @@ G_DEFINE_AUTOPTR_CLEANUP_FUNC(JMessage, j_message_unref)
 
 JMessageType j_message_get_type(JMessage const*);
 guint32 j_message_get_count(JMessage const*);
+guint32 j_message_get_id(JMessage const*);
+
+void j_message_set_multiplexed(JMessage*);
+gboolean j_message_get_multiplexed(JMessage const*);
 
 gboolean j_message_append_1(JMessage*, gconstpointer);
 gboolean j_message_append_4(JMessage*, gconstpointer);
@@ -93,8 +108,13 @@ gchar const* j_message_get_string(JMessage*);
 
 gboolean j_message_send(JMessage*, gpointer);
 gboolean j_message_receive(JMessage*, gpointer);
+gboolean j_message_receive_nonblocking(JMessage*, gpointer, gboolean*);
+
+void j_message_share_connection(gpointer);
+gboolean j_message_enable_zerocopy(gpointer);
 
 gboolean j_message_read(JMessage*, GInputStream*);
+gboolean j_message_read_multiplexed(GInputStream*, JMessageLookupFunc, gpointer, JMessage**);
 gboolean j_message_write(JMessage*, GOutputStream*);
 
 void j_message_add_send(JMessage*, gconstpointer, guint64);
@@ -36,23 +36,45 @@ G_BEGIN_DECLS
 
 typedef gboolean (*JOperationExecFunc)(JList*, JSemantics*);
 typedef void (*JOperationFreeFunc)(gpointer);
+typedef guint64 (*JOperationCacheSizeFunc)(gpointer);
+typedef void (*JOperationCacheFunc)(gpointer, gpointer);
 
 /**
  * An operation.
  **/
 struct JOperation
 {
+	/**
+	 * A string identifying the data the operation accesses, such as an object's namespace and name.
+	 * Operations with equal keys are considered dependent and only operations with equal keys are combined.
+	 **/
 	gconstpointer key;
 	gpointer data;
 
 	JOperationExecFunc exec_func;
 	JOperationFreeFunc free_func;
+
+	/**
+	 * Prepares the operation for being executed in the background by the operation cache.
+	 * It receives a buffer of the size returned by #cache_size_func, has to copy the caller's data into it and report the operation as done.
+	 * Operations without a cache function are never cached.
+	 **/
+	JOperationCacheFunc cache_func;
+
+	/**
+	 * Returns the number of bytes #cache_func needs to copy the caller's data, can be NULL.
+	 **/
+	JOperationCacheSizeFunc cache_size_func;
 };
 
 typedef struct JOperation JOperation;
 
 JOperation* j_operation_new(void);
 
+void j_operation_cache_noop(gpointer, gpointer);
+
+void j_operation_cache_wait(void);
+
 G_END_DECLS
 
 #endif
@@ -40,7 +40,13 @@ enum JStatisticsType
 	J_STATISTICS_BYTES_READ,
 	J_STATISTICS_BYTES_WRITTEN,
 	J_STATISTICS_BYTES_RECEIVED,
-	J_STATISTICS_BYTES_SENT
+	J_STATISTICS_BYTES_SENT,
+	J_STATISTICS_HANDLE_CACHE_HITS,
+	J_STATISTICS_HANDLE_CACHE_MISSES,
+	J_STATISTICS_CONNECTIONS_CREATED,
+	J_STATISTICS_CONNECTIONS_CLOSED,
+	J_STATISTICS_CONNECTION_WAITS,
+	J_STATISTICS_CONNECTION_WAIT_TIME
 };
 
 typedef enum JStatisticsType JStatisticsType;
@@ -41,6 +41,7 @@ enum JTraceFileOperation
 	J_TRACE_FILE_SEEK,
 	J_TRACE_FILE_STATUS,
 	J_TRACE_FILE_SYNC,
+	J_TRACE_FILE_TRUNCATE,
 	J_TRACE_FILE_WRITE
 };
 
@@ -82,6 +82,7 @@ struct JDBSchema
 
 	gchar* namespace;
 	gchar* name;
+	gchar* shard_key; //entries are partitioned across DB servers by this variable's value
 
 	guint bson_index_count;
 	gint ref_count;
@@ -127,7 +128,9 @@ gboolean j_db_internal_insert(JDBEntry* j_db_entry, JBatch* batch, GError** erro
 gboolean j_db_internal_update(JDBEntry* j_db_entry, JDBSelector* j_db_selector, JBatch* batch, GError** error);
 gboolean j_db_internal_delete(JDBEntry* j_db_entry, JDBSelector* j_db_selector, JBatch* batch, GError** error);
 gboolean j_db_internal_query(JDBSchema* j_db_schema, JDBSelector* j_db_selector, JDBIterator* j_db_iterator, JBatch* batch, GError** error);
+gboolean j_db_internal_query_cursor(JDBSchema* j_db_schema, JDBSelector* j_db_selector, JDBIterator* j_db_iterator, GError** error);
 gboolean j_db_internal_iterate(JDBIterator* j_db_iterator, GError** error);
+void j_db_internal_iterator_free(JDBIterator* j_db_iterator);
 
 // Client-side additional internal functions
 bson_t* j_db_selector_get_bson(JDBSelector* selector);
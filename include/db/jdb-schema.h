@@ -152,6 +152,25 @@ guint32 j_db_schema_get_all_fields(JDBSchema* schema, gchar*** names, JDBType**
 
 gboolean j_db_schema_add_index(JDBSchema* schema, gchar const** names, GError** error);
 
+/**
+ * partitions the schema's entries across all DB servers.
+ * Entries are placed according to the value of the given variable, while updates, deletes and queries are sent to all DB servers.
+ * Without a shard key, the whole schema is stored on a single DB server.
+ * All clients have to set the same shard key before creating, getting or using the schema.
+ * Entry IDs encode the DB server's index and are therefore unique across all DB servers.
+ *
+ * \param[in] schema the schema to partition
+ * \param[in] name the name of the variable to partition by
+ *
+ * \pre schema != NULL
+ * \pre name != NULL
+ * \pre schema has not been created or queried from the backend yet
+ *
+ * \return TRUE on success, FALSE otherwise
+ **/
+
+gboolean j_db_schema_set_shard_key(JDBSchema* schema, gchar const* name, GError** error);
+
 /**
  * stores a schema in the backend.
  *
@@ -41,12 +41,14 @@
 #include <core/jconnection-pool.h>
 #include <core/jcredentials.h>
 #include <core/jdistribution.h>
+#include <core/jfabric.h>
 #include <core/jhelper.h>
 #include <core/jlist.h>
 #include <core/jlist-iterator.h>
 #include <core/jmemory-chunk.h>
 #include <core/jmessage.h>
 #include <core/joperation.h>
+#include <core/jplacement.h>
 #include <core/jsemantics.h>
 #include <core/jstatistics.h>
 #include <core/jtrace.h>
@@ -42,6 +42,7 @@ G_END_DECLS
 G_BEGIN_DECLS
 
 JKVIterator* j_kv_iterator_new(gchar const*, gchar const*);
+JKVIterator* j_kv_iterator_new_keys(gchar const*, gchar const*);
 JKVIterator* j_kv_iterator_new_for_index(guint32, gchar const*, gchar const*);
 void j_kv_iterator_free(JKVIterator*);
 
@@ -57,6 +57,8 @@ void j_kv_delete(JKV*, JBatch*);
 void j_kv_get(JKV*, gpointer*, guint32*, JBatch*);
 void j_kv_get_callback(JKV*, JKVGetFunc, gpointer, JBatch*);
 
+void j_kv_get_many(gchar const*, gchar const* const*, guint32, gpointer*, guint32*, JBatch*);
+
 G_END_DECLS
 
 #endif
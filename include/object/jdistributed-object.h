@@ -44,6 +44,7 @@ void j_distributed_object_unref(JDistributedObject*);
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(JDistributedObject, j_distributed_object_unref)
 
 void j_distributed_object_create(JDistributedObject*, JBatch*);
+void j_distributed_object_create_with_size(JDistributedObject*, guint64, JBatch*);
 void j_distributed_object_delete(JDistributedObject*, JBatch*);
 
 void j_distributed_object_read(JDistributedObject*, gpointer, guint64, guint64, guint64*, JBatch*);
@@ -51,6 +52,7 @@ void j_distributed_object_write(JDistributedObject*, gconstpointer, guint64, gui
 
 void j_distributed_object_status(JDistributedObject*, gint64*, guint64*, JBatch*);
 void j_distributed_object_sync(JDistributedObject*, JBatch*);
+void j_distributed_object_truncate(JDistributedObject*, guint64, JBatch*);
 
 G_END_DECLS
 
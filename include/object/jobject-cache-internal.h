@@ -0,0 +1,58 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2020 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ **/
+
+#ifndef JULEA_OBJECT_OBJECT_CACHE_INTERNAL_H
+#define JULEA_OBJECT_OBJECT_CACHE_INTERNAL_H
+
+#if !defined(JULEA_OBJECT_H) && !defined(JULEA_OBJECT_COMPILATION)
+#error "Only <julea-object.h> can be included directly."
+#endif
+
+#include <glib.h>
+
+#include <julea.h>
+
+G_BEGIN_DECLS
+
+struct JObjectCache;
+
+typedef struct JObjectCache JObjectCache;
+
+G_GNUC_INTERNAL JObjectCache* j_object_cache_new(void);
+G_GNUC_INTERNAL void j_object_cache_free(JObjectCache*);
+
+G_GNUC_INTERNAL gboolean j_object_cache_use_read_ahead(JSemantics*);
+G_GNUC_INTERNAL gboolean j_object_cache_use_write_behind(JSemantics*);
+
+G_GNUC_INTERNAL gboolean j_object_cache_read(JObjectCache*, gpointer, guint64, guint64, guint64*);
+G_GNUC_INTERNAL guint64 j_object_cache_get_read_ahead(JObjectCache*, guint64, guint64);
+G_GNUC_INTERNAL void j_object_cache_fill(JObjectCache*, gpointer, guint64, guint64, gboolean);
+
+G_GNUC_INTERNAL gboolean j_object_cache_write(JObjectCache*, gconstpointer, guint64, guint64, JSemantics*);
+G_GNUC_INTERNAL gpointer j_object_cache_take_dirty(JObjectCache*, gboolean, guint64*, guint64*, JSemantics**);
+
+G_GNUC_INTERNAL void j_object_cache_invalidate(JObjectCache*, guint64, guint64);
+G_GNUC_INTERNAL void j_object_cache_clear(JObjectCache*);
+
+G_END_DECLS
+
+#endif
@@ -45,6 +45,7 @@ void j_object_unref(JObject*);
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(JObject, j_object_unref)
 
 void j_object_create(JObject*, JBatch*);
+void j_object_create_with_size(JObject*, guint64, JBatch*);
 void j_object_delete(JObject*, JBatch*);
 
 void j_object_read(JObject*, gpointer, guint64, guint64, guint64*, JBatch*);
@@ -52,6 +53,7 @@ void j_object_write(JObject*, gconstpointer, guint64, guint64, guint64*, JBatch*
 
 void j_object_status(JObject*, gint64*, guint64*, JBatch*);
 void j_object_sync(JObject*, JBatch*);
+void j_object_truncate(JObject*, guint64, JBatch*);
 
 G_END_DECLS
 
@@ -461,6 +461,237 @@ j_backend_object_write(JBackend* backend, gpointer data, gconstpointer buffer, g
 	return ret;
 }
 
+gboolean
+j_backend_object_allocate(JBackend* backend, gpointer data, guint64 size)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = FALSE;
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_OBJECT, FALSE);
+	g_return_val_if_fail(data != NULL, FALSE);
+
+	if (backend->object.backend_allocate != NULL)
+	{
+		J_TRACE("backend_allocate", "%p, %" G_GUINT64_FORMAT, data, size);
+		ret = backend->object.backend_allocate(backend->data, data, size);
+	}
+
+	return ret;
+}
+
+gboolean
+j_backend_object_truncate(JBackend* backend, gpointer data, guint64 size)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = FALSE;
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_OBJECT, FALSE);
+	g_return_val_if_fail(data != NULL, FALSE);
+
+	if (backend->object.backend_truncate != NULL)
+	{
+		J_TRACE("backend_truncate", "%p, %" G_GUINT64_FORMAT, data, size);
+		ret = backend->object.backend_truncate(backend->data, data, size);
+	}
+
+	return ret;
+}
+
+gboolean
+j_backend_object_writev(JBackend* backend, gpointer data, gconstpointer const* buffers, guint64 const* lengths, guint count, guint64 offset, guint64* bytes_written)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = TRUE;
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_OBJECT, FALSE);
+	g_return_val_if_fail(data != NULL, FALSE);
+	g_return_val_if_fail(buffers != NULL, FALSE);
+	g_return_val_if_fail(lengths != NULL, FALSE);
+	g_return_val_if_fail(bytes_written != NULL, FALSE);
+
+	if (backend->object.backend_writev != NULL)
+	{
+		J_TRACE("backend_writev", "%p, %p, %u, %" G_GUINT64_FORMAT ", %p", data, (gconstpointer)buffers, count, offset, (gpointer)bytes_written);
+		ret = backend->object.backend_writev(backend->data, data, buffers, lengths, count, offset, bytes_written);
+	}
+	else
+	{
+		*bytes_written = 0;
+
+		for (guint i = 0; i < count; i++)
+		{
+			guint64 nbytes = 0;
+
+			{
+				J_TRACE("backend_write", "%p, %p, %" G_GUINT64_FORMAT ", %" G_GUINT64_FORMAT ", %p", data, buffers[i], lengths[i], offset, (gpointer)&nbytes);
+				ret = backend->object.backend_write(backend->data, data, buffers[i], lengths[i], offset, &nbytes);
+			}
+
+			*bytes_written += nbytes;
+			offset += nbytes;
+
+			if (!ret || nbytes < lengths[i])
+			{
+				break;
+			}
+		}
+	}
+
+	return ret;
+}
+
+gboolean
+j_backend_object_read_batch(JBackend* backend, gpointer data, gpointer const* buffers, guint64 const* lengths, guint64 const* offsets, guint count, guint64* bytes_read)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = TRUE;
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_OBJECT, FALSE);
+	g_return_val_if_fail(data != NULL, FALSE);
+	g_return_val_if_fail(count == 0 || buffers != NULL, FALSE);
+	g_return_val_if_fail(count == 0 || lengths != NULL, FALSE);
+	g_return_val_if_fail(count == 0 || offsets != NULL, FALSE);
+	g_return_val_if_fail(count == 0 || bytes_read != NULL, FALSE);
+
+	if (backend->object.backend_read_batch != NULL)
+	{
+		J_TRACE("backend_read_batch", "%p, %p, %u, %p", data, (gconstpointer)buffers, count, (gpointer)bytes_read);
+		ret = backend->object.backend_read_batch(backend->data, data, buffers, lengths, offsets, count, bytes_read);
+	}
+	else
+	{
+		for (guint i = 0; i < count; i++)
+		{
+			J_TRACE("backend_read", "%p, %p, %" G_GUINT64_FORMAT ", %" G_GUINT64_FORMAT ", %p", data, buffers[i], lengths[i], offsets[i], (gpointer)(bytes_read + i));
+
+			bytes_read[i] = 0;
+			ret = backend->object.backend_read(backend->data, data, buffers[i], lengths[i], offsets[i], bytes_read + i) && ret;
+		}
+	}
+
+	return ret;
+}
+
+gboolean
+j_backend_object_write_batch(JBackend* backend, gpointer data, gconstpointer const* buffers, guint64 const* lengths, guint64 const* offsets, guint count, gboolean sync, guint64* bytes_written)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = TRUE;
+	guint first;
+	guint last;
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_OBJECT, FALSE);
+	g_return_val_if_fail(data != NULL, FALSE);
+	g_return_val_if_fail(count == 0 || buffers != NULL, FALSE);
+	g_return_val_if_fail(count == 0 || lengths != NULL, FALSE);
+	g_return_val_if_fail(count == 0 || offsets != NULL, FALSE);
+	g_return_val_if_fail(count == 0 || bytes_written != NULL, FALSE);
+
+	if (backend->object.backend_write_batch != NULL)
+	{
+		J_TRACE("backend_write_batch", "%p, %p, %u, %d, %p", data, (gconstpointer)buffers, count, sync, (gpointer)bytes_written);
+		return backend->object.backend_write_batch(backend->data, data, buffers, lengths, offsets, count, sync, bytes_written);
+	}
+
+	for (first = 0; first < count; first = last)
+	{
+		guint64 nbytes = 0;
+
+		last = first + 1;
+
+		// Find all buffers that directly follow each other
+		while (last < count && offsets[last] == offsets[last - 1] + lengths[last - 1])
+		{
+			last++;
+		}
+
+		if (last - first == 1)
+		{
+			ret = j_backend_object_write(backend, data, buffers[first], lengths[first], offsets[first], &nbytes) && ret;
+		}
+		else
+		{
+			ret = j_backend_object_writev(backend, data, buffers + first, lengths + first, last - first, offsets[first], &nbytes) && ret;
+		}
+
+		// Distribute the written bytes among the buffers
+		for (guint i = first; i < last; i++)
+		{
+			bytes_written[i] = MIN(nbytes, lengths[i]);
+			nbytes -= bytes_written[i];
+		}
+	}
+
+	if (sync)
+	{
+		ret = j_backend_object_sync(backend, data) && ret;
+	}
+
+	return ret;
+}
+
+gboolean
+j_backend_object_register_buffer(JBackend* backend, gpointer buffer, guint64 length)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = FALSE;
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_OBJECT, FALSE);
+	g_return_val_if_fail(buffer != NULL, FALSE);
+
+	if (backend->object.backend_register_buffer != NULL)
+	{
+		J_TRACE("backend_register_buffer", "%p, %" G_GUINT64_FORMAT, buffer, length);
+		ret = backend->object.backend_register_buffer(backend->data, buffer, length);
+	}
+
+	return ret;
+}
+
+void
+j_backend_object_unregister_buffer(JBackend* backend, gpointer buffer)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(backend != NULL);
+	g_return_if_fail(backend->type == J_BACKEND_TYPE_OBJECT);
+	g_return_if_fail(buffer != NULL);
+
+	if (backend->object.backend_unregister_buffer != NULL)
+	{
+		J_TRACE("backend_unregister_buffer", "%p", buffer);
+		backend->object.backend_unregister_buffer(backend->data, buffer);
+	}
+}
+
+void
+j_backend_object_statistics(JBackend* backend, JStatistics* statistics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(backend != NULL);
+	g_return_if_fail(backend->type == J_BACKEND_TYPE_OBJECT);
+	g_return_if_fail(statistics != NULL);
+
+	if (backend->object.backend_statistics != NULL)
+	{
+		J_TRACE("backend_statistics", "%p", (gpointer)statistics);
+		backend->object.backend_statistics(backend->data, statistics);
+	}
+}
+
 gboolean
 j_backend_kv_init(JBackend* backend, gchar const* path)
 {
@@ -597,6 +828,74 @@ j_backend_kv_get(JBackend* backend, gpointer batch, gchar const* key, gpointer*
 	return ret;
 }
 
+gboolean
+j_backend_kv_get_static(JBackend* backend, gpointer batch, gchar const* key, gconstpointer* value, guint32* value_len)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret;
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_KV, FALSE);
+	g_return_val_if_fail(backend->kv.backend_get_static != NULL, FALSE);
+	g_return_val_if_fail(batch != NULL, FALSE);
+	g_return_val_if_fail(key != NULL, FALSE);
+	g_return_val_if_fail(value != NULL, FALSE);
+	g_return_val_if_fail(value_len != NULL, FALSE);
+
+	{
+		J_TRACE("backend_get_static", "%p, %s, %p, %p", batch, key, (gpointer)value, (gpointer)value_len);
+		ret = backend->kv.backend_get_static(backend->data, batch, key, value, value_len);
+	}
+
+	return ret;
+}
+
+gboolean
+j_backend_kv_has_get_static(JBackend* backend)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_KV, FALSE);
+
+	return (backend->kv.backend_get_static != NULL);
+}
+
+gboolean
+j_backend_kv_get_many(JBackend* backend, gpointer batch, gchar const* const* keys, guint32 count, gconstpointer* values, guint32* value_lens)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret;
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_KV, FALSE);
+	g_return_val_if_fail(backend->kv.backend_get_many != NULL, FALSE);
+	g_return_val_if_fail(batch != NULL, FALSE);
+	g_return_val_if_fail(keys != NULL, FALSE);
+	g_return_val_if_fail(values != NULL, FALSE);
+	g_return_val_if_fail(value_lens != NULL, FALSE);
+
+	{
+		J_TRACE("backend_get_many", "%p, %u, %p, %p", batch, count, (gpointer)values, (gpointer)value_lens);
+		ret = backend->kv.backend_get_many(backend->data, batch, keys, count, values, value_lens);
+	}
+
+	return ret;
+}
+
+gboolean
+j_backend_kv_has_get_many(JBackend* backend)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_KV, FALSE);
+
+	return (backend->kv.backend_get_many != NULL);
+}
+
 gboolean
 j_backend_kv_get_all(JBackend* backend, gchar const* namespace, gpointer* iterator)
 {
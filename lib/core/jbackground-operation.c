@@ -57,13 +57,19 @@ struct JBackgroundOperation
 	 **/
 	gpointer result;
 
+	/**
+	 * Whether the background operation has been started.
+	 * An operation that has not been started yet is executed by the first thread waiting for it.
+	 **/
+	gboolean started;
+
 	/**
 	 * Whether the background operation has finished.
 	 **/
 	gboolean completed;
 
 	/**
-	 * The mutex for #completed.
+	 * The mutex for #started and #completed.
 	 */
 	GMutex mutex[1];
 
@@ -80,6 +86,26 @@ struct JBackgroundOperation
 
 static GThreadPool* j_thread_pool = NULL;
 
+/**
+ * Runs a background operation and signals its completion.
+ *
+ * \private
+ *
+ * \param background_operation A background operation.
+ **/
+static void
+j_background_operation_run(JBackgroundOperation* background_operation)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	background_operation->result = (*(background_operation->func))(background_operation->data);
+
+	g_mutex_lock(background_operation->mutex);
+	background_operation->completed = TRUE;
+	g_cond_broadcast(background_operation->cond);
+	g_mutex_unlock(background_operation->mutex);
+}
+
 /**
  * Executes background operations.
  *
@@ -98,15 +124,21 @@ j_background_operation_thread(gpointer data, gpointer user_data)
 
 	JBackgroundOperation* background_operation = data;
 
-	(void)user_data;
+	gboolean started;
 
-	background_operation->result = (*(background_operation->func))(background_operation->data);
+	(void)user_data;
 
 	g_mutex_lock(background_operation->mutex);
-	background_operation->completed = TRUE;
-	g_cond_signal(background_operation->cond);
+	started = background_operation->started;
+	background_operation->started = TRUE;
 	g_mutex_unlock(background_operation->mutex);
 
+	// The operation might already have been executed by a waiting thread.
+	if (!started)
+	{
+		j_background_operation_run(background_operation);
+	}
+
 	j_background_operation_unref(background_operation);
 }
 
@@ -199,6 +231,7 @@ j_background_operation_new(JBackgroundOperationFunc func, gpointer data)
 	background_operation->func = func;
 	background_operation->data = data;
 	background_operation->result = NULL;
+	background_operation->started = FALSE;
 	background_operation->completed = FALSE;
 	background_operation->ref_count = 2;
 
@@ -265,6 +298,8 @@ j_background_operation_unref(JBackgroundOperation* background_operation)
 
 /**
  * Waits for a background operation to finish.
+ * If the background operation has not been started yet, it is executed by the calling thread.
+ * This prevents deadlocks when background operations wait for other background operations that are still queued.
  *
  * \code
  * JBackgroundOperation* background_operation;
@@ -285,6 +320,16 @@ j_background_operation_wait(JBackgroundOperation* background_operation)
 
 	g_mutex_lock(background_operation->mutex);
 
+	if (!background_operation->started)
+	{
+		background_operation->started = TRUE;
+		g_mutex_unlock(background_operation->mutex);
+
+		j_background_operation_run(background_operation);
+
+		g_mutex_lock(background_operation->mutex);
+	}
+
 	while (!background_operation->completed)
 	{
 		g_cond_wait(background_operation->cond, background_operation->mutex);
@@ -68,15 +68,124 @@ struct JBatch
 	gint ref_count;
 };
 
+/**
+ * A group of operations that are executed together.
+ **/
+struct JBatchGroup
+{
+	JOperationExecFunc exec_func;
+	gconstpointer key;
+
+	/**
+	 * The operations' data.
+	 **/
+	JList* list;
+};
+
+typedef struct JBatchGroup JBatchGroup;
+
+/**
+ * A chain of groups sharing a key.
+ * Groups within a chain are executed in order, while different chains are independent.
+ **/
+struct JBatchChain
+{
+	JBatch* batch;
+
+	/**
+	 * The groups in execution order.
+	 **/
+	GPtrArray* groups;
+
+	/**
+	 * Whether the chain has been claimed for execution.
+	 * A chain is executed by either an executor thread or the batch's thread, whichever claims it first.
+	 **/
+	gint claimed;
+
+	gboolean ret;
+
+	/**
+	 * Whether the chain has been executed.
+	 **/
+	gboolean completed;
+
+	/**
+	 * The mutex for #completed.
+	 **/
+	GMutex mutex[1];
+
+	/**
+	 * The condition for #completed.
+	 **/
+	GCond cond[1];
+
+	/**
+	 * The reference count.
+	 **/
+	gint ref_count;
+};
+
+typedef struct JBatchChain JBatchChain;
+
 struct JBatchAsync
 {
 	JBatch* batch;
 	JBatchAsyncCallback callback;
 	gpointer user_data;
+
+	/**
+	 * The completion queue, if any.
+	 **/
+	JBatchQueue* queue;
 };
 
 typedef struct JBatchAsync JBatchAsync;
 
+/**
+ * A completion queue.
+ **/
+struct JBatchQueue
+{
+	/**
+	 * Contains #JBatchCompletion elements of finished batches.
+	 **/
+	GAsyncQueue* completions;
+
+	/**
+	 * The number of batches that have been submitted but not yet claimed by j_batch_queue_poll() or j_batch_queue_wait().
+	 * Protected by the lock of #completions.
+	 **/
+	gint pending;
+
+	/**
+	 * The number of waiting threads that have claimed a batch but not retrieved it yet.
+	 * Protected by the lock of #completions.
+	 **/
+	gint claimed;
+
+	/**
+	 * The reference count.
+	 **/
+	gint ref_count;
+};
+
+struct JBatchCompletion
+{
+	JBatch* batch;
+	gboolean ret;
+};
+
+typedef struct JBatchCompletion JBatchCompletion;
+
+/**
+ * Executes independent chains concurrently.
+ * A dedicated thread pool is used because exec functions may themselves wait for background operations.
+ **/
+static GThreadPool* j_batch_thread_pool = NULL;
+
+static void j_batch_chain_thread(gpointer, gpointer);
+
 static gpointer
 j_batch_background_operation(gpointer data)
 {
@@ -92,13 +201,69 @@ j_batch_background_operation(gpointer data)
 		(*async->callback)(async->batch, ret, async->user_data);
 	}
 
-	j_batch_unref(async->batch);
+	if (async->queue != NULL)
+	{
+		JBatchCompletion* completion;
+
+		completion = g_slice_new(JBatchCompletion);
+		// The batch's reference is handed over to the completion.
+		completion->batch = async->batch;
+		completion->ret = ret;
+
+		g_async_queue_push(async->queue->completions, completion);
+		j_batch_queue_unref(async->queue);
+	}
+	else
+	{
+		j_batch_unref(async->batch);
+	}
 
 	g_slice_free(JBatchAsync, async);
 
 	return NULL;
 }
 
+/**
+ * Initializes the batch executor.
+ *
+ * \param count The number of executor threads, 0 for the number of processors.
+ **/
+void
+j_batch_init(guint count)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	GThreadPool* thread_pool;
+
+	g_return_if_fail(j_batch_thread_pool == NULL);
+
+	if (count == 0)
+	{
+		count = g_get_num_processors();
+	}
+
+	thread_pool = g_thread_pool_new(j_batch_chain_thread, NULL, count, FALSE, NULL);
+	g_atomic_pointer_set(&j_batch_thread_pool, thread_pool);
+}
+
+/**
+ * Shuts down the batch executor.
+ **/
+void
+j_batch_fini(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	GThreadPool* thread_pool;
+
+	g_return_if_fail(j_batch_thread_pool != NULL);
+
+	thread_pool = g_atomic_pointer_get(&j_batch_thread_pool);
+	g_atomic_pointer_set(&j_batch_thread_pool, NULL);
+
+	g_thread_pool_free(thread_pool, FALSE, TRUE);
+}
+
 /**
  * Creates a new batch.
  *
@@ -243,8 +408,285 @@ j_batch_execute_same(JBatch* batch, JOperationExecFunc exec_func, JList* list)
 	return ret;
 }
 
+/**
+ * Hashes an operation key.
+ *
+ * \private
+ *
+ * \param key An operation key, can be NULL.
+ *
+ * \return A hash value.
+ **/
+static guint
+j_batch_key_hash(gconstpointer key)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	if (key == NULL)
+	{
+		return 0;
+	}
+
+	return g_str_hash(key);
+}
+
+/**
+ * Compares two operation keys.
+ *
+ * \private
+ *
+ * \param a An operation key, can be NULL.
+ * \param b An operation key, can be NULL.
+ *
+ * \return TRUE if the keys are equal, FALSE otherwise.
+ **/
+static gboolean
+j_batch_key_equal(gconstpointer a, gconstpointer b)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	return (g_strcmp0(a, b) == 0);
+}
+
+/**
+ * Groups a batch's operations for relaxed ordering.
+ *
+ * \private
+ *
+ * Operations sharing a key are considered dependent and keep their relative order.
+ * For instance, an object has to be created before it can be written.
+ * An operation is therefore only moved to an earlier group if that group is the last one using the operation's key.
+ * Independent operations of the same type and key are merged regardless of their position within the batch.
+ *
+ * \param batch A batch.
+ *
+ * \return An array of #JBatchGroup elements in execution order.
+ **/
+static GPtrArray*
+j_batch_plan(JBatch* batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(GHashTable) last_groups = NULL;
+	g_autoptr(JListIterator) iterator = NULL;
+	GPtrArray* groups;
+
+	groups = g_ptr_array_new();
+	// Maps each key to the last group using it
+	last_groups = g_hash_table_new(j_batch_key_hash, j_batch_key_equal);
+	iterator = j_list_iterator_new(batch->list);
+
+	while (j_list_iterator_next(iterator))
+	{
+		JOperation* operation = j_list_iterator_get(iterator);
+		JBatchGroup* group;
+
+		group = g_hash_table_lookup(last_groups, operation->key);
+
+		if (group == NULL || group->exec_func != operation->exec_func)
+		{
+			group = g_slice_new(JBatchGroup);
+			group->exec_func = operation->exec_func;
+			group->key = operation->key;
+			group->list = j_list_new(NULL);
+
+			g_ptr_array_add(groups, group);
+			g_hash_table_insert(last_groups, (gpointer)operation->key, group);
+		}
+
+		j_list_append(group->list, operation->data);
+	}
+
+	return groups;
+}
+
+static JBatchChain*
+j_batch_chain_ref(JBatchChain* chain)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_atomic_int_inc(&(chain->ref_count));
+
+	return chain;
+}
+
+static void
+j_batch_chain_unref(JBatchChain* chain)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	if (g_atomic_int_dec_and_test(&(chain->ref_count)))
+	{
+		for (guint i = 0; i < chain->groups->len; i++)
+		{
+			JBatchGroup* group = g_ptr_array_index(chain->groups, i);
+
+			j_list_unref(group->list);
+			g_slice_free(JBatchGroup, group);
+		}
+
+		g_ptr_array_unref(chain->groups);
+
+		g_mutex_clear(chain->mutex);
+		g_cond_clear(chain->cond);
+
+		g_slice_free(JBatchChain, chain);
+	}
+}
+
+/**
+ * Executes a chain's groups in order.
+ *
+ * \private
+ *
+ * \param chain A chain.
+ *
+ * \return TRUE if all groups have been executed successfully, FALSE otherwise.
+ **/
+static gboolean
+j_batch_chain_execute(JBatchChain* chain)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = TRUE;
+
+	for (guint i = 0; i < chain->groups->len; i++)
+	{
+		JBatchGroup* group = g_ptr_array_index(chain->groups, i);
+		J_TRACE("j_batch_group", "%u", j_list_length(group->list));
+
+		ret = j_batch_execute_same(chain->batch, group->exec_func, group->list) && ret;
+	}
+
+	return ret;
+}
+
+static void
+j_batch_chain_thread(gpointer data, gpointer user_data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JBatchChain* chain = data;
+
+	(void)user_data;
+
+	if (g_atomic_int_compare_and_exchange(&(chain->claimed), 0, 1))
+	{
+		chain->ret = j_batch_chain_execute(chain);
+
+		g_mutex_lock(chain->mutex);
+		chain->completed = TRUE;
+		g_cond_signal(chain->cond);
+		g_mutex_unlock(chain->mutex);
+	}
+
+	j_batch_chain_unref(chain);
+}
+
+/**
+ * Executes planned groups.
+ *
+ * \private
+ *
+ * Groups are split into chains by key, this is only done for relaxed ordering.
+ * All chains but the first are handed to the executor, so that operations for different backends and servers can run concurrently.
+ * The batch's thread executes all chains that have not been picked up by an executor thread yet.
+ * This way, the batch never waits for chains that are stuck in the executor's queue.
+ *
+ * \param batch  A batch.
+ * \param groups An array of #JBatchGroup elements as returned by j_batch_plan().
+ *
+ * \return TRUE if all groups have been executed successfully, FALSE otherwise.
+ **/
+static gboolean
+j_batch_execute_groups(JBatch* batch, GPtrArray* groups)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(GHashTable) chains_by_key = NULL;
+	g_autoptr(GPtrArray) chains = NULL;
+	g_autofree gboolean* executed = NULL;
+	gboolean ret = TRUE;
+
+	chains_by_key = g_hash_table_new(j_batch_key_hash, j_batch_key_equal);
+	chains = g_ptr_array_new();
+
+	for (guint i = 0; i < groups->len; i++)
+	{
+		JBatchGroup* group = g_ptr_array_index(groups, i);
+		JBatchChain* chain;
+
+		chain = g_hash_table_lookup(chains_by_key, group->key);
+
+		if (chain == NULL)
+		{
+			chain = g_slice_new(JBatchChain);
+			chain->batch = batch;
+			chain->groups = g_ptr_array_new();
+			chain->claimed = 0;
+			chain->ret = FALSE;
+			chain->completed = FALSE;
+			chain->ref_count = 1;
+
+			g_mutex_init(chain->mutex);
+			g_cond_init(chain->cond);
+
+			g_ptr_array_add(chains, chain);
+			g_hash_table_insert(chains_by_key, (gpointer)group->key, chain);
+		}
+
+		g_ptr_array_add(chain->groups, group);
+	}
+
+	executed = g_new0(gboolean, chains->len);
+
+	for (guint i = 1; j_batch_thread_pool != NULL && i < chains->len; i++)
+	{
+		JBatchChain* chain = g_ptr_array_index(chains, i);
+
+		g_thread_pool_push(j_batch_thread_pool, j_batch_chain_ref(chain), NULL);
+	}
+
+	for (guint i = 0; i < chains->len; i++)
+	{
+		JBatchChain* chain = g_ptr_array_index(chains, i);
+
+		if (g_atomic_int_compare_and_exchange(&(chain->claimed), 0, 1))
+		{
+			ret = j_batch_chain_execute(chain) && ret;
+			executed[i] = TRUE;
+		}
+	}
+
+	for (guint i = 0; i < chains->len; i++)
+	{
+		JBatchChain* chain = g_ptr_array_index(chains, i);
+
+		if (!executed[i])
+		{
+			// The chain is already running, so waiting for it cannot block indefinitely.
+			g_mutex_lock(chain->mutex);
+
+			while (!chain->completed)
+			{
+				g_cond_wait(chain->cond, chain->mutex);
+			}
+
+			g_mutex_unlock(chain->mutex);
+
+			ret = chain->ret && ret;
+		}
+
+		j_batch_chain_unref(chain);
+	}
+
+	return ret;
+}
+
 /**
  * Executes the batch.
+ * Batches that do not require immediate persistency might be cached and executed in the background.
+ * Errors of cached batches are reported by the next batch that is not cached.
  *
  * \code
  * \endcode
@@ -267,15 +709,15 @@ j_batch_execute(JBatch* batch)
 		return FALSE;
 	}
 
-	if (j_semantics_get(batch->semantics, J_SEMANTICS_PERSISTENCY) == J_SEMANTICS_PERSISTENCY_EVENTUAL
+	if (j_semantics_get(batch->semantics, J_SEMANTICS_PERSISTENCY) != J_SEMANTICS_PERSISTENCY_IMMEDIATE
 	    && j_operation_cache_add(batch))
 	{
 		return TRUE;
 	}
 
-	j_operation_cache_flush();
+	ret = j_operation_cache_flush();
 
-	ret = j_batch_execute_internal(batch);
+	ret = j_batch_execute_internal(batch) && ret;
 	j_list_delete_all(batch->list);
 
 	return ret;
@@ -306,6 +748,7 @@ j_batch_execute_async(JBatch* batch, JBatchAsyncCallback callback, gpointer user
 	async->batch = j_batch_ref(batch);
 	async->callback = callback;
 	async->user_data = user_data;
+	async->queue = NULL;
 
 	batch->background_operation = j_background_operation_new(j_batch_background_operation, async);
 }
@@ -448,21 +891,21 @@ j_batch_execute_internal(JBatch* batch)
 	gconstpointer last_key;
 	gboolean ret = TRUE;
 
+	// Only relaxed ordering allows operations to be reordered and executed concurrently
+	if (j_semantics_get(batch->semantics, J_SEMANTICS_ORDERING) == J_SEMANTICS_ORDERING_RELAXED)
+	{
+		g_autoptr(GPtrArray) groups = NULL;
+
+		groups = j_batch_plan(batch);
+
+		return j_batch_execute_groups(batch, groups);
+	}
+
 	iterator = j_list_iterator_new(batch->list);
 	same_list = j_list_new(NULL);
 	last_key = NULL;
 	last_exec_func = NULL;
 
-	if (j_semantics_get(batch->semantics, J_SEMANTICS_ORDERING) == J_SEMANTICS_ORDERING_RELAXED)
-	{
-		/* FIXME: perform some optimizations */
-		/**
-		 * It is important to consider dependencies:
-		 * - Operations have to be performed before their dependent ones.
-		 *   For example, a collection has to be created before items in it can be created.
-		 */
-	}
-
 	/**
 	 * Try to combine as many operations of the same type as possible.
 	 * These are temporarily stored in same_list.
@@ -472,7 +915,7 @@ j_batch_execute_internal(JBatch* batch)
 		JOperation* operation = j_list_iterator_get(iterator);
 
 		/* We only combine operations with the same type and the same key. */
-		if ((operation->exec_func != last_exec_func || operation->key != last_key) && last_exec_func != NULL)
+		if ((operation->exec_func != last_exec_func || !j_batch_key_equal(operation->key, last_key)) && last_exec_func != NULL)
 		{
 			ret = j_batch_execute_same(batch, last_exec_func, same_list) && ret;
 		}
@@ -487,6 +930,266 @@ j_batch_execute_internal(JBatch* batch)
 	return ret;
 }
 
+/**
+ * Creates a new completion queue.
+ * Batches can be submitted to the queue using j_batch_execute_queue().
+ * Finished batches can then be retrieved using j_batch_queue_poll() or j_batch_queue_wait().
+ *
+ * \code
+ * JBatchQueue* queue;
+ *
+ * queue = j_batch_queue_new();
+ * \endcode
+ *
+ * \return A new completion queue. Should be freed with j_batch_queue_unref().
+ **/
+JBatchQueue*
+j_batch_queue_new(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JBatchQueue* queue;
+
+	queue = g_slice_new(JBatchQueue);
+	queue->completions = g_async_queue_new();
+	queue->pending = 0;
+	queue->claimed = 0;
+	queue->ref_count = 1;
+
+	return queue;
+}
+
+/**
+ * Increases a completion queue's reference count.
+ *
+ * \param queue A completion queue.
+ *
+ * \return The completion queue.
+ **/
+JBatchQueue*
+j_batch_queue_ref(JBatchQueue* queue)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(queue != NULL, NULL);
+
+	g_atomic_int_inc(&(queue->ref_count));
+
+	return queue;
+}
+
+/**
+ * Decreases a completion queue's reference count.
+ * When the reference count reaches zero, frees the memory allocated for the completion queue.
+ * Batches that are still being executed keep the queue alive.
+ *
+ * \param queue A completion queue.
+ **/
+void
+j_batch_queue_unref(JBatchQueue* queue)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(queue != NULL);
+
+	if (g_atomic_int_dec_and_test(&(queue->ref_count)))
+	{
+		JBatchCompletion* completion;
+
+		while ((completion = g_async_queue_try_pop(queue->completions)) != NULL)
+		{
+			j_batch_unref(completion->batch);
+			g_slice_free(JBatchCompletion, completion);
+		}
+
+		g_async_queue_unref(queue->completions);
+
+		g_slice_free(JBatchQueue, queue);
+	}
+}
+
+/**
+ * Executes the batch asynchronously and reports its completion via a completion queue.
+ * In contrast to j_batch_execute_async(), the calling thread does not have to keep track of the batch.
+ * This allows a single thread to keep many batches in flight.
+ * The batches are still executed by the background operation threads, so the number of batches executing at the same time is limited by the size of their thread pool.
+ * Further batches wait for a free thread.
+ *
+ * \code
+ * g_autoptr(JBatchQueue) queue = NULL;
+ * g_autoptr(JBatch) batch = NULL;
+ * JBatch* completed;
+ * gboolean ret;
+ *
+ * queue = j_batch_queue_new();
+ * batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+ * ...
+ * j_batch_execute_queue(batch, queue);
+ *
+ * while ((completed = j_batch_queue_wait(queue, &ret)) != NULL)
+ * {
+ *   j_batch_unref(completed);
+ * }
+ * \endcode
+ *
+ * \param batch A batch.
+ * \param queue A completion queue.
+ **/
+void
+j_batch_execute_queue(JBatch* batch, JBatchQueue* queue)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JBatchAsync* async;
+
+	g_return_if_fail(batch != NULL);
+	g_return_if_fail(queue != NULL);
+	g_return_if_fail(batch->background_operation == NULL);
+
+	async = g_slice_new(JBatchAsync);
+	async->batch = j_batch_ref(batch);
+	async->callback = NULL;
+	async->user_data = NULL;
+	async->queue = j_batch_queue_ref(queue);
+
+	g_async_queue_lock(queue->completions);
+	queue->pending++;
+	g_async_queue_unlock(queue->completions);
+
+	batch->background_operation = j_background_operation_new(j_batch_background_operation, async);
+}
+
+/**
+ * Returns the number of batches that have been submitted to a completion queue but not yet retrieved.
+ *
+ * \param queue A completion queue.
+ *
+ * \return The number of pending batches.
+ **/
+guint
+j_batch_queue_get_pending(JBatchQueue* queue)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	guint pending;
+
+	g_return_val_if_fail(queue != NULL, 0);
+
+	g_async_queue_lock(queue->completions);
+	pending = queue->pending + queue->claimed;
+	g_async_queue_unlock(queue->completions);
+
+	return pending;
+}
+
+/**
+ * Retrieves a finished batch from a completion queue.
+ *
+ * \private
+ *
+ * \param completion A completion.
+ * \param ret        Returns the batch's result.
+ *
+ * \return The finished batch.
+ **/
+static JBatch*
+j_batch_queue_complete(JBatchCompletion* completion, gboolean* ret)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JBatch* batch;
+
+	batch = completion->batch;
+
+	if (ret != NULL)
+	{
+		*ret = completion->ret;
+	}
+
+	g_slice_free(JBatchCompletion, completion);
+
+	// Allows the batch to be executed again.
+	j_batch_wait(batch);
+
+	return batch;
+}
+
+/**
+ * Retrieves a finished batch from a completion queue without blocking.
+ *
+ * \param queue A completion queue.
+ * \param ret   Returns the batch's result.
+ *
+ * \return A finished batch or NULL if no batch has finished yet. Should be freed with j_batch_unref().
+ **/
+JBatch*
+j_batch_queue_poll(JBatchQueue* queue, gboolean* ret)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JBatchCompletion* completion = NULL;
+
+	g_return_val_if_fail(queue != NULL, NULL);
+
+	g_async_queue_lock(queue->completions);
+
+	// Completions up to the number of claimed batches belong to waiting threads
+	if (g_async_queue_length_unlocked(queue->completions) > queue->claimed)
+	{
+		completion = g_async_queue_try_pop_unlocked(queue->completions);
+		queue->pending--;
+	}
+
+	g_async_queue_unlock(queue->completions);
+
+	if (completion == NULL)
+	{
+		return NULL;
+	}
+
+	return j_batch_queue_complete(completion, ret);
+}
+
+/**
+ * Waits for a batch submitted to a completion queue to finish.
+ *
+ * \param queue A completion queue.
+ * \param ret   Returns the batch's result.
+ *
+ * \return A finished batch or NULL if no batches are pending. Should be freed with j_batch_unref().
+ **/
+JBatch*
+j_batch_queue_wait(JBatchQueue* queue, gboolean* ret)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JBatchCompletion* completion;
+
+	g_return_val_if_fail(queue != NULL, NULL);
+
+	g_async_queue_lock(queue->completions);
+
+	// Checking and claiming has to be atomic, otherwise multiple threads could wait for the last batch
+	if (queue->pending == 0)
+	{
+		g_async_queue_unlock(queue->completions);
+
+		return NULL;
+	}
+
+	queue->pending--;
+	queue->claimed++;
+
+	// Releases the lock while waiting, so that completions can be pushed
+	completion = g_async_queue_pop_unlocked(queue->completions);
+
+	queue->claimed--;
+
+	g_async_queue_unlock(queue->completions);
+
+	return j_batch_queue_complete(completion, ret);
+}
+
 /**
  * @}
  **/
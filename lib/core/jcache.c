@@ -180,7 +180,7 @@ j_cache_release(JCache* cache, gpointer data)
 	if ((size = g_hash_table_lookup(cache->buffers, data)) == NULL)
 	{
 		g_warn_if_reached();
-		return;
+		goto end;
 	}
 
 	g_hash_table_remove(cache->buffers, data);
@@ -188,6 +188,7 @@ j_cache_release(JCache* cache, gpointer data)
 	cache->used -= GPOINTER_TO_SIZE(size);
 	g_free(data);
 
+end:
 	g_mutex_unlock(cache->mutex);
 }
 
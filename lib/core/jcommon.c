@@ -29,12 +29,14 @@
 #include <jconfiguration.h>
 #include <jconnection-pool-internal.h>
 #include <jdistribution-internal.h>
+#include <jfabric.h>
 #include <jlist.h>
 #include <jlist-iterator.h>
 #include <jbatch.h>
 #include <jbatch-internal.h>
 #include <joperation-cache-internal.h>
 #include <joperation-internal.h>
+#include <jplacement-internal.h>
 #include <jtrace.h>
 
 /**
@@ -109,8 +111,16 @@ j_init(void)
 	}
 
 	j_connection_pool_init(j_configuration());
+
+	if (!j_fabric_init(j_configuration()))
+	{
+		g_warning("%s: Failed to initialize fabric, object data will be sent via TCP.", G_STRLOC);
+	}
+
+	j_placement_init(j_configuration());
 	j_distribution_init();
 	j_background_operation_init(0);
+	j_batch_init(0);
 	j_operation_cache_init();
 
 	j_inited = TRUE;
@@ -143,7 +153,10 @@ j_fini(void)
 	trace = j_trace_enter(G_STRFUNC, NULL);
 
 	j_operation_cache_fini();
+	j_batch_fini();
 	j_background_operation_fini();
+	j_placement_fini();
+	j_fabric_fini();
 	j_connection_pool_fini();
 
 	j_inited = FALSE;
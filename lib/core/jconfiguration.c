@@ -73,6 +73,36 @@ struct JConfiguration
 		 * The number of db servers.
 		 */
 		guint32 db_len;
+
+		/**
+		 * The object servers' weights, can be NULL.
+		 */
+		gint* object_weights;
+
+		/**
+		 * The kv servers' weights, can be NULL.
+		 */
+		gint* kv_weights;
+
+		/**
+		 * The db servers' weights, can be NULL.
+		 */
+		gint* db_weights;
+
+		/**
+		 * The number of object server weights.
+		 */
+		gsize object_weights_len;
+
+		/**
+		 * The number of kv server weights.
+		 */
+		gsize kv_weights_len;
+
+		/**
+		 * The number of db server weights.
+		 */
+		gsize db_weights_len;
 	} servers;
 
 	/**
@@ -142,6 +172,61 @@ struct JConfiguration
 	guint32 max_connections;
 	guint64 stripe_size;
 
+	/**
+	 * Whether large messages are sent using zero-copy sends.
+	 */
+	gboolean zerocopy;
+
+	/**
+	 * Whether clients multiplex concurrent requests over a single connection.
+	 */
+	gboolean multiplex;
+
+	/**
+	 * The size of the read-ahead window used for sequential object reads.
+	 */
+	guint64 read_ahead;
+
+	/**
+	 * The size of the buffer used to collect small object writes.
+	 */
+	guint64 write_behind;
+
+	/**
+	 * The number of connections opened per server during initialization.
+	 */
+	guint32 connection_warm_up;
+
+	/**
+	 * The number of seconds after which idle connections are checked and closed.
+	 */
+	guint32 connection_idle_timeout;
+
+	/**
+	 * The libfabric provider used for object data, NULL if disabled.
+	 */
+	gchar* fabric_provider;
+
+	/**
+	 * The placement used to map keys to servers, NULL for the default.
+	 */
+	gchar* placement;
+
+	/**
+	 * The number of virtual nodes per server and weight used by the ring placement.
+	 */
+	guint32 placement_virtual_nodes;
+
+	/**
+	 * The number of database query results fetched per request.
+	 */
+	guint32 db_page_size;
+
+	/**
+	 * The number of key-value pairs fetched per request when iterating.
+	 */
+	guint32 kv_page_size;
+
 	/**
 	 * The reference count.
 	 */
@@ -273,6 +358,12 @@ j_configuration_new_for_data(GKeyFile* key_file)
 	gchar** servers_object;
 	gchar** servers_kv;
 	gchar** servers_db;
+	gint* weights_object;
+	gint* weights_kv;
+	gint* weights_db;
+	gsize weights_object_len = 0;
+	gsize weights_kv_len = 0;
+	gsize weights_db_len = 0;
 	gchar* object_backend;
 	gchar* object_component;
 	gchar* object_path;
@@ -285,15 +376,40 @@ j_configuration_new_for_data(GKeyFile* key_file)
 	guint64 max_operation_size;
 	guint32 max_connections;
 	guint64 stripe_size;
+	gboolean zerocopy;
+	gboolean multiplex;
+	guint64 read_ahead;
+	guint64 write_behind;
+	guint32 connection_warm_up;
+	guint32 connection_idle_timeout;
+	gchar* fabric_provider;
+	gchar* placement;
+	guint32 placement_virtual_nodes;
+	guint32 db_page_size;
+	guint32 kv_page_size;
 
 	g_return_val_if_fail(key_file != NULL, FALSE);
 
 	max_operation_size = g_key_file_get_uint64(key_file, "core", "max-operation-size", NULL);
+	zerocopy = g_key_file_get_boolean(key_file, "core", "zerocopy", NULL);
+	fabric_provider = g_key_file_get_string(key_file, "core", "fabric-provider", NULL);
 	max_connections = g_key_file_get_integer(key_file, "clients", "max-connections", NULL);
 	stripe_size = g_key_file_get_uint64(key_file, "clients", "stripe-size", NULL);
+	multiplex = g_key_file_get_boolean(key_file, "clients", "multiplex", NULL);
+	read_ahead = g_key_file_get_uint64(key_file, "clients", "read-ahead", NULL);
+	write_behind = g_key_file_get_uint64(key_file, "clients", "write-behind", NULL);
+	connection_warm_up = g_key_file_get_integer(key_file, "clients", "connection-warm-up", NULL);
+	connection_idle_timeout = g_key_file_get_integer(key_file, "clients", "connection-idle-timeout", NULL);
+	placement = g_key_file_get_string(key_file, "clients", "placement", NULL);
+	placement_virtual_nodes = g_key_file_get_integer(key_file, "clients", "placement-virtual-nodes", NULL);
+	db_page_size = g_key_file_get_integer(key_file, "clients", "db-page-size", NULL);
+	kv_page_size = g_key_file_get_integer(key_file, "clients", "kv-page-size", NULL);
 	servers_object = g_key_file_get_string_list(key_file, "servers", "object", NULL, NULL);
 	servers_kv = g_key_file_get_string_list(key_file, "servers", "kv", NULL, NULL);
 	servers_db = g_key_file_get_string_list(key_file, "servers", "db", NULL, NULL);
+	weights_object = g_key_file_get_integer_list(key_file, "servers", "object-weights", &weights_object_len, NULL);
+	weights_kv = g_key_file_get_integer_list(key_file, "servers", "kv-weights", &weights_kv_len, NULL);
+	weights_db = g_key_file_get_integer_list(key_file, "servers", "db-weights", &weights_db_len, NULL);
 	object_backend = g_key_file_get_string(key_file, "object", "backend", NULL);
 	object_component = g_key_file_get_string(key_file, "object", "component", NULL);
 	object_path = g_key_file_get_string(key_file, "object", "path", NULL);
@@ -329,6 +445,11 @@ j_configuration_new_for_data(GKeyFile* key_file)
 		g_strfreev(servers_object);
 		g_strfreev(servers_kv);
 		g_strfreev(servers_db);
+		g_free(weights_object);
+		g_free(weights_kv);
+		g_free(weights_db);
+		g_free(fabric_provider);
+		g_free(placement);
 
 		return NULL;
 	}
@@ -340,6 +461,12 @@ j_configuration_new_for_data(GKeyFile* key_file)
 	configuration->servers.object_len = g_strv_length(servers_object);
 	configuration->servers.kv_len = g_strv_length(servers_kv);
 	configuration->servers.db_len = g_strv_length(servers_db);
+	configuration->servers.object_weights = weights_object;
+	configuration->servers.kv_weights = weights_kv;
+	configuration->servers.db_weights = weights_db;
+	configuration->servers.object_weights_len = weights_object_len;
+	configuration->servers.kv_weights_len = weights_kv_len;
+	configuration->servers.db_weights_len = weights_db_len;
 	configuration->object.backend = object_backend;
 	configuration->object.component = object_component;
 	configuration->object.path = object_path;
@@ -350,8 +477,19 @@ j_configuration_new_for_data(GKeyFile* key_file)
 	configuration->db.component = db_component;
 	configuration->db.path = db_path;
 	configuration->max_operation_size = max_operation_size;
+	configuration->zerocopy = zerocopy;
 	configuration->max_connections = max_connections;
 	configuration->stripe_size = stripe_size;
+	configuration->multiplex = multiplex;
+	configuration->read_ahead = read_ahead;
+	configuration->write_behind = write_behind;
+	configuration->connection_warm_up = connection_warm_up;
+	configuration->connection_idle_timeout = connection_idle_timeout;
+	configuration->fabric_provider = fabric_provider;
+	configuration->placement = placement;
+	configuration->placement_virtual_nodes = placement_virtual_nodes;
+	configuration->db_page_size = db_page_size;
+	configuration->kv_page_size = kv_page_size;
 	configuration->ref_count = 1;
 
 	if (configuration->max_operation_size == 0)
@@ -364,11 +502,37 @@ j_configuration_new_for_data(GKeyFile* key_file)
 		configuration->max_connections = g_get_num_processors();
 	}
 
+	if (configuration->connection_warm_up > configuration->max_connections)
+	{
+		configuration->connection_warm_up = configuration->max_connections;
+	}
+
 	if (configuration->stripe_size == 0)
 	{
 		configuration->stripe_size = 4 * 1024 * 1024;
 	}
 
+	if (configuration->placement_virtual_nodes == 0)
+	{
+		configuration->placement_virtual_nodes = 128;
+	}
+
+	if (configuration->db_page_size == 0)
+	{
+		configuration->db_page_size = 1000;
+	}
+
+	if (configuration->kv_page_size == 0)
+	{
+		configuration->kv_page_size = 1000;
+	}
+
+	if (configuration->fabric_provider != NULL && configuration->fabric_provider[0] == '\0')
+	{
+		g_free(configuration->fabric_provider);
+		configuration->fabric_provider = NULL;
+	}
+
 	return configuration;
 }
 
@@ -431,6 +595,13 @@ j_configuration_unref(JConfiguration* configuration)
 		g_strfreev(configuration->servers.kv);
 		g_strfreev(configuration->servers.db);
 
+		g_free(configuration->servers.object_weights);
+		g_free(configuration->servers.kv_weights);
+		g_free(configuration->servers.db_weights);
+
+		g_free(configuration->fabric_provider);
+		g_free(configuration->placement);
+
 		g_slice_free(JConfiguration, configuration);
 	}
 }
@@ -460,6 +631,51 @@ j_configuration_get_server(JConfiguration* configuration, JBackendType backend,
 	return NULL;
 }
 
+/**
+ * Returns a server's weight.
+ *
+ * \param configuration A configuration.
+ * \param backend       A backend type.
+ * \param index         A server index.
+ *
+ * \return The server's weight, 1 if no weight has been configured.
+ **/
+guint32
+j_configuration_get_server_weight(JConfiguration* configuration, JBackendType backend, guint32 index)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gint* weights = NULL;
+	gsize weights_len = 0;
+
+	g_return_val_if_fail(configuration != NULL, 1);
+
+	switch (backend)
+	{
+		case J_BACKEND_TYPE_OBJECT:
+			weights = configuration->servers.object_weights;
+			weights_len = configuration->servers.object_weights_len;
+			break;
+		case J_BACKEND_TYPE_KV:
+			weights = configuration->servers.kv_weights;
+			weights_len = configuration->servers.kv_weights_len;
+			break;
+		case J_BACKEND_TYPE_DB:
+			weights = configuration->servers.db_weights;
+			weights_len = configuration->servers.db_weights_len;
+			break;
+		default:
+			g_assert_not_reached();
+	}
+
+	if (weights == NULL || index >= weights_len || weights[index] <= 0)
+	{
+		return 1;
+	}
+
+	return weights[index];
+}
+
 guint32
 j_configuration_get_server_count(JConfiguration* configuration, JBackendType backend)
 {
@@ -558,6 +774,16 @@ j_configuration_get_max_operation_size(JConfiguration* configuration)
 	return configuration->max_operation_size;
 }
 
+gboolean
+j_configuration_get_zerocopy(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, FALSE);
+
+	return configuration->zerocopy;
+}
+
 guint32
 j_configuration_get_max_connections(JConfiguration* configuration)
 {
@@ -578,6 +804,106 @@ j_configuration_get_stripe_size(JConfiguration* configuration)
 	return configuration->stripe_size;
 }
 
+gboolean
+j_configuration_get_multiplex(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, FALSE);
+
+	return configuration->multiplex;
+}
+
+guint64
+j_configuration_get_read_ahead(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, 0);
+
+	return configuration->read_ahead;
+}
+
+guint64
+j_configuration_get_write_behind(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, 0);
+
+	return configuration->write_behind;
+}
+
+guint32
+j_configuration_get_connection_warm_up(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, 0);
+
+	return configuration->connection_warm_up;
+}
+
+guint32
+j_configuration_get_connection_idle_timeout(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, 0);
+
+	return configuration->connection_idle_timeout;
+}
+
+gchar const*
+j_configuration_get_fabric_provider(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, NULL);
+
+	return configuration->fabric_provider;
+}
+
+gchar const*
+j_configuration_get_placement(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, NULL);
+
+	return configuration->placement;
+}
+
+guint32
+j_configuration_get_placement_virtual_nodes(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, 0);
+
+	return configuration->placement_virtual_nodes;
+}
+
+guint32
+j_configuration_get_db_page_size(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, 0);
+
+	return configuration->db_page_size;
+}
+
+guint32
+j_configuration_get_kv_page_size(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, 0);
+
+	return configuration->kv_page_size;
+}
+
 /**
  * @}
  **/
@@ -25,6 +25,7 @@
 #include <glib.h>
 #include <glib-object.h>
 #include <gio/gio.h>
+#include <gio/gunixsocketaddress.h>
 
 #include <jconnection-pool.h>
 #include <jconnection-pool-internal.h>
@@ -33,6 +34,7 @@
 #include <jhelper.h>
 #include <jhelper-internal.h>
 #include <jmessage.h>
+#include <jstatistics.h>
 #include <jtrace.h>
 
 /**
@@ -43,32 +45,796 @@
  * @{
  **/
 
+/**
+ * A connection shared by multiple threads.
+ * Replies are matched to their messages using the message IDs.
+ **/
+struct JConnectionPoolMultiplexer
+{
+	GSocketConnection* connection;
+
+	/**
+	 * Receives all replies.
+	 **/
+	GThread* thread;
+
+	/**
+	 * Maps message IDs to the replies waiting for them.
+	 **/
+	GHashTable* replies;
+
+	/**
+	 * Set if the connection failed.
+	 * Failed multiplexers are replaced by a new one on the next request.
+	 **/
+	gboolean failed;
+
+	GMutex mutex[1];
+	GCond cond[1];
+
+	/**
+	 * The reference count.
+	 * The queue and all threads currently sending requests hold a reference.
+	 **/
+	gint ref_count;
+};
+
+typedef struct JConnectionPoolMultiplexer JConnectionPoolMultiplexer;
+
 struct JConnectionPoolQueue
 {
-	GAsyncQueue* queue;
-	guint count;
-};
+	GAsyncQueue* queue;
+	guint count;
+
+	gchar const* server;
+	gboolean zerocopy;
+
+	/**
+	 * Connection metrics, protected by #mutex.
+	 **/
+	JStatistics* statistics;
+	GMutex mutex[1];
+
+	/**
+	 * Created on first use if multiplexing is enabled and recreated if it failed, protected by #mutex.
+	 **/
+	JConnectionPoolMultiplexer* multiplexer;
+};
+
+typedef struct JConnectionPoolQueue JConnectionPoolQueue;
+
+/**
+ * A connection.
+ **/
+struct JConnectionPool
+{
+	JConfiguration* configuration;
+	JConnectionPoolQueue* object_queues;
+	JConnectionPoolQueue* kv_queues;
+	JConnectionPoolQueue* db_queues;
+	guint object_len;
+	guint kv_len;
+	guint db_len;
+	guint max_count;
+	gboolean zerocopy;
+	gboolean multiplex;
+
+	/**
+	 * The number of connections kept open per server.
+	 **/
+	guint warm_up;
+
+	/**
+	 * The time after which idle connections are checked and closed.
+	 **/
+	gint64 idle_timeout;
+
+	/**
+	 * Checks idle connections periodically.
+	 **/
+	GThread* maintenance_thread;
+	gboolean maintenance_stop;
+	GMutex maintenance_mutex[1];
+	GCond maintenance_cond[1];
+};
+
+typedef struct JConnectionPool JConnectionPool;
+
+/**
+ * The number of attempts to connect to a server.
+ * The delay between attempts is doubled after every failed attempt.
+ **/
+#define J_CONNECTION_POOL_CONNECT_ATTEMPTS 5
+#define J_CONNECTION_POOL_CONNECT_BACKOFF (10 * G_TIME_SPAN_MILLISECOND)
+
+static JConnectionPool* j_connection_pool = NULL;
+
+G_DEFINE_QUARK(j-connection-pool-last-used, j_connection_pool_last_used)
+
+static void
+j_connection_pool_set_last_used(GSocketConnection* connection, gint64 time)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gint64* last_used;
+
+	last_used = g_object_get_qdata(G_OBJECT(connection), j_connection_pool_last_used_quark());
+
+	if (last_used == NULL)
+	{
+		last_used = g_new(gint64, 1);
+		g_object_set_qdata_full(G_OBJECT(connection), j_connection_pool_last_used_quark(), last_used, g_free);
+	}
+
+	*last_used = time;
+}
+
+static gint64
+j_connection_pool_get_last_used(GSocketConnection* connection)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gint64* last_used;
+
+	last_used = g_object_get_qdata(G_OBJECT(connection), j_connection_pool_last_used_quark());
+
+	return (last_used != NULL) ? *last_used : 0;
+}
+
+/**
+ * Checks whether an idle connection is broken.
+ * Idle connections should not have any pending data, so a readable socket means that the server has closed the connection.
+ *
+ * \private
+ *
+ * \param connection A connection.
+ *
+ * \return TRUE if the connection is broken, FALSE otherwise.
+ **/
+static gboolean
+j_connection_pool_is_broken(GSocketConnection* connection)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	GSocket* socket;
+
+	socket = g_socket_connection_get_socket(connection);
+
+	return (g_socket_condition_check(socket, G_IO_IN | G_IO_HUP | G_IO_ERR) != 0);
+}
+
+static gboolean
+j_connection_pool_ping(GSocketConnection* connection)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(JMessage) message = NULL;
+	g_autoptr(JMessage) reply = NULL;
+
+	guint op_count;
+
+	message = j_message_new(J_MESSAGE_PING, 0);
+
+	if (!j_message_send(message, connection))
+	{
+		return FALSE;
+	}
+
+	reply = j_message_new_reply(message);
+
+	if (!j_message_receive(reply, connection))
+	{
+		return FALSE;
+	}
+
+	op_count = j_message_get_count(reply);
+
+	for (guint i = 0; i < op_count; i++)
+	{
+		gchar const* backend;
+
+		backend = j_message_get_string(reply);
+
+		if (g_strcmp0(backend, "object") == 0)
+		{
+			//g_print("Server has object backend.\n");
+		}
+		else if (g_strcmp0(backend, "kv") == 0)
+		{
+			//g_print("Server has kv backend.\n");
+		}
+		else if (g_strcmp0(backend, "db") == 0)
+		{
+			//g_print("Server has db backend.\n");
+		}
+	}
+
+	return TRUE;
+}
+
+/**
+ * Connects to a server running on the local host using its Unix domain socket.
+ * This avoids the overhead of the TCP loopback path.
+ *
+ * \private
+ *
+ * \param client A socket client.
+ * \param server A server.
+ *
+ * \return A connection or NULL if the server is not local or does not provide a Unix domain socket.
+ **/
+static GSocketConnection*
+j_connection_pool_connect_local(GSocketClient* client, gchar const* server)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(GNetworkAddress) address = NULL;
+	g_autoptr(GSocketAddress) local_address = NULL;
+	g_autofree gchar* path = NULL;
+
+	address = G_NETWORK_ADDRESS(g_network_address_parse(server, 4711, NULL));
+
+	if (address == NULL || !j_helper_is_local_host(g_network_address_get_hostname(address)))
+	{
+		return NULL;
+	}
+
+	path = j_helper_get_local_socket_path(g_network_address_get_port(address));
+
+	if (!g_file_test(path, G_FILE_TEST_EXISTS))
+	{
+		return NULL;
+	}
+
+	local_address = g_unix_socket_address_new(path);
+
+	return g_socket_client_connect(client, G_SOCKET_CONNECTABLE(local_address), NULL, NULL);
+}
+
+static GSocketConnection*
+j_connection_pool_connect(gchar const* server, gboolean zerocopy)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(GSocketClient) client = NULL;
+	gint64 backoff = J_CONNECTION_POOL_CONNECT_BACKOFF;
+
+	client = g_socket_client_new();
+
+	for (guint i = 0; i < J_CONNECTION_POOL_CONNECT_ATTEMPTS; i++)
+	{
+		GSocketConnection* connection;
+		g_autoptr(GError) error = NULL;
+
+		if (i > 0)
+		{
+			g_usleep(backoff);
+			backoff *= 2;
+		}
+
+		connection = j_connection_pool_connect_local(client, server);
+
+		if (connection == NULL)
+		{
+			connection = g_socket_client_connect_to_host(client, server, 4711, NULL, &error);
+		}
+
+		if (connection == NULL)
+		{
+			if (i == J_CONNECTION_POOL_CONNECT_ATTEMPTS - 1 && error != NULL)
+			{
+				g_critical("%s", error->message);
+			}
+
+			continue;
+		}
+
+		if (G_IS_TCP_CONNECTION(connection))
+		{
+			j_helper_set_nodelay(connection, TRUE);
+			g_socket_set_keepalive(g_socket_connection_get_socket(connection), TRUE);
+
+			// Zero-copy sends are only supported for TCP.
+			if (zerocopy)
+			{
+				j_message_enable_zerocopy(connection);
+			}
+		}
+
+		if (j_connection_pool_ping(connection))
+		{
+			j_connection_pool_set_last_used(connection, g_get_monotonic_time());
+
+			return connection;
+		}
+
+		g_io_stream_close(G_IO_STREAM(connection), NULL, NULL);
+		g_object_unref(connection);
+	}
+
+	g_critical("Can not connect to %s.", server);
+
+	return NULL;
+}
+
+static JMessage*
+j_connection_pool_multiplexer_lookup(guint32 id, gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JConnectionPoolMultiplexer* multiplexer = data;
+	JMessage* reply;
+
+	g_mutex_lock(multiplexer->mutex);
+	reply = g_hash_table_lookup(multiplexer->replies, GUINT_TO_POINTER(id));
+	g_mutex_unlock(multiplexer->mutex);
+
+	return reply;
+}
+
+static gpointer
+j_connection_pool_multiplexer_thread(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JConnectionPoolMultiplexer* multiplexer = data;
+	GInputStream* stream;
+	gboolean ret = TRUE;
+
+	stream = g_io_stream_get_input_stream(G_IO_STREAM(multiplexer->connection));
+
+	while (ret)
+	{
+		JMessage* reply = NULL;
+
+		ret = j_message_read_multiplexed(stream, j_connection_pool_multiplexer_lookup, multiplexer, &reply);
+
+		g_mutex_lock(multiplexer->mutex);
+
+		if (ret)
+		{
+			g_hash_table_remove(multiplexer->replies, GUINT_TO_POINTER(j_message_get_id(reply)));
+		}
+		else
+		{
+			multiplexer->failed = TRUE;
+		}
+
+		g_cond_broadcast(multiplexer->cond);
+		g_mutex_unlock(multiplexer->mutex);
+	}
+
+	return NULL;
+}
+
+static JConnectionPoolMultiplexer*
+j_connection_pool_multiplexer_new(gchar const* server)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JConnectionPoolMultiplexer* multiplexer;
+	GSocketConnection* connection;
+
+	connection = j_connection_pool_connect(server, FALSE);
+
+	if (connection == NULL)
+	{
+		return NULL;
+	}
+
+	j_message_share_connection(connection);
+
+	multiplexer = g_slice_new(JConnectionPoolMultiplexer);
+	multiplexer->connection = connection;
+	multiplexer->replies = g_hash_table_new(NULL, NULL);
+	multiplexer->failed = FALSE;
+	g_mutex_init(multiplexer->mutex);
+	g_cond_init(multiplexer->cond);
+	multiplexer->ref_count = 1;
+
+	multiplexer->thread = g_thread_new("julea-multiplexer", j_connection_pool_multiplexer_thread, multiplexer);
+
+	return multiplexer;
+}
+
+static JConnectionPoolMultiplexer*
+j_connection_pool_multiplexer_ref(JConnectionPoolMultiplexer* multiplexer)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_atomic_int_inc(&(multiplexer->ref_count));
+
+	return multiplexer;
+}
+
+static void
+j_connection_pool_multiplexer_unref(JConnectionPoolMultiplexer* multiplexer)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	if (!g_atomic_int_dec_and_test(&(multiplexer->ref_count)))
+	{
+		return;
+	}
+
+	// Shutting down the socket wakes up the receiving thread.
+	g_socket_shutdown(g_socket_connection_get_socket(multiplexer->connection), TRUE, TRUE, NULL);
+	g_thread_join(multiplexer->thread);
+
+	g_io_stream_close(G_IO_STREAM(multiplexer->connection), NULL, NULL);
+	g_object_unref(multiplexer->connection);
+
+	g_hash_table_unref(multiplexer->replies);
+	g_mutex_clear(multiplexer->mutex);
+	g_cond_clear(multiplexer->cond);
+
+	g_slice_free(JConnectionPoolMultiplexer, multiplexer);
+}
+
+static gboolean
+j_connection_pool_multiplexer_failed(JConnectionPoolMultiplexer* multiplexer)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean failed;
+
+	g_mutex_lock(multiplexer->mutex);
+	failed = multiplexer->failed;
+	g_mutex_unlock(multiplexer->mutex);
+
+	return failed;
+}
+
+static gboolean
+j_connection_pool_multiplexer_send(JConnectionPoolMultiplexer* multiplexer, JMessage* message, JMessage* reply)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = FALSE;
+
+	gpointer id;
+
+	if (reply == NULL)
+	{
+		// Messages without replies are not marked as multiplexed to preserve their ordering.
+		return j_message_send(message, multiplexer->connection);
+	}
+
+	j_message_set_multiplexed(message);
+	id = GUINT_TO_POINTER(j_message_get_id(message));
+
+	g_mutex_lock(multiplexer->mutex);
+
+	if (multiplexer->failed || g_hash_table_contains(multiplexer->replies, id))
+	{
+		g_mutex_unlock(multiplexer->mutex);
+		return FALSE;
+	}
+
+	g_hash_table_insert(multiplexer->replies, id, reply);
+
+	g_mutex_unlock(multiplexer->mutex);
+
+	if (j_message_send(message, multiplexer->connection))
+	{
+		g_mutex_lock(multiplexer->mutex);
+
+		while (g_hash_table_contains(multiplexer->replies, id) && !multiplexer->failed)
+		{
+			g_cond_wait(multiplexer->cond, multiplexer->mutex);
+		}
+
+		ret = !g_hash_table_contains(multiplexer->replies, id);
+
+		g_mutex_unlock(multiplexer->mutex);
+	}
+
+	if (!ret)
+	{
+		g_mutex_lock(multiplexer->mutex);
+		g_hash_table_remove(multiplexer->replies, id);
+		g_mutex_unlock(multiplexer->mutex);
+	}
+
+	return ret;
+}
+
+static void
+j_connection_pool_queue_statistics_add(JConnectionPoolQueue* queue, JStatisticsType type, guint64 value)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_mutex_lock(queue->mutex);
+	j_statistics_add(queue->statistics, type, value);
+	g_mutex_unlock(queue->mutex);
+}
+
+/**
+ * Returns a queue's multiplexer, connecting to the server if necessary.
+ * Failed multiplexers are replaced, which allows reconnecting after the server has been restarted.
+ *
+ * \private
+ *
+ * \param queue A queue.
+ *
+ * \return The multiplexer or NULL if the server cannot be reached. Should be released with j_connection_pool_multiplexer_unref().
+ **/
+static JConnectionPoolMultiplexer*
+j_connection_pool_queue_get_multiplexer(JConnectionPoolQueue* queue)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JConnectionPoolMultiplexer* failed = NULL;
+	JConnectionPoolMultiplexer* multiplexer = NULL;
+	JConnectionPoolMultiplexer* new_multiplexer;
+
+	g_mutex_lock(queue->mutex);
+
+	if (queue->multiplexer != NULL && !j_connection_pool_multiplexer_failed(queue->multiplexer))
+	{
+		multiplexer = j_connection_pool_multiplexer_ref(queue->multiplexer);
+	}
+
+	g_mutex_unlock(queue->mutex);
+
+	if (multiplexer != NULL)
+	{
+		return multiplexer;
+	}
+
+	// Connecting might block for a long time, other threads have to be able to use the queue in the meantime
+	new_multiplexer = j_connection_pool_multiplexer_new(queue->server);
+
+	g_mutex_lock(queue->mutex);
+
+	if (queue->multiplexer != NULL && j_connection_pool_multiplexer_failed(queue->multiplexer))
+	{
+		// Threads still using the failed multiplexer hold their own references.
+		failed = queue->multiplexer;
+		queue->multiplexer = NULL;
+
+		j_statistics_add(queue->statistics, J_STATISTICS_CONNECTIONS_CLOSED, 1);
+	}
+
+	// Another thread might have installed a multiplexer while connecting
+	if (queue->multiplexer == NULL && new_multiplexer != NULL)
+	{
+		queue->multiplexer = new_multiplexer;
+		new_multiplexer = NULL;
+
+		j_statistics_add(queue->statistics, J_STATISTICS_CONNECTIONS_CREATED, 1);
+	}
+
+	if (queue->multiplexer != NULL)
+	{
+		multiplexer = j_connection_pool_multiplexer_ref(queue->multiplexer);
+	}
+
+	g_mutex_unlock(queue->mutex);
+
+	if (failed != NULL)
+	{
+		j_connection_pool_multiplexer_unref(failed);
+	}
+
+	if (new_multiplexer != NULL)
+	{
+		j_connection_pool_multiplexer_unref(new_multiplexer);
+	}
+
+	return multiplexer;
+}
+
+/**
+ * Closes a pooled connection and makes room for a new one.
+ *
+ * \private
+ *
+ * \param queue      A queue.
+ * \param connection A connection that is not in the queue anymore.
+ **/
+static void
+j_connection_pool_queue_close(JConnectionPoolQueue* queue, GSocketConnection* connection)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_io_stream_close(G_IO_STREAM(connection), NULL, NULL);
+	g_object_unref(connection);
+
+	g_atomic_int_add(&(queue->count), -1);
+	j_connection_pool_queue_statistics_add(queue, J_STATISTICS_CONNECTIONS_CLOSED, 1);
+}
+
+static void
+j_connection_pool_queue_init(JConnectionPoolQueue* queue, gchar const* server, gboolean zerocopy)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	queue->queue = g_async_queue_new();
+	queue->count = 0;
+	queue->server = server;
+	queue->zerocopy = zerocopy;
+	queue->statistics = j_statistics_new(FALSE);
+	queue->multiplexer = NULL;
+	g_mutex_init(queue->mutex);
+}
+
+static gpointer
+j_connection_pool_queue_warm_up(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JConnectionPoolQueue* queue = data;
+
+	for (guint i = 0; i < j_connection_pool->warm_up; i++)
+	{
+		GSocketConnection* connection;
+
+		connection = j_connection_pool_connect(queue->server, queue->zerocopy);
+
+		if (connection == NULL)
+		{
+			break;
+		}
+
+		g_atomic_int_inc(&(queue->count));
+		j_connection_pool_queue_statistics_add(queue, J_STATISTICS_CONNECTIONS_CREATED, 1);
+		g_async_queue_push(queue->queue, connection);
+	}
+
+	return NULL;
+}
+
+/**
+ * Checks a queue's idle connections.
+ * Broken connections are closed.
+ * Connections that have been idle for too long are closed if there are more than the warm-up number of connections, otherwise they are pinged to keep them alive.
+ * A failed multiplexer is replaced, so that the next request does not have to reconnect.
+ *
+ * \private
+ *
+ * \param queue A queue.
+ **/
+static void
+j_connection_pool_queue_maintain(JConnectionPoolQueue* queue)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(GPtrArray) connections = NULL;
+	gint length;
+	gint64 now;
+
+	if (j_connection_pool->multiplex)
+	{
+		JConnectionPoolMultiplexer* multiplexer;
+		gboolean used;
+
+		g_mutex_lock(queue->mutex);
+		used = (queue->multiplexer != NULL);
+		g_mutex_unlock(queue->mutex);
+
+		// Only reconnect multiplexers that have been used before
+		if (used && (multiplexer = j_connection_pool_queue_get_multiplexer(queue)) != NULL)
+		{
+			j_connection_pool_multiplexer_unref(multiplexer);
+		}
+	}
+
+	connections = g_ptr_array_new();
+	length = g_async_queue_length(queue->queue);
+	now = g_get_monotonic_time();
+
+	for (gint i = 0; i < length; i++)
+	{
+		GSocketConnection* connection;
+		gboolean idle;
+
+		connection = g_async_queue_try_pop(queue->queue);
+
+		if (connection == NULL)
+		{
+			break;
+		}
+
+		idle = (now - j_connection_pool_get_last_used(connection) >= j_connection_pool->idle_timeout);
+
+		if (j_connection_pool_is_broken(connection))
+		{
+			j_connection_pool_queue_close(queue, connection);
+		}
+		else if (idle && (guint)g_atomic_int_get(&(queue->count)) > j_connection_pool->warm_up)
+		{
+			j_connection_pool_queue_close(queue, connection);
+		}
+		else if (idle && !j_connection_pool_ping(connection))
+		{
+			j_connection_pool_queue_close(queue, connection);
+		}
+		else
+		{
+			if (idle)
+			{
+				j_connection_pool_set_last_used(connection, now);
+			}
+
+			g_ptr_array_add(connections, connection);
+		}
+	}
+
+	for (guint i = 0; i < connections->len; i++)
+	{
+		g_async_queue_push(queue->queue, g_ptr_array_index(connections, i));
+	}
+}
+
+static void
+j_connection_pool_queue_fini(JConnectionPoolQueue* queue)
+{
+	J_TRACE_FUNCTION(NULL);
 
-typedef struct JConnectionPoolQueue JConnectionPoolQueue;
+	GSocketConnection* connection;
 
-/**
- * A connection.
- **/
-struct JConnectionPool
+	while ((connection = g_async_queue_try_pop(queue->queue)) != NULL)
+	{
+		g_io_stream_close(G_IO_STREAM(connection), NULL, NULL);
+		g_object_unref(connection);
+	}
+
+	g_async_queue_unref(queue->queue);
+
+	if (queue->multiplexer != NULL)
+	{
+		j_connection_pool_multiplexer_unref(queue->multiplexer);
+	}
+
+	j_statistics_free(queue->statistics);
+	g_mutex_clear(queue->mutex);
+}
+
+static gpointer
+j_connection_pool_maintenance_thread(gpointer data)
 {
-	JConfiguration* configuration;
-	JConnectionPoolQueue* object_queues;
-	JConnectionPoolQueue* kv_queues;
-	JConnectionPoolQueue* db_queues;
-	guint object_len;
-	guint kv_len;
-	guint db_len;
-	guint max_count;
-};
+	J_TRACE_FUNCTION(NULL);
 
-typedef struct JConnectionPool JConnectionPool;
+	JConnectionPool* pool = data;
+	gint64 interval;
 
-static JConnectionPool* j_connection_pool = NULL;
+	// Check twice per timeout to close idle connections in time.
+	interval = MAX(pool->idle_timeout / 2, G_TIME_SPAN_SECOND);
+
+	g_mutex_lock(pool->maintenance_mutex);
+
+	while (!pool->maintenance_stop)
+	{
+		if (g_cond_wait_until(pool->maintenance_cond, pool->maintenance_mutex, g_get_monotonic_time() + interval))
+		{
+			continue;
+		}
+
+		g_mutex_unlock(pool->maintenance_mutex);
+
+		for (guint i = 0; i < pool->object_len; i++)
+		{
+			j_connection_pool_queue_maintain(&(pool->object_queues[i]));
+		}
+
+		for (guint i = 0; i < pool->kv_len; i++)
+		{
+			j_connection_pool_queue_maintain(&(pool->kv_queues[i]));
+		}
+
+		for (guint i = 0; i < pool->db_len; i++)
+		{
+			j_connection_pool_queue_maintain(&(pool->db_queues[i]));
+		}
+
+		g_mutex_lock(pool->maintenance_mutex);
+	}
+
+	g_mutex_unlock(pool->maintenance_mutex);
+
+	return NULL;
+}
 
 void
 j_connection_pool_init(JConfiguration* configuration)
@@ -88,26 +854,65 @@ j_connection_pool_init(JConfiguration* configuration)
 	pool->db_len = j_configuration_get_server_count(configuration, J_BACKEND_TYPE_DB);
 	pool->db_queues = g_new(JConnectionPoolQueue, pool->db_len);
 	pool->max_count = j_configuration_get_max_connections(configuration);
+	pool->zerocopy = j_configuration_get_zerocopy(configuration);
+	pool->multiplex = j_configuration_get_multiplex(configuration);
+	pool->warm_up = j_configuration_get_connection_warm_up(configuration);
+	pool->idle_timeout = j_configuration_get_connection_idle_timeout(configuration) * G_TIME_SPAN_SECOND;
+	pool->maintenance_thread = NULL;
+	pool->maintenance_stop = FALSE;
+	g_mutex_init(pool->maintenance_mutex);
+	g_cond_init(pool->maintenance_cond);
 
 	for (guint i = 0; i < pool->object_len; i++)
 	{
-		pool->object_queues[i].queue = g_async_queue_new();
-		pool->object_queues[i].count = 0;
+		j_connection_pool_queue_init(&(pool->object_queues[i]), j_configuration_get_server(configuration, J_BACKEND_TYPE_OBJECT, i), pool->zerocopy);
 	}
 
 	for (guint i = 0; i < pool->kv_len; i++)
 	{
-		pool->kv_queues[i].queue = g_async_queue_new();
-		pool->kv_queues[i].count = 0;
+		j_connection_pool_queue_init(&(pool->kv_queues[i]), j_configuration_get_server(configuration, J_BACKEND_TYPE_KV, i), FALSE);
 	}
 
 	for (guint i = 0; i < pool->db_len; i++)
 	{
-		pool->db_queues[i].queue = g_async_queue_new();
-		pool->db_queues[i].count = 0;
+		j_connection_pool_queue_init(&(pool->db_queues[i]), j_configuration_get_server(configuration, J_BACKEND_TYPE_DB, i), FALSE);
 	}
 
 	g_atomic_pointer_set(&j_connection_pool, pool);
+
+	if (pool->warm_up > 0)
+	{
+		g_autoptr(GPtrArray) threads = NULL;
+
+		threads = g_ptr_array_new();
+
+		// Connect to all servers concurrently to avoid serial handshakes.
+		for (guint i = 0; i < pool->object_len; i++)
+		{
+			g_ptr_array_add(threads, g_thread_new("julea-warm-up", j_connection_pool_queue_warm_up, &(pool->object_queues[i])));
+		}
+
+		// Multiplexed KV and DB requests do not use the pooled connections, object data is always sent via pooled connections
+		for (guint i = 0; i < pool->kv_len && !pool->multiplex; i++)
+		{
+			g_ptr_array_add(threads, g_thread_new("julea-warm-up", j_connection_pool_queue_warm_up, &(pool->kv_queues[i])));
+		}
+
+		for (guint i = 0; i < pool->db_len && !pool->multiplex; i++)
+		{
+			g_ptr_array_add(threads, g_thread_new("julea-warm-up", j_connection_pool_queue_warm_up, &(pool->db_queues[i])));
+		}
+
+		for (guint i = 0; i < threads->len; i++)
+		{
+			g_thread_join(g_ptr_array_index(threads, i));
+		}
+	}
+
+	if (pool->idle_timeout > 0)
+	{
+		pool->maintenance_thread = g_thread_new("julea-connection-pool", j_connection_pool_maintenance_thread, pool);
+	}
 }
 
 void
@@ -120,48 +925,37 @@ j_connection_pool_fini(void)
 	g_return_if_fail(j_connection_pool != NULL);
 
 	pool = g_atomic_pointer_get(&j_connection_pool);
-	g_atomic_pointer_set(&j_connection_pool, NULL);
 
-	for (guint i = 0; i < pool->object_len; i++)
+	if (pool->maintenance_thread != NULL)
 	{
-		GSocketConnection* connection;
+		g_mutex_lock(pool->maintenance_mutex);
+		pool->maintenance_stop = TRUE;
+		g_cond_signal(pool->maintenance_cond);
+		g_mutex_unlock(pool->maintenance_mutex);
 
-		while ((connection = g_async_queue_try_pop(pool->object_queues[i].queue)) != NULL)
-		{
-			g_io_stream_close(G_IO_STREAM(connection), NULL, NULL);
-			g_object_unref(connection);
-		}
+		g_thread_join(pool->maintenance_thread);
+	}
+
+	g_atomic_pointer_set(&j_connection_pool, NULL);
 
-		g_async_queue_unref(pool->object_queues[i].queue);
+	for (guint i = 0; i < pool->object_len; i++)
+	{
+		j_connection_pool_queue_fini(&(pool->object_queues[i]));
 	}
 
 	for (guint i = 0; i < pool->kv_len; i++)
 	{
-		GSocketConnection* connection;
-
-		while ((connection = g_async_queue_try_pop(pool->kv_queues[i].queue)) != NULL)
-		{
-			g_io_stream_close(G_IO_STREAM(connection), NULL, NULL);
-			g_object_unref(connection);
-		}
-
-		g_async_queue_unref(pool->kv_queues[i].queue);
+		j_connection_pool_queue_fini(&(pool->kv_queues[i]));
 	}
 
 	for (guint i = 0; i < pool->db_len; i++)
 	{
-		GSocketConnection* connection;
-
-		while ((connection = g_async_queue_try_pop(pool->db_queues[i].queue)) != NULL)
-		{
-			g_io_stream_close(G_IO_STREAM(connection), NULL, NULL);
-			g_object_unref(connection);
-		}
-
-		g_async_queue_unref(pool->db_queues[i].queue);
+		j_connection_pool_queue_fini(&(pool->db_queues[i]));
 	}
 
 	j_configuration_unref(pool->configuration);
+	g_mutex_clear(pool->maintenance_mutex);
+	g_cond_clear(pool->maintenance_cond);
 
 	g_free(pool->object_queues);
 	g_free(pool->kv_queues);
@@ -170,104 +964,107 @@ j_connection_pool_fini(void)
 	g_slice_free(JConnectionPool, pool);
 }
 
-static GSocketConnection*
-j_connection_pool_pop_internal(GAsyncQueue* queue, guint* count, gchar const* server)
+static JConnectionPoolQueue*
+j_connection_pool_get_queue(JBackendType backend, guint index)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	GSocketConnection* connection;
-
-	g_return_val_if_fail(queue != NULL, NULL);
-	g_return_val_if_fail(count != NULL, NULL);
-
-	connection = g_async_queue_try_pop(queue);
-
-	if (connection != NULL)
+	switch (backend)
 	{
-		return connection;
+		case J_BACKEND_TYPE_OBJECT:
+			g_return_val_if_fail(index < j_connection_pool->object_len, NULL);
+			return &(j_connection_pool->object_queues[index]);
+		case J_BACKEND_TYPE_KV:
+			g_return_val_if_fail(index < j_connection_pool->kv_len, NULL);
+			return &(j_connection_pool->kv_queues[index]);
+		case J_BACKEND_TYPE_DB:
+			g_return_val_if_fail(index < j_connection_pool->db_len, NULL);
+			return &(j_connection_pool->db_queues[index]);
+		default:
+			g_assert_not_reached();
 	}
 
-	if ((guint)g_atomic_int_get(count) < j_connection_pool->max_count)
-	{
-		if ((guint)g_atomic_int_add(count, 1) < j_connection_pool->max_count)
-		{
-			GError* error = NULL;
-			g_autoptr(GSocketClient) client = NULL;
+	return NULL;
+}
 
-			g_autoptr(JMessage) message = NULL;
-			g_autoptr(JMessage) reply = NULL;
+static GSocketConnection*
+j_connection_pool_pop_internal(JConnectionPoolQueue* queue)
+{
+	J_TRACE_FUNCTION(NULL);
 
-			guint op_count;
+	g_return_val_if_fail(queue != NULL, NULL);
 
-			client = g_socket_client_new();
-			connection = g_socket_client_connect_to_host(client, server, 4711, NULL, &error);
+	while (TRUE)
+	{
+		GSocketConnection* connection;
 
-			if (error != NULL)
-			{
-				g_critical("%s", error->message);
-				g_error_free(error);
-			}
+		connection = g_async_queue_try_pop(queue->queue);
 
-			if (connection == NULL)
+		if (connection == NULL && (guint)g_atomic_int_get(&(queue->count)) < j_connection_pool->max_count)
+		{
+			if ((guint)g_atomic_int_add(&(queue->count), 1) < j_connection_pool->max_count)
 			{
-				g_critical("Can not connect to %s [%d].", server, g_atomic_int_get(count));
-			}
+				connection = j_connection_pool_connect(queue->server, queue->zerocopy);
 
-			j_helper_set_nodelay(connection, TRUE);
+				if (connection != NULL)
+				{
+					j_connection_pool_queue_statistics_add(queue, J_STATISTICS_CONNECTIONS_CREATED, 1);
 
-			message = j_message_new(J_MESSAGE_PING, 0);
-			j_message_send(message, connection);
+					return connection;
+				}
+			}
 
-			reply = j_message_new_reply(message);
-			j_message_receive(reply, connection);
+			g_atomic_int_add(&(queue->count), -1);
+		}
 
-			op_count = j_message_get_count(reply);
+		if (connection == NULL)
+		{
+			gint64 start;
 
-			for (guint i = 0; i < op_count; i++)
+			// There are no connections that could be returned to the pool.
+			if (g_atomic_int_get(&(queue->count)) == 0)
 			{
-				gchar const* backend;
+				return NULL;
+			}
 
-				backend = j_message_get_string(reply);
+			start = g_get_monotonic_time();
+			// Use a timeout to notice if all remaining connections are closed in the meantime.
+			connection = g_async_queue_timeout_pop(queue->queue, G_TIME_SPAN_SECOND);
 
-				if (g_strcmp0(backend, "object") == 0)
-				{
-					//g_print("Server has object backend.\n");
-				}
-				else if (g_strcmp0(backend, "kv") == 0)
-				{
-					//g_print("Server has kv backend.\n");
-				}
-				else if (g_strcmp0(backend, "db") == 0)
-				{
-					//g_print("Server has db backend.\n");
-				}
+			g_mutex_lock(queue->mutex);
+			j_statistics_add(queue->statistics, J_STATISTICS_CONNECTION_WAITS, 1);
+			j_statistics_add(queue->statistics, J_STATISTICS_CONNECTION_WAIT_TIME, g_get_monotonic_time() - start);
+			g_mutex_unlock(queue->mutex);
+
+			if (connection == NULL)
+			{
+				continue;
 			}
 		}
-		else
+
+		if (!j_connection_pool_is_broken(connection))
 		{
-			g_atomic_int_add(count, -1);
+			return connection;
 		}
-	}
 
-	if (connection != NULL)
-	{
-		return connection;
+		j_connection_pool_queue_close(queue, connection);
 	}
-
-	connection = g_async_queue_pop(queue);
-
-	return connection;
 }
 
 static void
-j_connection_pool_push_internal(GAsyncQueue* queue, GSocketConnection* connection)
+j_connection_pool_push_internal(JConnectionPoolQueue* queue, GSocketConnection* connection)
 {
 	J_TRACE_FUNCTION(NULL);
 
 	g_return_if_fail(queue != NULL);
 	g_return_if_fail(connection != NULL);
 
-	g_async_queue_push(queue, connection);
+	if (j_connection_pool->idle_timeout > 0)
+	{
+		j_connection_pool_set_last_used(connection, g_get_monotonic_time());
+	}
+
+	g_async_queue_push(queue->queue, connection);
 }
 
 gpointer
@@ -275,24 +1072,18 @@ j_connection_pool_pop(JBackendType backend, guint index)
 {
 	J_TRACE_FUNCTION(NULL);
 
+	JConnectionPoolQueue* queue;
+
 	g_return_val_if_fail(j_connection_pool != NULL, NULL);
 
-	switch (backend)
+	queue = j_connection_pool_get_queue(backend, index);
+
+	if (queue == NULL)
 	{
-		case J_BACKEND_TYPE_OBJECT:
-			g_return_val_if_fail(index < j_connection_pool->object_len, NULL);
-			return j_connection_pool_pop_internal(j_connection_pool->object_queues[index].queue, &(j_connection_pool->object_queues[index].count), j_configuration_get_server(j_connection_pool->configuration, J_BACKEND_TYPE_OBJECT, index));
-		case J_BACKEND_TYPE_KV:
-			g_return_val_if_fail(index < j_connection_pool->kv_len, NULL);
-			return j_connection_pool_pop_internal(j_connection_pool->kv_queues[index].queue, &(j_connection_pool->kv_queues[index].count), j_configuration_get_server(j_connection_pool->configuration, J_BACKEND_TYPE_KV, index));
-		case J_BACKEND_TYPE_DB:
-			g_return_val_if_fail(index < j_connection_pool->db_len, NULL);
-			return j_connection_pool_pop_internal(j_connection_pool->db_queues[index].queue, &(j_connection_pool->db_queues[index].count), j_configuration_get_server(j_connection_pool->configuration, J_BACKEND_TYPE_DB, index));
-		default:
-			g_assert_not_reached();
+		return NULL;
 	}
 
-	return NULL;
+	return j_connection_pool_pop_internal(queue);
 }
 
 void
@@ -300,26 +1091,139 @@ j_connection_pool_push(JBackendType backend, guint index, gpointer connection)
 {
 	J_TRACE_FUNCTION(NULL);
 
+	JConnectionPoolQueue* queue;
+
 	g_return_if_fail(j_connection_pool != NULL);
 	g_return_if_fail(connection != NULL);
 
-	switch (backend)
+	queue = j_connection_pool_get_queue(backend, index);
+
+	if (queue != NULL)
 	{
-		case J_BACKEND_TYPE_OBJECT:
-			g_return_if_fail(index < j_connection_pool->object_len);
-			j_connection_pool_push_internal(j_connection_pool->object_queues[index].queue, connection);
-			break;
-		case J_BACKEND_TYPE_KV:
-			g_return_if_fail(index < j_connection_pool->kv_len);
-			j_connection_pool_push_internal(j_connection_pool->kv_queues[index].queue, connection);
-			break;
-		case J_BACKEND_TYPE_DB:
-			g_return_if_fail(index < j_connection_pool->db_len);
-			j_connection_pool_push_internal(j_connection_pool->db_queues[index].queue, connection);
-			break;
-		default:
-			g_assert_not_reached();
+		j_connection_pool_push_internal(queue, connection);
+	}
+}
+
+/**
+ * Returns a server's connection statistics.
+ * These include the number of established and closed connections as well as the number of times and the time in microseconds spent waiting for a connection.
+ *
+ * \code
+ * \endcode
+ *
+ * \param backend A backend type.
+ * \param index   A server index.
+ *
+ * \return A copy of the server's statistics. Should be freed with j_statistics_free().
+ **/
+JStatistics*
+j_connection_pool_get_statistics(JBackendType backend, guint index)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JConnectionPoolQueue* queue;
+	JStatistics* statistics;
+
+	g_return_val_if_fail(j_connection_pool != NULL, NULL);
+
+	queue = j_connection_pool_get_queue(backend, index);
+
+	if (queue == NULL)
+	{
+		return NULL;
+	}
+
+	statistics = j_statistics_new(FALSE);
+
+	g_mutex_lock(queue->mutex);
+	j_statistics_add(statistics, J_STATISTICS_CONNECTIONS_CREATED, j_statistics_get(queue->statistics, J_STATISTICS_CONNECTIONS_CREATED));
+	j_statistics_add(statistics, J_STATISTICS_CONNECTIONS_CLOSED, j_statistics_get(queue->statistics, J_STATISTICS_CONNECTIONS_CLOSED));
+	j_statistics_add(statistics, J_STATISTICS_CONNECTION_WAITS, j_statistics_get(queue->statistics, J_STATISTICS_CONNECTION_WAITS));
+	j_statistics_add(statistics, J_STATISTICS_CONNECTION_WAIT_TIME, j_statistics_get(queue->statistics, J_STATISTICS_CONNECTION_WAIT_TIME));
+	g_mutex_unlock(queue->mutex);
+
+	return statistics;
+}
+
+/**
+ * Sends a message to a server and receives its reply.
+ * If multiplexing is enabled, all threads share a single connection per server and replies are matched using the message IDs.
+ * Otherwise, a connection is taken from the pool for the duration of the request.
+ *
+ * This function must not be used for messages whose replies are followed by additional data.
+ *
+ * \code
+ * \endcode
+ *
+ * \param backend A backend type.
+ * \param index   A server index.
+ * \param message A message.
+ * \param reply   A reply created with j_message_new_reply() or NULL if no reply is expected.
+ *
+ * \return TRUE on success, FALSE if an error occurred.
+ **/
+gboolean
+j_connection_pool_send_receive(JBackendType backend, guint index, JMessage* message, JMessage* reply)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = FALSE;
+
+	JConnectionPoolQueue* queue;
+	gpointer connection;
+
+	g_return_val_if_fail(j_connection_pool != NULL, FALSE);
+	g_return_val_if_fail(message != NULL, FALSE);
+
+	queue = j_connection_pool_get_queue(backend, index);
+
+	if (queue == NULL)
+	{
+		return FALSE;
+	}
+
+	if (j_connection_pool->multiplex)
+	{
+		JConnectionPoolMultiplexer* multiplexer;
+
+		multiplexer = j_connection_pool_queue_get_multiplexer(queue);
+
+		if (multiplexer == NULL)
+		{
+			return FALSE;
+		}
+
+		ret = j_connection_pool_multiplexer_send(multiplexer, message, reply);
+		j_connection_pool_multiplexer_unref(multiplexer);
+
+		return ret;
+	}
+
+	connection = j_connection_pool_pop_internal(queue);
+
+	if (connection == NULL)
+	{
+		return FALSE;
+	}
+
+	ret = j_message_send(message, connection);
+
+	if (ret && reply != NULL)
+	{
+		ret = j_message_receive(reply, connection);
+	}
+
+	// The connection might still contain (parts of) the message or reply and must not be reused
+	if (!ret)
+	{
+		j_connection_pool_queue_close(queue, connection);
+
+		return FALSE;
 	}
+
+	j_connection_pool_push_internal(queue, connection);
+
+	return TRUE;
 }
 
 /**
@@ -31,6 +31,7 @@
 
 #include <jbackend.h>
 #include <jconfiguration.h>
+#include <jplacement.h>
 #include <jtrace.h>
 
 #include "distribution/distribution.h"
@@ -201,6 +202,44 @@ j_distribution_set(JDistribution* distribution, gchar const* key, guint64 value)
 	}
 }
 
+/**
+ * Derives the distribution's start index from a key using the object servers' placement.
+ * In contrast to the default random start index, the start index is deterministic and changes only for few keys when servers are added.
+ *
+ * \code
+ * \endcode
+ *
+ * \param distribution A distribution.
+ * \param key          A key, usually the object's name.
+ */
+void
+j_distribution_set_start_key(JDistribution* distribution, gchar const* key)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	guint32 index;
+
+	g_return_if_fail(distribution != NULL);
+	g_return_if_fail(key != NULL);
+
+	index = j_placement_get_server_index(J_BACKEND_TYPE_OBJECT, key);
+
+	switch (distribution->type)
+	{
+		case J_DISTRIBUTION_ROUND_ROBIN:
+			j_distribution_set(distribution, "start-index", index);
+			break;
+		case J_DISTRIBUTION_SINGLE_SERVER:
+			j_distribution_set(distribution, "index", index);
+			break;
+		case J_DISTRIBUTION_WEIGHTED:
+			// The weights determine the servers
+			break;
+		default:
+			g_warn_if_reached();
+	}
+}
+
 void
 j_distribution_set2(JDistribution* distribution, gchar const* key, guint64 value1, guint64 value2)
 {
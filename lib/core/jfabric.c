@@ -0,0 +1,948 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2020 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ **/
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <string.h>
+
+#ifdef HAVE_LIBFABRIC
+#include <rdma/fabric.h>
+#include <rdma/fi_cm.h>
+#include <rdma/fi_domain.h>
+#include <rdma/fi_endpoint.h>
+#include <rdma/fi_errno.h>
+#include <rdma/fi_rma.h>
+#endif
+
+#include <jfabric.h>
+
+#include <jconfiguration.h>
+#include <jmessage.h>
+#include <jtrace.h>
+
+/**
+ * \defgroup JFabric Fabric
+ *
+ * Optional transport that moves object data via RMA using libfabric.
+ * Control messages are still exchanged via #JMessage, only the data is transferred directly between registered buffers.
+ * Clients register their buffers and send the regions' addresses and keys to the server, which reads or writes them remotely.
+ *
+ * @{
+ **/
+
+/**
+ * A registered memory region.
+ */
+struct JFabricRegion
+{
+#ifdef HAVE_LIBFABRIC
+	struct fid_mr* mr;
+#endif
+
+	gpointer data;
+	guint64 length;
+
+	/**
+	 * The address used by peers to access the region.
+	 */
+	guint64 address;
+
+	/**
+	 * The key used by peers to access the region.
+	 */
+	guint64 key;
+};
+
+#ifdef HAVE_LIBFABRIC
+
+/**
+ * The context of a pending RMA operation.
+ */
+struct JFabricContext
+{
+	/**
+	 * Used by the provider, has to be the first member.
+	 */
+	struct fi_context fi_context;
+
+	gboolean completed;
+	gboolean failed;
+};
+
+typedef struct JFabricContext JFabricContext;
+
+struct JFabric
+{
+	struct fi_info* info;
+	struct fid_fabric* fabric;
+	struct fid_domain* domain;
+	struct fid_av* av;
+	struct fid_cq* cq;
+	struct fid_ep* ep;
+
+	/**
+	 * The endpoint's address that is sent to peers.
+	 */
+	gpointer address;
+	gsize address_length;
+
+	/**
+	 * Maps peer addresses (#GBytes) to fi_addr_t.
+	 */
+	GHashTable* peers;
+	GMutex peers_mutex[1];
+
+	/**
+	 * Buffers registered via j_fabric_register_buffer().
+	 * Contains #JFabricRegion elements.
+	 */
+	GPtrArray* buffers;
+	GMutex buffers_mutex[1];
+
+	/**
+	 * The next key to use if the provider does not generate keys.
+	 */
+	gint next_key;
+
+	/**
+	 * Completes pending operations.
+	 */
+	GThread* progress_thread;
+	gint progress_stop;
+
+	/**
+	 * Used to wait for completions.
+	 */
+	GMutex mutex[1];
+	GCond cond[1];
+};
+
+typedef struct JFabric JFabric;
+
+static JFabric* j_fabric = NULL;
+
+static void
+j_fabric_complete(JFabricContext* context, gboolean failed)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_mutex_lock(j_fabric->mutex);
+	context->failed = failed;
+	context->completed = TRUE;
+	g_cond_broadcast(j_fabric->cond);
+	g_mutex_unlock(j_fabric->mutex);
+}
+
+static gboolean
+j_fabric_wait(JFabricContext* context)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret;
+
+	g_mutex_lock(j_fabric->mutex);
+
+	while (!context->completed)
+	{
+		g_cond_wait(j_fabric->cond, j_fabric->mutex);
+	}
+
+	ret = !context->failed;
+
+	g_mutex_unlock(j_fabric->mutex);
+
+	return ret;
+}
+
+/**
+ * Drives progress and dispatches completions to the waiting operations.
+ *
+ * \private
+ *
+ * \param data Unused.
+ *
+ * \return NULL.
+ **/
+static gpointer
+j_fabric_progress_thread(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	(void)data;
+
+	while (!g_atomic_int_get(&(j_fabric->progress_stop)))
+	{
+		struct fi_cq_entry entries[16];
+		ssize_t count;
+
+		count = fi_cq_sread(j_fabric->cq, entries, G_N_ELEMENTS(entries), NULL, 100);
+
+		if (count > 0)
+		{
+			for (ssize_t i = 0; i < count; i++)
+			{
+				j_fabric_complete(entries[i].op_context, FALSE);
+			}
+		}
+		else if (count == -FI_EAVAIL)
+		{
+			struct fi_cq_err_entry error;
+
+			memset(&error, 0, sizeof(error));
+
+			if (fi_cq_readerr(j_fabric->cq, &error, 0) > 0)
+			{
+				g_warning("RMA operation failed: %s", fi_strerror(error.err));
+
+				if (error.op_context != NULL)
+				{
+					j_fabric_complete(error.op_context, TRUE);
+				}
+			}
+		}
+	}
+
+	return NULL;
+}
+
+static JFabricRegion*
+j_fabric_region_new_internal(gpointer data, guint64 length, guint64 access)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JFabricRegion* region;
+	guint64 requested_key = 0;
+	gint ret;
+
+	if (!(j_fabric->info->domain_attr->mr_mode & FI_MR_PROV_KEY))
+	{
+		requested_key = g_atomic_int_add(&(j_fabric->next_key), 1);
+	}
+
+	region = g_slice_new(JFabricRegion);
+
+	if ((ret = fi_mr_reg(j_fabric->domain, data, length, access, 0, requested_key, 0, &(region->mr), NULL)) != 0)
+	{
+		g_warning("Could not register memory region: %s", fi_strerror(-ret));
+		g_slice_free(JFabricRegion, region);
+
+		return NULL;
+	}
+
+	region->data = data;
+	region->length = length;
+	region->key = fi_mr_key(region->mr);
+	region->address = 0;
+
+	// Remote accesses are relative to the region's start unless virtual addresses are used
+	if (j_fabric->info->domain_attr->mr_mode & FI_MR_VIRT_ADDR)
+	{
+		region->address = (guint64)(guintptr)data;
+	}
+
+	return region;
+}
+
+/**
+ * Transfers data between a local buffer and a peer's memory region.
+ * Transfers are split according to the provider's maximum message size.
+ *
+ * \private
+ *
+ * \param write   Whether to write to or read from the peer.
+ * \param peer    The peer.
+ * \param data    The local buffer.
+ * \param length  The number of bytes to transfer.
+ * \param address The remote address.
+ * \param key     The remote key.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+j_fabric_transfer(gboolean write, guint64 peer, gpointer data, guint64 length, guint64 address, guint64 key)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JFabricRegion* temporary = NULL;
+	gboolean ret = TRUE;
+	gsize max_length;
+	void* desc = NULL;
+
+	if (j_fabric->info->domain_attr->mr_mode & FI_MR_LOCAL)
+	{
+		g_mutex_lock(j_fabric->buffers_mutex);
+
+		for (guint i = 0; i < j_fabric->buffers->len; i++)
+		{
+			JFabricRegion* region = g_ptr_array_index(j_fabric->buffers, i);
+
+			if ((gchar*)data >= (gchar*)region->data && (gchar*)data + length <= (gchar*)region->data + region->length)
+			{
+				desc = fi_mr_desc(region->mr);
+				break;
+			}
+		}
+
+		g_mutex_unlock(j_fabric->buffers_mutex);
+
+		// The buffer has not been registered beforehand, register it only for this transfer
+		if (desc == NULL)
+		{
+			temporary = j_fabric_region_new_internal(data, length, FI_READ | FI_WRITE);
+
+			if (temporary == NULL)
+			{
+				return FALSE;
+			}
+
+			desc = fi_mr_desc(temporary->mr);
+		}
+	}
+
+	max_length = j_fabric->info->ep_attr->max_msg_size;
+
+	for (guint64 done = 0; ret && done < length;)
+	{
+		JFabricContext context;
+		gsize chunk_length;
+		ssize_t posted;
+
+		chunk_length = MIN(length - done, max_length);
+		memset(&context, 0, sizeof(context));
+
+		do
+		{
+			if (write)
+			{
+				struct iovec iov;
+				struct fi_rma_iov rma_iov;
+				struct fi_msg_rma msg;
+
+				iov.iov_base = (gchar*)data + done;
+				iov.iov_len = chunk_length;
+
+				rma_iov.addr = address + done;
+				rma_iov.len = chunk_length;
+				rma_iov.key = key;
+
+				memset(&msg, 0, sizeof(msg));
+				msg.msg_iov = &iov;
+				msg.desc = &desc;
+				msg.iov_count = 1;
+				msg.addr = peer;
+				msg.rma_iov = &rma_iov;
+				msg.rma_iov_count = 1;
+				msg.context = &context;
+
+				// The data has to be visible to the peer before the reply is sent
+				posted = fi_writemsg(j_fabric->ep, &msg, FI_COMPLETION | FI_DELIVERY_COMPLETE);
+			}
+			else
+			{
+				posted = fi_read(j_fabric->ep, (gchar*)data + done, chunk_length, desc, peer, address + done, key, &context);
+			}
+
+			if (posted == -FI_EAGAIN)
+			{
+				g_thread_yield();
+			}
+		} while (posted == -FI_EAGAIN);
+
+		if (posted != 0)
+		{
+			g_warning("Could not post RMA operation: %s", fi_strerror(-posted));
+			ret = FALSE;
+			break;
+		}
+
+		ret = j_fabric_wait(&context);
+		done += chunk_length;
+	}
+
+	if (temporary != NULL)
+	{
+		j_fabric_region_free(temporary);
+	}
+
+	return ret;
+}
+
+static void
+j_fabric_free(JFabric* fabric)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	// Buffers have to be deregistered before the domain is closed
+	g_ptr_array_unref(fabric->buffers);
+
+	if (fabric->ep != NULL)
+	{
+		fi_close(&(fabric->ep->fid));
+	}
+
+	if (fabric->av != NULL)
+	{
+		fi_close(&(fabric->av->fid));
+	}
+
+	if (fabric->cq != NULL)
+	{
+		fi_close(&(fabric->cq->fid));
+	}
+
+	if (fabric->domain != NULL)
+	{
+		fi_close(&(fabric->domain->fid));
+	}
+
+	if (fabric->fabric != NULL)
+	{
+		fi_close(&(fabric->fabric->fid));
+	}
+
+	if (fabric->info != NULL)
+	{
+		fi_freeinfo(fabric->info);
+	}
+
+	g_free(fabric->address);
+
+	g_hash_table_unref(fabric->peers);
+
+	g_mutex_clear(fabric->peers_mutex);
+	g_mutex_clear(fabric->buffers_mutex);
+	g_mutex_clear(fabric->mutex);
+	g_cond_clear(fabric->cond);
+
+	g_slice_free(JFabric, fabric);
+}
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(JFabric, j_fabric_free)
+
+#endif
+
+/**
+ * Initializes the fabric transport.
+ * The transport is only enabled if a provider has been configured.
+ *
+ * \param configuration A configuration.
+ *
+ * \return FALSE if the transport has been configured but could not be initialized, TRUE otherwise.
+ **/
+gboolean
+j_fabric_init(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gchar const* provider;
+
+	g_return_val_if_fail(configuration != NULL, FALSE);
+
+	provider = j_configuration_get_fabric_provider(configuration);
+
+	if (provider == NULL)
+	{
+		return TRUE;
+	}
+
+#ifdef HAVE_LIBFABRIC
+	{
+		g_autoptr(JFabric) fabric = NULL;
+		struct fi_info* hints;
+		struct fi_cq_attr cq_attr;
+		struct fi_av_attr av_attr;
+		gsize address_length = 0;
+		gint ret;
+
+		g_return_val_if_fail(j_fabric == NULL, FALSE);
+
+		fabric = g_slice_new0(JFabric);
+		fabric->peers = g_hash_table_new_full(g_bytes_hash, g_bytes_equal, (GDestroyNotify)g_bytes_unref, g_free);
+		fabric->buffers = g_ptr_array_new_with_free_func((GDestroyNotify)j_fabric_region_free);
+		fabric->next_key = 1;
+		g_mutex_init(fabric->peers_mutex);
+		g_mutex_init(fabric->buffers_mutex);
+		g_mutex_init(fabric->mutex);
+		g_cond_init(fabric->cond);
+
+		hints = fi_allocinfo();
+		hints->caps = FI_RMA | FI_READ | FI_WRITE | FI_REMOTE_READ | FI_REMOTE_WRITE;
+		hints->mode = FI_CONTEXT;
+		hints->ep_attr->type = FI_EP_RDM;
+		hints->domain_attr->threading = FI_THREAD_SAFE;
+		hints->domain_attr->mr_mode = FI_MR_LOCAL | FI_MR_VIRT_ADDR | FI_MR_ALLOCATED | FI_MR_PROV_KEY;
+		// fi_freeinfo() frees the provider name
+		hints->fabric_attr->prov_name = strdup(provider);
+
+		ret = fi_getinfo(FI_VERSION(1, 5), NULL, NULL, 0, hints, &(fabric->info));
+		fi_freeinfo(hints);
+
+		if (ret != 0)
+		{
+			g_warning("Could not find libfabric provider %s: %s", provider, fi_strerror(-ret));
+			return FALSE;
+		}
+
+		if ((ret = fi_fabric(fabric->info->fabric_attr, &(fabric->fabric), NULL)) != 0
+		    || (ret = fi_domain(fabric->fabric, fabric->info, &(fabric->domain), NULL)) != 0)
+		{
+			g_warning("Could not open libfabric domain: %s", fi_strerror(-ret));
+			return FALSE;
+		}
+
+		memset(&cq_attr, 0, sizeof(cq_attr));
+		cq_attr.format = FI_CQ_FORMAT_CONTEXT;
+		cq_attr.wait_obj = FI_WAIT_UNSPEC;
+
+		memset(&av_attr, 0, sizeof(av_attr));
+		av_attr.type = fabric->info->domain_attr->av_type;
+
+		if ((ret = fi_cq_open(fabric->domain, &cq_attr, &(fabric->cq), NULL)) != 0
+		    || (ret = fi_av_open(fabric->domain, &av_attr, &(fabric->av), NULL)) != 0
+		    || (ret = fi_endpoint(fabric->domain, fabric->info, &(fabric->ep), NULL)) != 0
+		    || (ret = fi_ep_bind(fabric->ep, &(fabric->cq->fid), FI_TRANSMIT | FI_RECV)) != 0
+		    || (ret = fi_ep_bind(fabric->ep, &(fabric->av->fid), 0)) != 0
+		    || (ret = fi_enable(fabric->ep)) != 0)
+		{
+			g_warning("Could not open libfabric endpoint: %s", fi_strerror(-ret));
+			return FALSE;
+		}
+
+		// Query the address's length first
+		fi_getname(&(fabric->ep->fid), NULL, &address_length);
+		fabric->address = g_malloc0(address_length);
+		fabric->address_length = address_length;
+
+		if ((ret = fi_getname(&(fabric->ep->fid), fabric->address, &(fabric->address_length))) != 0)
+		{
+			g_warning("Could not get libfabric address: %s", fi_strerror(-ret));
+			return FALSE;
+		}
+
+		j_fabric = g_steal_pointer(&fabric);
+		j_fabric->progress_thread = g_thread_new("julea-fabric", j_fabric_progress_thread, NULL);
+
+		return TRUE;
+	}
+#else
+	g_warning("libfabric provider %s has been configured but JULEA has been built without libfabric support.", provider);
+
+	return FALSE;
+#endif
+}
+
+/**
+ * Shuts down the fabric transport.
+ **/
+void
+j_fabric_fini(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+#ifdef HAVE_LIBFABRIC
+	if (j_fabric == NULL)
+	{
+		return;
+	}
+
+	g_atomic_int_set(&(j_fabric->progress_stop), 1);
+	g_thread_join(j_fabric->progress_thread);
+
+	j_fabric_free(j_fabric);
+	j_fabric = NULL;
+#endif
+}
+
+/**
+ * Returns whether the fabric transport is used.
+ *
+ * \return TRUE if the transport is used, FALSE otherwise.
+ **/
+gboolean
+j_fabric_is_enabled(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+#ifdef HAVE_LIBFABRIC
+	return (j_fabric != NULL);
+#else
+	return FALSE;
+#endif
+}
+
+/**
+ * Returns the number of bytes appended by j_fabric_append_address().
+ *
+ * \return The length.
+ **/
+gsize
+j_fabric_get_address_length(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+#ifdef HAVE_LIBFABRIC
+	g_return_val_if_fail(j_fabric != NULL, 0);
+
+	return sizeof(guint32) + j_fabric->address_length;
+#else
+	return 0;
+#endif
+}
+
+/**
+ * Appends the local address to a message.
+ * The message must have enough space left, see j_fabric_get_address_length().
+ *
+ * \param message A message.
+ **/
+void
+j_fabric_append_address(JMessage* message)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(message != NULL);
+
+#ifdef HAVE_LIBFABRIC
+	{
+		guint32 address_length;
+
+		g_return_if_fail(j_fabric != NULL);
+
+		address_length = j_fabric->address_length;
+
+		j_message_append_4(message, &address_length);
+		j_message_append_n(message, j_fabric->address, address_length);
+	}
+#endif
+}
+
+/**
+ * Registers a buffer that peers can access remotely.
+ * Peers are only granted the requested access.
+ *
+ * \param data   A buffer.
+ * \param length The buffer's length.
+ * \param access The access granted to peers.
+ *
+ * \return A new region, NULL on failure or if length is 0. Should be freed with j_fabric_region_free().
+ **/
+JFabricRegion*
+j_fabric_region_new(gpointer data, guint64 length, JFabricAccess access)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	if (length == 0)
+	{
+		return NULL;
+	}
+
+	g_return_val_if_fail(data != NULL, NULL);
+
+#ifdef HAVE_LIBFABRIC
+	g_return_val_if_fail(j_fabric != NULL, NULL);
+
+	return j_fabric_region_new_internal(data, length, (access == J_FABRIC_ACCESS_WRITE) ? FI_REMOTE_WRITE : FI_REMOTE_READ);
+#else
+	(void)length;
+	(void)access;
+
+	return NULL;
+#endif
+}
+
+/**
+ * Deregisters a region.
+ *
+ * \param region A region.
+ **/
+void
+j_fabric_region_free(JFabricRegion* region)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	if (region == NULL)
+	{
+		return;
+	}
+
+#ifdef HAVE_LIBFABRIC
+	fi_close(&(region->mr->fid));
+#endif
+
+	g_slice_free(JFabricRegion, region);
+}
+
+/**
+ * Appends a region's address and key to a message.
+ * A NULL region is appended as an invalid region, which causes the peer's accesses to fail.
+ *
+ * \param region  A region, can be NULL.
+ * \param message A message.
+ **/
+void
+j_fabric_region_append(JFabricRegion* region, JMessage* message)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	guint64 address = 0;
+	guint64 key = 0;
+
+	g_return_if_fail(message != NULL);
+
+	if (region != NULL)
+	{
+		address = region->address;
+		key = region->key;
+	}
+
+	j_message_append_8(message, &address);
+	j_message_append_8(message, &key);
+}
+
+/**
+ * Registers a local buffer that is used for RMA operations.
+ * Providers requiring local registration otherwise have to register buffers for each operation.
+ * Registered buffers stay registered until the transport is shut down.
+ *
+ * \param data   A buffer.
+ * \param length The buffer's length.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+gboolean
+j_fabric_register_buffer(gpointer data, guint64 length)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(data != NULL, FALSE);
+
+#ifdef HAVE_LIBFABRIC
+	{
+		JFabricRegion* region;
+
+		if (j_fabric == NULL)
+		{
+			return FALSE;
+		}
+
+		region = j_fabric_region_new_internal(data, length, FI_READ | FI_WRITE);
+
+		if (region == NULL)
+		{
+			return FALSE;
+		}
+
+		g_mutex_lock(j_fabric->buffers_mutex);
+		g_ptr_array_add(j_fabric->buffers, region);
+		g_mutex_unlock(j_fabric->buffers_mutex);
+
+		return TRUE;
+	}
+#else
+	(void)length;
+
+	return FALSE;
+#endif
+}
+
+/**
+ * Deregisters a local buffer registered via j_fabric_register_buffer().
+ * Has to be called before the buffer is freed.
+ *
+ * \param data A buffer.
+ **/
+void
+j_fabric_deregister_buffer(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(data != NULL);
+
+#ifdef HAVE_LIBFABRIC
+	if (j_fabric == NULL)
+	{
+		return;
+	}
+
+	g_mutex_lock(j_fabric->buffers_mutex);
+
+	for (guint i = 0; i < j_fabric->buffers->len; i++)
+	{
+		JFabricRegion* region = g_ptr_array_index(j_fabric->buffers, i);
+
+		if (region->data == data)
+		{
+			g_ptr_array_remove_index_fast(j_fabric->buffers, i);
+			break;
+		}
+	}
+
+	g_mutex_unlock(j_fabric->buffers_mutex);
+#endif
+}
+
+/**
+ * Gets a peer's address from a message.
+ * Peers are added to the address vector on first use.
+ * The address is consumed even if the fabric transport is not used.
+ *
+ * \param message A message.
+ * \param peer    Returns the peer.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+gboolean
+j_fabric_get_peer(JMessage* message, guint64* peer)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gconstpointer address_data;
+	guint32 address_length;
+
+	g_return_val_if_fail(message != NULL, FALSE);
+	g_return_val_if_fail(peer != NULL, FALSE);
+
+	// The address has to be consumed even if the fabric is not available, the rest of the message could not be parsed otherwise
+	address_length = j_message_get_4(message);
+
+	if ((address_data = j_message_get_n(message, address_length)) == NULL)
+	{
+		return FALSE;
+	}
+
+#ifdef HAVE_LIBFABRIC
+	{
+		g_autoptr(GBytes) address = NULL;
+		gboolean ret = TRUE;
+		fi_addr_t* fi_addr;
+
+		if (j_fabric == NULL)
+		{
+			return FALSE;
+		}
+
+		address = g_bytes_new(address_data, address_length);
+
+		g_mutex_lock(j_fabric->peers_mutex);
+
+		if ((fi_addr = g_hash_table_lookup(j_fabric->peers, address)) == NULL)
+		{
+			fi_addr = g_new(fi_addr_t, 1);
+
+			if (fi_av_insert(j_fabric->av, g_bytes_get_data(address, NULL), 1, fi_addr, 0, NULL) == 1)
+			{
+				g_hash_table_insert(j_fabric->peers, g_bytes_ref(address), fi_addr);
+			}
+			else
+			{
+				g_warning("Could not add libfabric peer.");
+				g_free(fi_addr);
+				fi_addr = NULL;
+				ret = FALSE;
+			}
+		}
+
+		if (fi_addr != NULL)
+		{
+			*peer = *fi_addr;
+		}
+
+		g_mutex_unlock(j_fabric->peers_mutex);
+
+		return ret;
+	}
+#else
+	return FALSE;
+#endif
+}
+
+/**
+ * Reads data from a peer's region into a local buffer.
+ *
+ * \param peer    A peer, see j_fabric_get_peer().
+ * \param data    A buffer.
+ * \param length  The number of bytes to read.
+ * \param address The remote address.
+ * \param key     The remote key.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+gboolean
+j_fabric_read(guint64 peer, gpointer data, guint64 length, guint64 address, guint64 key)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(data != NULL, FALSE);
+
+#ifdef HAVE_LIBFABRIC
+	g_return_val_if_fail(j_fabric != NULL, FALSE);
+
+	return j_fabric_transfer(FALSE, peer, data, length, address, key);
+#else
+	(void)peer;
+	(void)length;
+	(void)address;
+	(void)key;
+
+	return FALSE;
+#endif
+}
+
+/**
+ * Writes data from a local buffer into a peer's region.
+ * The data is visible to the peer when the function returns.
+ *
+ * \param peer    A peer, see j_fabric_get_peer().
+ * \param data    A buffer.
+ * \param length  The number of bytes to write.
+ * \param address The remote address.
+ * \param key     The remote key.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+gboolean
+j_fabric_write(guint64 peer, gconstpointer data, guint64 length, guint64 address, guint64 key)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(data != NULL, FALSE);
+
+#ifdef HAVE_LIBFABRIC
+	g_return_val_if_fail(j_fabric != NULL, FALSE);
+
+	// Remote writes do not modify the local buffer
+	return j_fabric_transfer(TRUE, peer, (gpointer)data, length, address, key);
+#else
+	(void)peer;
+	(void)length;
+	(void)address;
+	(void)key;
+
+	return FALSE;
+#endif
+}
+
+/**
+ * @}
+ **/
@@ -58,6 +58,12 @@ j_helper_set_nodelay(GSocketConnection* connection, gboolean enable)
 
 	g_return_if_fail(connection != NULL);
 
+	// Local connections do not use TCP.
+	if (!G_IS_TCP_CONNECTION(connection))
+	{
+		return;
+	}
+
 	socket_ = g_socket_connection_get_socket(connection);
 	fd = g_socket_get_fd(socket_);
 
@@ -76,6 +82,11 @@ j_helper_set_cork(GSocketConnection* connection, gboolean enable)
 
 	g_return_if_fail(connection != NULL);
 
+	if (!G_IS_TCP_CONNECTION(connection))
+	{
+		return;
+	}
+
 	socket_ = g_socket_connection_get_socket(connection);
 	fd = g_socket_get_fd(socket_);
 
@@ -114,6 +125,49 @@ j_helper_str_replace(gchar const* str, gchar const* old, gchar const* new)
 	return replace;
 }
 
+/**
+ * Returns the path of the Unix domain socket used by a server for local clients.
+ * The socket is located in a private directory within the user's runtime directory.
+ *
+ * \param port The server's port.
+ *
+ * \return The socket's path. Should be freed with g_free().
+ **/
+gchar*
+j_helper_get_local_socket_path(guint16 port)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autofree gchar* name = NULL;
+
+	name = g_strdup_printf("julea-%u.socket", port);
+
+	// Shared directories such as /tmp would allow other users to create the socket in place of the server
+	return g_build_filename(g_get_user_runtime_dir(), "julea", name, NULL);
+}
+
+/**
+ * Checks whether a host name refers to the local host.
+ *
+ * \private
+ *
+ * \param host A host name.
+ *
+ * \return TRUE if the host is the local host, FALSE otherwise.
+ **/
+gboolean
+j_helper_is_local_host(gchar const* host)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(host != NULL, FALSE);
+
+	return (g_strcmp0(host, "localhost") == 0
+		|| g_strcmp0(host, "127.0.0.1") == 0
+		|| g_strcmp0(host, "::1") == 0
+		|| g_strcmp0(host, g_get_host_name()) == 0);
+}
+
 gboolean
 j_helper_execute_parallel(JBackgroundOperationFunc func, gpointer* data, guint length)
 {
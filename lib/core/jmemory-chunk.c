@@ -28,6 +28,8 @@
 
 #include <jmemory-chunk.h>
 
+#include <jhelper.h>
+
 #include <jtrace.h>
 
 /**
@@ -35,6 +37,8 @@
  * @{
  **/
 
+#define J_MEMORY_CHUNK_ALIGNMENT 4096
+
 /**
  * A cache.
  */
@@ -80,7 +84,8 @@ j_memory_chunk_new(guint64 size)
 
 	cache = g_slice_new(JMemoryChunk);
 	cache->size = size;
-	cache->data = g_malloc(cache->size);
+	// Aligned memory allows the data to be used for direct I/O
+	cache->data = j_helper_alloc_aligned(J_MEMORY_CHUNK_ALIGNMENT, (cache->size + J_MEMORY_CHUNK_ALIGNMENT - 1) / J_MEMORY_CHUNK_ALIGNMENT * J_MEMORY_CHUNK_ALIGNMENT);
 	cache->current = cache->data;
 
 	return cache;
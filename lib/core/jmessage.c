@@ -28,6 +28,14 @@
 #include <math.h>
 #include <string.h>
 
+#include <sys/socket.h>
+
+#ifdef HAVE_MSG_ZEROCOPY
+#include <errno.h>
+#include <linux/errqueue.h>
+#include <poll.h>
+#endif
+
 #include <jmessage.h>
 
 #include <jhelper-internal.h>
@@ -68,6 +76,21 @@ enum JMessageSemantics
 
 typedef enum JMessageSemantics JMessageSemantics;
 
+/**
+ * Message flags.
+ * They are stored alongside the serialized semantics.
+ **/
+enum JMessageFlags
+{
+	/**
+	 * The message is sent via a multiplexed connection.
+	 * Its reply might be sent out of order.
+	 **/
+	J_MESSAGE_FLAGS_MULTIPLEXED = 1 << 30
+};
+
+typedef enum JMessageFlags JMessageFlags;
+
 /**
  * Additional message data.
  **/
@@ -154,6 +177,11 @@ struct JMessage
 	 **/
 	JList* send_list;
 
+	/**
+	 * The number of bytes of the header and data received so far by j_message_receive_nonblocking().
+	 **/
+	gsize received;
+
 	/**
 	 * The original message.
 	 * Set if the message is a reply, NULL otherwise.
@@ -166,6 +194,39 @@ struct JMessage
 	gint ref_count;
 };
 
+/**
+ * The maximum number of vectors passed to a single sendmsg call.
+ * This corresponds to Linux's UIO_MAXIOV.
+ **/
+#define J_MESSAGE_VECTORS_MAX 1024
+
+/**
+ * The minimum amount of additional data required to use zero-copy sends.
+ * Smaller messages are cheaper to copy than to pin and wait for.
+ **/
+#define J_MESSAGE_ZEROCOPY_THRESHOLD (64 * 1024)
+
+/**
+ * Zero-copy state of a connection.
+ **/
+struct JMessageZerocopy
+{
+	/**
+	 * The number of zero-copy sends.
+	 **/
+	guint32 sent;
+
+	/**
+	 * The number of completed zero-copy sends.
+	 **/
+	guint32 completed;
+};
+
+typedef struct JMessageZerocopy JMessageZerocopy;
+
+G_DEFINE_QUARK(j-message-send-lock, j_message_send_lock)
+G_DEFINE_QUARK(j-message-zerocopy, j_message_zerocopy)
+
 /**
  * Returns a message's length.
  *
@@ -190,6 +251,172 @@ j_message_length(JMessage const* message)
 	return GUINT32_FROM_LE(length);
 }
 
+/**
+ * Returns a new message ID.
+ * IDs are unique within a process until they wrap around.
+ *
+ * \private
+ *
+ * \return A message ID.
+ **/
+static guint32
+j_message_next_id(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	static gsize initialized = 0;
+	static gint id = 0;
+
+	if (g_once_init_enter(&initialized))
+	{
+		g_atomic_int_set(&id, g_random_int());
+		g_once_init_leave(&initialized, 1);
+	}
+
+	return g_atomic_int_add(&id, 1);
+}
+
+static void
+j_message_send_lock_free(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	GMutex* mutex = data;
+
+	g_mutex_clear(mutex);
+	g_slice_free(GMutex, mutex);
+}
+
+#ifdef HAVE_MSG_ZEROCOPY
+static void
+j_message_zerocopy_free(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_slice_free(JMessageZerocopy, data);
+}
+#endif
+
+/**
+ * Sends a number of vectors, using as few sendmsg calls as possible.
+ *
+ * \private
+ *
+ * \param socket_     A socket.
+ * \param vectors     The vectors. Will be modified.
+ * \param vectors_len The number of vectors.
+ * \param flags       Flags for sendmsg.
+ * \param sends       Returns the number of sendmsg calls.
+ * \param error       A GError.
+ *
+ * \return TRUE on success, FALSE if an error occurred.
+ **/
+static gboolean
+j_message_send_vectors(GSocket* socket_, GOutputVector* vectors, guint vectors_len, gint flags, guint32* sends, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	*sends = 0;
+
+	while (vectors_len > 0)
+	{
+		gssize bytes_sent;
+
+		bytes_sent = g_socket_send_message(socket_, NULL, vectors, MIN(vectors_len, J_MESSAGE_VECTORS_MAX), NULL, 0, flags, NULL, error);
+
+		if (bytes_sent < 0)
+		{
+			return FALSE;
+		}
+
+		(*sends)++;
+
+		// Skip all vectors that have been sent completely and adjust a partially sent one.
+		while (vectors_len > 0 && (gsize)bytes_sent >= vectors->size)
+		{
+			bytes_sent -= vectors->size;
+			vectors++;
+			vectors_len--;
+		}
+
+		if (vectors_len > 0)
+		{
+			vectors->buffer = (gchar const*)vectors->buffer + bytes_sent;
+			vectors->size -= bytes_sent;
+		}
+	}
+
+	return TRUE;
+}
+
+#ifdef HAVE_MSG_ZEROCOPY
+/**
+ * Waits for all zero-copy sends on a socket to complete.
+ * Afterwards, the kernel does not reference the sent buffers anymore.
+ *
+ * \private
+ *
+ * \param socket_  A socket.
+ * \param zerocopy The socket's zero-copy state.
+ *
+ * \return TRUE on success, FALSE if an error occurred.
+ **/
+static gboolean
+j_message_wait_zerocopy(GSocket* socket_, JMessageZerocopy* zerocopy)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gint fd;
+
+	fd = g_socket_get_fd(socket_);
+
+	while (zerocopy->completed != zerocopy->sent)
+	{
+		struct cmsghdr* cmsg;
+		struct msghdr msg;
+		gchar control[128];
+
+		memset(&msg, 0, sizeof(msg));
+		msg.msg_control = control;
+		msg.msg_controllen = sizeof(control);
+
+		// Reading from the error queue never blocks.
+		if (recvmsg(fd, &msg, MSG_ERRQUEUE) == -1)
+		{
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+			{
+				// POLLERR is always reported.
+				struct pollfd pfd = { .fd = fd, .events = 0, .revents = 0 };
+
+				poll(&pfd, 1, -1);
+				continue;
+			}
+			else if (errno == EINTR)
+			{
+				continue;
+			}
+
+			return FALSE;
+		}
+
+		for (cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg))
+		{
+			struct sock_extended_err const* serr = (struct sock_extended_err const*)(gpointer)CMSG_DATA(cmsg);
+
+			if (serr->ee_errno != 0 || serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY)
+			{
+				continue;
+			}
+
+			// Notifications cover the range of sends from ee_info to ee_data.
+			zerocopy->completed += serr->ee_data - serr->ee_info + 1;
+		}
+	}
+
+	return TRUE;
+}
+#endif
+
 static void
 j_message_data_free(gpointer data)
 {
@@ -312,23 +539,24 @@ j_message_new(JMessageType op_type, gsize length)
 	J_TRACE_FUNCTION(NULL);
 
 	JMessage* message;
-	guint32 rand;
+	guint32 id;
 
 	//g_return_val_if_fail(op_type != J_MESSAGE_NONE, NULL);
 
 	length = MAX(256, length);
-	rand = g_random_int();
+	id = j_message_next_id();
 
 	message = g_slice_new(JMessage);
 	message->size = length;
 	message->data = g_malloc(message->size);
 	message->current = message->data;
 	message->send_list = j_list_new(j_message_data_free);
+	message->received = 0;
 	message->original_message = NULL;
 	message->ref_count = 1;
 
 	message->header.length = GUINT32_TO_LE(0);
-	message->header.id = GUINT32_TO_LE(rand);
+	message->header.id = GUINT32_TO_LE(id);
 	message->header.semantics = GUINT32_TO_LE(0);
 	message->header.op_type = GUINT32_TO_LE(op_type);
 	message->header.op_count = GUINT32_TO_LE(0);
@@ -360,6 +588,7 @@ j_message_new_reply(JMessage* message)
 	reply->data = g_malloc(reply->size);
 	reply->current = reply->data;
 	reply->send_list = j_list_new(j_message_data_free);
+	reply->received = 0;
 	reply->original_message = j_message_ref(message);
 	reply->ref_count = 1;
 
@@ -481,6 +710,79 @@ j_message_get_count(JMessage const* message)
 	return op_count;
 }
 
+/**
+ * Returns a message's ID.
+ * Replies have the same ID as their original message.
+ *
+ * \code
+ * \endcode
+ *
+ * \param message A message.
+ *
+ * \return The message's ID.
+ **/
+guint32
+j_message_get_id(JMessage const* message)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	guint32 id;
+
+	g_return_val_if_fail(message != NULL, 0);
+
+	id = message->header.id;
+	id = GUINT32_FROM_LE(id);
+
+	return id;
+}
+
+/**
+ * Marks a message as multiplexed.
+ * The server is then allowed to handle it concurrently with other messages received via the same connection.
+ *
+ * \code
+ * \endcode
+ *
+ * \param message A message.
+ **/
+void
+j_message_set_multiplexed(JMessage* message)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	guint32 semantics;
+
+	g_return_if_fail(message != NULL);
+
+	semantics = GUINT32_FROM_LE(message->header.semantics);
+	semantics |= J_MESSAGE_FLAGS_MULTIPLEXED;
+	message->header.semantics = GUINT32_TO_LE(semantics);
+}
+
+/**
+ * Returns whether a message is multiplexed.
+ *
+ * \code
+ * \endcode
+ *
+ * \param message A message.
+ *
+ * \return TRUE if the message is multiplexed, FALSE otherwise.
+ **/
+gboolean
+j_message_get_multiplexed(JMessage const* message)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	guint32 semantics;
+
+	g_return_val_if_fail(message != NULL, FALSE);
+
+	semantics = GUINT32_FROM_LE(message->header.semantics);
+
+	return ((semantics & J_MESSAGE_FLAGS_MULTIPLEXED) != 0);
+}
+
 /**
  * Appends 1 byte to a message.
  *
@@ -798,14 +1100,115 @@ j_message_receive(JMessage* message, gpointer connection)
 	return j_message_read(message, stream);
 }
 
+/**
+ * Reads a message from the network without blocking.
+ * Only the data that is currently available is read, that is, the function has to be called again once more data has arrived.
+ * The progress is stored in the message, so it must not be used for anything else until it has been received completely.
+ *
+ * \code
+ * \endcode
+ *
+ * \param message    A message.
+ * \param connection A network connection.
+ * \param complete   Returns whether the message has been received completely.
+ *
+ * \return TRUE on success, FALSE if an error occurred or the connection has been closed.
+ **/
+gboolean
+j_message_receive_nonblocking(JMessage* message, gpointer connection, gboolean* complete)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = FALSE;
+
+	GError* error = NULL;
+	GSocket* socket_;
+
+	g_return_val_if_fail(message != NULL, FALSE);
+	g_return_val_if_fail(connection != NULL, FALSE);
+	g_return_val_if_fail(complete != NULL, FALSE);
+
+	socket_ = g_socket_connection_get_socket(connection);
+	*complete = FALSE;
+
+	while (TRUE)
+	{
+		gchar* buffer;
+		gsize length;
+		gssize bytes_read;
+
+		if (message->received < sizeof(JMessageHeader))
+		{
+			buffer = (gchar*)&(message->header) + message->received;
+			length = sizeof(JMessageHeader) - message->received;
+		}
+		else
+		{
+			gsize data_received;
+
+			data_received = message->received - sizeof(JMessageHeader);
+
+			if (data_received == j_message_length(message))
+			{
+				message->current = message->data;
+				message->received = 0;
+
+				*complete = TRUE;
+				ret = TRUE;
+
+				break;
+			}
+
+			if (data_received == 0)
+			{
+				j_message_ensure_size(message, j_message_length(message));
+			}
+
+			buffer = message->data + data_received;
+			length = j_message_length(message) - data_received;
+		}
+
+		bytes_read = g_socket_receive_with_blocking(socket_, buffer, length, FALSE, NULL, &error);
+
+		if (bytes_read < 0)
+		{
+			// No more data available for now
+			if (g_error_matches(error, G_IO_ERROR, G_IO_ERROR_WOULD_BLOCK))
+			{
+				g_clear_error(&error);
+				ret = TRUE;
+			}
+
+			break;
+		}
+
+		// The connection has been closed
+		if (bytes_read == 0)
+		{
+			break;
+		}
+
+		message->received += bytes_read;
+	}
+
+	if (error != NULL)
+	{
+		g_critical("%s", error->message);
+		g_error_free(error);
+	}
+
+	return ret;
+}
+
 /**
  * Writes a message to the network.
+ * The header, the message and all additional data are gathered and sent using a single sendmsg call if possible.
  *
  * \code
  * \endcode
  *
- * \param message A message.
- * \parem stream  A network stream.
+ * \param message    A message.
+ * \param connection A network connection.
  *
  * \return TRUE on success, FALSE if an error occurred.
  **/
@@ -814,23 +1217,186 @@ j_message_send(JMessage* message, gpointer connection)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	gboolean ret;
+	gboolean ret = FALSE;
 
-	GOutputStream* stream;
+	g_autoptr(JListIterator) iterator = NULL;
+	g_autofree GOutputVector* vectors = NULL;
+	GError* error = NULL;
+	GMutex* mutex;
+	GSocket* socket_;
+	JMessageZerocopy* zerocopy;
+	gboolean cork;
+	gint flags = 0;
+	guint vectors_len = 2;
+	guint64 send_length = 0;
+	guint32 sends;
 
 	g_return_val_if_fail(message != NULL, FALSE);
 	g_return_val_if_fail(connection != NULL, FALSE);
 
-	j_helper_set_cork(connection, TRUE);
+	socket_ = g_socket_connection_get_socket(connection);
+
+	if (message->send_list != NULL)
+	{
+		vectors_len += j_list_length(message->send_list);
+	}
+
+	// Gather the header, the message and all additional data to be able to send them using a single sendmsg call.
+	vectors = g_new(GOutputVector, vectors_len);
+	vectors[0].buffer = &(message->header);
+	vectors[0].size = sizeof(JMessageHeader);
+	vectors[1].buffer = message->data;
+	vectors[1].size = j_message_length(message);
+
+	if (message->send_list != NULL)
+	{
+		guint i = 2;
+
+		iterator = j_list_iterator_new(message->send_list);
+
+		while (j_list_iterator_next(iterator))
+		{
+			JMessageData* message_data = j_list_iterator_get(iterator);
+
+			vectors[i].buffer = message_data->data;
+			vectors[i].size = message_data->length;
+			send_length += message_data->length;
+			i++;
+		}
+	}
+
+	// Corking is only necessary if multiple sendmsg calls are required.
+	cork = (vectors_len > J_MESSAGE_VECTORS_MAX);
 
-	stream = g_io_stream_get_output_stream(G_IO_STREAM(connection));
-	ret = j_message_write(message, stream);
+	mutex = g_object_get_qdata(G_OBJECT(connection), j_message_send_lock_quark());
+	zerocopy = g_object_get_qdata(G_OBJECT(connection), j_message_zerocopy_quark());
 
-	j_helper_set_cork(connection, FALSE);
+#ifdef HAVE_MSG_ZEROCOPY
+	if (zerocopy != NULL && send_length >= J_MESSAGE_ZEROCOPY_THRESHOLD)
+	{
+		flags |= MSG_ZEROCOPY;
+	}
+#endif
+
+	if (mutex != NULL)
+	{
+		g_mutex_lock(mutex);
+	}
+
+	if (cork)
+	{
+		j_helper_set_cork(connection, TRUE);
+	}
+
+	ret = j_message_send_vectors(socket_, vectors, vectors_len, flags, &sends, &error);
+
+	if (cork)
+	{
+		j_helper_set_cork(connection, FALSE);
+	}
+
+#ifdef HAVE_MSG_ZEROCOPY
+	if (flags & MSG_ZEROCOPY)
+	{
+		// The caller owns the additional data, so we have to wait until the kernel is done with it.
+		zerocopy->sent += sends;
+		ret = j_message_wait_zerocopy(socket_, zerocopy) && ret;
+	}
+#else
+	(void)zerocopy;
+	(void)sends;
+#endif
+
+	if (mutex != NULL)
+	{
+		g_mutex_unlock(mutex);
+	}
+
+	if (error != NULL)
+	{
+		g_critical("%s", error->message);
+		g_error_free(error);
+	}
 
 	return ret;
 }
 
+/**
+ * Enables zero-copy sends for a connection.
+ * j_message_send() will use MSG_ZEROCOPY for messages with large amounts of additional data.
+ * This function has to be called before the connection is used concurrently.
+ *
+ * \code
+ * \endcode
+ *
+ * \param connection A connection.
+ *
+ * \return TRUE if zero-copy sends are supported, FALSE otherwise.
+ **/
+gboolean
+j_message_enable_zerocopy(gpointer connection)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(connection != NULL, FALSE);
+
+#ifdef HAVE_MSG_ZEROCOPY
+	if (g_object_get_qdata(G_OBJECT(connection), j_message_zerocopy_quark()) == NULL)
+	{
+		JMessageZerocopy* zerocopy;
+		GSocket* socket_;
+		gint const flag = 1;
+
+		socket_ = g_socket_connection_get_socket(connection);
+
+		if (setsockopt(g_socket_get_fd(socket_), SOL_SOCKET, SO_ZEROCOPY, &flag, sizeof(flag)) != 0)
+		{
+			return FALSE;
+		}
+
+		zerocopy = g_slice_new(JMessageZerocopy);
+		zerocopy->sent = 0;
+		zerocopy->completed = 0;
+
+		g_object_set_qdata_full(G_OBJECT(connection), j_message_zerocopy_quark(), zerocopy, j_message_zerocopy_free);
+	}
+
+	return TRUE;
+#else
+	return FALSE;
+#endif
+}
+
+/**
+ * Marks a connection as shared by multiple threads.
+ * Messages sent via j_message_send() are serialized for shared connections.
+ * This function has to be called before the connection is used concurrently.
+ *
+ * \code
+ * \endcode
+ *
+ * \param connection A connection.
+ **/
+void
+j_message_share_connection(gpointer connection)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	GMutex* mutex;
+
+	g_return_if_fail(connection != NULL);
+
+	if (g_object_get_qdata(G_OBJECT(connection), j_message_send_lock_quark()) != NULL)
+	{
+		return;
+	}
+
+	mutex = g_slice_new(GMutex);
+	g_mutex_init(mutex);
+
+	g_object_set_qdata_full(G_OBJECT(connection), j_message_send_lock_quark(), mutex, j_message_send_lock_free);
+}
+
 /**
  * Reads a message from the network.
  *
@@ -869,9 +1435,10 @@ j_message_read(JMessage* message, GInputStream* stream)
 
 	message->current = message->data;
 
-	if (message->original_message != NULL)
+	if (message->original_message != NULL && message->header.id != message->original_message->header.id)
 	{
-		g_assert(message->header.id == message->original_message->header.id);
+		g_critical("Received reply to message %u instead of message %u.", j_message_get_id(message), j_message_get_id(message->original_message));
+		goto end;
 	}
 
 	ret = TRUE;
@@ -886,6 +1453,74 @@ end:
 	return ret;
 }
 
+/**
+ * Reads a reply from a multiplexed connection.
+ * Replies might arrive in any order, so the reply to fill is looked up using the received message ID.
+ *
+ * \code
+ * \endcode
+ *
+ * \param stream      A network stream.
+ * \param lookup_func A function returning the reply for a message ID.
+ * \param data        User data passed to lookup_func.
+ * \param message     Returns the received reply.
+ *
+ * \return TRUE on success, FALSE if an error occurred.
+ **/
+gboolean
+j_message_read_multiplexed(GInputStream* stream, JMessageLookupFunc lookup_func, gpointer data, JMessage** message)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = FALSE;
+
+	GError* error = NULL;
+	JMessageHeader header;
+	JMessage* reply;
+	gsize bytes_read;
+	guint32 id;
+
+	g_return_val_if_fail(stream != NULL, FALSE);
+	g_return_val_if_fail(lookup_func != NULL, FALSE);
+	g_return_val_if_fail(message != NULL, FALSE);
+
+	if (!g_input_stream_read_all(stream, &header, sizeof(JMessageHeader), &bytes_read, NULL, &error) || bytes_read != sizeof(JMessageHeader))
+	{
+		goto end;
+	}
+
+	id = GUINT32_FROM_LE(header.id);
+	reply = lookup_func(id, data);
+
+	if (reply == NULL)
+	{
+		g_critical("Received reply to unknown message %u.", id);
+		goto end;
+	}
+
+	reply->header = header;
+	j_message_ensure_size(reply, j_message_length(reply));
+
+	if (!g_input_stream_read_all(stream, reply->data, j_message_length(reply), &bytes_read, NULL, &error) || bytes_read != j_message_length(reply))
+	{
+		goto end;
+	}
+
+	reply->current = reply->data;
+	*message = reply;
+
+	ret = TRUE;
+
+end:
+	if (error != NULL)
+	{
+		g_critical("%s", error->message);
+		g_error_free(error);
+	}
+
+	return ret;
+}
+
 /**
  * Writes a message to the network.
  *
@@ -1012,6 +1647,9 @@ j_message_set_semantics(JMessage* message, JSemantics* semantics)
 	g_return_if_fail(message != NULL);
 	g_return_if_fail(semantics != NULL);
 
+	// Preserve the message flags
+	serialized_semantics = GUINT32_FROM_LE(message->header.semantics) & J_MESSAGE_FLAGS_MULTIPLEXED;
+
 #define SERIALIZE_SEMANTICS(type, key) \
 	{ \
 		gint tmp; \
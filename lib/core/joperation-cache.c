@@ -64,17 +64,22 @@ struct JOperationCache
 	GThread* thread;
 
 	/**
-	 * Whether #thread is currently working.
+	 * The number of batches that have been added but not executed yet.
 	 */
-	gboolean working;
+	guint pending;
 
 	/**
-	 * The mutex for #working.
+	 * Whether a batch executed by #thread has failed since the last flush.
+	 */
+	gboolean failed;
+
+	/**
+	 * The mutex for #pending.
 	 */
 	GMutex mutex[1];
 
 	/**
-	 * The condition for #working.
+	 * The condition for #pending.
 	 */
 	GCond cond[1];
 };
@@ -107,19 +112,29 @@ j_operation_cache_thread(gpointer data)
 			return NULL;
 		}
 
-		j_batch_execute_internal(cached_batch->batch);
+		if (!j_batch_execute_internal(cached_batch->batch))
+		{
+			g_mutex_lock(cache->mutex);
+			cache->failed = TRUE;
+			g_mutex_unlock(cache->mutex);
+		}
 
 		j_batch_unref(cached_batch->batch);
-		j_cache_release(j_operation_cache->cache, cached_batch->data);
+
+		if (cached_batch->data != NULL)
+		{
+			j_cache_release(cache->cache, cached_batch->data);
+		}
+
 		g_slice_free(JCachedBatch, cached_batch);
 
 		g_mutex_lock(cache->mutex);
 
-		cache->working = (g_async_queue_length(cache->queue) > 0);
+		cache->pending--;
 
-		if (!cache->working)
+		if (cache->pending == 0)
 		{
-			g_cond_signal(cache->cond);
+			g_cond_broadcast(cache->cond);
 		}
 
 		g_mutex_unlock(cache->mutex);
@@ -128,76 +143,43 @@ j_operation_cache_thread(gpointer data)
 	return NULL;
 }
 
+/**
+ * Checks whether an operation can be executed in the background.
+ *
+ * \private
+ *
+ * \param operation An operation.
+ *
+ * \return TRUE if the operation can be cached, FALSE otherwise.
+ **/
 static gboolean
 j_operation_cache_test(JOperation* operation)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	gboolean ret = FALSE;
-
-	(void)operation;
-
-	/* FIXME
-	switch (operation->type)
-	{
-		case J_OPERATION_COLLECTION_CREATE:
-		case J_OPERATION_COLLECTION_DELETE:
-		case J_OPERATION_ITEM_CREATE:
-		case J_OPERATION_ITEM_DELETE:
-		case J_OPERATION_ITEM_WRITE:
-			ret = TRUE;
-			break;
-
-		case J_OPERATION_COLLECTION_GET:
-		case J_OPERATION_ITEM_GET:
-		case J_OPERATION_ITEM_GET_STATUS:
-		case J_OPERATION_ITEM_READ:
-			ret = FALSE;
-			break;
-
-		case J_OPERATION_NONE:
-		default:
-			g_warn_if_reached();
-	}
-	*/
-
-	return ret;
+	return (operation->cache_func != NULL);
 }
 
+/**
+ * Returns the number of bytes needed to copy an operation's data.
+ *
+ * \private
+ *
+ * \param operation An operation.
+ *
+ * \return The required size.
+ **/
 static guint64
 j_operation_cache_get_required_size(JOperation* operation)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	guint64 ret = 0;
-
-	(void)operation;
-
-	/* FIXME
-	switch (operation->type)
+	if (operation->cache_size_func == NULL)
 	{
-		case J_OPERATION_ITEM_WRITE:
-			ret = operation->item_write.length;
-			break;
-
-		case J_OPERATION_COLLECTION_CREATE:
-		case J_OPERATION_COLLECTION_DELETE:
-		case J_OPERATION_ITEM_CREATE:
-		case J_OPERATION_ITEM_DELETE:
-		case J_OPERATION_COLLECTION_GET:
-		case J_OPERATION_ITEM_GET:
-		case J_OPERATION_ITEM_GET_STATUS:
-		case J_OPERATION_ITEM_READ:
-			ret = 0;
-			break;
-
-		case J_OPERATION_NONE:
-		default:
-			g_warn_if_reached();
+		return 0;
 	}
-	*/
 
-	return ret;
+	return operation->cache_size_func(operation->data);
 }
 
 void
@@ -213,7 +195,8 @@ j_operation_cache_init(void)
 	cache->cache = j_cache_new(50 * 1024 * 1024);
 	cache->queue = g_async_queue_new_full(NULL);
 	cache->thread = g_thread_new("JOperationCache", j_operation_cache_thread, cache);
-	cache->working = FALSE;
+	cache->pending = 0;
+	cache->failed = FALSE;
 
 	g_mutex_init(cache->mutex);
 	g_cond_init(cache->cond);
@@ -248,20 +231,53 @@ j_operation_cache_fini(void)
 	g_slice_free(JOperationCache, cache);
 }
 
+/**
+ * Waits until all cached batches have been executed.
+ * This is necessary before reading data without executing a batch.
+ * Errors of cached batches are reported by the next batch that is not cached.
+ *
+ * \code
+ * \endcode
+ **/
+void
+j_operation_cache_wait(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_mutex_lock(j_operation_cache->mutex);
+
+	while (j_operation_cache->pending > 0)
+	{
+		g_cond_wait(j_operation_cache->cond, j_operation_cache->mutex);
+	}
+
+	g_mutex_unlock(j_operation_cache->mutex);
+}
+
+/**
+ * Waits until all cached batches have been executed.
+ *
+ * \private
+ *
+ * \return FALSE if a cached batch has failed since the last flush, TRUE otherwise.
+ **/
 gboolean
 j_operation_cache_flush(void)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	gboolean ret = TRUE;
+	gboolean ret;
 
 	g_mutex_lock(j_operation_cache->mutex);
 
-	while (j_operation_cache->working)
+	while (j_operation_cache->pending > 0)
 	{
 		g_cond_wait(j_operation_cache->cond, j_operation_cache->mutex);
 	}
 
+	ret = !j_operation_cache->failed;
+	j_operation_cache->failed = FALSE;
+
 	g_mutex_unlock(j_operation_cache->mutex);
 
 	return ret;
@@ -272,13 +288,11 @@ j_operation_cache_add(JBatch* batch)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	gboolean ret = TRUE;
 	JCachedBatch* cached_batch;
 	JList* operations;
 	JListIterator* iterator;
-	gboolean can_cache = TRUE;
 	gchar* data;
-	gpointer buffer;
+	gpointer buffer = NULL;
 	guint64 required_size = 0;
 
 	operations = j_batch_get_operations(batch);
@@ -288,12 +302,10 @@ j_operation_cache_add(JBatch* batch)
 	{
 		JOperation* operation = j_list_iterator_get(iterator);
 
-		can_cache = j_operation_cache_test(operation) && can_cache;
-
-		if (!can_cache)
+		if (!j_operation_cache_test(operation))
 		{
-			ret = FALSE;
-			break;
+			j_list_iterator_free(iterator);
+			return FALSE;
 		}
 
 		required_size += j_operation_cache_get_required_size(operation);
@@ -301,13 +313,8 @@ j_operation_cache_add(JBatch* batch)
 
 	j_list_iterator_free(iterator);
 
-	// FIXME never cleared
-	if ((buffer = j_cache_get(j_operation_cache->cache, required_size)) == NULL)
-	{
-		ret = FALSE;
-	}
-
-	if (!ret)
+	// The buffer is released by the background thread after the batch has been executed
+	if (required_size > 0 && (buffer = j_cache_get(j_operation_cache->cache, required_size)) == NULL)
 	{
 		return FALSE;
 	}
@@ -317,32 +324,27 @@ j_operation_cache_add(JBatch* batch)
 
 	while (j_list_iterator_next(iterator))
 	{
-		/* FIXME
 		JOperation* operation = j_list_iterator_get(iterator);
+		guint64 size;
 
-		if (operation->type == J_OPERATION_ITEM_WRITE)
-		{
-			memcpy(data, operation->item_write.data, operation->item_write.length);
-
-			operation->item_write.data = data;
-			*(operation->item_write.bytes_written) += operation->item_write.length;
-			operation->item_write.bytes_written = NULL;
+		size = j_operation_cache_get_required_size(operation);
 
-			data += operation->item_write.length;
+		if (size > 0)
+		{
+			operation->cache_func(operation->data, data);
+			data += size;
+		}
+		else
+		{
+			operation->cache_func(operation->data, NULL);
 		}
-		*/
-		(void)data;
 	}
 
 	j_list_iterator_free(iterator);
 
-	if (!ret)
-	{
-		return FALSE;
-	}
-
+	// The batch has to be counted before it is pushed, otherwise flushes could miss it
 	g_mutex_lock(j_operation_cache->mutex);
-	j_operation_cache->working = TRUE;
+	j_operation_cache->pending++;
 	g_mutex_unlock(j_operation_cache->mutex);
 
 	cached_batch = g_slice_new(JCachedBatch);
@@ -351,5 +353,9 @@ j_operation_cache_add(JBatch* batch)
 
 	g_async_queue_push(j_operation_cache->queue, cached_batch);
 
-	return ret;
+	return TRUE;
 }
+
+/**
+ * @}
+ **/
@@ -54,6 +54,8 @@ j_operation_new(void)
 	operation->data = NULL;
 	operation->exec_func = NULL;
 	operation->free_func = NULL;
+	operation->cache_func = NULL;
+	operation->cache_size_func = NULL;
 
 	return operation;
 }
@@ -82,6 +84,25 @@ j_operation_free(JOperation* operation)
 	g_slice_free(JOperation, operation);
 }
 
+/**
+ * A cache function for operations that do not reference any of the caller's data.
+ *
+ * \code
+ * operation->cache_func = j_operation_cache_noop;
+ * \endcode
+ *
+ * \param data   The operation's data.
+ * \param buffer A buffer, always NULL.
+ **/
+void
+j_operation_cache_noop(gpointer data, gpointer buffer)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	(void)data;
+	(void)buffer;
+}
+
 /**
  * @}
  **/
@@ -0,0 +1,450 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2020 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ **/
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <jplacement.h>
+#include <jplacement-internal.h>
+
+#include <jbackend.h>
+#include <jconfiguration.h>
+#include <jhelper.h>
+#include <jtrace.h>
+
+/**
+ * \defgroup JPlacement Placement
+ *
+ * Data structures and functions for mapping keys to servers.
+ *
+ * The modulo placement divides the key's hash by the number of servers, which remaps almost all keys when servers are added or removed.
+ * The ring placement uses consistent hashing: Each server is represented by a number of virtual nodes on a hash ring according to its weight and keys are mapped to the first virtual node following their hash.
+ * The jump placement uses jump consistent hashing, which does not require any memory and balances keys evenly but does not support weights and only allows adding or removing servers at the end.
+ *
+ * @{
+ **/
+
+/**
+ * A virtual node on the hash ring.
+ */
+struct JPlacementNode
+{
+	guint64 hash;
+	guint32 index;
+};
+
+typedef struct JPlacementNode JPlacementNode;
+
+/**
+ * A placement.
+ **/
+struct JPlacement
+{
+	/**
+	 * The type.
+	 **/
+	JPlacementType type;
+
+	/**
+	 * The number of virtual nodes per server and weight.
+	 **/
+	guint32 virtual_nodes;
+
+	/**
+	 * The number of servers.
+	 **/
+	guint32 server_count;
+
+	/**
+	 * The ring's virtual nodes sorted by their hashes.
+	 * Contains #JPlacementNode elements.
+	 **/
+	GArray* nodes;
+
+	/**
+	 * The reference count.
+	 **/
+	gint ref_count;
+};
+
+/**
+ * The placements for the configured servers, indexed by backend type.
+ **/
+static JPlacement* j_placements[3] = { NULL, NULL, NULL };
+
+/**
+ * Hashes a string.
+ * Unlike j_helper_hash(), the hash is 64 bits wide and well-distributed even for similar keys such as paths.
+ *
+ * \private
+ *
+ * \param str A string.
+ *
+ * \return The hash.
+ **/
+static guint64
+j_placement_hash(gchar const* str)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	// FNV-1a
+	guint64 hash = G_GUINT64_CONSTANT(14695981039346656037);
+
+	for (; *str != '\0'; str++)
+	{
+		hash ^= (guchar)*str;
+		hash *= G_GUINT64_CONSTANT(1099511628211);
+	}
+
+	// The SplitMix64 finalizer makes all bits depend on all input bits
+	hash ^= hash >> 30;
+	hash *= G_GUINT64_CONSTANT(0xbf58476d1ce4e5b9);
+	hash ^= hash >> 27;
+	hash *= G_GUINT64_CONSTANT(0x94d049bb133111eb);
+	hash ^= hash >> 31;
+
+	return hash;
+}
+
+/**
+ * Maps a hash to a bucket using jump consistent hashing (Lamping and Veach).
+ *
+ * \private
+ *
+ * \param key     A hash.
+ * \param buckets The number of buckets.
+ *
+ * \return The bucket.
+ **/
+static guint32
+j_placement_jump(guint64 key, guint32 buckets)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gint64 b = -1;
+	gint64 j = 0;
+
+	while (j < buckets)
+	{
+		b = j;
+		key = key * G_GUINT64_CONSTANT(2862933555777941757) + 1;
+		j = (b + 1) * ((gdouble)(G_GINT64_CONSTANT(1) << 31) / (gdouble)((key >> 33) + 1));
+	}
+
+	return b;
+}
+
+static gint
+j_placement_node_compare(gconstpointer a, gconstpointer b)
+{
+	JPlacementNode const* node_a = a;
+	JPlacementNode const* node_b = b;
+
+	if (node_a->hash != node_b->hash)
+	{
+		return (node_a->hash < node_b->hash) ? -1 : 1;
+	}
+
+	// Make collisions deterministic
+	return (node_a->index < node_b->index) ? -1 : (node_a->index > node_b->index);
+}
+
+/**
+ * Creates a new placement.
+ *
+ * \code
+ * JPlacement* p;
+ *
+ * p = j_placement_new(J_PLACEMENT_RING, 128);
+ * j_placement_add_server(p, "server1:4711", 1);
+ * j_placement_add_server(p, "server2:4711", 2);
+ * \endcode
+ *
+ * \param type          A placement type.
+ * \param virtual_nodes The number of virtual nodes per server and weight, only used by the ring placement.
+ *
+ * \return A new placement. Should be freed with j_placement_unref().
+ **/
+JPlacement*
+j_placement_new(JPlacementType type, guint32 virtual_nodes)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JPlacement* placement;
+
+	placement = g_slice_new(JPlacement);
+	placement->type = type;
+	placement->virtual_nodes = MAX(virtual_nodes, 1);
+	placement->server_count = 0;
+	placement->nodes = g_array_new(FALSE, FALSE, sizeof(JPlacementNode));
+	placement->ref_count = 1;
+
+	return placement;
+}
+
+/**
+ * Creates a new placement for the servers of a configuration.
+ *
+ * \param configuration A configuration.
+ * \param backend       A backend type.
+ *
+ * \return A new placement. Should be freed with j_placement_unref().
+ **/
+JPlacement*
+j_placement_new_for_configuration(JConfiguration* configuration, JBackendType backend)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JPlacement* placement;
+	JPlacementType type = J_PLACEMENT_MODULO;
+	gchar const* type_str;
+	guint32 server_count;
+
+	g_return_val_if_fail(configuration != NULL, NULL);
+
+	type_str = j_configuration_get_placement(configuration);
+
+	if (g_strcmp0(type_str, "ring") == 0)
+	{
+		type = J_PLACEMENT_RING;
+	}
+	else if (g_strcmp0(type_str, "jump") == 0)
+	{
+		type = J_PLACEMENT_JUMP;
+	}
+	else if (type_str != NULL && g_strcmp0(type_str, "modulo") != 0)
+	{
+		g_warning("Unknown placement %s, using modulo placement.", type_str);
+	}
+
+	placement = j_placement_new(type, j_configuration_get_placement_virtual_nodes(configuration));
+	server_count = j_configuration_get_server_count(configuration, backend);
+
+	for (guint32 i = 0; i < server_count; i++)
+	{
+		j_placement_add_server(placement, j_configuration_get_server(configuration, backend, i), j_configuration_get_server_weight(configuration, backend, i));
+	}
+
+	return placement;
+}
+
+/**
+ * Increases a placement's reference count.
+ *
+ * \param placement A placement.
+ *
+ * \return #placement.
+ **/
+JPlacement*
+j_placement_ref(JPlacement* placement)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(placement != NULL, NULL);
+
+	g_atomic_int_inc(&(placement->ref_count));
+
+	return placement;
+}
+
+/**
+ * Decreases a placement's reference count.
+ * When the reference count reaches zero, frees the memory allocated for the placement.
+ *
+ * \param placement A placement.
+ **/
+void
+j_placement_unref(JPlacement* placement)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(placement != NULL);
+
+	if (g_atomic_int_dec_and_test(&(placement->ref_count)))
+	{
+		g_array_unref(placement->nodes);
+
+		g_slice_free(JPlacement, placement);
+	}
+}
+
+/**
+ * Adds a server to a placement.
+ * The server gets the next index, that is, servers have to be added in the same order as they are configured.
+ * Servers have to be added before the placement is used.
+ *
+ * \param placement A placement.
+ * \param name      The server's name, used to position it on the ring.
+ * \param weight    The server's weight, only used by the ring placement.
+ **/
+void
+j_placement_add_server(JPlacement* placement, gchar const* name, guint32 weight)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	guint32 index;
+
+	g_return_if_fail(placement != NULL);
+	g_return_if_fail(name != NULL);
+
+	index = placement->server_count;
+	placement->server_count++;
+
+	if (placement->type != J_PLACEMENT_RING)
+	{
+		return;
+	}
+
+	for (guint32 i = 0; i < placement->virtual_nodes * MAX(weight, 1); i++)
+	{
+		g_autofree gchar* node_name = NULL;
+		JPlacementNode node;
+
+		node_name = g_strdup_printf("%s#%u", name, i);
+
+		node.hash = j_placement_hash(node_name);
+		node.index = index;
+
+		g_array_append_val(placement->nodes, node);
+	}
+
+	g_array_sort(placement->nodes, j_placement_node_compare);
+}
+
+/**
+ * Maps a key to a server.
+ *
+ * \param placement A placement.
+ * \param key       A key.
+ *
+ * \return The server's index.
+ **/
+guint32
+j_placement_get_index(JPlacement* placement, gchar const* key)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	guint64 hash;
+	guint lo = 0;
+	guint hi;
+
+	g_return_val_if_fail(placement != NULL, 0);
+	g_return_val_if_fail(key != NULL, 0);
+	g_return_val_if_fail(placement->server_count > 0, 0);
+
+	switch (placement->type)
+	{
+		case J_PLACEMENT_MODULO:
+			return j_helper_hash(key) % placement->server_count;
+		case J_PLACEMENT_JUMP:
+			return j_placement_jump(j_placement_hash(key), placement->server_count);
+		case J_PLACEMENT_RING:
+			break;
+		default:
+			g_assert_not_reached();
+	}
+
+	hash = j_placement_hash(key);
+	hi = placement->nodes->len;
+
+	// Find the first virtual node whose hash is not smaller than the key's
+	while (lo < hi)
+	{
+		guint mid = lo + (hi - lo) / 2;
+
+		if (g_array_index(placement->nodes, JPlacementNode, mid).hash < hash)
+		{
+			lo = mid + 1;
+		}
+		else
+		{
+			hi = mid;
+		}
+	}
+
+	// Wrap around
+	if (lo == placement->nodes->len)
+	{
+		lo = 0;
+	}
+
+	return g_array_index(placement->nodes, JPlacementNode, lo).index;
+}
+
+/**
+ * Maps a key to one of the configured servers.
+ *
+ * \param backend A backend type.
+ * \param key     A key.
+ *
+ * \return The server's index.
+ **/
+guint32
+j_placement_get_server_index(JBackendType backend, gchar const* key)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(backend < G_N_ELEMENTS(j_placements), 0);
+	g_return_val_if_fail(j_placements[backend] != NULL, 0);
+
+	return j_placement_get_index(j_placements[backend], key);
+}
+
+/**
+ * Creates the placements for the configured servers.
+ *
+ * \private
+ *
+ * \param configuration A configuration.
+ **/
+void
+j_placement_init(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(configuration != NULL);
+
+	j_placements[J_BACKEND_TYPE_OBJECT] = j_placement_new_for_configuration(configuration, J_BACKEND_TYPE_OBJECT);
+	j_placements[J_BACKEND_TYPE_KV] = j_placement_new_for_configuration(configuration, J_BACKEND_TYPE_KV);
+	j_placements[J_BACKEND_TYPE_DB] = j_placement_new_for_configuration(configuration, J_BACKEND_TYPE_DB);
+}
+
+/**
+ * Frees the placements for the configured servers.
+ *
+ * \private
+ **/
+void
+j_placement_fini(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	for (guint i = 0; i < G_N_ELEMENTS(j_placements); i++)
+	{
+		g_clear_pointer(&(j_placements[i]), j_placement_unref);
+	}
+}
+
+/**
+ * @}
+ **/
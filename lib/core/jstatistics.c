@@ -82,6 +82,36 @@ struct JStatistics
 	 * The number of sent bytes.
 	 **/
 	guint64 bytes_sent;
+
+	/**
+	 * The number of objects whose handles were found in the backend's handle cache.
+	 **/
+	guint64 handle_cache_hits;
+
+	/**
+	 * The number of objects that had to be opened by the backend.
+	 **/
+	guint64 handle_cache_misses;
+
+	/**
+	 * The number of connections established by the client.
+	 **/
+	guint64 connections_created;
+
+	/**
+	 * The number of connections closed because they were broken or idle.
+	 **/
+	guint64 connections_closed;
+
+	/**
+	 * The number of times a client had to wait for a connection.
+	 **/
+	guint64 connection_waits;
+
+	/**
+	 * The time clients spent waiting for connections in microseconds.
+	 **/
+	guint64 connection_wait_time;
 };
 
 static gchar const*
@@ -107,6 +137,18 @@ j_statistics_get_type_name(JStatisticsType type)
 			return "bytes_received";
 		case J_STATISTICS_BYTES_SENT:
 			return "bytes_sent";
+		case J_STATISTICS_HANDLE_CACHE_HITS:
+			return "handle_cache_hits";
+		case J_STATISTICS_HANDLE_CACHE_MISSES:
+			return "handle_cache_misses";
+		case J_STATISTICS_CONNECTIONS_CREATED:
+			return "connections_created";
+		case J_STATISTICS_CONNECTIONS_CLOSED:
+			return "connections_closed";
+		case J_STATISTICS_CONNECTION_WAITS:
+			return "connection_waits";
+		case J_STATISTICS_CONNECTION_WAIT_TIME:
+			return "connection_wait_time";
 		default:
 			g_warn_if_reached();
 			return NULL;
@@ -143,6 +185,12 @@ j_statistics_new(gboolean trace)
 	statistics->bytes_written = 0;
 	statistics->bytes_received = 0;
 	statistics->bytes_sent = 0;
+	statistics->handle_cache_hits = 0;
+	statistics->handle_cache_misses = 0;
+	statistics->connections_created = 0;
+	statistics->connections_closed = 0;
+	statistics->connection_waits = 0;
+	statistics->connection_wait_time = 0;
 
 	return statistics;
 }
@@ -202,6 +250,24 @@ j_statistics_get(JStatistics* statistics, JStatisticsType type)
 		case J_STATISTICS_BYTES_SENT:
 			value = statistics->bytes_sent;
 			break;
+		case J_STATISTICS_HANDLE_CACHE_HITS:
+			value = statistics->handle_cache_hits;
+			break;
+		case J_STATISTICS_HANDLE_CACHE_MISSES:
+			value = statistics->handle_cache_misses;
+			break;
+		case J_STATISTICS_CONNECTIONS_CREATED:
+			value = statistics->connections_created;
+			break;
+		case J_STATISTICS_CONNECTIONS_CLOSED:
+			value = statistics->connections_closed;
+			break;
+		case J_STATISTICS_CONNECTION_WAITS:
+			value = statistics->connection_waits;
+			break;
+		case J_STATISTICS_CONNECTION_WAIT_TIME:
+			value = statistics->connection_wait_time;
+			break;
 		default:
 			g_warn_if_reached();
 			break;
@@ -243,6 +309,24 @@ j_statistics_add(JStatistics* statistics, JStatisticsType type, guint64 value)
 		case J_STATISTICS_BYTES_SENT:
 			statistics->bytes_sent += value;
 			break;
+		case J_STATISTICS_HANDLE_CACHE_HITS:
+			statistics->handle_cache_hits += value;
+			break;
+		case J_STATISTICS_HANDLE_CACHE_MISSES:
+			statistics->handle_cache_misses += value;
+			break;
+		case J_STATISTICS_CONNECTIONS_CREATED:
+			statistics->connections_created += value;
+			break;
+		case J_STATISTICS_CONNECTIONS_CLOSED:
+			statistics->connections_closed += value;
+			break;
+		case J_STATISTICS_CONNECTION_WAITS:
+			statistics->connection_waits += value;
+			break;
+		case J_STATISTICS_CONNECTION_WAIT_TIME:
+			statistics->connection_wait_time += value;
+			break;
 		default:
 			g_warn_if_reached();
 			break;
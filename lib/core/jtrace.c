@@ -307,6 +307,8 @@ j_trace_file_operation_name(JTraceFileOperation op)
 			return "status";
 		case J_TRACE_FILE_SYNC:
 			return "sync";
+		case J_TRACE_FILE_TRUNCATE:
+			return "truncate";
 		case J_TRACE_FILE_WRITE:
 			return "write";
 		default:
@@ -870,6 +872,9 @@ j_trace_file_end(gchar const* path, JTraceFileOperation op, guint64 length, guin
 			case J_TRACE_FILE_SYNC:
 				otf_op = OTF_FILEOP_SYNC;
 				break;
+			case J_TRACE_FILE_TRUNCATE:
+				otf_op = OTF_FILEOP_OTHER;
+				break;
 			case J_TRACE_FILE_WRITE:
 				otf_op = OTF_FILEOP_WRITE;
 				break;
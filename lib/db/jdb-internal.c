@@ -34,21 +34,656 @@
 #include <julea.h>
 #include "../../backend/db/jbson.c"
 
+/**
+ * A cursor streaming query results from a DB server.
+ **/
+struct JDBCursor
+{
+	/**
+	 * The DB server's index.
+	 **/
+	guint32 index;
+
+	/**
+	 * The server-side cursor's ID, 0 if all results have been received.
+	 **/
+	guint64 id;
+
+	/**
+	 * The current page of results.
+	 **/
+	bson_t page;
+	bson_iter_t iter;
+	gboolean page_valid;
+
+	/**
+	 * The request for the next page, which is sent as soon as the current page has been received.
+	 **/
+	JBackgroundOperation* prefetch;
+};
+
+typedef struct JDBCursor JDBCursor;
+
 struct JDBIteratorHelper
 {
 	bson_t bson;
 	bson_iter_t iter;
 	gboolean initialized;
+
+	/**
+	 * The cursors if results are streamed from the DB servers, NULL otherwise.
+	 **/
+	JDBCursor* cursors;
+	guint32 cursor_count;
+	guint32 cursor_current;
+
+	/**
+	 * Whether the results come from a sharded schema, their IDs have to be encoded then.
+	 **/
+	gboolean sharded;
 };
 
-typedef struct JDBIteratorHelper JDBIteratorHelper;
+typedef struct JDBIteratorHelper JDBIteratorHelper;
+
+/**
+ * Sends an operation to all DB servers.
+ **/
+#define J_DB_SERVER_ALL G_MAXUINT32
+
+/**
+ * A DB operation.
+ **/
+struct JDBOperation
+{
+	/**
+	 * The backend operation.
+	 * Has to be the first member, operations are passed around as #JBackendOperation.
+	 **/
+	JBackendOperation data;
+
+	/**
+	 * The index of the DB server to send the operation to or #J_DB_SERVER_ALL.
+	 **/
+	guint32 server;
+
+	/**
+	 * Whether the operation's schema is sharded, IDs have to be translated then.
+	 **/
+	gboolean sharded;
+
+	/**
+	 * The error of a cached operation, the caller's error might be gone by the time it is executed.
+	 **/
+	GError* error;
+};
+
+typedef struct JDBOperation JDBOperation;
+
+struct JDBBackgroundData
+{
+	guint32 index;
+	JMessage* message;
+	JMessage* reply;
+	gboolean ret;
+};
+
+typedef struct JDBBackgroundData JDBBackgroundData;
+
+GQuark
+j_db_error_quark(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	return g_quark_from_static_string("j-db-error-quark");
+}
+
+/**
+ * Returns the DB server a schema is stored on.
+ * Schemas are distributed across the DB servers according to the DB placement if a non-default placement is configured.
+ *
+ * \private
+ *
+ * \param schema A schema.
+ *
+ * \return The server's index.
+ **/
+static guint32
+j_db_internal_get_schema_server(JDBSchema* schema)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autofree gchar* key = NULL;
+	gchar const* placement;
+
+	if (j_db_get_backend() != NULL)
+	{
+		return 0;
+	}
+
+	placement = j_configuration_get_placement(j_configuration());
+
+	// Schemas used to be stored on the first server, they remain reachable with the default placement
+	if (g_strcmp0(placement, "ring") != 0 && g_strcmp0(placement, "jump") != 0)
+	{
+		return 0;
+	}
+
+	key = g_strdup_printf("%s/%s", schema->namespace, schema->name);
+
+	return j_placement_get_server_index(J_BACKEND_TYPE_DB, key);
+}
+
+/**
+ * Returns the DB servers that have to be contacted for operations affecting all of a schema's entries.
+ *
+ * \private
+ *
+ * \param schema A schema.
+ *
+ * \return The server's index or #J_DB_SERVER_ALL if the schema is sharded.
+ **/
+static guint32
+j_db_internal_get_shard_servers(JDBSchema* schema)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	if (schema->shard_key != NULL && j_db_get_backend() == NULL)
+	{
+		return J_DB_SERVER_ALL;
+	}
+
+	return j_db_internal_get_schema_server(schema);
+}
+
+/**
+ * Returns the DB server an entry is stored on.
+ * Entries of sharded schemas are placed according to the value of the shard key.
+ *
+ * \private
+ *
+ * \param entry An entry.
+ *
+ * \return The server's index.
+ **/
+static guint32
+j_db_internal_get_entry_server(JDBEntry* entry)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDBSchema* schema = entry->schema;
+	bson_iter_t iter;
+	g_autofree gchar* key = NULL;
+	g_autofree gchar* value = NULL;
+
+	if (j_db_internal_get_shard_servers(schema) != J_DB_SERVER_ALL || !bson_iter_init_find(&iter, &entry->bson, schema->shard_key))
+	{
+		return j_db_internal_get_schema_server(schema);
+	}
+
+	switch (bson_iter_type(&iter))
+	{
+		case BSON_TYPE_UTF8:
+			value = g_strdup(bson_iter_utf8(&iter, NULL));
+			break;
+		case BSON_TYPE_INT32:
+			value = g_strdup_printf("%" G_GINT32_FORMAT, bson_iter_int32(&iter));
+			break;
+		case BSON_TYPE_INT64:
+			value = g_strdup_printf("%" G_GINT64_FORMAT, bson_iter_int64(&iter));
+			break;
+		case BSON_TYPE_DOUBLE:
+			value = g_malloc(G_ASCII_DTOSTR_BUF_SIZE);
+			g_ascii_dtostr(value, G_ASCII_DTOSTR_BUF_SIZE, bson_iter_double(&iter));
+			break;
+		case BSON_TYPE_BINARY:
+		{
+			guint8 const* binary;
+			guint32 binary_len;
+
+			bson_iter_binary(&iter, NULL, &binary_len, &binary);
+			value = g_base64_encode(binary, binary_len);
+		}
+		break;
+		default:
+			value = g_strdup("");
+			break;
+	}
+
+	key = g_strdup_printf("%s/%s/%s", schema->namespace, schema->name, value);
+
+	return j_placement_get_server_index(J_BACKEND_TYPE_DB, key);
+}
+
+/**
+ * Replaces an ID field of a document with its globally unique ID.
+ * The backends' IDs of sharded schemas are only unique per DB server, the server's index is therefore encoded into the IDs returned to clients.
+ *
+ * \private
+ *
+ * \param document     A document.
+ * \param field        The ID field's name.
+ * \param server       The index of the DB server the document has been received from.
+ * \param server_count The number of DB servers.
+ **/
+static void
+j_db_internal_encode_id(bson_t* document, gchar const* field, guint32 server, guint32 server_count)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	bson_t encoded[1];
+	bson_iter_t iter;
+
+	if (!bson_iter_init_find(&iter, document, field) || !BSON_ITER_HOLDS_INT32(&iter))
+	{
+		return;
+	}
+
+	bson_init(encoded);
+	bson_iter_init(&iter, document);
+
+	while (bson_iter_next(&iter))
+	{
+		if (g_strcmp0(bson_iter_key(&iter), field) == 0 && BSON_ITER_HOLDS_INT32(&iter))
+		{
+			guint32 id = bson_iter_int32(&iter);
+
+			bson_append_int32(encoded, field, -1, id * server_count + server);
+		}
+		else
+		{
+			bson_append_iter(encoded, NULL, -1, &iter);
+		}
+	}
+
+	bson_destroy(document);
+	bson_copy_to(encoded, document);
+	bson_destroy(encoded);
+}
+
+/**
+ * Encodes the IDs of query results received from a DB server, see j_db_internal_encode_id().
+ *
+ * \private
+ *
+ * \param results      The results.
+ * \param server       The index of the DB server the results have been received from.
+ * \param server_count The number of DB servers.
+ **/
+static void
+j_db_internal_encode_result_ids(bson_t* results, guint32 server, guint32 server_count)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	bson_t encoded[1];
+	bson_iter_t iter;
+
+	if (!bson_iter_init(&iter, results))
+	{
+		return;
+	}
+
+	bson_init(encoded);
+
+	while (bson_iter_next(&iter))
+	{
+		bson_t received[1];
+		bson_t document[1];
+		guint8 const* document_data;
+		guint32 document_len;
+
+		if (!BSON_ITER_HOLDS_DOCUMENT(&iter))
+		{
+			bson_append_iter(encoded, NULL, -1, &iter);
+			continue;
+		}
+
+		bson_iter_document(&iter, &document_len, &document_data);
+		bson_init_static(received, document_data, document_len);
+		bson_copy_to(received, document);
+
+		j_db_internal_encode_id(document, "_id", server, server_count);
+		bson_append_document(encoded, bson_iter_key(&iter), -1, document);
+
+		bson_destroy(document);
+	}
+
+	bson_destroy(results);
+	bson_copy_to(encoded, results);
+	bson_destroy(encoded);
+}
+
+/**
+ * Translates a condition on the global IDs of a sharded schema into one on a DB server's IDs.
+ * Global IDs are ordered differently than the servers' IDs, each comparison is therefore translated separately.
+ *
+ * \private
+ *
+ * \param condition    The condition.
+ * \param server       The DB server's index.
+ * \param server_count The number of DB servers.
+ * \param translated   Returns the translated condition, has to be initialized.
+ **/
+static void
+j_db_internal_translate_id_condition(bson_t const* condition, guint32 server, guint32 server_count, bson_t* translated)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDBSelectorOperator operator_ = J_DB_SELECTOR_OPERATOR_EQ;
+	bson_iter_t iter;
+	guint64 id = 0;
+	guint64 local_id = 0;
+	// Conditions that can never or always be true for the server's entries
+	gboolean never = FALSE;
+	gboolean always = FALSE;
+
+	if (bson_iter_init_find(&iter, condition, "_operator"))
+	{
+		operator_ = bson_iter_int32(&iter);
+	}
+
+	if (bson_iter_init_find(&iter, condition, "_value"))
+	{
+		id = (guint32)bson_iter_int32(&iter);
+	}
+
+	switch (operator_)
+	{
+		case J_DB_SELECTOR_OPERATOR_EQ:
+		case J_DB_SELECTOR_OPERATOR_NE:
+			if (id % server_count == server)
+			{
+				local_id = id / server_count;
+			}
+			else if (operator_ == J_DB_SELECTOR_OPERATOR_EQ)
+			{
+				never = TRUE;
+			}
+			else
+			{
+				always = TRUE;
+			}
+			break;
+		case J_DB_SELECTOR_OPERATOR_LT:
+			never = (id <= server);
+			local_id = (id - server + server_count - 1) / server_count;
+			break;
+		case J_DB_SELECTOR_OPERATOR_LE:
+			never = (id < server);
+			local_id = (id - server) / server_count;
+			break;
+		case J_DB_SELECTOR_OPERATOR_GT:
+			always = (id < server);
+			local_id = (id - server) / server_count;
+			break;
+		case J_DB_SELECTOR_OPERATOR_GE:
+			always = (id <= server);
+			local_id = (id - server + server_count - 1) / server_count;
+			break;
+		default:
+			g_warn_if_reached();
+	}
+
+	// IDs are never negative
+	if (never)
+	{
+		operator_ = J_DB_SELECTOR_OPERATOR_LT;
+		local_id = 0;
+	}
+	else if (always)
+	{
+		operator_ = J_DB_SELECTOR_OPERATOR_GE;
+		local_id = 0;
+	}
+
+	bson_append_utf8(translated, "_name", -1, "_id", -1);
+	bson_append_int32(translated, "_operator", -1, operator_);
+	bson_append_int32(translated, "_value", -1, (guint32)local_id);
+}
+
+/**
+ * Translates the conditions on IDs of a sharded schema's selector for a DB server, see j_db_internal_translate_id_condition().
+ *
+ * \private
+ *
+ * \param selector     The selector's BSON.
+ * \param server       The DB server's index.
+ * \param server_count The number of DB servers.
+ * \param translated   Returns the translated selector, has to be initialized.
+ **/
+static void
+j_db_internal_translate_selector(bson_t const* selector, guint32 server, guint32 server_count, bson_t* translated)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	bson_iter_t iter;
+
+	if (!bson_iter_init(&iter, selector))
+	{
+		return;
+	}
+
+	while (bson_iter_next(&iter))
+	{
+		bson_t child[1];
+		bson_t translated_child[1];
+		bson_iter_t child_iter;
+		guint8 const* child_data;
+		guint32 child_len;
+
+		if (!BSON_ITER_HOLDS_DOCUMENT(&iter))
+		{
+			bson_append_iter(translated, NULL, -1, &iter);
+			continue;
+		}
+
+		bson_iter_document(&iter, &child_len, &child_data);
+		bson_init_static(child, child_data, child_len);
+
+		bson_append_document_begin(translated, bson_iter_key(&iter), -1, translated_child);
+
+		if (bson_iter_init_find(&child_iter, child, "_mode"))
+		{
+			j_db_internal_translate_selector(child, server, server_count, translated_child);
+		}
+		else if (bson_iter_init_find(&child_iter, child, "_name") && g_strcmp0(bson_iter_utf8(&child_iter, NULL), "_id") == 0)
+		{
+			j_db_internal_translate_id_condition(child, server, server_count, translated_child);
+		}
+		else
+		{
+			bson_concat(translated_child, child);
+		}
+
+		bson_append_document_end(translated, translated_child);
+	}
+}
+
+/**
+ * Returns the DB server an operation on a sharded schema has to be sent to.
+ * Selectors requiring a specific ID only match entries on the server that owns the ID.
+ *
+ * \private
+ *
+ * \param schema   A schema.
+ * \param selector A selector, can be NULL.
+ *
+ * \return The server's index or #J_DB_SERVER_ALL.
+ **/
+static guint32
+j_db_internal_get_selector_server(JDBSchema* schema, JDBSelector* selector)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	bson_t const* bson;
+	bson_iter_t iter;
+	guint32 server;
+
+	server = j_db_internal_get_shard_servers(schema);
+	bson = j_db_selector_get_bson(selector);
+
+	if (server != J_DB_SERVER_ALL || bson == NULL || selector->mode != J_DB_SELECTOR_MODE_AND || !bson_iter_init(&iter, bson))
+	{
+		return server;
+	}
+
+	while (bson_iter_next(&iter))
+	{
+		bson_t condition[1];
+		bson_iter_t condition_iter;
+		guint8 const* condition_data;
+		guint32 condition_len;
+
+		if (!BSON_ITER_HOLDS_DOCUMENT(&iter))
+		{
+			continue;
+		}
+
+		bson_iter_document(&iter, &condition_len, &condition_data);
+		bson_init_static(condition, condition_data, condition_len);
+
+		if (bson_iter_init_find(&condition_iter, condition, "_name") && g_strcmp0(bson_iter_utf8(&condition_iter, NULL), "_id") == 0
+		    && bson_iter_init_find(&condition_iter, condition, "_operator") && bson_iter_int32(&condition_iter) == J_DB_SELECTOR_OPERATOR_EQ
+		    && bson_iter_init_find(&condition_iter, condition, "_value"))
+		{
+			return (guint32)bson_iter_int32(&condition_iter) % j_configuration_get_server_count(j_configuration(), J_BACKEND_TYPE_DB);
+		}
+	}
+
+	return server;
+}
+
+static gpointer
+j_db_internal_send_receive_background_operation(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDBBackgroundData* background_data = data;
+
+	background_data->ret = j_connection_pool_send_receive(J_BACKEND_TYPE_DB, background_data->index, background_data->message, background_data->reply);
+
+	return data;
+}
+
+/**
+ * Reads the replies of an operation that has been sent to all DB servers.
+ * Query results are concatenated in the order of the servers.
+ * Not finding any matching entries is only an error if no server found any.
+ *
+ * \private
+ *
+ * \param data            An operation.
+ * \param type            The operation's message type.
+ * \param background_data The background data for all servers.
+ * \param server_count    The number of servers.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+j_db_internal_merge_replies(JBackendOperation* data, JMessageType type, JDBBackgroundData** background_data, guint32 server_count)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	GError** error = data->out_param[data->out_param_count - 1].ptr;
+	g_autoptr(GError) merged_error = NULL;
+	gboolean ret = TRUE;
+	gboolean found = FALSE;
+	guint32 count = 0;
+
+	if (type == J_MESSAGE_DB_QUERY)
+	{
+		bson_init(data->out_param[0].ptr);
+	}
+
+	for (guint32 i = 0; i < server_count; i++)
+	{
+		JBackendOperationParam out_param[G_N_ELEMENTS(data->out_param)];
+		g_autoptr(GError) shard_error = NULL;
+		bson_t result[1];
+
+		if (!background_data[i]->ret)
+		{
+			ret = FALSE;
+			continue;
+		}
+
+		memcpy(out_param, data->out_param, sizeof(out_param));
+		out_param[data->out_param_count - 1].ptr = &shard_error;
+
+		if (type == J_MESSAGE_DB_QUERY)
+		{
+			bson_init(result);
+			out_param[0].ptr = result;
+		}
+
+		if (j_backend_operation_from_message(background_data[i]->reply, out_param, data->out_param_count))
+		{
+			found = TRUE;
+		}
+		else if (shard_error != NULL && shard_error->code == J_BACKEND_DB_ERROR_ITERATOR_NO_MORE_ELEMENTS)
+		{
+			if (merged_error == NULL)
+			{
+				merged_error = g_steal_pointer(&shard_error);
+			}
+		}
+		else
+		{
+			ret = FALSE;
+
+			if (shard_error != NULL && (merged_error == NULL || merged_error->code == J_BACKEND_DB_ERROR_ITERATOR_NO_MORE_ELEMENTS))
+			{
+				g_clear_error(&merged_error);
+				merged_error = g_steal_pointer(&shard_error);
+			}
+		}
+
+		if (type == J_MESSAGE_DB_QUERY)
+		{
+			bson_iter_t iter;
+
+			// Operations are only sent to all servers for sharded schemas
+			j_db_internal_encode_result_ids(result, i, server_count);
+
+			if (bson_iter_init(&iter, result))
+			{
+				while (bson_iter_next(&iter))
+				{
+					bson_t document[1];
+					guint8 const* document_data;
+					guint32 document_len;
+					char key_buf[16];
+					char const* key;
+
+					bson_iter_document(&iter, &document_len, &document_data);
+
+					if (document_data != NULL && bson_init_static(document, document_data, document_len))
+					{
+						bson_uint32_to_string(count, &key, key_buf, sizeof(key_buf));
+						bson_append_document(data->out_param[0].ptr, key, -1, document);
+						count++;
+					}
+				}
+			}
+
+			bson_destroy(result);
+		}
+	}
+
+	if (found && ret)
+	{
+		g_clear_error(&merged_error);
+	}
+	else if (merged_error != NULL)
+	{
+		ret = FALSE;
+	}
 
-GQuark
-j_db_error_quark(void)
-{
-	J_TRACE_FUNCTION(NULL);
+	if (merged_error != NULL)
+	{
+		g_propagate_error(error, g_steal_pointer(&merged_error));
+	}
 
-	return g_quark_from_static_string("j-db-error-quark");
+	return ret;
 }
 
 static gboolean
@@ -58,18 +693,18 @@ j_backend_db_func_exec(JList* operations, JSemantics* semantics, JMessageType ty
 
 	JBackendOperation* data = NULL;
 	gboolean ret = TRUE;
-	GSocketConnection* db_connection;
 	g_autoptr(JListIterator) iter_send = NULL;
 	g_autoptr(JListIterator) iter_recieve = NULL;
-	g_autoptr(JMessage) message = NULL;
-	g_autoptr(JMessage) reply = NULL;
+	g_autofree JDBBackgroundData** background_data = NULL;
 	JBackend* db_backend = j_db_get_backend();
 	gpointer batch = NULL;
 	GError* error = NULL;
+	guint32 server_count = 0;
 
 	if (db_backend == NULL)
 	{
-		message = j_message_new(type, 0);
+		server_count = j_configuration_get_server_count(j_configuration(), J_BACKEND_TYPE_DB);
+		background_data = g_new0(JDBBackgroundData*, server_count);
 	}
 
 	iter_send = j_list_iterator_new(operations);
@@ -96,7 +731,45 @@ j_backend_db_func_exec(JList* operations, JSemantics* semantics, JMessageType ty
 		}
 		else
 		{
-			ret = j_backend_operation_to_message(message, data->in_param, data->in_param_count) && ret;
+			JDBOperation* operation = (JDBOperation*)data;
+
+			for (guint32 i = 0; i < server_count; i++)
+			{
+				JBackendOperationParam in_param[G_N_ELEMENTS(data->in_param)];
+
+				if (operation->server != J_DB_SERVER_ALL && operation->server != i)
+				{
+					continue;
+				}
+
+				if (background_data[i] == NULL)
+				{
+					background_data[i] = g_slice_new(JDBBackgroundData);
+					background_data[i]->index = i;
+					background_data[i]->message = j_message_new(type, 0);
+					background_data[i]->reply = NULL;
+					background_data[i]->ret = FALSE;
+				}
+
+				// Serializing modifies the parameters, use a copy to be able to send the operation to multiple servers
+				memcpy(in_param, data->in_param, sizeof(in_param));
+
+				// Selectors of sharded schemas refer to global IDs, which differ from the server's IDs
+				if (operation->sharded && (type == J_MESSAGE_DB_UPDATE || type == J_MESSAGE_DB_DELETE || type == J_MESSAGE_DB_QUERY) && in_param[2].ptr != NULL)
+				{
+					bson_t selector[1];
+
+					bson_init(selector);
+					j_db_internal_translate_selector(in_param[2].ptr, i, server_count, selector);
+					in_param[2].ptr_const = selector;
+					ret = j_backend_operation_to_message(background_data[i]->message, in_param, data->in_param_count) && ret;
+					bson_destroy(selector);
+				}
+				else
+				{
+					ret = j_backend_operation_to_message(background_data[i]->message, in_param, data->in_param_count) && ret;
+				}
+			}
 		}
 	}
 
@@ -116,19 +789,60 @@ j_backend_db_func_exec(JList* operations, JSemantics* semantics, JMessageType ty
 	}
 	else
 	{
-		db_connection = j_connection_pool_pop(J_BACKEND_TYPE_DB, 0);
-		j_message_send(message, db_connection);
-		reply = j_message_new_reply(message);
-		j_message_receive(reply, db_connection);
+		for (guint32 i = 0; i < server_count; i++)
+		{
+			if (background_data[i] != NULL)
+			{
+				background_data[i]->reply = j_message_new_reply(background_data[i]->message);
+			}
+		}
+
+		j_helper_execute_parallel(j_db_internal_send_receive_background_operation, (gpointer*)background_data, server_count);
+
 		iter_recieve = j_list_iterator_new(operations);
 
 		while (j_list_iterator_next(iter_recieve))
 		{
+			JDBOperation* operation;
+
 			data = j_list_iterator_get(iter_recieve);
-			ret = j_backend_operation_from_message(reply, data->out_param, data->out_param_count) && ret;
+			operation = (JDBOperation*)data;
+
+			if (operation->server == J_DB_SERVER_ALL)
+			{
+				ret = j_db_internal_merge_replies(data, type, background_data, server_count) && ret;
+			}
+			else if (operation->server < server_count && background_data[operation->server]->ret)
+			{
+				gboolean received;
+
+				received = j_backend_operation_from_message(background_data[operation->server]->reply, data->out_param, data->out_param_count);
+				ret = received && ret;
+
+				if (received && operation->sharded && type == J_MESSAGE_DB_INSERT)
+				{
+					j_db_internal_encode_id(data->out_param[0].ptr, "_value", operation->server, server_count);
+				}
+				else if (received && operation->sharded && type == J_MESSAGE_DB_QUERY)
+				{
+					j_db_internal_encode_result_ids(data->out_param[0].ptr, operation->server, server_count);
+				}
+			}
+			else
+			{
+				ret = FALSE;
+			}
 		}
 
-		j_connection_pool_push(J_BACKEND_TYPE_DB, 0, db_connection);
+		for (guint32 i = 0; i < server_count; i++)
+		{
+			if (background_data[i] != NULL)
+			{
+				j_message_unref(background_data[i]->message);
+				j_message_unref(background_data[i]->reply);
+				g_slice_free(JDBBackgroundData, background_data[i]);
+			}
+		}
 	}
 
 	return ret;
@@ -143,6 +857,15 @@ j_backend_db_func_free(gpointer _data)
 
 	if (data)
 	{
+		JDBOperation* operation = (JDBOperation*)data;
+
+		// Errors of cached operations cannot be returned to the caller
+		if (operation->error != NULL)
+		{
+			g_warning("Cached DB operation failed: %s", operation->error->message);
+			g_error_free(operation->error);
+		}
+
 		for (guint i = 0; i < data->unref_func_count; i++)
 		{
 			if (data->unref_values[i])
@@ -151,8 +874,43 @@ j_backend_db_func_free(gpointer _data)
 			}
 		}
 
-		g_slice_free(JBackendOperation, data);
+		g_slice_free(JDBOperation, (JDBOperation*)data);
+	}
+}
+
+static void
+j_backend_db_func_cache(gpointer _data, gpointer buffer)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JBackendOperation* data = _data;
+	JDBOperation* operation = _data;
+
+	(void)buffer;
+
+	// The caller might modify its entries, selectors and schemas before the operation is executed
+	for (guint i = 0; i < data->in_param_count; i++)
+	{
+		bson_t* copy;
+
+		if (data->in_param[i].type != J_BACKEND_OPERATION_PARAM_TYPE_BSON || data->in_param[i].ptr == NULL)
+		{
+			continue;
+		}
+
+		g_assert(data->unref_func_count < G_N_ELEMENTS(data->unref_funcs));
+
+		copy = bson_copy(data->in_param[i].ptr);
+		data->in_param[i].ptr = copy;
+
+		// The copies are freed together with the operation
+		data->unref_funcs[data->unref_func_count] = (GDestroyNotify)bson_destroy;
+		data->unref_values[data->unref_func_count] = copy;
+		data->unref_func_count++;
 	}
+
+	// The caller's error might be gone by the time the operation is executed, errors are logged when the operation is freed
+	data->out_param[data->out_param_count - 1].ptr = &(operation->error);
 }
 
 static gboolean
@@ -169,11 +927,16 @@ j_db_internal_schema_create(JDBSchema* j_db_schema, JBatch* batch, GError** erro
 	J_TRACE_FUNCTION(NULL);
 
 	JOperation* op;
+	JDBOperation* operation;
 	JBackendOperation* data;
 
 	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
 
-	data = g_slice_new(JBackendOperation);
+	operation = g_slice_new(JDBOperation);
+	operation->error = NULL;
+	operation->server = j_db_internal_get_shard_servers(j_db_schema);
+	operation->sharded = (operation->server == J_DB_SERVER_ALL);
+	data = &operation->data;
 	memcpy(data, &j_backend_operation_db_schema_create, sizeof(JBackendOperation));
 	data->in_param[0].ptr_const = j_db_schema->namespace;
 	data->in_param[1].ptr_const = j_db_schema->name;
@@ -189,6 +952,7 @@ j_db_internal_schema_create(JDBSchema* j_db_schema, JBatch* batch, GError** erro
 	op->data = data;
 	op->exec_func = j_db_schema_create_exec;
 	op->free_func = j_backend_db_func_free;
+	op->cache_func = j_backend_db_func_cache;
 
 	j_batch_add(batch, op);
 
@@ -209,11 +973,16 @@ j_db_internal_schema_get(JDBSchema* j_db_schema, JBatch* batch, GError** error)
 	J_TRACE_FUNCTION(NULL);
 
 	JOperation* op;
+	JDBOperation* operation;
 	JBackendOperation* data;
 
 	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
 
-	data = g_slice_new(JBackendOperation);
+	operation = g_slice_new(JDBOperation);
+	operation->error = NULL;
+	operation->server = j_db_internal_get_schema_server(j_db_schema);
+	operation->sharded = FALSE;
+	data = &operation->data;
 	memcpy(data, &j_backend_operation_db_schema_get, sizeof(JBackendOperation));
 	data->in_param[0].ptr_const = j_db_schema->namespace;
 	data->in_param[1].ptr_const = j_db_schema->name;
@@ -249,11 +1018,16 @@ j_db_internal_schema_delete(JDBSchema* j_db_schema, JBatch* batch, GError** erro
 	J_TRACE_FUNCTION(NULL);
 
 	JOperation* op;
+	JDBOperation* operation;
 	JBackendOperation* data;
 
 	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
 
-	data = g_slice_new(JBackendOperation);
+	operation = g_slice_new(JDBOperation);
+	operation->error = NULL;
+	operation->server = j_db_internal_get_shard_servers(j_db_schema);
+	operation->sharded = (operation->server == J_DB_SERVER_ALL);
+	data = &operation->data;
 	memcpy(data, &j_backend_operation_db_schema_delete, sizeof(JBackendOperation));
 	data->in_param[0].ptr_const = j_db_schema->namespace;
 	data->in_param[1].ptr_const = j_db_schema->name;
@@ -268,6 +1042,7 @@ j_db_internal_schema_delete(JDBSchema* j_db_schema, JBatch* batch, GError** erro
 	op->data = data;
 	op->exec_func = j_db_schema_delete_exec;
 	op->free_func = j_backend_db_func_free;
+	op->cache_func = j_backend_db_func_cache;
 
 	j_batch_add(batch, op);
 
@@ -288,11 +1063,16 @@ j_db_internal_insert(JDBEntry* j_db_entry, JBatch* batch, GError** error)
 	J_TRACE_FUNCTION(NULL);
 
 	JOperation* op;
+	JDBOperation* operation;
 	JBackendOperation* data;
 
 	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
 
-	data = g_slice_new(JBackendOperation);
+	operation = g_slice_new(JDBOperation);
+	operation->error = NULL;
+	operation->server = j_db_internal_get_entry_server(j_db_entry);
+	operation->sharded = (j_db_internal_get_shard_servers(j_db_entry->schema) == J_DB_SERVER_ALL);
+	data = &operation->data;
 	memcpy(data, &j_backend_operation_db_insert, sizeof(JBackendOperation));
 	data->in_param[0].ptr_const = j_db_entry->schema->namespace;
 	data->in_param[1].ptr_const = j_db_entry->schema->name;
@@ -309,6 +1089,7 @@ j_db_internal_insert(JDBEntry* j_db_entry, JBatch* batch, GError** error)
 	op->data = data;
 	op->exec_func = j_db_insert_exec;
 	op->free_func = j_backend_db_func_free;
+	// Inserts return the new entry's ID and are therefore never cached
 
 	j_batch_add(batch, op);
 
@@ -329,11 +1110,16 @@ j_db_internal_update(JDBEntry* j_db_entry, JDBSelector* j_db_selector, JBatch* b
 	J_TRACE_FUNCTION(NULL);
 
 	JOperation* op;
+	JDBOperation* operation;
 	JBackendOperation* data;
 
 	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
 
-	data = g_slice_new(JBackendOperation);
+	operation = g_slice_new(JDBOperation);
+	operation->error = NULL;
+	operation->server = j_db_internal_get_selector_server(j_db_entry->schema, j_db_selector);
+	operation->sharded = (j_db_internal_get_shard_servers(j_db_entry->schema) == J_DB_SERVER_ALL);
+	data = &operation->data;
 	memcpy(data, &j_backend_operation_db_update, sizeof(JBackendOperation));
 	data->in_param[0].ptr_const = j_db_entry->schema->namespace;
 	data->in_param[1].ptr_const = j_db_entry->schema->name;
@@ -352,6 +1138,7 @@ j_db_internal_update(JDBEntry* j_db_entry, JDBSelector* j_db_selector, JBatch* b
 	op->data = data;
 	op->exec_func = j_db_update_exec;
 	op->free_func = j_backend_db_func_free;
+	op->cache_func = j_backend_db_func_cache;
 
 	j_batch_add(batch, op);
 
@@ -372,11 +1159,16 @@ j_db_internal_delete(JDBEntry* j_db_entry, JDBSelector* j_db_selector, JBatch* b
 	J_TRACE_FUNCTION(NULL);
 
 	JOperation* op;
+	JDBOperation* operation;
 	JBackendOperation* data;
 
 	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
 
-	data = g_slice_new(JBackendOperation);
+	operation = g_slice_new(JDBOperation);
+	operation->error = NULL;
+	operation->server = j_db_internal_get_selector_server(j_db_entry->schema, j_db_selector);
+	operation->sharded = (j_db_internal_get_shard_servers(j_db_entry->schema) == J_DB_SERVER_ALL);
+	data = &operation->data;
 	memcpy(data, &j_backend_operation_db_delete, sizeof(JBackendOperation));
 	data->in_param[0].ptr_const = j_db_entry->schema->namespace;
 	data->in_param[1].ptr_const = j_db_entry->schema->name;
@@ -394,6 +1186,7 @@ j_db_internal_delete(JDBEntry* j_db_entry, JDBSelector* j_db_selector, JBatch* b
 	op->data = data;
 	op->exec_func = j_db_delete_exec;
 	op->free_func = j_backend_db_func_free;
+	op->cache_func = j_backend_db_func_cache;
 
 	j_batch_add(batch, op);
 
@@ -415,16 +1208,24 @@ j_db_internal_query(JDBSchema* j_db_schema, JDBSelector* j_db_selector, JDBItera
 
 	JDBIteratorHelper* helper;
 	JOperation* op;
+	JDBOperation* operation;
 	JBackendOperation* data;
 
 	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
 
 	helper = j_helper_alloc_aligned(128, sizeof(JDBIteratorHelper));
 	helper->initialized = FALSE;
+	helper->cursors = NULL;
+	helper->cursor_count = 0;
+	helper->cursor_current = 0;
 	memset(&helper->bson, 0, sizeof(bson_t));
 	j_db_iterator->iterator = helper;
 
-	data = g_slice_new(JBackendOperation);
+	operation = g_slice_new(JDBOperation);
+	operation->error = NULL;
+	operation->server = j_db_internal_get_selector_server(j_db_schema, j_db_selector);
+	operation->sharded = (j_db_internal_get_shard_servers(j_db_schema) == J_DB_SERVER_ALL);
+	data = &operation->data;
 	memcpy(data, &j_backend_operation_db_query, sizeof(JBackendOperation));
 	data->in_param[0].ptr_const = j_db_schema->namespace;
 	data->in_param[1].ptr_const = j_db_schema->name;
@@ -451,6 +1252,361 @@ j_db_internal_query(JDBSchema* j_db_schema, JDBSelector* j_db_selector, JDBItera
 	return TRUE;
 }
 
+static JDBBackgroundData*
+j_db_internal_background_data_new(guint32 index, JMessage* message)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDBBackgroundData* background_data;
+
+	background_data = g_slice_new(JDBBackgroundData);
+	background_data->index = index;
+	background_data->message = message;
+	background_data->reply = j_message_new_reply(message);
+	background_data->ret = FALSE;
+
+	return background_data;
+}
+
+static void
+j_db_internal_background_data_free(JDBBackgroundData* background_data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	j_message_unref(background_data->message);
+	j_message_unref(background_data->reply);
+
+	g_slice_free(JDBBackgroundData, background_data);
+}
+
+/**
+ * Requests the next page of a cursor in the background.
+ *
+ * \private
+ *
+ * \param cursor A cursor.
+ **/
+static void
+j_db_internal_cursor_prefetch(JDBCursor* cursor)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JMessage* message;
+
+	message = j_message_new(J_MESSAGE_DB_CURSOR_FETCH, sizeof(guint64));
+	j_message_add_operation(message, sizeof(guint64));
+	j_message_append_8(message, &(cursor->id));
+
+	cursor->prefetch = j_background_operation_new(j_db_internal_send_receive_background_operation, j_db_internal_background_data_new(cursor->index, message));
+}
+
+/**
+ * Reads a page of results and prefetches the next one.
+ *
+ * \private
+ *
+ * \param cursor          A cursor.
+ * \param background_data The background data containing the reply.
+ * \param error           A GError.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+j_db_internal_cursor_receive(JDBCursor* cursor, JDBBackgroundData* background_data, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JBackendOperationParam out_param[G_N_ELEMENTS(j_backend_operation_db_query.out_param)];
+	gboolean ret;
+
+	if (cursor->page_valid)
+	{
+		bson_destroy(&cursor->page);
+	}
+
+	bson_init(&cursor->page);
+	cursor->page_valid = TRUE;
+	cursor->id = 0;
+
+	if (!background_data->ret)
+	{
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_FAILED, "query failed");
+		return FALSE;
+	}
+
+	memcpy(out_param, j_backend_operation_db_query.out_param, sizeof(out_param));
+	out_param[0].ptr = &cursor->page;
+	out_param[1].ptr = error;
+
+	cursor->id = j_message_get_8(background_data->reply);
+	ret = j_backend_operation_from_message(background_data->reply, out_param, j_backend_operation_db_query.out_param_count);
+
+	if (!bson_iter_init(&cursor->iter, &cursor->page))
+	{
+		bson_reinit(&cursor->page);
+		bson_iter_init(&cursor->iter, &cursor->page);
+	}
+
+	if (cursor->id != 0)
+	{
+		j_db_internal_cursor_prefetch(cursor);
+	}
+
+	return ret;
+}
+
+/**
+ * Waits for the prefetched page of a cursor.
+ *
+ * \private
+ *
+ * \param cursor A cursor.
+ * \param error  A GError.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+j_db_internal_cursor_next_page(JDBCursor* cursor, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDBBackgroundData* background_data;
+	gboolean ret;
+
+	background_data = j_background_operation_wait(cursor->prefetch);
+	j_background_operation_unref(cursor->prefetch);
+	cursor->prefetch = NULL;
+
+	ret = j_db_internal_cursor_receive(cursor, background_data, error);
+	j_db_internal_background_data_free(background_data);
+
+	return ret;
+}
+
+gboolean
+j_db_internal_query_cursor(JDBSchema* j_db_schema, JDBSelector* j_db_selector, JDBIterator* j_db_iterator, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JConfiguration* configuration = j_configuration();
+	JDBIteratorHelper* helper;
+	g_autofree JDBBackgroundData** background_data = NULL;
+	gboolean ret = TRUE;
+	guint32 page_size;
+	guint32 server;
+	guint32 server_count;
+
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	// Cursors do not use batches, so cached operations have to be executed first
+	j_operation_cache_wait();
+
+	page_size = j_configuration_get_db_page_size(configuration);
+	server = j_db_internal_get_selector_server(j_db_schema, j_db_selector);
+	server_count = j_configuration_get_server_count(configuration, J_BACKEND_TYPE_DB);
+
+	helper = j_helper_alloc_aligned(128, sizeof(JDBIteratorHelper));
+	helper->initialized = FALSE;
+	helper->cursors = g_new0(JDBCursor, (server == J_DB_SERVER_ALL) ? server_count : 1);
+	helper->cursor_count = 0;
+	helper->cursor_current = 0;
+	helper->sharded = (j_db_internal_get_shard_servers(j_db_schema) == J_DB_SERVER_ALL);
+	memset(&helper->bson, 0, sizeof(bson_t));
+	j_db_iterator->iterator = helper;
+
+	background_data = g_new0(JDBBackgroundData*, server_count);
+
+	for (guint32 i = 0; i < server_count; i++)
+	{
+		JBackendOperationParam in_param[G_N_ELEMENTS(j_backend_operation_db_query.in_param)];
+		JMessage* message;
+		bson_t selector[1];
+
+		if (server != J_DB_SERVER_ALL && server != i)
+		{
+			continue;
+		}
+
+		memcpy(in_param, j_backend_operation_db_query.in_param, sizeof(in_param));
+		in_param[0].ptr_const = j_db_schema->namespace;
+		in_param[1].ptr_const = j_db_schema->name;
+		in_param[2].ptr_const = j_db_selector_get_bson(j_db_selector);
+
+		bson_init(selector);
+
+		// Selectors of sharded schemas refer to global IDs, which differ from the server's IDs
+		if (helper->sharded && in_param[2].ptr != NULL)
+		{
+			j_db_internal_translate_selector(in_param[2].ptr, i, server_count, selector);
+			in_param[2].ptr_const = selector;
+		}
+
+		message = j_message_new(J_MESSAGE_DB_CURSOR_OPEN, sizeof(guint32));
+		j_message_add_operation(message, sizeof(guint32));
+		j_message_append_4(message, &page_size);
+		j_backend_operation_to_message(message, in_param, j_backend_operation_db_query.in_param_count);
+
+		bson_destroy(selector);
+
+		background_data[i] = j_db_internal_background_data_new(i, message);
+	}
+
+	// Queries of sharded schemas are sent to all servers in parallel
+	j_helper_execute_parallel(j_db_internal_send_receive_background_operation, (gpointer*)background_data, server_count);
+
+	for (guint32 i = 0; i < server_count; i++)
+	{
+		JDBCursor* cursor;
+		GError* cursor_error = NULL;
+
+		if (background_data[i] == NULL)
+		{
+			continue;
+		}
+
+		cursor = &(helper->cursors[helper->cursor_count]);
+		cursor->index = i;
+		helper->cursor_count++;
+
+		if (!j_db_internal_cursor_receive(cursor, background_data[i], &cursor_error))
+		{
+			ret = FALSE;
+
+			if (error != NULL && *error == NULL)
+			{
+				g_propagate_error(error, cursor_error);
+				cursor_error = NULL;
+			}
+		}
+
+		g_clear_error(&cursor_error);
+		j_db_internal_background_data_free(background_data[i]);
+	}
+
+	if (!ret)
+	{
+		j_db_internal_iterator_free(j_db_iterator);
+	}
+
+	return ret;
+}
+
+void
+j_db_internal_iterator_free(JDBIterator* j_db_iterator)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDBIteratorHelper* helper = j_db_iterator->iterator;
+	bson_t zerobson;
+
+	if (helper == NULL)
+	{
+		return;
+	}
+
+	memset(&zerobson, 0, sizeof(bson_t));
+
+	for (guint32 i = 0; i < helper->cursor_count; i++)
+	{
+		JDBCursor* cursor = &(helper->cursors[i]);
+
+		if (cursor->prefetch != NULL)
+		{
+			JDBBackgroundData* background_data;
+
+			background_data = j_background_operation_wait(cursor->prefetch);
+			j_background_operation_unref(cursor->prefetch);
+			cursor->prefetch = NULL;
+
+			cursor->id = (background_data->ret) ? j_message_get_8(background_data->reply) : 0;
+			j_db_internal_background_data_free(background_data);
+		}
+
+		// Close cursors that have not been exhausted to release the server's resources
+		if (cursor->id != 0)
+		{
+			g_autoptr(JMessage) message = NULL;
+
+			message = j_message_new(J_MESSAGE_DB_CURSOR_CLOSE, sizeof(guint64));
+			j_message_add_operation(message, sizeof(guint64));
+			j_message_append_8(message, &(cursor->id));
+
+			j_connection_pool_send_receive(J_BACKEND_TYPE_DB, cursor->index, message, NULL);
+		}
+
+		if (cursor->page_valid)
+		{
+			bson_destroy(&cursor->page);
+		}
+	}
+
+	g_free(helper->cursors);
+
+	if (memcmp(&helper->bson, &zerobson, sizeof(bson_t)))
+	{
+		j_bson_destroy(&helper->bson);
+	}
+
+	g_free(helper);
+	j_db_iterator->iterator = NULL;
+}
+
+/**
+ * Returns the next result of a cursor-based query, fetching further pages as required.
+ *
+ * \private
+ *
+ * \param j_db_iterator An iterator.
+ * \param error         A GError.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+j_db_internal_iterate_cursors(JDBIterator* j_db_iterator, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDBIteratorHelper* helper = j_db_iterator->iterator;
+
+	while (helper->cursor_current < helper->cursor_count)
+	{
+		JDBCursor* cursor = &(helper->cursors[helper->cursor_current]);
+
+		if (bson_iter_next(&cursor->iter))
+		{
+			if (G_UNLIKELY(!j_bson_iter_copy_document(&cursor->iter, &j_db_iterator->bson, error)))
+			{
+				goto _error;
+			}
+
+			if (helper->sharded)
+			{
+				j_db_internal_encode_id(&j_db_iterator->bson, "_id", cursor->index, j_configuration_get_server_count(j_configuration(), J_BACKEND_TYPE_DB));
+			}
+
+			return TRUE;
+		}
+
+		if (cursor->id == 0)
+		{
+			helper->cursor_current++;
+			continue;
+		}
+
+		if (G_UNLIKELY(!j_db_internal_cursor_next_page(cursor, error)))
+		{
+			goto _error;
+		}
+	}
+
+	g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_ITERATOR_NO_MORE_ELEMENTS, "no more elements");
+
+_error:
+	j_db_internal_iterator_free(j_db_iterator);
+
+	return FALSE;
+}
+
 gboolean
 j_db_internal_iterate(JDBIterator* j_db_iterator, GError** error)
 {
@@ -462,6 +1618,11 @@ j_db_internal_iterate(JDBIterator* j_db_iterator, GError** error)
 
 	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
 
+	if (helper->cursors != NULL)
+	{
+		return j_db_internal_iterate_cursors(j_db_iterator, error);
+	}
+
 	memset(&zerobson, 0, sizeof(bson_t));
 
 	if (!helper->initialized)
@@ -469,7 +1630,7 @@ j_db_internal_iterate(JDBIterator* j_db_iterator, GError** error)
 		if (G_UNLIKELY(!memcmp(&helper->bson, &zerobson, sizeof(bson_t))))
 		{
 			g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_ITERATOR_INVALID, "iterator invalid");
-			goto error2;
+			goto _error;
 		}
 
 		if (G_UNLIKELY(!j_bson_iter_init(&helper->iter, &helper->bson, error)))
@@ -499,10 +1660,7 @@ j_db_internal_iterate(JDBIterator* j_db_iterator, GError** error)
 	return TRUE;
 
 _error:
-	j_bson_destroy(&helper->bson);
-
-error2:
-	g_free(helper);
+	j_db_internal_iterator_free(j_db_iterator);
 
 	return FALSE;
 }
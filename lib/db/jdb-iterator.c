@@ -39,7 +39,6 @@ j_db_iterator_new(JDBSchema* schema, JDBSelector* selector, GError** error)
 	J_TRACE_FUNCTION(NULL);
 
 	guint ret;
-	guint ret2 = FALSE;
 	JBatch* batch;
 	JDBIterator* iterator = NULL;
 
@@ -73,10 +72,18 @@ j_db_iterator_new(JDBSchema* schema, JDBSelector* selector, GError** error)
 	iterator->ref_count = 1;
 	iterator->valid = FALSE;
 	iterator->bson_valid = FALSE;
-	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
-	ret2 = j_db_internal_query(schema, selector, iterator, batch, error);
-	ret = ret2 && j_batch_execute(batch);
-	j_batch_unref(batch);
+
+	if (j_db_get_backend() == NULL)
+	{
+		// Results are streamed from the servers page by page
+		ret = j_db_internal_query_cursor(schema, selector, iterator, error);
+	}
+	else
+	{
+		batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+		ret = j_db_internal_query(schema, selector, iterator, batch, error) && j_batch_execute(batch);
+		j_batch_unref(batch);
+	}
 
 	if (G_UNLIKELY(!ret))
 	{
@@ -88,14 +95,6 @@ j_db_iterator_new(JDBSchema* schema, JDBSelector* selector, GError** error)
 	return iterator;
 
 _error:
-	if (ret2)
-	{
-		while (j_db_internal_iterate(iterator, NULL))
-		{
-			/*do nothing*/
-		}
-	}
-
 	j_db_iterator_unref(iterator);
 
 	return NULL;
@@ -122,10 +121,7 @@ j_db_iterator_unref(JDBIterator* iterator)
 
 	if (g_atomic_int_dec_and_test(&iterator->ref_count))
 	{
-		while (iterator->valid)
-		{
-			j_db_iterator_next(iterator, NULL);
-		}
+		j_db_internal_iterator_free(iterator);
 
 		j_db_schema_unref(iterator->schema);
 
@@ -49,6 +49,7 @@ j_db_schema_new(gchar const* namespace, gchar const* name, GError** error)
 	schema = j_helper_alloc_aligned(128, sizeof(JDBSchema));
 	schema->namespace = g_strdup(namespace);
 	schema->name = g_strdup(name);
+	schema->shard_key = NULL;
 	schema->variables = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
 	schema->index = g_array_new(FALSE, FALSE, sizeof(JDBSchemaIndex));
 	schema->bson_initialized = FALSE;
@@ -87,6 +88,7 @@ j_db_schema_unref(JDBSchema* schema)
 	{
 		g_free(schema->namespace);
 		g_free(schema->name);
+		g_free(schema->shard_key);
 		g_hash_table_unref(schema->variables);
 
 		for (i = 0; i < schema->index->len; i++)
@@ -399,6 +401,24 @@ _error:
 	return FALSE;
 }
 
+gboolean
+j_db_schema_set_shard_key(JDBSchema* schema, gchar const* name, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(schema != NULL, FALSE);
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(!schema->server_side, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	(void)error;
+
+	g_free(schema->shard_key);
+	schema->shard_key = g_strdup(name);
+
+	return TRUE;
+}
+
 gboolean
 j_db_schema_create(JDBSchema* schema, JBatch* batch, GError** error)
 {
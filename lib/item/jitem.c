@@ -450,9 +450,12 @@ j_item_new(JCollection* collection, gchar const* name, JDistribution* distributi
 		return NULL;
 	}
 
+	path = g_build_path("/", j_collection_get_name(collection), name, NULL);
+
 	if (distribution == NULL)
 	{
 		distribution = j_distribution_new(J_DISTRIBUTION_ROUND_ROBIN);
+		j_distribution_set_start_key(distribution, path);
 	}
 
 	item = g_slice_new(JItem);
@@ -466,7 +469,6 @@ j_item_new(JCollection* collection, gchar const* name, JDistribution* distributi
 	item->collection = j_collection_ref(collection);
 	item->ref_count = 1;
 
-	path = g_build_path("/", j_collection_get_name(item->collection), item->name, NULL);
 	item->kv = j_kv_new("items", path);
 	item->object = j_distributed_object_new("item", path, item->distribution);
 
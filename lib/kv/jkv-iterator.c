@@ -24,6 +24,8 @@
 
 #include <glib.h>
 
+#include <string.h>
+
 #include <kv/jkv-iterator.h>
 
 #include <kv/jkv.h>
@@ -39,6 +41,35 @@
  * @{
  **/
 
+/**
+ * A cursor streaming key-value pairs from a KV server.
+ **/
+struct JKVCursor
+{
+	/**
+	 * The KV server's index.
+	 **/
+	guint32 index;
+
+	/**
+	 * The server-side cursor's ID, 0 if all entries have been received.
+	 **/
+	guint64 id;
+
+	/**
+	 * The current page of entries and the number of entries not yet returned.
+	 **/
+	JMessage* page;
+	guint32 remaining;
+
+	/**
+	 * The request for the next page, which is sent as soon as the current page has been received.
+	 **/
+	JBackgroundOperation* prefetch;
+};
+
+typedef struct JKVCursor JKVCursor;
+
 struct JKVIterator
 {
 	JBackend* kv_backend;
@@ -48,6 +79,11 @@ struct JKVIterator
 	 **/
 	gpointer cursor;
 
+	/**
+	 * Whether only keys are returned.
+	 **/
+	gboolean keys_only;
+
 	/**
 	 * The current key.
 	 **/
@@ -59,132 +95,228 @@ struct JKVIterator
 	gconstpointer value;
 	guint32 len;
 
-	JMessage** replies;
-	guint32 replies_n;
-	guint32 replies_cur;
+	/**
+	 * The cursors of the KV servers, which are iterated one after the other.
+	 **/
+	JKVCursor* cursors;
+	guint32 cursors_n;
+	guint32 cursors_cur;
+};
+
+struct JKVBackgroundData
+{
+	guint32 index;
+	JMessage* message;
+	JMessage* reply;
+	gboolean ret;
 };
 
-static JMessage*
-fetch_reply(guint32 index, gchar const* namespace, gchar const* prefix)
+typedef struct JKVBackgroundData JKVBackgroundData;
+
+static gpointer
+j_kv_iterator_send_receive_background_operation(gpointer data)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	g_autoptr(JMessage) message = NULL;
-	JMessage* reply;
-	JMessageType message_type;
-	gpointer kv_connection;
-	gsize namespace_len;
-	gsize prefix_len;
+	JKVBackgroundData* background_data = data;
 
-	namespace_len = strlen(namespace) + 1;
+	background_data->ret = j_connection_pool_send_receive(J_BACKEND_TYPE_KV, background_data->index, background_data->message, background_data->reply);
 
-	if (prefix == NULL)
-	{
-		message_type = J_MESSAGE_KV_GET_ALL;
-		prefix_len = 0;
-	}
-	else
+	return data;
+}
+
+static JKVBackgroundData*
+j_kv_iterator_background_data_new(guint32 index, JMessage* message)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JKVBackgroundData* background_data;
+
+	background_data = g_slice_new(JKVBackgroundData);
+	background_data->index = index;
+	background_data->message = message;
+	background_data->reply = j_message_new_reply(message);
+	background_data->ret = FALSE;
+
+	return background_data;
+}
+
+static void
+j_kv_iterator_background_data_free(JKVBackgroundData* background_data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	j_message_unref(background_data->message);
+	j_message_unref(background_data->reply);
+
+	g_slice_free(JKVBackgroundData, background_data);
+}
+
+/**
+ * Requests the next page of a cursor in the background.
+ *
+ * \private
+ *
+ * \param cursor A cursor.
+ **/
+static void
+j_kv_iterator_cursor_prefetch(JKVCursor* cursor)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JMessage* message;
+
+	message = j_message_new(J_MESSAGE_KV_CURSOR_FETCH, sizeof(guint64));
+	j_message_add_operation(message, sizeof(guint64));
+	j_message_append_8(message, &(cursor->id));
+
+	cursor->prefetch = j_background_operation_new(j_kv_iterator_send_receive_background_operation, j_kv_iterator_background_data_new(cursor->index, message));
+}
+
+/**
+ * Takes over a page of entries and prefetches the next one.
+ *
+ * \private
+ *
+ * \param cursor          A cursor.
+ * \param background_data The background data containing the reply.
+ **/
+static void
+j_kv_iterator_cursor_receive(JKVCursor* cursor, JKVBackgroundData* background_data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_clear_pointer(&(cursor->page), j_message_unref);
+	cursor->id = 0;
+	cursor->remaining = 0;
+
+	if (!background_data->ret)
 	{
-		message_type = J_MESSAGE_KV_GET_BY_PREFIX;
-		prefix_len = strlen(prefix) + 1;
+		return;
 	}
 
-	message = j_message_new(message_type, namespace_len + prefix_len);
-	j_message_append_n(message, namespace, namespace_len);
+	cursor->page = j_message_ref(background_data->reply);
+	cursor->id = j_message_get_8(cursor->page);
+	cursor->remaining = j_message_get_4(cursor->page);
 
-	if (prefix != NULL)
+	if (cursor->id != 0)
 	{
-		j_message_append_n(message, prefix, prefix_len);
+		j_kv_iterator_cursor_prefetch(cursor);
 	}
+}
 
-	kv_connection = j_connection_pool_pop(J_BACKEND_TYPE_KV, index);
-	j_message_send(message, kv_connection);
+/**
+ * Waits for the prefetched page of a cursor.
+ *
+ * \private
+ *
+ * \param cursor A cursor.
+ **/
+static void
+j_kv_iterator_cursor_next_page(JKVCursor* cursor)
+{
+	J_TRACE_FUNCTION(NULL);
 
-	reply = j_message_new_reply(message);
-	j_message_receive(reply, kv_connection);
+	JKVBackgroundData* background_data;
 
-	j_connection_pool_push(J_BACKEND_TYPE_KV, index, kv_connection);
+	background_data = j_background_operation_wait(cursor->prefetch);
+	j_background_operation_unref(cursor->prefetch);
+	cursor->prefetch = NULL;
 
-	return reply;
+	j_kv_iterator_cursor_receive(cursor, background_data);
+	j_kv_iterator_background_data_free(background_data);
 }
 
 /**
- * Creates a new JKVIterator.
+ * Opens cursors on one or all KV servers in parallel.
  *
- * \param store A JStore.
+ * \private
  *
- * \return A new JKVIterator.
+ * \param iterator  An iterator.
+ * \param index     The KV server's index or G_MAXUINT32 for all servers.
+ * \param namespace A namespace.
+ * \param prefix    A prefix, might be NULL.
  **/
-JKVIterator*
-j_kv_iterator_new(gchar const* namespace, gchar const* prefix)
+static void
+j_kv_iterator_open(JKVIterator* iterator, guint32 index, gchar const* namespace, gchar const* prefix)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JKVIterator* iterator;
-
 	JConfiguration* configuration = j_configuration();
+	g_autofree JKVBackgroundData** background_data = NULL;
+	gsize namespace_len;
+	gsize prefix_len;
+	guint32 page_size;
+	guint32 server_count;
+	guint8 keys_only;
 
-	g_return_val_if_fail(namespace != NULL, NULL);
+	namespace_len = strlen(namespace) + 1;
+	prefix_len = (prefix != NULL) ? strlen(prefix) + 1 : 1;
+	page_size = j_configuration_get_kv_page_size(configuration);
+	server_count = j_configuration_get_server_count(configuration, J_BACKEND_TYPE_KV);
+	keys_only = iterator->keys_only;
 
-	/* FIXME still necessary? */
-	//j_operation_cache_flush();
+	iterator->cursors_n = (index == G_MAXUINT32) ? server_count : 1;
+	iterator->cursors = g_new0(JKVCursor, iterator->cursors_n);
 
-	iterator = g_slice_new(JKVIterator);
-	iterator->kv_backend = j_kv_get_backend();
-	iterator->cursor = NULL;
-	iterator->key = NULL;
-	iterator->value = NULL;
-	iterator->len = 0;
-	iterator->replies_n = j_configuration_get_server_count(configuration, J_BACKEND_TYPE_KV);
-	iterator->replies = g_new0(JMessage*, iterator->replies_n);
-	iterator->replies_cur = 0;
+	background_data = g_new0(JKVBackgroundData*, server_count);
 
-	if (iterator->kv_backend != NULL)
+	for (guint32 i = 0; i < server_count; i++)
 	{
-		if (prefix == NULL)
-		{
-			j_backend_kv_get_all(iterator->kv_backend, namespace, &(iterator->cursor));
-		}
-		else
+		JMessage* message;
+
+		if (index != G_MAXUINT32 && index != i)
 		{
-			j_backend_kv_get_by_prefix(iterator->kv_backend, namespace, prefix, &(iterator->cursor));
+			continue;
 		}
+
+		message = j_message_new(J_MESSAGE_KV_CURSOR_OPEN, 4 + 1 + namespace_len + prefix_len);
+		j_message_add_operation(message, 4 + 1 + namespace_len + prefix_len);
+		j_message_append_4(message, &page_size);
+		j_message_append_1(message, &keys_only);
+		j_message_append_string(message, namespace);
+		// An empty prefix matches all keys
+		j_message_append_string(message, (prefix != NULL) ? prefix : "");
+
+		background_data[i] = j_kv_iterator_background_data_new(i, message);
 	}
-	else
+
+	j_helper_execute_parallel(j_kv_iterator_send_receive_background_operation, (gpointer*)background_data, server_count);
+
+	for (guint32 i = 0, j = 0; i < server_count; i++)
 	{
-		for (guint32 i = 0; i < iterator->replies_n; i++)
+		if (background_data[i] == NULL)
 		{
-			iterator->replies[i] = fetch_reply(i, namespace, prefix);
+			continue;
 		}
-	}
 
-	return iterator;
+		iterator->cursors[j].index = i;
+		j_kv_iterator_cursor_receive(&(iterator->cursors[j]), background_data[i]);
+		j_kv_iterator_background_data_free(background_data[i]);
+		j++;
+	}
 }
 
-JKVIterator*
-j_kv_iterator_new_for_index(guint32 index, gchar const* namespace, gchar const* prefix)
+static JKVIterator*
+j_kv_iterator_new_internal(guint32 index, gchar const* namespace, gchar const* prefix, gboolean keys_only)
 {
 	J_TRACE_FUNCTION(NULL);
 
 	JKVIterator* iterator;
 
-	JConfiguration* configuration = j_configuration();
-
-	g_return_val_if_fail(namespace != NULL, NULL);
-	g_return_val_if_fail(index < j_configuration_get_server_count(configuration, J_BACKEND_TYPE_KV), NULL);
-
-	/* FIXME still necessary? */
-	//j_operation_cache_flush();
+	// Iterators do not use batches, so cached operations have to be executed first
+	j_operation_cache_wait();
 
 	iterator = g_slice_new(JKVIterator);
 	iterator->kv_backend = j_kv_get_backend();
 	iterator->cursor = NULL;
+	iterator->keys_only = keys_only;
 	iterator->key = NULL;
 	iterator->value = NULL;
 	iterator->len = 0;
-	iterator->replies_n = 1;
-	iterator->replies = g_new0(JMessage*, 1);
-	iterator->replies_cur = 0;
+	iterator->cursors = NULL;
+	iterator->cursors_n = 0;
+	iterator->cursors_cur = 0;
 
 	if (iterator->kv_backend != NULL)
 	{
@@ -199,12 +331,63 @@ j_kv_iterator_new_for_index(guint32 index, gchar const* namespace, gchar const*
 	}
 	else
 	{
-		iterator->replies[0] = fetch_reply(index, namespace, prefix);
+		j_kv_iterator_open(iterator, index, namespace, prefix);
 	}
 
 	return iterator;
 }
 
+/**
+ * Creates a new JKVIterator.
+ * Key-value pairs are fetched from the servers in pages of the configured size.
+ *
+ * \param namespace A namespace.
+ * \param prefix    A prefix, might be NULL.
+ *
+ * \return A new JKVIterator.
+ **/
+JKVIterator*
+j_kv_iterator_new(gchar const* namespace, gchar const* prefix)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(namespace != NULL, NULL);
+
+	return j_kv_iterator_new_internal(G_MAXUINT32, namespace, prefix, FALSE);
+}
+
+/**
+ * Creates a new JKVIterator that only returns keys.
+ * Values are not transferred, that is, j_kv_iterator_get() returns NULL values with a length of 0.
+ *
+ * \param namespace A namespace.
+ * \param prefix    A prefix, might be NULL.
+ *
+ * \return A new JKVIterator.
+ **/
+JKVIterator*
+j_kv_iterator_new_keys(gchar const* namespace, gchar const* prefix)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(namespace != NULL, NULL);
+
+	return j_kv_iterator_new_internal(G_MAXUINT32, namespace, prefix, TRUE);
+}
+
+JKVIterator*
+j_kv_iterator_new_for_index(guint32 index, gchar const* namespace, gchar const* prefix)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JConfiguration* configuration = j_configuration();
+
+	g_return_val_if_fail(namespace != NULL, NULL);
+	g_return_val_if_fail(index < j_configuration_get_server_count(configuration, J_BACKEND_TYPE_KV), NULL);
+
+	return j_kv_iterator_new_internal(index, namespace, prefix, FALSE);
+}
+
 /**
  * Frees the memory allocated by the JKVIterator.
  *
@@ -217,15 +400,38 @@ j_kv_iterator_free(JKVIterator* iterator)
 
 	g_return_if_fail(iterator != NULL);
 
-	for (guint32 i = 0; i < iterator->replies_n; i++)
+	for (guint32 i = 0; i < iterator->cursors_n; i++)
 	{
-		if (iterator->replies[i] != NULL)
+		JKVCursor* cursor = &(iterator->cursors[i]);
+
+		if (cursor->prefetch != NULL)
 		{
-			j_message_unref(iterator->replies[i]);
+			JKVBackgroundData* background_data;
+
+			background_data = j_background_operation_wait(cursor->prefetch);
+			j_background_operation_unref(cursor->prefetch);
+			cursor->prefetch = NULL;
+
+			cursor->id = (background_data->ret) ? j_message_get_8(background_data->reply) : 0;
+			j_kv_iterator_background_data_free(background_data);
 		}
+
+		// Close cursors that have not been exhausted to release the server's resources
+		if (cursor->id != 0)
+		{
+			g_autoptr(JMessage) message = NULL;
+
+			message = j_message_new(J_MESSAGE_KV_CURSOR_CLOSE, sizeof(guint64));
+			j_message_add_operation(message, sizeof(guint64));
+			j_message_append_8(message, &(cursor->id));
+
+			j_connection_pool_send_receive(J_BACKEND_TYPE_KV, cursor->index, message, NULL);
+		}
+
+		g_clear_pointer(&(cursor->page), j_message_unref);
 	}
 
-	g_free(iterator->replies);
+	g_free(iterator->cursors);
 
 	g_slice_free(JKVIterator, iterator);
 }
@@ -252,23 +458,44 @@ j_kv_iterator_next(JKVIterator* iterator)
 	if (iterator->kv_backend != NULL)
 	{
 		ret = j_backend_kv_iterate(iterator->kv_backend, iterator->cursor, &(iterator->key), &(iterator->value), &(iterator->len));
+
+		if (ret && iterator->keys_only)
+		{
+			iterator->value = NULL;
+			iterator->len = 0;
+		}
 	}
 	else
 	{
-	retry:
-		iterator->len = j_message_get_4(iterator->replies[iterator->replies_cur]);
-
-		if (iterator->len > 0)
+		while (iterator->cursors_cur < iterator->cursors_n)
 		{
-			iterator->value = j_message_get_n(iterator->replies[iterator->replies_cur], iterator->len);
-			iterator->key = j_message_get_string(iterator->replies[iterator->replies_cur]);
+			JKVCursor* cursor = &(iterator->cursors[iterator->cursors_cur]);
 
-			ret = TRUE;
-		}
-		else if (iterator->replies_cur < iterator->replies_n - 1)
-		{
-			iterator->replies_cur++;
-			goto retry;
+			if (cursor->remaining > 0)
+			{
+				iterator->value = NULL;
+				iterator->len = 0;
+
+				if (!iterator->keys_only)
+				{
+					iterator->len = j_message_get_4(cursor->page);
+					iterator->value = j_message_get_n(cursor->page, iterator->len);
+				}
+
+				iterator->key = j_message_get_string(cursor->page);
+				cursor->remaining--;
+
+				ret = TRUE;
+				break;
+			}
+
+			if (cursor->prefetch != NULL)
+			{
+				j_kv_iterator_cursor_next_page(cursor);
+				continue;
+			}
+
+			iterator->cursors_cur++;
 		}
 	}
 
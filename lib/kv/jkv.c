@@ -59,11 +59,47 @@ struct JKVOperation
 			guint32 value_len;
 			GDestroyNotify value_destroy;
 		} put;
+
+		struct
+		{
+			gchar* namespace;
+			gchar** keys;
+			guint32 count;
+			gpointer* values;
+			guint32* value_lens;
+
+			/**
+			 * The positions of the keys within the caller's arrays.
+			 * Each operation only contains the keys of a single server.
+			 **/
+			guint32* positions;
+		} get_many;
 	};
 };
 
 typedef struct JKVOperation JKVOperation;
 
+/**
+ * The value and length a key's reply has to be stored in.
+ **/
+struct JKVGetManySlot
+{
+	gpointer* value;
+	guint32* value_len;
+};
+
+typedef struct JKVGetManySlot JKVGetManySlot;
+
+struct JKVBackgroundData
+{
+	guint32 index;
+	JMessage* message;
+	JMessage* reply;
+	gboolean ret;
+};
+
+typedef struct JKVBackgroundData JKVBackgroundData;
+
 /**
  * A JKV.
  **/
@@ -84,6 +120,12 @@ struct JKV
 	 **/
 	gchar* key;
 
+	/**
+	 * The key used to group operations.
+	 * Operations for the same index and namespace can be combined into a single message.
+	 **/
+	gchar const* operation_key;
+
 	/**
 	 * The reference count.
 	 **/
@@ -166,6 +208,36 @@ j_kv_put_free(gpointer data)
 	g_slice_free(JKVOperation, operation);
 }
 
+static guint64
+j_kv_put_cache_size(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JKVOperation* operation = data;
+
+	// Values that are owned by the operation do not have to be copied
+	if (operation->put.value_destroy != NULL)
+	{
+		return 0;
+	}
+
+	return operation->put.value_len;
+}
+
+static void
+j_kv_put_cache(gpointer data, gpointer buffer)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JKVOperation* operation = data;
+
+	if (buffer != NULL)
+	{
+		memcpy(buffer, operation->put.value, operation->put.value_len);
+		operation->put.value = buffer;
+	}
+}
+
 static void
 j_kv_delete_free(gpointer data)
 {
@@ -188,6 +260,32 @@ j_kv_get_free(gpointer data)
 	g_slice_free(JKVOperation, operation);
 }
 
+static void
+j_kv_get_many_free(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JKVOperation* operation = data;
+
+	g_strfreev(operation->get_many.keys);
+	g_free(operation->get_many.namespace);
+	g_free(operation->get_many.positions);
+
+	g_slice_free(JKVOperation, operation);
+}
+
+static gpointer
+j_kv_send_receive_background_operation(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JKVBackgroundData* background_data = data;
+
+	background_data->ret = j_connection_pool_send_receive(J_BACKEND_TYPE_KV, background_data->index, background_data->message, background_data->reply);
+
+	return data;
+}
+
 static gboolean
 j_kv_put_exec(JList* operations, JSemantics* semantics)
 {
@@ -268,22 +366,16 @@ j_kv_put_exec(JList* operations, JSemantics* semantics)
 	}
 	else
 	{
-		gpointer kv_connection;
-
-		kv_connection = j_connection_pool_pop(J_BACKEND_TYPE_KV, index);
-		j_message_send(message, kv_connection);
+		g_autoptr(JMessage) reply = NULL;
 
 		if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
 		{
-			g_autoptr(JMessage) reply = NULL;
-
 			reply = j_message_new_reply(message);
-			j_message_receive(reply, kv_connection);
-
-			/* FIXME do something with reply */
 		}
 
-		j_connection_pool_push(J_BACKEND_TYPE_KV, index, kv_connection);
+		ret = j_connection_pool_send_receive(J_BACKEND_TYPE_KV, index, message, reply) && ret;
+
+		/* FIXME do something with reply */
 	}
 
 	return ret;
@@ -359,22 +451,16 @@ j_kv_delete_exec(JList* operations, JSemantics* semantics)
 	}
 	else
 	{
-		gpointer kv_connection;
-
-		kv_connection = j_connection_pool_pop(J_BACKEND_TYPE_KV, index);
-		j_message_send(message, kv_connection);
+		g_autoptr(JMessage) reply = NULL;
 
 		if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
 		{
-			g_autoptr(JMessage) reply = NULL;
-
 			reply = j_message_new_reply(message);
-			j_message_receive(reply, kv_connection);
-
-			/* FIXME do something with reply */
 		}
 
-		j_connection_pool_push(J_BACKEND_TYPE_KV, index, kv_connection);
+		ret = j_connection_pool_send_receive(J_BACKEND_TYPE_KV, index, message, reply) && ret;
+
+		/* FIXME do something with reply */
 	}
 
 	return ret;
@@ -474,13 +560,13 @@ j_kv_get_exec(JList* operations, JSemantics* semantics)
 	{
 		g_autoptr(JListIterator) iter = NULL;
 		g_autoptr(JMessage) reply = NULL;
-		gpointer kv_connection;
-
-		kv_connection = j_connection_pool_pop(J_BACKEND_TYPE_KV, index);
-		j_message_send(message, kv_connection);
 
 		reply = j_message_new_reply(message);
-		j_message_receive(reply, kv_connection);
+
+		if (!j_connection_pool_send_receive(J_BACKEND_TYPE_KV, index, message, reply))
+		{
+			return FALSE;
+		}
 
 		iter = j_list_iterator_new(operations);
 
@@ -513,13 +599,234 @@ j_kv_get_exec(JList* operations, JSemantics* semantics)
 				}
 			}
 		}
+	}
+
+	return ret;
+}
+
+/**
+ * Gets multiple values using the client-side backend.
+ *
+ * \private
+ *
+ * \param kv_backend The backend.
+ * \param operations A list of get_many operations for the same namespace.
+ * \param semantics  The semantics.
+ *
+ * \return TRUE if all values have been found, FALSE otherwise.
+ **/
+static gboolean
+j_kv_get_many_exec_backend(JBackend* kv_backend, JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = TRUE;
+
+	g_autoptr(JListIterator) it = NULL;
+	JKVOperation* first;
+	gpointer kv_batch = NULL;
+	gboolean get_many;
+
+	first = j_list_get_first(operations);
+
+	if (!j_backend_kv_batch_start(kv_backend, first->get_many.namespace, semantics, &kv_batch))
+	{
+		return FALSE;
+	}
+
+	get_many = j_backend_kv_has_get_many(kv_backend);
+	it = j_list_iterator_new(operations);
+
+	while (j_list_iterator_next(it))
+	{
+		JKVOperation* kop = j_list_iterator_get(it);
+
+		if (get_many)
+		{
+			g_autofree gconstpointer* values = NULL;
+			g_autofree guint32* value_lens = NULL;
+
+			values = g_new0(gconstpointer, kop->get_many.count);
+			value_lens = g_new0(guint32, kop->get_many.count);
+			ret = j_backend_kv_get_many(kv_backend, kv_batch, (gchar const* const*)kop->get_many.keys, kop->get_many.count, values, value_lens) && ret;
+
+			// The values belong to the backend batch, create copies for the caller
+			for (guint32 i = 0; i < kop->get_many.count; i++)
+			{
+				guint32 position = kop->get_many.positions[i];
+
+				kop->get_many.values[position] = (values[i] != NULL) ? g_memdup(values[i], value_lens[i]) : NULL;
+				kop->get_many.value_lens[position] = value_lens[i];
+			}
+		}
+		else
+		{
+			for (guint32 i = 0; i < kop->get_many.count; i++)
+			{
+				guint32 position = kop->get_many.positions[i];
+
+				if (!j_backend_kv_get(kv_backend, kv_batch, kop->get_many.keys[i], &(kop->get_many.values[position]), &(kop->get_many.value_lens[position])))
+				{
+					kop->get_many.values[position] = NULL;
+					kop->get_many.value_lens[position] = 0;
+					ret = FALSE;
+				}
+			}
+		}
+	}
+
+	ret = j_backend_kv_batch_execute(kv_backend, kv_batch) && ret;
+
+	return ret;
+}
+
+static gboolean
+j_kv_get_many_exec(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = TRUE;
+
+	JBackend* kv_backend;
+	g_autoptr(JListIterator) it = NULL;
+	g_autofree JMessage** messages = NULL;
+	g_autofree GArray** slots = NULL;
+	g_autofree JKVBackgroundData** background_data = NULL;
+	gchar const* namespace;
+	gsize namespace_len;
+	guint32 server_count;
+
+	g_return_val_if_fail(operations != NULL, FALSE);
+	g_return_val_if_fail(semantics != NULL, FALSE);
+
+	{
+		JKVOperation* kop;
+
+		kop = j_list_get_first(operations);
+		g_assert(kop != NULL);
+
+		namespace = kop->get_many.namespace;
+		namespace_len = strlen(namespace) + 1;
+	}
+
+	kv_backend = j_kv_get_backend();
+
+	if (kv_backend != NULL)
+	{
+		return j_kv_get_many_exec_backend(kv_backend, operations, semantics);
+	}
+
+	server_count = j_configuration_get_server_count(j_configuration(), J_BACKEND_TYPE_KV);
+	messages = g_new0(JMessage*, server_count);
+	slots = g_new0(GArray*, server_count);
+	background_data = g_new0(JKVBackgroundData*, server_count);
+
+	it = j_list_iterator_new(operations);
+
+	// Combine all keys of the same server into a single message
+	while (j_list_iterator_next(it))
+	{
+		JKVOperation* kop = j_list_iterator_get(it);
+
+		for (guint32 i = 0; i < kop->get_many.count; i++)
+		{
+			JKVGetManySlot slot;
+			gchar const* key = kop->get_many.keys[i];
+			gsize key_len;
+			guint32 index;
+
+			index = j_placement_get_server_index(J_BACKEND_TYPE_KV, key);
+			key_len = strlen(key) + 1;
+
+			if (messages[index] == NULL)
+			{
+				messages[index] = j_message_new(J_MESSAGE_KV_GET, namespace_len);
+				j_message_set_semantics(messages[index], semantics);
+				j_message_append_n(messages[index], namespace, namespace_len);
+
+				slots[index] = g_array_new(FALSE, FALSE, sizeof(JKVGetManySlot));
+			}
+
+			j_message_add_operation(messages[index], key_len);
+			j_message_append_n(messages[index], key, key_len);
+
+			slot.value = &(kop->get_many.values[kop->get_many.positions[i]]);
+			slot.value_len = &(kop->get_many.value_lens[kop->get_many.positions[i]]);
+			g_array_append_val(slots[index], slot);
+		}
+	}
+
+	for (guint32 i = 0; i < server_count; i++)
+	{
+		if (messages[i] == NULL)
+		{
+			continue;
+		}
+
+		background_data[i] = g_slice_new(JKVBackgroundData);
+		background_data[i]->index = i;
+		background_data[i]->message = messages[i];
+		background_data[i]->reply = j_message_new_reply(messages[i]);
+		background_data[i]->ret = FALSE;
+	}
+
+	j_helper_execute_parallel(j_kv_send_receive_background_operation, (gpointer*)background_data, server_count);
+
+	for (guint32 i = 0; i < server_count; i++)
+	{
+		if (background_data[i] == NULL)
+		{
+			continue;
+		}
+
+		ret = background_data[i]->ret && ret;
+
+		for (guint j = 0; background_data[i]->ret && j < slots[i]->len; j++)
+		{
+			JKVGetManySlot* slot = &g_array_index(slots[i], JKVGetManySlot, j);
+			guint32 len;
+
+			len = j_message_get_4(background_data[i]->reply);
+			ret = (len > 0) && ret;
+
+			if (len > 0)
+			{
+				*(slot->value) = g_memdup(j_message_get_n(background_data[i]->reply, len), len);
+				*(slot->value_len) = len;
+			}
+		}
 
-		j_connection_pool_push(J_BACKEND_TYPE_KV, index, kv_connection);
+		g_array_unref(slots[i]);
+		j_message_unref(background_data[i]->message);
+		j_message_unref(background_data[i]->reply);
+		g_slice_free(JKVBackgroundData, background_data[i]);
 	}
 
 	return ret;
 }
 
+/**
+ * Returns the key used to group a key-value pair's operations.
+ *
+ * \private
+ *
+ * \param index     The data server index.
+ * \param namespace The namespace.
+ *
+ * \return An interned string.
+ **/
+static gchar const*
+j_kv_get_operation_key(guint32 index, gchar const* namespace)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autofree gchar* operation_key = NULL;
+
+	operation_key = g_strdup_printf("%u:%s", index, namespace);
+
+	return g_intern_string(operation_key);
+}
+
 /**
  * Creates a new key-value pair.
  *
@@ -539,16 +846,16 @@ j_kv_new(gchar const* namespace, gchar const* key)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JConfiguration* configuration = j_configuration();
 	JKV* kv;
 
 	g_return_val_if_fail(namespace != NULL, NULL);
 	g_return_val_if_fail(key != NULL, NULL);
 
 	kv = g_slice_new(JKV);
-	kv->index = j_helper_hash(key) % j_configuration_get_server_count(configuration, J_BACKEND_TYPE_KV);
+	kv->index = j_placement_get_server_index(J_BACKEND_TYPE_KV, key);
 	kv->namespace = g_strdup(namespace);
 	kv->key = g_strdup(key);
+	kv->operation_key = j_kv_get_operation_key(kv->index, namespace);
 	kv->ref_count = 1;
 
 	return kv;
@@ -584,6 +891,7 @@ j_kv_new_for_index(guint32 index, gchar const* namespace, gchar const* key)
 	kv->index = index;
 	kv->namespace = g_strdup(namespace);
 	kv->key = g_strdup(key);
+	kv->operation_key = j_kv_get_operation_key(kv->index, namespace);
 	kv->ref_count = 1;
 
 	return kv;
@@ -666,11 +974,12 @@ j_kv_put(JKV* kv, gpointer value, guint32 value_len, GDestroyNotify value_destro
 	kop->put.value_destroy = value_destroy;
 
 	operation = j_operation_new();
-	// FIXME key = index + namespace
-	operation->key = kv;
+	operation->key = kv->operation_key;
 	operation->data = kop;
 	operation->exec_func = j_kv_put_exec;
 	operation->free_func = j_kv_put_free;
+	operation->cache_func = j_kv_put_cache;
+	operation->cache_size_func = j_kv_put_cache_size;
 
 	j_batch_add(batch, operation);
 }
@@ -694,10 +1003,11 @@ j_kv_delete(JKV* kv, JBatch* batch)
 	g_return_if_fail(kv != NULL);
 
 	operation = j_operation_new();
-	operation->key = kv;
+	operation->key = kv->operation_key;
 	operation->data = j_kv_ref(kv);
 	operation->exec_func = j_kv_delete_exec;
 	operation->free_func = j_kv_delete_free;
+	operation->cache_func = j_operation_cache_noop;
 
 	j_batch_add(batch, operation);
 }
@@ -729,7 +1039,7 @@ j_kv_get(JKV* kv, gpointer* value, guint32* value_len, JBatch* batch)
 	kop->get.data = NULL;
 
 	operation = j_operation_new();
-	operation->key = kv;
+	operation->key = kv->operation_key;
 	operation->data = kop;
 	operation->exec_func = j_kv_get_exec;
 	operation->free_func = j_kv_get_free;
@@ -765,7 +1075,7 @@ j_kv_get_callback(JKV* kv, JKVGetFunc func, gpointer data, JBatch* batch)
 	kop->get.data = data;
 
 	operation = j_operation_new();
-	operation->key = kv;
+	operation->key = kv->operation_key;
 	operation->data = kop;
 	operation->exec_func = j_kv_get_exec;
 	operation->free_func = j_kv_get_free;
@@ -773,6 +1083,104 @@ j_kv_get_callback(JKV* kv, JKVGetFunc func, gpointer data, JBatch* batch)
 	j_batch_add(batch, operation);
 }
 
+/**
+ * Gets multiple key-value pairs of a namespace.
+ * The keys are distributed to their servers, which are queried in parallel using a single message each.
+ * Unlike j_kv_get(), no #JKV has to be created per key.
+ *
+ * Values that do not exist are set to NULL.
+ * The keys are ordered with respect to other operations for the same keys within the batch.
+ *
+ * \code
+ * gchar const* keys[] = { "key1", "key2" };
+ * gpointer values[2];
+ * guint32 value_lens[2];
+ *
+ * j_kv_get_many("namespace", keys, 2, values, value_lens, batch);
+ * \endcode
+ *
+ * \param namespace  A namespace.
+ * \param keys       An array of keys.
+ * \param count      The number of keys.
+ * \param values     An array the values will be stored in, the values have to be freed by the caller.
+ * \param value_lens An array the values' lengths will be stored in.
+ * \param batch      A batch.
+ **/
+void
+j_kv_get_many(gchar const* namespace, gchar const* const* keys, guint32 count, gpointer* values, guint32* value_lens, JBatch* batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autofree GArray** positions = NULL;
+	guint32 server_count;
+
+	g_return_if_fail(namespace != NULL);
+	g_return_if_fail(keys != NULL);
+	g_return_if_fail(values != NULL);
+	g_return_if_fail(value_lens != NULL);
+
+	server_count = j_configuration_get_server_count(j_configuration(), J_BACKEND_TYPE_KV);
+	positions = g_new0(GArray*, server_count);
+
+	for (guint32 i = 0; i < count; i++)
+	{
+		guint32 index;
+
+		index = j_placement_get_server_index(J_BACKEND_TYPE_KV, keys[i]);
+
+		if (positions[index] == NULL)
+		{
+			positions[index] = g_array_new(FALSE, FALSE, sizeof(guint32));
+		}
+
+		g_array_append_val(positions[index], i);
+
+		values[i] = NULL;
+		value_lens[i] = 0;
+	}
+
+	/**
+	 * Use one operation per server, so that it shares its key with the other operations for the server.
+	 * This way, gets are ordered with puts and deletes of the same keys under relaxed ordering.
+	 */
+	for (guint32 index = 0; index < server_count; index++)
+	{
+		JKVOperation* kop;
+		JOperation* operation;
+		guint32 length;
+
+		if (positions[index] == NULL)
+		{
+			continue;
+		}
+
+		length = positions[index]->len;
+
+		kop = g_slice_new(JKVOperation);
+		kop->get_many.namespace = g_strdup(namespace);
+		kop->get_many.keys = g_new(gchar*, length + 1);
+		kop->get_many.count = length;
+		kop->get_many.values = values;
+		kop->get_many.value_lens = value_lens;
+		kop->get_many.positions = (guint32*)(gpointer)g_array_free(positions[index], FALSE);
+
+		for (guint32 i = 0; i < length; i++)
+		{
+			kop->get_many.keys[i] = g_strdup(keys[kop->get_many.positions[i]]);
+		}
+
+		kop->get_many.keys[length] = NULL;
+
+		operation = j_operation_new();
+		operation->key = j_kv_get_operation_key(index, namespace);
+		operation->data = kop;
+		operation->exec_func = j_kv_get_many_exec;
+		operation->free_func = j_kv_get_many_free;
+
+		j_batch_add(batch, operation);
+	}
+}
+
 /**
  * Returns the kv backend.
  *
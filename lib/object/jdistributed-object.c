@@ -28,6 +28,7 @@
 
 #include <object/jdistributed-object.h>
 
+#include <object/jobject-cache-internal.h>
 #include <object/jobject-internal.h>
 
 #include <julea.h>
@@ -50,6 +51,11 @@ struct JDistributedObjectBackgroundData
 	JList* operations;
 	JSemantics* semantics;
 
+	/**
+	 * Whether all operations have succeeded, set to FALSE by the background operation on failure.
+	 */
+	gboolean* ret;
+
 	/**
 	 * The union for read and write parts.
 	 */
@@ -91,6 +97,12 @@ struct JDistributedObjectOperation
 {
 	union
 	{
+		struct
+		{
+			JDistributedObject* object;
+			guint64 size;
+		} create;
+
 		struct
 		{
 			JDistributedObject* object;
@@ -103,6 +115,12 @@ struct JDistributedObjectOperation
 			JDistributedObject* object;
 		} sync;
 
+		struct
+		{
+			JDistributedObject* object;
+			guint64 size;
+		} truncate;
+
 		struct
 		{
 			JDistributedObject* object;
@@ -119,12 +137,33 @@ struct JDistributedObjectOperation
 			guint64 length;
 			guint64 offset;
 			guint64* bytes_written;
+
+			/**
+			 * Replaces bytes_written when the operation is cached.
+			 **/
+			guint64 cached_bytes_written;
 		} write;
 	};
 };
 
 typedef struct JDistributedObjectOperation JDistributedObjectOperation;
 
+/**
+ * A read that fills the read-ahead window.
+ **/
+struct JDistributedObjectPrefetch
+{
+	JDistributedObjectOperation operation;
+	guint64 bytes_read;
+
+	/**
+	 * The reads that are served by this prefetch.
+	 **/
+	JList* operations;
+};
+
+typedef struct JDistributedObjectPrefetch JDistributedObjectPrefetch;
+
 /**
  * A JDistributedObject.
  **/
@@ -140,22 +179,37 @@ struct JDistributedObject
 	 **/
 	gchar* name;
 
+	/**
+	 * The key used to group operations.
+	 * Operations issued through different handles for the same object share a key.
+	 **/
+	gchar* key;
+
 	JDistribution* distribution;
 
+	/**
+	 * The read-ahead and write-behind cache.
+	 **/
+	JObjectCache* cache;
+
 	/**
 	 * The reference count.
 	 **/
 	gint ref_count;
 };
 
+static gboolean j_distributed_object_write_exec_uncached(JList*, JSemantics*);
+
 static void
 j_distributed_object_create_free(gpointer data)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JDistributedObject* object = data;
+	JDistributedObjectOperation* operation = data;
 
-	j_distributed_object_unref(object);
+	j_distributed_object_unref(operation->create.object);
+
+	g_slice_free(JDistributedObjectOperation, operation);
 }
 
 static void
@@ -192,6 +246,51 @@ j_distributed_object_sync_free(gpointer data)
 	g_slice_free(JDistributedObjectOperation, operation);
 }
 
+static void
+j_distributed_object_truncate_free(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributedObjectOperation* operation = data;
+
+	j_distributed_object_unref(operation->truncate.object);
+
+	g_slice_free(JDistributedObjectOperation, operation);
+}
+
+/**
+ * Determines the sizes of the parts stored on each server.
+ *
+ * \private
+ *
+ * \param object       An object.
+ * \param size         The size of the whole object.
+ * \param sizes        Returns the size of each server's part.
+ * \param server_count The number of servers.
+ **/
+static void
+j_distributed_object_get_part_sizes(JDistributedObject* object, guint64 size, guint64* sizes, guint32 server_count)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	guint index;
+	guint64 block_id;
+	guint64 new_length;
+	guint64 new_offset;
+
+	for (guint i = 0; i < server_count; i++)
+	{
+		sizes[i] = 0;
+	}
+
+	j_distribution_reset(object->distribution, size, 0);
+
+	while (j_distribution_distribute(object->distribution, &index, &new_length, &new_offset, &block_id))
+	{
+		sizes[index] = MAX(sizes[index], new_offset + new_length);
+	}
+}
+
 static void
 j_distributed_object_read_free(gpointer data)
 {
@@ -216,6 +315,78 @@ j_distributed_object_write_free(gpointer data)
 	g_slice_free(JDistributedObjectOperation, operation);
 }
 
+static guint64
+j_distributed_object_write_cache_size(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributedObjectOperation* operation = data;
+
+	return operation->write.length;
+}
+
+static void
+j_distributed_object_write_cache(gpointer data, gpointer buffer)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributedObjectOperation* operation = data;
+
+	memcpy(buffer, operation->write.data, operation->write.length);
+	operation->write.data = buffer;
+
+	// The caller's bytes_written might be gone by the time the operation is executed
+	j_helper_atomic_add(operation->write.bytes_written, operation->write.length);
+	operation->write.bytes_written = &(operation->write.cached_bytes_written);
+}
+
+/**
+ * Writes back an object's buffered writes.
+ *
+ * \private
+ *
+ * \param object    An object.
+ * \param only_full Whether to only write back a full buffer.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+j_distributed_object_flush(JDistributedObject* object, gboolean only_full)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret;
+
+	g_autoptr(JList) operations = NULL;
+	g_autofree gpointer data = NULL;
+	JDistributedObjectOperation operation;
+	JSemantics* semantics;
+	guint64 bytes_written = 0;
+	guint64 length;
+	guint64 offset;
+
+	if ((data = j_object_cache_take_dirty(object->cache, only_full, &length, &offset, &semantics)) == NULL)
+	{
+		return TRUE;
+	}
+
+	operation.write.object = object;
+	operation.write.data = data;
+	operation.write.length = length;
+	operation.write.offset = offset;
+	operation.write.bytes_written = &bytes_written;
+
+	operations = j_list_new(NULL);
+	j_list_append(operations, &operation);
+
+	ret = j_distributed_object_write_exec_uncached(operations, semantics);
+
+	j_semantics_unref(semantics);
+
+	// Short writes have to be reported since the buffered writes have already been reported as written
+	return ret && bytes_written == length;
+}
+
 /**
  * Executes create operations in a background operation.
  *
@@ -239,6 +410,12 @@ j_distributed_object_create_background_operation(gpointer data)
 	safety = j_semantics_get(background_data->semantics, J_SEMANTICS_SAFETY);
 	object_connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, background_data->index);
 
+	if (object_connection == NULL)
+	{
+		*(background_data->ret) = FALSE;
+		goto end;
+	}
+
 	j_message_send(background_data->message, object_connection);
 
 	if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
@@ -251,8 +428,13 @@ j_distributed_object_create_background_operation(gpointer data)
 		/* FIXME do something with reply */
 	}
 
+end:
 	j_message_unref(background_data->message);
-	j_connection_pool_push(J_BACKEND_TYPE_OBJECT, background_data->index, object_connection);
+
+	if (object_connection != NULL)
+	{
+		j_connection_pool_push(J_BACKEND_TYPE_OBJECT, background_data->index, object_connection);
+	}
 
 	g_slice_free(JDistributedObjectBackgroundData, background_data);
 
@@ -282,6 +464,12 @@ j_distributed_object_delete_background_operation(gpointer data)
 	safety = j_semantics_get(background_data->semantics, J_SEMANTICS_SAFETY);
 	object_connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, background_data->index);
 
+	if (object_connection == NULL)
+	{
+		*(background_data->ret) = FALSE;
+		goto end;
+	}
+
 	j_message_send(background_data->message, object_connection);
 
 	if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
@@ -294,8 +482,13 @@ j_distributed_object_delete_background_operation(gpointer data)
 		/* FIXME do something with reply */
 	}
 
+end:
 	j_message_unref(background_data->message);
-	j_connection_pool_push(J_BACKEND_TYPE_OBJECT, background_data->index, object_connection);
+
+	if (object_connection != NULL)
+	{
+		j_connection_pool_push(J_BACKEND_TYPE_OBJECT, background_data->index, object_connection);
+	}
 
 	g_slice_free(JDistributedObjectBackgroundData, background_data);
 
@@ -325,6 +518,20 @@ j_distributed_object_read_background_operation(gpointer data)
 	guint32 operation_count;
 
 	object_connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, background_data->index);
+
+	if (object_connection == NULL)
+	{
+		it = j_list_iterator_new(background_data->read.buffers);
+
+		while (j_list_iterator_next(it))
+		{
+			g_slice_free(JDistributedObjectReadBuffer, j_list_iterator_get(it));
+		}
+
+		*(background_data->ret) = FALSE;
+		goto end;
+	}
+
 	j_message_send(background_data->message, object_connection);
 
 	reply = j_message_new_reply(background_data->message);
@@ -358,7 +565,14 @@ j_distributed_object_read_background_operation(gpointer data)
 			nbytes = j_message_get_8(reply);
 			j_helper_atomic_add(bytes_read, nbytes);
 
-			if (nbytes > 0)
+			// The server reports whether it could access the region
+			if (j_message_get_type(background_data->message) == J_MESSAGE_OBJECT_READ_RMA && !j_message_get_4(reply))
+			{
+				*(background_data->ret) = FALSE;
+			}
+
+			// Data transferred via RMA has already been written to the buffer
+			if (nbytes > 0 && j_message_get_type(background_data->message) == J_MESSAGE_OBJECT_READ)
 			{
 				GInputStream* input;
 
@@ -372,9 +586,13 @@ j_distributed_object_read_background_operation(gpointer data)
 		operations_done += reply_operation_count;
 	}
 
+end:
 	j_message_unref(background_data->message);
 
-	j_connection_pool_push(J_BACKEND_TYPE_OBJECT, background_data->index, object_connection);
+	if (object_connection != NULL)
+	{
+		j_connection_pool_push(J_BACKEND_TYPE_OBJECT, background_data->index, object_connection);
+	}
 
 	j_list_unref(background_data->read.buffers);
 
@@ -405,9 +623,17 @@ j_distributed_object_write_background_operation(gpointer data)
 
 	safety = j_semantics_get(background_data->semantics, J_SEMANTICS_SAFETY);
 	object_connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, background_data->index);
+
+	if (object_connection == NULL)
+	{
+		*(background_data->ret) = FALSE;
+		goto end;
+	}
+
 	j_message_send(background_data->message, object_connection);
 
-	if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
+	// The server reads the data via RMA, the buffers must not be released before it has replied
+	if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE || j_message_get_type(background_data->message) == J_MESSAGE_OBJECT_WRITE_RMA)
 	{
 		g_autoptr(JListIterator) it = NULL;
 		g_autoptr(JMessage) reply = NULL;
@@ -424,12 +650,22 @@ j_distributed_object_write_background_operation(gpointer data)
 
 			nbytes = j_message_get_8(reply);
 			j_helper_atomic_add(bytes_written, nbytes);
+
+			// The server reports whether it could access the region
+			if (j_message_get_type(background_data->message) == J_MESSAGE_OBJECT_WRITE_RMA && !j_message_get_4(reply))
+			{
+				*(background_data->ret) = FALSE;
+			}
 		}
 	}
 
+end:
 	j_message_unref(background_data->message);
 
-	j_connection_pool_push(J_BACKEND_TYPE_OBJECT, background_data->index, object_connection);
+	if (object_connection != NULL)
+	{
+		j_connection_pool_push(J_BACKEND_TYPE_OBJECT, background_data->index, object_connection);
+	}
 
 	j_list_unref(background_data->write.bytes_written);
 
@@ -459,6 +695,13 @@ j_distributed_object_status_background_operation(gpointer data)
 	gpointer object_connection;
 
 	object_connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, background_data->index);
+
+	if (object_connection == NULL)
+	{
+		*(background_data->ret) = FALSE;
+		goto end;
+	}
+
 	j_message_send(background_data->message, object_connection);
 
 	reply = j_message_new_reply(background_data->message);
@@ -489,9 +732,13 @@ j_distributed_object_status_background_operation(gpointer data)
 		}
 	}
 
+end:
 	j_message_unref(background_data->message);
 
-	j_connection_pool_push(J_BACKEND_TYPE_OBJECT, background_data->index, object_connection);
+	if (object_connection != NULL)
+	{
+		j_connection_pool_push(J_BACKEND_TYPE_OBJECT, background_data->index, object_connection);
+	}
 
 	g_slice_free(JDistributedObjectBackgroundData, background_data);
 
@@ -519,6 +766,13 @@ j_distributed_object_sync_background_operation(gpointer data)
 
 	safety = j_semantics_get(background_data->semantics, J_SEMANTICS_SAFETY);
 	object_connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, background_data->index);
+
+	if (object_connection == NULL)
+	{
+		*(background_data->ret) = FALSE;
+		goto end;
+	}
+
 	j_message_send(background_data->message, object_connection);
 
 	if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
@@ -531,8 +785,79 @@ j_distributed_object_sync_background_operation(gpointer data)
 		// FIXME do something with reply
 	}
 
+end:
+	j_message_unref(background_data->message);
+
+	if (object_connection != NULL)
+	{
+		j_connection_pool_push(J_BACKEND_TYPE_OBJECT, background_data->index, object_connection);
+	}
+
+	g_slice_free(JDistributedObjectBackgroundData, background_data);
+
+	return NULL;
+}
+
+/**
+ * Executes truncate operations in a background operation.
+ *
+ * \private
+ *
+ * \param data Background data.
+ *
+ * \return #data.
+ **/
+static gpointer
+j_distributed_object_truncate_background_operation(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributedObjectBackgroundData* background_data = data;
+
+	JSemanticsSafety safety;
+	gpointer object_connection;
+
+	safety = j_semantics_get(background_data->semantics, J_SEMANTICS_SAFETY);
+	object_connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, background_data->index);
+
+	if (object_connection == NULL)
+	{
+		*(background_data->ret) = FALSE;
+		goto end;
+	}
+
+	j_message_send(background_data->message, object_connection);
+
+	if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
+	{
+		g_autoptr(JMessage) reply = NULL;
+
+		reply = j_message_new_reply(background_data->message);
+
+		if (j_message_receive(reply, object_connection))
+		{
+			guint32 operations_done;
+
+			operations_done = j_message_get_count(reply);
+
+			for (guint i = 0; i < operations_done; i++)
+			{
+				*(background_data->ret) = (j_message_get_4(reply) != 0) && *(background_data->ret);
+			}
+		}
+		else
+		{
+			*(background_data->ret) = FALSE;
+		}
+	}
+
+end:
 	j_message_unref(background_data->message);
-	j_connection_pool_push(J_BACKEND_TYPE_OBJECT, background_data->index, object_connection);
+
+	if (object_connection != NULL)
+	{
+		j_connection_pool_push(J_BACKEND_TYPE_OBJECT, background_data->index, object_connection);
+	}
 
 	g_slice_free(JDistributedObjectBackgroundData, background_data);
 
@@ -550,6 +875,7 @@ j_distributed_object_create_exec(JList* operations, JSemantics* semantics)
 	JBackend* object_backend;
 	g_autoptr(JListIterator) it = NULL;
 	g_autofree JMessage** messages = NULL;
+	g_autofree guint64* sizes = NULL;
 	gchar const* namespace = NULL;
 	gsize namespace_len = 0;
 	guint32 server_count = 0;
@@ -558,9 +884,10 @@ j_distributed_object_create_exec(JList* operations, JSemantics* semantics)
 	g_return_val_if_fail(semantics != NULL, FALSE);
 
 	{
-		JDistributedObject* object;
+		JDistributedObjectOperation* operation = j_list_get_first(operations);
+		JDistributedObject* object = operation->create.object;
 
-		object = j_list_get_first(operations);
+		g_assert(operation != NULL);
 		g_assert(object != NULL);
 
 		namespace = object->namespace;
@@ -574,6 +901,7 @@ j_distributed_object_create_exec(JList* operations, JSemantics* semantics)
 	{
 		server_count = j_configuration_get_server_count(j_configuration(), J_BACKEND_TYPE_OBJECT);
 		messages = g_new(JMessage*, server_count);
+		sizes = g_new(guint64, server_count);
 
 		// FIXME use actual distribution
 		for (guint i = 0; i < server_count; i++)
@@ -594,13 +922,23 @@ j_distributed_object_create_exec(JList* operations, JSemantics* semantics)
 
 	while (j_list_iterator_next(it))
 	{
-		JDistributedObject* object = j_list_iterator_get(it);
+		JDistributedObjectOperation* operation = j_list_iterator_get(it);
+		JDistributedObject* object = operation->create.object;
 
 		if (object_backend != NULL)
 		{
 			gpointer object_handle;
+			gboolean created;
+
+			created = j_backend_object_create(object_backend, object->namespace, object->name, &object_handle);
+			ret = created && ret;
+
+			if (created && operation->create.size > 0)
+			{
+				// The size is only a hint, failing to reserve space is not an error
+				j_backend_object_allocate(object_backend, object_handle, operation->create.size);
+			}
 
-			ret = j_backend_object_create(object_backend, object->namespace, object->name, &object_handle) && ret;
 			ret = j_backend_object_close(object_backend, object_handle) && ret;
 		}
 		else
@@ -608,12 +946,14 @@ j_distributed_object_create_exec(JList* operations, JSemantics* semantics)
 			gsize name_len;
 
 			name_len = strlen(object->name) + 1;
+			j_distributed_object_get_part_sizes(object, operation->create.size, sizes, server_count);
 
 			// FIXME use actual distribution
 			for (guint i = 0; i < server_count; i++)
 			{
-				j_message_add_operation(messages[i], name_len);
+				j_message_add_operation(messages[i], name_len + sizeof(guint64));
 				j_message_append_n(messages[i], object->name, name_len);
+				j_message_append_8(messages[i], &(sizes[i]));
 			}
 		}
 	}
@@ -621,24 +961,34 @@ j_distributed_object_create_exec(JList* operations, JSemantics* semantics)
 	if (object_backend == NULL)
 	{
 		g_autofree gpointer* background_data = NULL;
+		g_autofree gboolean* rets = NULL;
 
 		background_data = g_new(gpointer, server_count);
+		rets = g_new(gboolean, server_count);
 
 		// FIXME use actual distribution
 		for (guint i = 0; i < server_count; i++)
 		{
 			JDistributedObjectBackgroundData* data;
 
+			rets[i] = TRUE;
+
 			data = g_slice_new(JDistributedObjectBackgroundData);
 			data->index = i;
 			data->message = messages[i];
 			data->operations = NULL;
 			data->semantics = semantics;
+			data->ret = &(rets[i]);
 
 			background_data[i] = data;
 		}
 
 		j_helper_execute_parallel(j_distributed_object_create_background_operation, background_data, server_count);
+
+		for (guint i = 0; i < server_count; i++)
+		{
+			ret = rets[i] && ret;
+		}
 	}
 
 	return ret;
@@ -693,6 +1043,9 @@ j_distributed_object_delete_exec(JList* operations, JSemantics* semantics)
 	{
 		JDistributedObject* object = j_list_iterator_get(it);
 
+		// Buffered writes do not have to be written back anymore
+		j_object_cache_clear(object->cache);
+
 		if (object_backend != NULL)
 		{
 			gpointer object_handle;
@@ -718,31 +1071,41 @@ j_distributed_object_delete_exec(JList* operations, JSemantics* semantics)
 	if (object_backend == NULL)
 	{
 		g_autofree gpointer* background_data = NULL;
+		g_autofree gboolean* rets = NULL;
 
 		background_data = g_new(gpointer, server_count);
+		rets = g_new(gboolean, server_count);
 
 		// FIXME use actual distribution
 		for (guint i = 0; i < server_count; i++)
 		{
 			JDistributedObjectBackgroundData* data;
 
+			rets[i] = TRUE;
+
 			data = g_slice_new(JDistributedObjectBackgroundData);
 			data->index = i;
 			data->message = messages[i];
 			data->operations = NULL;
 			data->semantics = semantics;
+			data->ret = &(rets[i]);
 
 			background_data[i] = data;
 		}
 
 		j_helper_execute_parallel(j_distributed_object_delete_background_operation, background_data, server_count);
+
+		for (guint i = 0; i < server_count; i++)
+		{
+			ret = rets[i] && ret;
+		}
 	}
 
 	return ret;
 }
 
 static gboolean
-j_distributed_object_read_exec(JList* operations, JSemantics* semantics)
+j_distributed_object_read_exec_uncached(JList* operations, JSemantics* semantics)
 {
 	J_TRACE_FUNCTION(NULL);
 
@@ -752,6 +1115,7 @@ j_distributed_object_read_exec(JList* operations, JSemantics* semantics)
 	JBackend* object_backend;
 	g_autofree JList** br_lists = NULL;
 	g_autoptr(JListIterator) it = NULL;
+	g_autoptr(GPtrArray) regions = NULL;
 	g_autofree JMessage** messages = NULL;
 	JDistributedObject* object = NULL;
 	gpointer object_handle;
@@ -789,6 +1153,12 @@ j_distributed_object_read_exec(JList* operations, JSemantics* semantics)
 		namespace_len = strlen(object->namespace) + 1;
 		name_len = strlen(object->name) + 1;
 
+		if (j_fabric_is_enabled())
+		{
+			// The regions have to stay registered until all servers have replied
+			regions = g_ptr_array_new_with_free_func((GDestroyNotify)j_fabric_region_free);
+		}
+
 		for (guint i = 0; i < server_count; i++)
 		{
 			messages[i] = NULL;
@@ -837,17 +1207,45 @@ j_distributed_object_read_exec(JList* operations, JSemantics* semantics)
 
 				if (messages[index] == NULL && br_lists[index] == NULL)
 				{
-					messages[index] = j_message_new(J_MESSAGE_OBJECT_READ, namespace_len + name_len);
+					if (regions != NULL)
+					{
+						messages[index] = j_message_new(J_MESSAGE_OBJECT_READ_RMA, namespace_len + name_len + j_fabric_get_address_length());
+					}
+					else
+					{
+						messages[index] = j_message_new(J_MESSAGE_OBJECT_READ, namespace_len + name_len);
+					}
+
 					j_message_set_semantics(messages[index], semantics);
 					j_message_append_n(messages[index], object->namespace, namespace_len);
 					j_message_append_n(messages[index], object->name, name_len);
 
+					if (regions != NULL)
+					{
+						j_fabric_append_address(messages[index]);
+					}
+
 					br_lists[index] = j_list_new(NULL);
 				}
 
-				j_message_add_operation(messages[index], sizeof(guint64) + sizeof(guint64));
-				j_message_append_8(messages[index], &new_length);
-				j_message_append_8(messages[index], &new_offset);
+				if (regions != NULL)
+				{
+					JFabricRegion* region;
+
+					region = j_fabric_region_new(new_data, new_length, J_FABRIC_ACCESS_WRITE);
+					g_ptr_array_add(regions, region);
+
+					j_message_add_operation(messages[index], 4 * sizeof(guint64));
+					j_message_append_8(messages[index], &new_length);
+					j_message_append_8(messages[index], &new_offset);
+					j_fabric_region_append(region, messages[index]);
+				}
+				else
+				{
+					j_message_add_operation(messages[index], sizeof(guint64) + sizeof(guint64));
+					j_message_append_8(messages[index], &new_length);
+					j_message_append_8(messages[index], &new_offset);
+				}
 
 				buffer = g_slice_new(JDistributedObjectReadBuffer);
 				buffer->data = new_data;
@@ -876,13 +1274,17 @@ j_distributed_object_read_exec(JList* operations, JSemantics* semantics)
 	else
 	{
 		g_autofree gpointer* background_data = NULL;
+		g_autofree gboolean* rets = NULL;
 
 		background_data = g_new(gpointer, server_count);
+		rets = g_new(gboolean, server_count);
 
 		for (guint i = 0; i < server_count; i++)
 		{
 			JDistributedObjectBackgroundData* data;
 
+			rets[i] = TRUE;
+
 			if (messages[i] == NULL)
 			{
 				background_data[i] = NULL;
@@ -894,12 +1296,18 @@ j_distributed_object_read_exec(JList* operations, JSemantics* semantics)
 			data->message = messages[i];
 			data->operations = NULL;
 			data->semantics = semantics;
+			data->ret = &(rets[i]);
 			data->read.buffers = br_lists[i];
 
 			background_data[i] = data;
 		}
 
 		j_helper_execute_parallel(j_distributed_object_read_background_operation, background_data, server_count);
+
+		for (guint i = 0; i < server_count; i++)
+		{
+			ret = rets[i] && ret;
+		}
 	}
 
 	/*
@@ -916,7 +1324,7 @@ j_distributed_object_read_exec(JList* operations, JSemantics* semantics)
 }
 
 static gboolean
-j_distributed_object_write_exec(JList* operations, JSemantics* semantics)
+j_distributed_object_write_exec_uncached(JList* operations, JSemantics* semantics)
 {
 	J_TRACE_FUNCTION(NULL);
 
@@ -926,6 +1334,7 @@ j_distributed_object_write_exec(JList* operations, JSemantics* semantics)
 	JBackend* object_backend;
 	g_autofree JList** bw_lists = NULL;
 	g_autoptr(JListIterator) it = NULL;
+	g_autoptr(GPtrArray) regions = NULL;
 	g_autofree JMessage** messages = NULL;
 	JDistributedObject* object = NULL;
 	gpointer object_handle;
@@ -963,6 +1372,12 @@ j_distributed_object_write_exec(JList* operations, JSemantics* semantics)
 		namespace_len = strlen(object->namespace) + 1;
 		name_len = strlen(object->name) + 1;
 
+		if (j_fabric_is_enabled())
+		{
+			// The regions have to stay registered until all servers have replied
+			regions = g_ptr_array_new_with_free_func((GDestroyNotify)j_fabric_region_free);
+		}
+
 		for (guint i = 0; i < server_count; i++)
 		{
 			messages[i] = NULL;
@@ -987,6 +1402,8 @@ j_distributed_object_write_exec(JList* operations, JSemantics* semantics)
 
 		j_trace_file_begin(object->name, J_TRACE_FILE_WRITE);
 
+		j_object_cache_invalidate(object->cache, length, offset);
+
 		if (object_backend != NULL)
 		{
 			guint64 nbytes = 0;
@@ -1009,18 +1426,47 @@ j_distributed_object_write_exec(JList* operations, JSemantics* semantics)
 			{
 				if (messages[index] == NULL && bw_lists[index] == NULL)
 				{
-					messages[index] = j_message_new(J_MESSAGE_OBJECT_WRITE, namespace_len + name_len);
+					if (regions != NULL)
+					{
+						messages[index] = j_message_new(J_MESSAGE_OBJECT_WRITE_RMA, namespace_len + name_len + j_fabric_get_address_length());
+					}
+					else
+					{
+						messages[index] = j_message_new(J_MESSAGE_OBJECT_WRITE, namespace_len + name_len);
+					}
+
 					j_message_set_semantics(messages[index], semantics);
 					j_message_append_n(messages[index], object->namespace, namespace_len);
 					j_message_append_n(messages[index], object->name, name_len);
 
+					if (regions != NULL)
+					{
+						j_fabric_append_address(messages[index]);
+					}
+
 					bw_lists[index] = j_list_new(NULL);
 				}
 
-				j_message_add_operation(messages[index], sizeof(guint64) + sizeof(guint64));
-				j_message_append_8(messages[index], &new_length);
-				j_message_append_8(messages[index], &new_offset);
-				j_message_add_send(messages[index], new_data, new_length);
+				if (regions != NULL)
+				{
+					JFabricRegion* region;
+
+					// The server only reads from the region
+					region = j_fabric_region_new((gpointer)new_data, new_length, J_FABRIC_ACCESS_READ);
+					g_ptr_array_add(regions, region);
+
+					j_message_add_operation(messages[index], 4 * sizeof(guint64));
+					j_message_append_8(messages[index], &new_length);
+					j_message_append_8(messages[index], &new_offset);
+					j_fabric_region_append(region, messages[index]);
+				}
+				else
+				{
+					j_message_add_operation(messages[index], sizeof(guint64) + sizeof(guint64));
+					j_message_append_8(messages[index], &new_length);
+					j_message_append_8(messages[index], &new_offset);
+					j_message_add_send(messages[index], new_data, new_length);
+				}
 
 				j_list_append(bw_lists[index], bytes_written);
 
@@ -1034,7 +1480,7 @@ j_distributed_object_write_exec(JList* operations, JSemantics* semantics)
 				new_data += new_length;
 
 				// Fake bytes_written here instead of doing another loop further down
-				if (j_semantics_get(semantics, J_SEMANTICS_SAFETY) == J_SEMANTICS_SAFETY_NONE)
+				if (j_semantics_get(semantics, J_SEMANTICS_SAFETY) == J_SEMANTICS_SAFETY_NONE && regions == NULL)
 				{
 					j_helper_atomic_add(bytes_written, new_length);
 				}
@@ -1051,13 +1497,17 @@ j_distributed_object_write_exec(JList* operations, JSemantics* semantics)
 	else
 	{
 		g_autofree gpointer* background_data = NULL;
+		g_autofree gboolean* rets = NULL;
 
 		background_data = g_new(gpointer, server_count);
+		rets = g_new(gboolean, server_count);
 
 		for (guint i = 0; i < server_count; i++)
 		{
 			JDistributedObjectBackgroundData* data;
 
+			rets[i] = TRUE;
+
 			if (messages[i] == NULL)
 			{
 				background_data[i] = NULL;
@@ -1069,12 +1519,18 @@ j_distributed_object_write_exec(JList* operations, JSemantics* semantics)
 			data->message = messages[i];
 			data->operations = NULL;
 			data->semantics = semantics;
+			data->ret = &(rets[i]);
 			data->write.bytes_written = bw_lists[i];
 
 			background_data[i] = data;
 		}
 
 		j_helper_execute_parallel(j_distributed_object_write_background_operation, background_data, server_count);
+
+		for (guint i = 0; i < server_count; i++)
+		{
+			ret = rets[i] && ret;
+		}
 	}
 
 	/*
@@ -1090,6 +1546,264 @@ j_distributed_object_write_exec(JList* operations, JSemantics* semantics)
 	return ret;
 }
 
+static gboolean
+j_distributed_object_read_exec_handle(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = TRUE;
+
+	g_autoptr(JList) uncached = NULL;
+	g_autoptr(JList) prefetches = NULL;
+	g_autoptr(JListIterator) it = NULL;
+	JDistributedObjectPrefetch* prefetch = NULL;
+	JDistributedObject* object;
+
+	g_return_val_if_fail(operations != NULL, FALSE);
+	g_return_val_if_fail(semantics != NULL, FALSE);
+
+	{
+		JDistributedObjectOperation* operation = j_list_get_first(operations);
+
+		object = operation->read.object;
+
+		g_assert(operation != NULL);
+		g_assert(object != NULL);
+	}
+
+	// Reads have to see our own buffered writes
+	ret = j_distributed_object_flush(object, FALSE) && ret;
+
+	if (!j_object_cache_use_read_ahead(semantics))
+	{
+		return j_distributed_object_read_exec_uncached(operations, semantics) && ret;
+	}
+
+	uncached = j_list_new(NULL);
+	prefetches = j_list_new(NULL);
+
+	it = j_list_iterator_new(operations);
+
+	while (j_list_iterator_next(it))
+	{
+		JDistributedObjectOperation* operation = j_list_iterator_get(it);
+		guint64 length = operation->read.length;
+		guint64 offset = operation->read.offset;
+		guint64 read_ahead;
+
+		read_ahead = j_object_cache_get_read_ahead(object->cache, length, offset);
+
+		if (j_object_cache_read(object->cache, operation->read.data, length, offset, operation->read.bytes_read))
+		{
+			continue;
+		}
+
+		// Sequential reads within this batch are served by the previous prefetch
+		if (prefetch != NULL && offset >= prefetch->operation.read.offset && offset + length <= prefetch->operation.read.offset + prefetch->operation.read.length)
+		{
+			j_list_append(prefetch->operations, operation);
+			continue;
+		}
+
+		if (read_ahead > 0)
+		{
+			prefetch = g_slice_new(JDistributedObjectPrefetch);
+			prefetch->operation.read.object = object;
+			prefetch->operation.read.data = g_malloc(read_ahead);
+			prefetch->operation.read.length = read_ahead;
+			prefetch->operation.read.offset = offset;
+			prefetch->operation.read.bytes_read = &(prefetch->bytes_read);
+			prefetch->bytes_read = 0;
+			prefetch->operations = j_list_new(NULL);
+
+			j_list_append(prefetch->operations, operation);
+			j_list_append(uncached, &(prefetch->operation));
+			j_list_append(prefetches, prefetch);
+
+			continue;
+		}
+
+		j_list_append(uncached, operation);
+	}
+
+	if (j_list_length(uncached) > 0)
+	{
+		ret = j_distributed_object_read_exec_uncached(uncached, semantics) && ret;
+	}
+
+	j_list_iterator_free(it);
+	it = j_list_iterator_new(prefetches);
+
+	while (j_list_iterator_next(it))
+	{
+		g_autoptr(JListIterator) operations_it = NULL;
+
+		prefetch = j_list_iterator_get(it);
+
+		// Prefetches that come up short have reached the end of the object
+		j_object_cache_fill(object->cache, prefetch->operation.read.data, prefetch->bytes_read, prefetch->operation.read.offset, prefetch->bytes_read < prefetch->operation.read.length);
+
+		operations_it = j_list_iterator_new(prefetch->operations);
+
+		while (j_list_iterator_next(operations_it))
+		{
+			JDistributedObjectOperation* operation = j_list_iterator_get(operations_it);
+
+			// Reads starting behind the end of the object do not return any data
+			j_object_cache_read(object->cache, operation->read.data, operation->read.length, operation->read.offset, operation->read.bytes_read);
+		}
+
+		j_list_unref(prefetch->operations);
+		g_slice_free(JDistributedObjectPrefetch, prefetch);
+	}
+
+	return ret;
+}
+
+static gboolean
+j_distributed_object_write_exec_handle(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = TRUE;
+
+	g_autoptr(JList) uncached = NULL;
+	g_autoptr(JListIterator) it = NULL;
+	JDistributedObject* object;
+
+	g_return_val_if_fail(operations != NULL, FALSE);
+	g_return_val_if_fail(semantics != NULL, FALSE);
+
+	{
+		JDistributedObjectOperation* operation = j_list_get_first(operations);
+
+		object = operation->write.object;
+
+		g_assert(operation != NULL);
+		g_assert(object != NULL);
+	}
+
+	if (!j_object_cache_use_write_behind(semantics))
+	{
+		// Buffered writes have to be written before newer ones
+		ret = j_distributed_object_flush(object, FALSE) && ret;
+
+		return j_distributed_object_write_exec_uncached(operations, semantics) && ret;
+	}
+
+	uncached = j_list_new(NULL);
+	it = j_list_iterator_new(operations);
+
+	/**
+	 * Buffered data is always newer than the operations in uncached.
+	 * Therefore, uncached operations have to be executed before the buffer is written back.
+	 */
+	while (j_list_iterator_next(it))
+	{
+		JDistributedObjectOperation* operation = j_list_iterator_get(it);
+		gconstpointer data = operation->write.data;
+		guint64 length = operation->write.length;
+		guint64 offset = operation->write.offset;
+
+		if (j_object_cache_write(object->cache, data, length, offset, semantics))
+		{
+			j_helper_atomic_add(operation->write.bytes_written, length);
+			continue;
+		}
+
+		if (j_list_length(uncached) > 0)
+		{
+			ret = j_distributed_object_write_exec_uncached(uncached, semantics) && ret;
+			j_list_delete_all(uncached);
+		}
+
+		ret = j_distributed_object_flush(object, FALSE) && ret;
+
+		if (j_object_cache_write(object->cache, data, length, offset, semantics))
+		{
+			j_helper_atomic_add(operation->write.bytes_written, length);
+			continue;
+		}
+
+		j_list_append(uncached, operation);
+	}
+
+	if (j_list_length(uncached) > 0)
+	{
+		ret = j_distributed_object_write_exec_uncached(uncached, semantics) && ret;
+	}
+
+	ret = j_distributed_object_flush(object, TRUE) && ret;
+
+	return ret;
+}
+
+/**
+ * Executes operations in runs that use the same object handle.
+ *
+ * \private
+ *
+ * Operations for the same object might be issued through different handles, each of which has its own cache.
+ * Splitting them into consecutive runs keeps their order while each run only uses a single cache.
+ *
+ * \param operations A list of read or write operations.
+ * \param semantics  The semantics.
+ * \param exec_func  The function executing a single run.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+j_distributed_object_exec_per_handle(JList* operations, JSemantics* semantics, JOperationExecFunc exec_func)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(JList) run = NULL;
+	g_autoptr(JListIterator) it = NULL;
+	JDistributedObject* run_object = NULL;
+	gboolean ret = TRUE;
+
+	run = j_list_new(NULL);
+	it = j_list_iterator_new(operations);
+
+	while (j_list_iterator_next(it))
+	{
+		JDistributedObjectOperation* operation = j_list_iterator_get(it);
+
+		// Read and write operations both start with the object
+		if (run_object != NULL && operation->read.object != run_object)
+		{
+			ret = exec_func(run, semantics) && ret;
+			j_list_delete_all(run);
+		}
+
+		run_object = operation->read.object;
+		j_list_append(run, operation);
+	}
+
+	if (j_list_length(run) > 0)
+	{
+		ret = exec_func(run, semantics) && ret;
+	}
+
+	return ret;
+}
+
+static gboolean
+j_distributed_object_read_exec(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	return j_distributed_object_exec_per_handle(operations, semantics, j_distributed_object_read_exec_handle);
+}
+
+static gboolean
+j_distributed_object_write_exec(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	return j_distributed_object_exec_per_handle(operations, semantics, j_distributed_object_write_exec_handle);
+}
+
 static gboolean
 j_distributed_object_status_exec(JList* operations, JSemantics* semantics)
 {
@@ -1143,6 +1857,9 @@ j_distributed_object_status_exec(JList* operations, JSemantics* semantics)
 		gint64* modification_time = operation->status.modification_time;
 		guint64* size = operation->status.size;
 
+		// The size has to include our own buffered writes
+		ret = j_distributed_object_flush(object, FALSE) && ret;
+
 		if (modification_time != NULL)
 		{
 			*modification_time = 0;
@@ -1179,24 +1896,34 @@ j_distributed_object_status_exec(JList* operations, JSemantics* semantics)
 	if (object_backend == NULL)
 	{
 		g_autofree gpointer* background_data = NULL;
+		g_autofree gboolean* rets = NULL;
 
 		background_data = g_new(gpointer, server_count);
+		rets = g_new(gboolean, server_count);
 
 		// FIXME use actual distribution
 		for (guint i = 0; i < server_count; i++)
 		{
 			JDistributedObjectBackgroundData* data;
 
+			rets[i] = TRUE;
+
 			data = g_slice_new(JDistributedObjectBackgroundData);
 			data->index = i;
 			data->message = messages[i];
 			data->operations = operations;
 			data->semantics = semantics;
+			data->ret = &(rets[i]);
 
 			background_data[i] = data;
 		}
 
 		j_helper_execute_parallel(j_distributed_object_status_background_operation, background_data, server_count);
+
+		for (guint i = 0; i < server_count; i++)
+		{
+			ret = rets[i] && ret;
+		}
 	}
 
 	return ret;
@@ -1253,6 +1980,8 @@ j_distributed_object_sync_exec(JList* operations, JSemantics* semantics)
 		JDistributedObjectOperation* operation = j_list_iterator_get(it);
 		JDistributedObject* object = operation->sync.object;
 
+		ret = j_distributed_object_flush(object, FALSE) && ret;
+
 		if (object_backend != NULL)
 		{
 			gpointer object_handle;
@@ -1279,24 +2008,155 @@ j_distributed_object_sync_exec(JList* operations, JSemantics* semantics)
 	if (object_backend == NULL)
 	{
 		g_autofree gpointer* background_data = NULL;
+		g_autofree gboolean* rets = NULL;
 
 		background_data = g_new(gpointer, server_count);
+		rets = g_new(gboolean, server_count);
 
 		// FIXME use actual distribution
 		for (guint i = 0; i < server_count; i++)
 		{
 			JDistributedObjectBackgroundData* data;
 
+			rets[i] = TRUE;
+
 			data = g_slice_new(JDistributedObjectBackgroundData);
 			data->index = i;
 			data->message = messages[i];
 			data->operations = operations;
 			data->semantics = semantics;
+			data->ret = &(rets[i]);
 
 			background_data[i] = data;
 		}
 
 		j_helper_execute_parallel(j_distributed_object_sync_background_operation, background_data, server_count);
+
+		for (guint i = 0; i < server_count; i++)
+		{
+			ret = rets[i] && ret;
+		}
+	}
+
+	return ret;
+}
+
+static gboolean
+j_distributed_object_truncate_exec(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = TRUE;
+
+	JBackend* object_backend;
+	g_autoptr(JListIterator) it = NULL;
+	g_autofree JMessage** messages = NULL;
+	g_autofree guint64* sizes = NULL;
+	gchar const* namespace = NULL;
+	gsize namespace_len = 0;
+	guint32 server_count = 0;
+
+	g_return_val_if_fail(operations != NULL, FALSE);
+	g_return_val_if_fail(semantics != NULL, FALSE);
+
+	{
+		JDistributedObjectOperation* operation = j_list_get_first(operations);
+		JDistributedObject* object = operation->truncate.object;
+
+		g_assert(operation != NULL);
+		g_assert(object != NULL);
+
+		namespace = object->namespace;
+		namespace_len = strlen(namespace) + 1;
+	}
+
+	it = j_list_iterator_new(operations);
+	object_backend = j_object_get_backend();
+
+	if (object_backend == NULL)
+	{
+		server_count = j_configuration_get_server_count(j_configuration(), J_BACKEND_TYPE_OBJECT);
+		messages = g_new(JMessage*, server_count);
+		sizes = g_new(guint64, server_count);
+
+		// FIXME use actual distribution
+		for (guint i = 0; i < server_count; i++)
+		{
+			messages[i] = j_message_new(J_MESSAGE_OBJECT_TRUNCATE, namespace_len);
+			j_message_set_semantics(messages[i], semantics);
+			j_message_append_n(messages[i], namespace, namespace_len);
+		}
+	}
+
+	while (j_list_iterator_next(it))
+	{
+		JDistributedObjectOperation* operation = j_list_iterator_get(it);
+		JDistributedObject* object = operation->truncate.object;
+
+		ret = j_distributed_object_flush(object, FALSE) && ret;
+		j_object_cache_invalidate(object->cache, G_MAXUINT64 - operation->truncate.size, operation->truncate.size);
+
+		if (object_backend != NULL)
+		{
+			gpointer object_handle;
+
+			if (j_backend_object_open(object_backend, object->namespace, object->name, &object_handle))
+			{
+				ret = j_backend_object_truncate(object_backend, object_handle, operation->truncate.size) && ret;
+				ret = j_backend_object_close(object_backend, object_handle) && ret;
+			}
+			else
+			{
+				ret = FALSE;
+			}
+		}
+		else
+		{
+			gsize name_len;
+
+			name_len = strlen(object->name) + 1;
+			j_distributed_object_get_part_sizes(object, operation->truncate.size, sizes, server_count);
+
+			for (guint i = 0; i < server_count; i++)
+			{
+				j_message_add_operation(messages[i], name_len + sizeof(guint64));
+				j_message_append_n(messages[i], object->name, name_len);
+				j_message_append_8(messages[i], &(sizes[i]));
+			}
+		}
+	}
+
+	if (object_backend == NULL)
+	{
+		g_autofree gpointer* background_data = NULL;
+		g_autofree gboolean* rets = NULL;
+
+		background_data = g_new(gpointer, server_count);
+		rets = g_new(gboolean, server_count);
+
+		// FIXME use actual distribution
+		for (guint i = 0; i < server_count; i++)
+		{
+			JDistributedObjectBackgroundData* data;
+
+			rets[i] = TRUE;
+
+			data = g_slice_new(JDistributedObjectBackgroundData);
+			data->index = i;
+			data->message = messages[i];
+			data->operations = operations;
+			data->semantics = semantics;
+			data->ret = &(rets[i]);
+
+			background_data[i] = data;
+		}
+
+		j_helper_execute_parallel(j_distributed_object_truncate_background_operation, background_data, server_count);
+
+		for (guint i = 0; i < server_count; i++)
+		{
+			ret = rets[i] && ret;
+		}
 	}
 
 	return ret;
@@ -1332,7 +2192,9 @@ j_distributed_object_new(gchar const* namespace, gchar const* name, JDistributio
 	object = g_slice_new(JDistributedObject);
 	object->namespace = g_strdup(namespace);
 	object->name = g_strdup(name);
+	object->key = g_strdup_printf("%s/%s", namespace, name);
 	object->distribution = j_distribution_ref(distribution);
+	object->cache = j_object_cache_new();
 	object->ref_count = 1;
 
 	return object;
@@ -1365,7 +2227,8 @@ j_distributed_object_ref(JDistributedObject* object)
 
 /**
  * Decreases an object's reference count.
- * When the reference count reaches zero, frees the memory allocated for the object.
+ * When the reference count reaches zero, writes back buffered writes and frees the memory allocated for the object.
+ * Errors during the write-back are only logged, objects should be synced beforehand to be notified of them.
  *
  * \code
  * \endcode
@@ -1381,6 +2244,15 @@ j_distributed_object_unref(JDistributedObject* object)
 
 	if (g_atomic_int_dec_and_test(&(object->ref_count)))
 	{
+		// There is no caller to report errors to, objects should be synced before being freed
+		if (!j_distributed_object_flush(object, FALSE))
+		{
+			g_warning("Could not write back buffered writes of object %s/%s.", object->namespace, object->name);
+		}
+
+		j_object_cache_free(object->cache);
+
+		g_free(object->key);
 		g_free(object->name);
 		g_free(object->namespace);
 
@@ -1407,16 +2279,41 @@ j_distributed_object_create(JDistributedObject* object, JBatch* batch)
 {
 	J_TRACE_FUNCTION(NULL);
 
+	j_distributed_object_create_with_size(object, 0, batch);
+}
+
+/**
+ * Creates an object and reserves space for its expected size on all servers.
+ * The size is only a hint and does not change the object's size.
+ *
+ * \code
+ * \endcode
+ *
+ * \param object An object.
+ * \param size   The expected size, 0 if unknown.
+ * \param batch  A batch.
+ **/
+void
+j_distributed_object_create_with_size(JDistributedObject* object, guint64 size, JBatch* batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributedObjectOperation* iop;
 	JOperation* operation;
 
 	g_return_if_fail(object != NULL);
 
+	iop = g_slice_new(JDistributedObjectOperation);
+	iop->create.object = j_distributed_object_ref(object);
+	iop->create.size = size;
+
 	operation = j_operation_new();
 	// FIXME key = index + namespace
-	operation->key = object;
-	operation->data = j_distributed_object_ref(object);
+	operation->key = object->key;
+	operation->data = iop;
 	operation->exec_func = j_distributed_object_create_exec;
 	operation->free_func = j_distributed_object_create_free;
+	operation->cache_func = j_operation_cache_noop;
 
 	j_batch_add(batch, operation);
 }
@@ -1440,10 +2337,11 @@ j_distributed_object_delete(JDistributedObject* object, JBatch* batch)
 	g_return_if_fail(object != NULL);
 
 	operation = j_operation_new();
-	operation->key = object;
+	operation->key = object->key;
 	operation->data = j_distributed_object_ref(object);
 	operation->exec_func = j_distributed_object_delete_exec;
 	operation->free_func = j_distributed_object_delete_free;
+	operation->cache_func = j_operation_cache_noop;
 
 	j_batch_add(batch, operation);
 }
@@ -1492,7 +2390,7 @@ j_distributed_object_read(JDistributedObject* object, gpointer data, guint64 len
 		iop->read.bytes_read = bytes_read;
 
 		operation = j_operation_new();
-		operation->key = object;
+		operation->key = object->key;
 		operation->data = iop;
 		operation->exec_func = j_distributed_object_read_exec;
 		operation->free_func = j_distributed_object_read_free;
@@ -1552,12 +2450,15 @@ j_distributed_object_write(JDistributedObject* object, gconstpointer data, guint
 		iop->write.length = chunk_size;
 		iop->write.offset = offset;
 		iop->write.bytes_written = bytes_written;
+		iop->write.cached_bytes_written = 0;
 
 		operation = j_operation_new();
-		operation->key = object;
+		operation->key = object->key;
 		operation->data = iop;
 		operation->exec_func = j_distributed_object_write_exec;
 		operation->free_func = j_distributed_object_write_free;
+		operation->cache_func = j_distributed_object_write_cache;
+		operation->cache_size_func = j_distributed_object_write_cache_size;
 
 		j_batch_add(batch, operation);
 
@@ -1594,7 +2495,7 @@ j_distributed_object_status(JDistributedObject* object, gint64* modification_tim
 	iop->status.size = size;
 
 	operation = j_operation_new();
-	operation->key = object;
+	operation->key = object->key;
 	operation->data = iop;
 	operation->exec_func = j_distributed_object_status_exec;
 	operation->free_func = j_distributed_object_status_free;
@@ -1625,7 +2526,7 @@ j_distributed_object_sync(JDistributedObject* object, JBatch* batch)
 	iop->sync.object = j_distributed_object_ref(object);
 
 	operation = j_operation_new();
-	operation->key = object;
+	operation->key = object->key;
 	operation->data = iop;
 	operation->exec_func = j_distributed_object_sync_exec;
 	operation->free_func = j_distributed_object_sync_free;
@@ -1633,6 +2534,40 @@ j_distributed_object_sync(JDistributedObject* object, JBatch* batch)
 	j_batch_add(batch, operation);
 }
 
+/**
+ * Truncates or extends an object to the given size.
+ * The parts stored on each server are resized according to the object's distribution.
+ *
+ * \code
+ * \endcode
+ *
+ * \param object An object.
+ * \param size   The new size.
+ * \param batch  A batch.
+ **/
+void
+j_distributed_object_truncate(JDistributedObject* object, guint64 size, JBatch* batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDistributedObjectOperation* iop;
+	JOperation* operation;
+
+	g_return_if_fail(object != NULL);
+
+	iop = g_slice_new(JDistributedObjectOperation);
+	iop->truncate.object = j_distributed_object_ref(object);
+	iop->truncate.size = size;
+
+	operation = j_operation_new();
+	operation->key = object->key;
+	operation->data = iop;
+	operation->exec_func = j_distributed_object_truncate_exec;
+	operation->free_func = j_distributed_object_truncate_free;
+
+	j_batch_add(batch, operation);
+}
+
 /**
  * @}
  **/
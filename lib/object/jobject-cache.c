@@ -0,0 +1,499 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2020 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ **/
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <string.h>
+
+#include <object/jobject-cache-internal.h>
+
+#include <julea.h>
+
+/**
+ * \defgroup JObjectCache Object Cache
+ *
+ * Client-side read-ahead and write-behind for objects.
+ *
+ * Each object has at most one read-ahead window and one write-behind buffer.
+ * A read that continues the previous read is considered sequential and causes the following window to be prefetched.
+ * If enabled, small contiguous writes are collected until the buffer is full and then sent using a single operation.
+ *
+ * @{
+ **/
+
+/**
+ * An object cache.
+ **/
+struct JObjectCache
+{
+	/**
+	 * The read-ahead window.
+	 **/
+	struct
+	{
+		gchar* data;
+		guint64 length;
+		guint64 offset;
+
+		/**
+		 * Whether the window ends at the end of the object.
+		 **/
+		gboolean eof;
+
+		/**
+		 * The offset a sequential read is expected at.
+		 **/
+		guint64 next_offset;
+
+		/**
+		 * The number of consecutive sequential reads.
+		 **/
+		guint sequential;
+	} read;
+
+	/**
+	 * The write-behind buffer.
+	 **/
+	struct
+	{
+		gchar* data;
+		guint64 length;
+		guint64 offset;
+
+		/**
+		 * The semantics of the first buffered write.
+		 **/
+		JSemantics* semantics;
+	} write;
+
+	GMutex mutex[1];
+};
+
+/**
+ * Returns the size of the write-behind buffer.
+ * Buffered data is written using a single operation, so the buffer must not exceed the maximum operation size.
+ *
+ * \return The buffer size, 0 if write-behind is disabled.
+ **/
+static guint64
+j_object_cache_get_write_behind_size(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JConfiguration* configuration = j_configuration();
+
+	return MIN(j_configuration_get_write_behind(configuration), j_configuration_get_max_operation_size(configuration));
+}
+
+/**
+ * Creates a new object cache.
+ *
+ * \return A new object cache. Should be freed with j_object_cache_free().
+ **/
+JObjectCache*
+j_object_cache_new(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JObjectCache* cache;
+
+	cache = g_slice_new0(JObjectCache);
+	g_mutex_init(cache->mutex);
+
+	return cache;
+}
+
+/**
+ * Frees the memory allocated for the object cache.
+ * Buffered writes are discarded, they have to be taken using j_object_cache_take_dirty() beforehand.
+ *
+ * \param cache An object cache.
+ **/
+void
+j_object_cache_free(JObjectCache* cache)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(cache != NULL);
+
+	j_object_cache_clear(cache);
+	g_mutex_clear(cache->mutex);
+
+	g_slice_free(JObjectCache, cache);
+}
+
+/**
+ * Checks whether read-ahead may be used.
+ * Cached data might be stale, which is only acceptable if immediate consistency is not required.
+ *
+ * \param semantics A semantics object.
+ *
+ * \return TRUE if read-ahead may be used, FALSE otherwise.
+ **/
+gboolean
+j_object_cache_use_read_ahead(JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(semantics != NULL, FALSE);
+
+	if (j_configuration_get_read_ahead(j_configuration()) == 0)
+	{
+		return FALSE;
+	}
+
+	return (j_semantics_get(semantics, J_SEMANTICS_CONSISTENCY) != J_SEMANTICS_CONSISTENCY_IMMEDIATE);
+}
+
+/**
+ * Checks whether write-behind may be used.
+ * Buffered writes are neither visible to other clients nor persistent,
+ * which is only acceptable if neither immediate consistency nor immediate persistency are required.
+ * Additionally, write-behind has to be enabled explicitly since buffered writes are reported as written before they are sent.
+ *
+ * \param semantics A semantics object.
+ *
+ * \return TRUE if write-behind may be used, FALSE otherwise.
+ **/
+gboolean
+j_object_cache_use_write_behind(JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(semantics != NULL, FALSE);
+
+	if (j_object_cache_get_write_behind_size() == 0)
+	{
+		return FALSE;
+	}
+
+	if (j_semantics_get(semantics, J_SEMANTICS_CONSISTENCY) == J_SEMANTICS_CONSISTENCY_IMMEDIATE)
+	{
+		return FALSE;
+	}
+
+	return (j_semantics_get(semantics, J_SEMANTICS_PERSISTENCY) != J_SEMANTICS_PERSISTENCY_IMMEDIATE);
+}
+
+/**
+ * Reads from the read-ahead window.
+ *
+ * \param cache      An object cache.
+ * \param data       A buffer to hold the read data.
+ * \param length     Number of bytes to read.
+ * \param offset     An offset within the object.
+ * \param bytes_read Number of bytes read.
+ *
+ * \return TRUE if the read was served from the cache, FALSE otherwise.
+ **/
+gboolean
+j_object_cache_read(JObjectCache* cache, gpointer data, guint64 length, guint64 offset, guint64* bytes_read)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = FALSE;
+	guint64 end;
+
+	g_return_val_if_fail(cache != NULL, FALSE);
+	g_return_val_if_fail(data != NULL, FALSE);
+	g_return_val_if_fail(bytes_read != NULL, FALSE);
+
+	g_mutex_lock(cache->mutex);
+
+	end = cache->read.offset + cache->read.length;
+
+	if (cache->read.data != NULL && offset >= cache->read.offset && offset <= end)
+	{
+		// Reads beyond the end of the object are served, too, because the window knows the object's size
+		if (offset + length <= end || cache->read.eof)
+		{
+			guint64 nbytes;
+
+			nbytes = MIN(length, end - offset);
+			memcpy(data, cache->read.data + (offset - cache->read.offset), nbytes);
+			j_helper_atomic_add(bytes_read, nbytes);
+
+			ret = TRUE;
+		}
+	}
+
+	g_mutex_unlock(cache->mutex);
+
+	return ret;
+}
+
+/**
+ * Records a read and returns the amount of data to prefetch in case it cannot be served from the cache.
+ * Prefetching only happens for sequential reads that are smaller than the configured read-ahead window.
+ * Every read has to be recorded exactly once.
+ *
+ * \param cache  An object cache.
+ * \param length Number of bytes to read.
+ * \param offset An offset within the object.
+ *
+ * \return The number of bytes to read, 0 if no data should be prefetched.
+ **/
+guint64
+j_object_cache_get_read_ahead(JObjectCache* cache, guint64 length, guint64 offset)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JConfiguration* configuration = j_configuration();
+	guint64 read_ahead;
+	guint64 ret = 0;
+
+	g_return_val_if_fail(cache != NULL, 0);
+
+	read_ahead = MIN(j_configuration_get_read_ahead(configuration), j_configuration_get_max_operation_size(configuration));
+
+	g_mutex_lock(cache->mutex);
+
+	if (offset == cache->read.next_offset)
+	{
+		cache->read.sequential++;
+	}
+	else
+	{
+		cache->read.sequential = 0;
+	}
+
+	cache->read.next_offset = offset + length;
+
+	if (cache->read.sequential > 0 && length < read_ahead)
+	{
+		ret = read_ahead;
+	}
+
+	g_mutex_unlock(cache->mutex);
+
+	return ret;
+}
+
+/**
+ * Replaces the read-ahead window.
+ * The cache takes ownership of the data.
+ *
+ * \param cache  An object cache.
+ * \param data   The prefetched data.
+ * \param length Number of bytes prefetched.
+ * \param offset An offset within the object.
+ * \param eof    Whether the data ends at the end of the object.
+ **/
+void
+j_object_cache_fill(JObjectCache* cache, gpointer data, guint64 length, guint64 offset, gboolean eof)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(cache != NULL);
+	g_return_if_fail(data != NULL);
+
+	g_mutex_lock(cache->mutex);
+
+	g_free(cache->read.data);
+
+	cache->read.data = data;
+	cache->read.length = length;
+	cache->read.offset = offset;
+	cache->read.eof = eof;
+
+	g_mutex_unlock(cache->mutex);
+}
+
+/**
+ * Buffers a write.
+ * Writes are only buffered if they are contiguous to the already buffered data and fit into the remaining buffer.
+ * The buffer's size is the configured stripe size, limited by the maximum operation size.
+ *
+ * \param cache     An object cache.
+ * \param data      A buffer holding the data to write.
+ * \param length    Number of bytes to write.
+ * \param offset    An offset within the object.
+ * \param semantics A semantics object.
+ *
+ * \return TRUE if the write was buffered, FALSE otherwise.
+ **/
+gboolean
+j_object_cache_write(JObjectCache* cache, gconstpointer data, guint64 length, guint64 offset, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = FALSE;
+	guint64 size;
+
+	g_return_val_if_fail(cache != NULL, FALSE);
+	g_return_val_if_fail(data != NULL, FALSE);
+	g_return_val_if_fail(semantics != NULL, FALSE);
+
+	size = j_object_cache_get_write_behind_size();
+
+	if (length >= size)
+	{
+		return FALSE;
+	}
+
+	g_mutex_lock(cache->mutex);
+
+	if (cache->write.data == NULL)
+	{
+		cache->write.data = g_malloc(size);
+		cache->write.length = 0;
+		cache->write.offset = offset;
+		cache->write.semantics = j_semantics_ref(semantics);
+	}
+
+	if (offset == cache->write.offset + cache->write.length && cache->write.length + length <= size)
+	{
+		memcpy(cache->write.data + cache->write.length, data, length);
+		cache->write.length += length;
+
+		ret = TRUE;
+	}
+
+	g_mutex_unlock(cache->mutex);
+
+	if (ret)
+	{
+		j_object_cache_invalidate(cache, length, offset);
+	}
+
+	return ret;
+}
+
+/**
+ * Takes the buffered writes out of the cache.
+ * The caller is responsible for writing the data.
+ *
+ * \param cache     An object cache.
+ * \param only_full Whether to only take the data if the buffer is full.
+ * \param length    Returns the number of buffered bytes.
+ * \param offset    Returns the offset of the buffered data.
+ * \param semantics Returns the semantics of the first buffered write. Should be freed with j_semantics_unref().
+ *
+ * \return The buffered data, NULL if there is none. Should be freed with g_free().
+ **/
+gpointer
+j_object_cache_take_dirty(JObjectCache* cache, gboolean only_full, guint64* length, guint64* offset, JSemantics** semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gpointer ret = NULL;
+
+	g_return_val_if_fail(cache != NULL, NULL);
+	g_return_val_if_fail(length != NULL, NULL);
+	g_return_val_if_fail(offset != NULL, NULL);
+	g_return_val_if_fail(semantics != NULL, NULL);
+
+	g_mutex_lock(cache->mutex);
+
+	if (cache->write.data == NULL || cache->write.length == 0)
+	{
+		goto end;
+	}
+
+	if (only_full && cache->write.length < j_object_cache_get_write_behind_size())
+	{
+		goto end;
+	}
+
+	ret = cache->write.data;
+	*length = cache->write.length;
+	*offset = cache->write.offset;
+	*semantics = cache->write.semantics;
+
+	cache->write.data = NULL;
+	cache->write.length = 0;
+	cache->write.semantics = NULL;
+
+end:
+	g_mutex_unlock(cache->mutex);
+
+	return ret;
+}
+
+/**
+ * Drops the read-ahead window if it overlaps with the given range.
+ *
+ * \param cache  An object cache.
+ * \param length A length.
+ * \param offset An offset within the object.
+ **/
+void
+j_object_cache_invalidate(JObjectCache* cache, guint64 length, guint64 offset)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(cache != NULL);
+
+	g_mutex_lock(cache->mutex);
+
+	if (cache->read.data != NULL)
+	{
+		// A window at the end of the object also covers everything behind it
+		if (offset < cache->read.offset + cache->read.length || cache->read.eof)
+		{
+			if (offset + length > cache->read.offset)
+			{
+				g_free(cache->read.data);
+				cache->read.data = NULL;
+			}
+		}
+	}
+
+	g_mutex_unlock(cache->mutex);
+}
+
+/**
+ * Drops all cached data, including buffered writes.
+ *
+ * \param cache An object cache.
+ **/
+void
+j_object_cache_clear(JObjectCache* cache)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(cache != NULL);
+
+	g_mutex_lock(cache->mutex);
+
+	g_free(cache->read.data);
+	cache->read.data = NULL;
+	cache->read.sequential = 0;
+
+	g_free(cache->write.data);
+	cache->write.data = NULL;
+	cache->write.length = 0;
+
+	if (cache->write.semantics != NULL)
+	{
+		j_semantics_unref(cache->write.semantics);
+		cache->write.semantics = NULL;
+	}
+
+	g_mutex_unlock(cache->mutex);
+}
+
+/**
+ * @}
+ **/
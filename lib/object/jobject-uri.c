@@ -194,12 +194,24 @@ j_object_uri_parse(JObjectURI* uri, gchar const* uri_)
 			if (parts_len >= 2)
 			{
 				g_autoptr(JDistribution) distribution = NULL;
+				gchar const* placement;
+
+				uri->name = g_strdup(parts[1]);
+				placement = j_configuration_get_placement(j_configuration());
 
 				// FIXME
 				distribution = j_distribution_new(J_DISTRIBUTION_ROUND_ROBIN);
-				j_distribution_set(distribution, "start-index", 0);
 
-				uri->name = g_strdup(parts[1]);
+				// The distribution is not stored, objects created with the default placement always start at the first server
+				if (g_strcmp0(placement, "ring") == 0 || g_strcmp0(placement, "jump") == 0)
+				{
+					j_distribution_set_start_key(distribution, uri->name);
+				}
+				else
+				{
+					j_distribution_set(distribution, "start-index", 0);
+				}
+
 				uri->distributed_object = j_distributed_object_new(uri->namespace, uri->name, distribution);
 			}
 			break;
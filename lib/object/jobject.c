@@ -27,6 +27,7 @@
 #include <string.h>
 
 #include <object/jobject.h>
+#include <object/jobject-cache-internal.h>
 #include <object/jobject-internal.h>
 
 #include <julea.h>
@@ -43,6 +44,12 @@ struct JObjectOperation
 {
 	union
 	{
+		struct
+		{
+			JObject* object;
+			guint64 size;
+		} create;
+
 		struct
 		{
 			JObject* object;
@@ -55,6 +62,12 @@ struct JObjectOperation
 			JObject* object;
 		} sync;
 
+		struct
+		{
+			JObject* object;
+			guint64 size;
+		} truncate;
+
 		struct
 		{
 			JObject* object;
@@ -71,12 +84,33 @@ struct JObjectOperation
 			guint64 length;
 			guint64 offset;
 			guint64* bytes_written;
+
+			/**
+			 * Replaces bytes_written when the operation is cached.
+			 **/
+			guint64 cached_bytes_written;
 		} write;
 	};
 };
 
 typedef struct JObjectOperation JObjectOperation;
 
+/**
+ * A read that fills the read-ahead window.
+ **/
+struct JObjectPrefetch
+{
+	JObjectOperation operation;
+	guint64 bytes_read;
+
+	/**
+	 * The reads that are served by this prefetch.
+	 **/
+	JList* operations;
+};
+
+typedef struct JObjectPrefetch JObjectPrefetch;
+
 /**
  * A JObject.
  **/
@@ -97,12 +131,25 @@ struct JObject
 	 **/
 	gchar* name;
 
+	/**
+	 * The key used to group operations.
+	 * Operations issued through different handles for the same object share a key.
+	 **/
+	gchar* key;
+
+	/**
+	 * The read-ahead and write-behind cache.
+	 **/
+	JObjectCache* cache;
+
 	/**
 	 * The reference count.
 	 **/
 	gint ref_count;
 };
 
+static gboolean j_object_write_exec_uncached(JList*, JSemantics*);
+
 static JBackend* j_object_backend = NULL;
 static GModule* j_object_module = NULL;
 
@@ -167,9 +214,11 @@ j_object_create_free(gpointer data)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JObject* object = data;
+	JObjectOperation* operation = data;
 
-	j_object_unref(object);
+	j_object_unref(operation->create.object);
+
+	g_slice_free(JObjectOperation, operation);
 }
 
 static void
@@ -206,6 +255,18 @@ j_object_sync_free(gpointer data)
 	g_slice_free(JObjectOperation, operation);
 }
 
+static void
+j_object_truncate_free(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JObjectOperation* operation = data;
+
+	j_object_unref(operation->truncate.object);
+
+	g_slice_free(JObjectOperation, operation);
+}
+
 static void
 j_object_read_free(gpointer data)
 {
@@ -230,6 +291,78 @@ j_object_write_free(gpointer data)
 	g_slice_free(JObjectOperation, operation);
 }
 
+static guint64
+j_object_write_cache_size(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JObjectOperation* operation = data;
+
+	return operation->write.length;
+}
+
+static void
+j_object_write_cache(gpointer data, gpointer buffer)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JObjectOperation* operation = data;
+
+	memcpy(buffer, operation->write.data, operation->write.length);
+	operation->write.data = buffer;
+
+	// The caller's bytes_written might be gone by the time the operation is executed
+	j_helper_atomic_add(operation->write.bytes_written, operation->write.length);
+	operation->write.bytes_written = &(operation->write.cached_bytes_written);
+}
+
+/**
+ * Writes back an object's buffered writes.
+ *
+ * \private
+ *
+ * \param object    An object.
+ * \param only_full Whether to only write back a full buffer.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+j_object_flush(JObject* object, gboolean only_full)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret;
+
+	g_autoptr(JList) operations = NULL;
+	g_autofree gpointer data = NULL;
+	JObjectOperation operation;
+	JSemantics* semantics;
+	guint64 bytes_written = 0;
+	guint64 length;
+	guint64 offset;
+
+	if ((data = j_object_cache_take_dirty(object->cache, only_full, &length, &offset, &semantics)) == NULL)
+	{
+		return TRUE;
+	}
+
+	operation.write.object = object;
+	operation.write.data = data;
+	operation.write.length = length;
+	operation.write.offset = offset;
+	operation.write.bytes_written = &bytes_written;
+
+	operations = j_list_new(NULL);
+	j_list_append(operations, &operation);
+
+	ret = j_object_write_exec_uncached(operations, semantics);
+
+	j_semantics_unref(semantics);
+
+	// Short writes have to be reported since the buffered writes have already been reported as written
+	return ret && bytes_written == length;
+}
+
 static gboolean
 j_object_create_exec(JList* operations, JSemantics* semantics)
 {
@@ -249,9 +382,10 @@ j_object_create_exec(JList* operations, JSemantics* semantics)
 	g_return_val_if_fail(semantics != NULL, FALSE);
 
 	{
-		JObject* object;
+		JObjectOperation* operation = j_list_get_first(operations);
+		JObject* object = operation->create.object;
 
-		object = j_list_get_first(operations);
+		g_assert(operation != NULL);
 		g_assert(object != NULL);
 
 		namespace = object->namespace;
@@ -279,13 +413,23 @@ j_object_create_exec(JList* operations, JSemantics* semantics)
 
 	while (j_list_iterator_next(it))
 	{
-		JObject* object = j_list_iterator_get(it);
+		JObjectOperation* operation = j_list_iterator_get(it);
+		JObject* object = operation->create.object;
 
 		if (object_backend != NULL)
 		{
 			gpointer object_handle;
+			gboolean created;
+
+			created = j_backend_object_create(object_backend, object->namespace, object->name, &object_handle);
+			ret = created && ret;
+
+			if (created && operation->create.size > 0)
+			{
+				// The size is only a hint, failing to reserve space is not an error
+				j_backend_object_allocate(object_backend, object_handle, operation->create.size);
+			}
 
-			ret = j_backend_object_create(object_backend, object->namespace, object->name, &object_handle) && ret;
 			ret = j_backend_object_close(object_backend, object_handle) && ret;
 		}
 		else
@@ -294,8 +438,9 @@ j_object_create_exec(JList* operations, JSemantics* semantics)
 
 			name_len = strlen(object->name) + 1;
 
-			j_message_add_operation(message, name_len);
+			j_message_add_operation(message, name_len + sizeof(guint64));
 			j_message_append_n(message, object->name, name_len);
+			j_message_append_8(message, &(operation->create.size));
 		}
 	}
 
@@ -307,6 +452,12 @@ j_object_create_exec(JList* operations, JSemantics* semantics)
 
 		safety = j_semantics_get(semantics, J_SEMANTICS_SAFETY);
 		object_connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, index);
+
+		if (object_connection == NULL)
+		{
+			return FALSE;
+		}
+
 		j_message_send(message, object_connection);
 
 		if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
@@ -368,6 +519,9 @@ j_object_delete_exec(JList* operations, JSemantics* semantics)
 	{
 		JObject* object = j_list_iterator_get(it);
 
+		// Buffered writes do not have to be written back anymore
+		j_object_cache_clear(object->cache);
+
 		if (object_backend != NULL)
 		{
 			gpointer object_handle;
@@ -394,6 +548,12 @@ j_object_delete_exec(JList* operations, JSemantics* semantics)
 
 		safety = j_semantics_get(semantics, J_SEMANTICS_SAFETY);
 		object_connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, index);
+
+		if (object_connection == NULL)
+		{
+			return FALSE;
+		}
+
 		j_message_send(message, object_connection);
 
 		if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
@@ -413,7 +573,7 @@ j_object_delete_exec(JList* operations, JSemantics* semantics)
 }
 
 static gboolean
-j_object_read_exec(JList* operations, JSemantics* semantics)
+j_object_read_exec_uncached(JList* operations, JSemantics* semantics)
 {
 	J_TRACE_FUNCTION(NULL);
 
@@ -422,6 +582,7 @@ j_object_read_exec(JList* operations, JSemantics* semantics)
 
 	JBackend* object_backend;
 	JListIterator* it;
+	g_autoptr(GPtrArray) regions = NULL;
 	g_autoptr(JMessage) message = NULL;
 	JObject* object;
 	gpointer object_handle;
@@ -456,10 +617,26 @@ j_object_read_exec(JList* operations, JSemantics* semantics)
 		namespace_len = strlen(object->namespace) + 1;
 		name_len = strlen(object->name) + 1;
 
-		message = j_message_new(J_MESSAGE_OBJECT_READ, namespace_len + name_len);
+		if (j_fabric_is_enabled())
+		{
+			// The regions have to stay registered until the server has replied
+			regions = g_ptr_array_new_with_free_func((GDestroyNotify)j_fabric_region_free);
+
+			message = j_message_new(J_MESSAGE_OBJECT_READ_RMA, namespace_len + name_len + j_fabric_get_address_length());
+		}
+		else
+		{
+			message = j_message_new(J_MESSAGE_OBJECT_READ, namespace_len + name_len);
+		}
+
 		j_message_set_semantics(message, semantics);
 		j_message_append_n(message, object->namespace, namespace_len);
 		j_message_append_n(message, object->name, name_len);
+
+		if (regions != NULL)
+		{
+			j_fabric_append_address(message);
+		}
 	}
 
 	/*
@@ -486,6 +663,18 @@ j_object_read_exec(JList* operations, JSemantics* semantics)
 			ret = j_backend_object_read(object_backend, object_handle, data, length, offset, &nbytes) && ret;
 			j_helper_atomic_add(bytes_read, nbytes);
 		}
+		else if (regions != NULL)
+		{
+			JFabricRegion* region;
+
+			region = j_fabric_region_new(data, length, J_FABRIC_ACCESS_WRITE);
+			g_ptr_array_add(regions, region);
+
+			j_message_add_operation(message, 4 * sizeof(guint64));
+			j_message_append_8(message, &length);
+			j_message_append_8(message, &offset);
+			j_fabric_region_append(region, message);
+		}
 		else
 		{
 			j_message_add_operation(message, sizeof(guint64) + sizeof(guint64));
@@ -510,6 +699,12 @@ j_object_read_exec(JList* operations, JSemantics* semantics)
 		guint32 operation_count;
 
 		object_connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, object->index);
+
+		if (object_connection == NULL)
+		{
+			return FALSE;
+		}
+
 		j_message_send(message, object_connection);
 
 		reply = j_message_new_reply(message);
@@ -543,7 +738,14 @@ j_object_read_exec(JList* operations, JSemantics* semantics)
 				nbytes = j_message_get_8(reply);
 				j_helper_atomic_add(bytes_read, nbytes);
 
-				if (nbytes > 0)
+				// The server reports whether it could access the region
+				if (regions != NULL && !j_message_get_4(reply))
+				{
+					ret = FALSE;
+				}
+
+				// Data transferred via RMA has already been written to the buffer
+				if (nbytes > 0 && regions == NULL)
 				{
 					GInputStream* input;
 
@@ -574,7 +776,7 @@ j_object_read_exec(JList* operations, JSemantics* semantics)
 }
 
 static gboolean
-j_object_write_exec(JList* operations, JSemantics* semantics)
+j_object_write_exec_uncached(JList* operations, JSemantics* semantics)
 {
 	J_TRACE_FUNCTION(NULL);
 
@@ -583,6 +785,7 @@ j_object_write_exec(JList* operations, JSemantics* semantics)
 
 	JBackend* object_backend;
 	JListIterator* it;
+	g_autoptr(GPtrArray) regions = NULL;
 	g_autoptr(JMessage) message = NULL;
 	JObject* object;
 	gpointer object_handle;
@@ -617,10 +820,26 @@ j_object_write_exec(JList* operations, JSemantics* semantics)
 		namespace_len = strlen(object->namespace) + 1;
 		name_len = strlen(object->name) + 1;
 
-		message = j_message_new(J_MESSAGE_OBJECT_WRITE, namespace_len + name_len);
+		if (j_fabric_is_enabled())
+		{
+			// The regions have to stay registered until the server has replied
+			regions = g_ptr_array_new_with_free_func((GDestroyNotify)j_fabric_region_free);
+
+			message = j_message_new(J_MESSAGE_OBJECT_WRITE_RMA, namespace_len + name_len + j_fabric_get_address_length());
+		}
+		else
+		{
+			message = j_message_new(J_MESSAGE_OBJECT_WRITE, namespace_len + name_len);
+		}
+
 		j_message_set_semantics(message, semantics);
 		j_message_append_n(message, object->namespace, namespace_len);
 		j_message_append_n(message, object->name, name_len);
+
+		if (regions != NULL)
+		{
+			j_fabric_append_address(message);
+		}
 	}
 
 	/*
@@ -640,6 +859,8 @@ j_object_write_exec(JList* operations, JSemantics* semantics)
 
 		j_trace_file_begin(object->name, J_TRACE_FILE_WRITE);
 
+		j_object_cache_invalidate(object->cache, length, offset);
+
 		/*
 		if (lock != NULL)
 		{
@@ -654,6 +875,19 @@ j_object_write_exec(JList* operations, JSemantics* semantics)
 			ret = j_backend_object_write(object_backend, object_handle, data, length, offset, &nbytes) && ret;
 			j_helper_atomic_add(bytes_written, nbytes);
 		}
+		else if (regions != NULL)
+		{
+			JFabricRegion* region;
+
+			// The server only reads from the region
+			region = j_fabric_region_new((gpointer)data, length, J_FABRIC_ACCESS_READ);
+			g_ptr_array_add(regions, region);
+
+			j_message_add_operation(message, 4 * sizeof(guint64));
+			j_message_append_8(message, &length);
+			j_message_append_8(message, &offset);
+			j_fabric_region_append(region, message);
+		}
 		else
 		{
 			j_message_add_operation(message, sizeof(guint64) + sizeof(guint64));
@@ -685,9 +919,16 @@ j_object_write_exec(JList* operations, JSemantics* semantics)
 
 		safety = j_semantics_get(semantics, J_SEMANTICS_SAFETY);
 		object_connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, object->index);
+
+		if (object_connection == NULL)
+		{
+			return FALSE;
+		}
+
 		j_message_send(message, object_connection);
 
-		if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
+		// The server reads the data via RMA, the buffers must not be released before it has replied
+		if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE || regions != NULL)
 		{
 			g_autoptr(JMessage) reply = NULL;
 			guint64 nbytes;
@@ -704,6 +945,12 @@ j_object_write_exec(JList* operations, JSemantics* semantics)
 
 				nbytes = j_message_get_8(reply);
 				j_helper_atomic_add(bytes_written, nbytes);
+
+				// The server reports whether it could access the region
+				if (regions != NULL && !j_message_get_4(reply))
+				{
+					ret = FALSE;
+				}
 			}
 
 			j_list_iterator_free(it);
@@ -725,6 +972,264 @@ j_object_write_exec(JList* operations, JSemantics* semantics)
 	return ret;
 }
 
+static gboolean
+j_object_read_exec_handle(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = TRUE;
+
+	g_autoptr(JList) uncached = NULL;
+	g_autoptr(JList) prefetches = NULL;
+	g_autoptr(JListIterator) it = NULL;
+	JObjectPrefetch* prefetch = NULL;
+	JObject* object;
+
+	g_return_val_if_fail(operations != NULL, FALSE);
+	g_return_val_if_fail(semantics != NULL, FALSE);
+
+	{
+		JObjectOperation* operation = j_list_get_first(operations);
+
+		object = operation->read.object;
+
+		g_assert(operation != NULL);
+		g_assert(object != NULL);
+	}
+
+	// Reads have to see our own buffered writes
+	ret = j_object_flush(object, FALSE) && ret;
+
+	if (!j_object_cache_use_read_ahead(semantics))
+	{
+		return j_object_read_exec_uncached(operations, semantics) && ret;
+	}
+
+	uncached = j_list_new(NULL);
+	prefetches = j_list_new(NULL);
+
+	it = j_list_iterator_new(operations);
+
+	while (j_list_iterator_next(it))
+	{
+		JObjectOperation* operation = j_list_iterator_get(it);
+		guint64 length = operation->read.length;
+		guint64 offset = operation->read.offset;
+		guint64 read_ahead;
+
+		read_ahead = j_object_cache_get_read_ahead(object->cache, length, offset);
+
+		if (j_object_cache_read(object->cache, operation->read.data, length, offset, operation->read.bytes_read))
+		{
+			continue;
+		}
+
+		// Sequential reads within this batch are served by the previous prefetch
+		if (prefetch != NULL && offset >= prefetch->operation.read.offset && offset + length <= prefetch->operation.read.offset + prefetch->operation.read.length)
+		{
+			j_list_append(prefetch->operations, operation);
+			continue;
+		}
+
+		if (read_ahead > 0)
+		{
+			prefetch = g_slice_new(JObjectPrefetch);
+			prefetch->operation.read.object = object;
+			prefetch->operation.read.data = g_malloc(read_ahead);
+			prefetch->operation.read.length = read_ahead;
+			prefetch->operation.read.offset = offset;
+			prefetch->operation.read.bytes_read = &(prefetch->bytes_read);
+			prefetch->bytes_read = 0;
+			prefetch->operations = j_list_new(NULL);
+
+			j_list_append(prefetch->operations, operation);
+			j_list_append(uncached, &(prefetch->operation));
+			j_list_append(prefetches, prefetch);
+
+			continue;
+		}
+
+		j_list_append(uncached, operation);
+	}
+
+	if (j_list_length(uncached) > 0)
+	{
+		ret = j_object_read_exec_uncached(uncached, semantics) && ret;
+	}
+
+	j_list_iterator_free(it);
+	it = j_list_iterator_new(prefetches);
+
+	while (j_list_iterator_next(it))
+	{
+		g_autoptr(JListIterator) operations_it = NULL;
+
+		prefetch = j_list_iterator_get(it);
+
+		// Prefetches that come up short have reached the end of the object
+		j_object_cache_fill(object->cache, prefetch->operation.read.data, prefetch->bytes_read, prefetch->operation.read.offset, prefetch->bytes_read < prefetch->operation.read.length);
+
+		operations_it = j_list_iterator_new(prefetch->operations);
+
+		while (j_list_iterator_next(operations_it))
+		{
+			JObjectOperation* operation = j_list_iterator_get(operations_it);
+
+			// Reads starting behind the end of the object do not return any data
+			j_object_cache_read(object->cache, operation->read.data, operation->read.length, operation->read.offset, operation->read.bytes_read);
+		}
+
+		j_list_unref(prefetch->operations);
+		g_slice_free(JObjectPrefetch, prefetch);
+	}
+
+	return ret;
+}
+
+static gboolean
+j_object_write_exec_handle(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = TRUE;
+
+	g_autoptr(JList) uncached = NULL;
+	g_autoptr(JListIterator) it = NULL;
+	JObject* object;
+
+	g_return_val_if_fail(operations != NULL, FALSE);
+	g_return_val_if_fail(semantics != NULL, FALSE);
+
+	{
+		JObjectOperation* operation = j_list_get_first(operations);
+
+		object = operation->write.object;
+
+		g_assert(operation != NULL);
+		g_assert(object != NULL);
+	}
+
+	if (!j_object_cache_use_write_behind(semantics))
+	{
+		// Buffered writes have to be written before newer ones
+		ret = j_object_flush(object, FALSE) && ret;
+
+		return j_object_write_exec_uncached(operations, semantics) && ret;
+	}
+
+	uncached = j_list_new(NULL);
+	it = j_list_iterator_new(operations);
+
+	/**
+	 * Buffered data is always newer than the operations in uncached.
+	 * Therefore, uncached operations have to be executed before the buffer is written back.
+	 */
+	while (j_list_iterator_next(it))
+	{
+		JObjectOperation* operation = j_list_iterator_get(it);
+		gconstpointer data = operation->write.data;
+		guint64 length = operation->write.length;
+		guint64 offset = operation->write.offset;
+
+		if (j_object_cache_write(object->cache, data, length, offset, semantics))
+		{
+			j_helper_atomic_add(operation->write.bytes_written, length);
+			continue;
+		}
+
+		if (j_list_length(uncached) > 0)
+		{
+			ret = j_object_write_exec_uncached(uncached, semantics) && ret;
+			j_list_delete_all(uncached);
+		}
+
+		ret = j_object_flush(object, FALSE) && ret;
+
+		if (j_object_cache_write(object->cache, data, length, offset, semantics))
+		{
+			j_helper_atomic_add(operation->write.bytes_written, length);
+			continue;
+		}
+
+		j_list_append(uncached, operation);
+	}
+
+	if (j_list_length(uncached) > 0)
+	{
+		ret = j_object_write_exec_uncached(uncached, semantics) && ret;
+	}
+
+	ret = j_object_flush(object, TRUE) && ret;
+
+	return ret;
+}
+
+/**
+ * Executes operations in runs that use the same object handle.
+ *
+ * \private
+ *
+ * Operations for the same object might be issued through different handles, each of which has its own cache.
+ * Splitting them into consecutive runs keeps their order while each run only uses a single cache.
+ *
+ * \param operations A list of read or write operations.
+ * \param semantics  The semantics.
+ * \param exec_func  The function executing a single run.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+j_object_exec_per_handle(JList* operations, JSemantics* semantics, JOperationExecFunc exec_func)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(JList) run = NULL;
+	g_autoptr(JListIterator) it = NULL;
+	JObject* run_object = NULL;
+	gboolean ret = TRUE;
+
+	run = j_list_new(NULL);
+	it = j_list_iterator_new(operations);
+
+	while (j_list_iterator_next(it))
+	{
+		JObjectOperation* operation = j_list_iterator_get(it);
+
+		// Read and write operations both start with the object
+		if (run_object != NULL && operation->read.object != run_object)
+		{
+			ret = exec_func(run, semantics) && ret;
+			j_list_delete_all(run);
+		}
+
+		run_object = operation->read.object;
+		j_list_append(run, operation);
+	}
+
+	if (j_list_length(run) > 0)
+	{
+		ret = exec_func(run, semantics) && ret;
+	}
+
+	return ret;
+}
+
+static gboolean
+j_object_read_exec(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	return j_object_exec_per_handle(operations, semantics, j_object_read_exec_handle);
+}
+
+static gboolean
+j_object_write_exec(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	return j_object_exec_per_handle(operations, semantics, j_object_write_exec_handle);
+}
+
 static gboolean
 j_object_status_exec(JList* operations, JSemantics* semantics)
 {
@@ -769,9 +1274,13 @@ j_object_status_exec(JList* operations, JSemantics* semantics)
 	{
 		JObjectOperation* operation = j_list_iterator_get(it);
 		JObject* object = operation->status.object;
+
 		gint64* modification_time = operation->status.modification_time;
 		guint64* size = operation->status.size;
 
+		// The size has to include our own buffered writes
+		ret = j_object_flush(object, FALSE) && ret;
+
 		if (object_backend != NULL)
 		{
 			gpointer object_handle;
@@ -799,6 +1308,12 @@ j_object_status_exec(JList* operations, JSemantics* semantics)
 		gpointer object_connection;
 
 		object_connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, index);
+
+		if (object_connection == NULL)
+		{
+			return FALSE;
+		}
+
 		j_message_send(message, object_connection);
 
 		reply = j_message_new_reply(message);
@@ -881,6 +1396,8 @@ j_object_sync_exec(JList* operations, JSemantics* semantics)
 		JObjectOperation* operation = j_list_iterator_get(it);
 		JObject* object = operation->sync.object;
 
+		ret = j_object_flush(object, FALSE) && ret;
+
 		if (object_backend != NULL)
 		{
 			gpointer object_handle;
@@ -909,6 +1426,12 @@ j_object_sync_exec(JList* operations, JSemantics* semantics)
 
 		safety = j_semantics_get(semantics, J_SEMANTICS_SAFETY);
 		object_connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, index);
+
+		if (object_connection == NULL)
+		{
+			return FALSE;
+		}
+
 		j_message_send(message, object_connection);
 
 		if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
@@ -927,6 +1450,125 @@ j_object_sync_exec(JList* operations, JSemantics* semantics)
 	return ret;
 }
 
+static gboolean
+j_object_truncate_exec(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = TRUE;
+
+	JBackend* object_backend;
+	JListIterator* it;
+	g_autoptr(JMessage) message = NULL;
+	gchar const* namespace;
+	gsize namespace_len;
+	guint32 index;
+
+	g_return_val_if_fail(operations != NULL, FALSE);
+	g_return_val_if_fail(semantics != NULL, FALSE);
+
+	{
+		JObjectOperation* operation = j_list_get_first(operations);
+		JObject* object = operation->truncate.object;
+
+		g_assert(operation != NULL);
+		g_assert(object != NULL);
+
+		namespace = object->namespace;
+		namespace_len = strlen(namespace) + 1;
+		index = object->index;
+	}
+
+	it = j_list_iterator_new(operations);
+	object_backend = j_object_get_backend();
+
+	if (object_backend == NULL)
+	{
+		message = j_message_new(J_MESSAGE_OBJECT_TRUNCATE, namespace_len);
+		j_message_set_semantics(message, semantics);
+		j_message_append_n(message, namespace, namespace_len);
+	}
+
+	while (j_list_iterator_next(it))
+	{
+		JObjectOperation* operation = j_list_iterator_get(it);
+		JObject* object = operation->truncate.object;
+
+		ret = j_object_flush(object, FALSE) && ret;
+		j_object_cache_invalidate(object->cache, G_MAXUINT64 - operation->truncate.size, operation->truncate.size);
+
+		if (object_backend != NULL)
+		{
+			gpointer object_handle;
+
+			if (j_backend_object_open(object_backend, object->namespace, object->name, &object_handle))
+			{
+				ret = j_backend_object_truncate(object_backend, object_handle, operation->truncate.size) && ret;
+				ret = j_backend_object_close(object_backend, object_handle) && ret;
+			}
+			else
+			{
+				ret = FALSE;
+			}
+		}
+		else
+		{
+			gsize name_len;
+
+			name_len = strlen(object->name) + 1;
+
+			j_message_add_operation(message, name_len + sizeof(guint64));
+			j_message_append_n(message, object->name, name_len);
+			j_message_append_8(message, &(operation->truncate.size));
+		}
+	}
+
+	j_list_iterator_free(it);
+
+	if (object_backend == NULL)
+	{
+		JSemanticsSafety safety;
+		gpointer object_connection;
+
+		safety = j_semantics_get(semantics, J_SEMANTICS_SAFETY);
+		object_connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, index);
+
+		if (object_connection == NULL)
+		{
+			return FALSE;
+		}
+
+		j_message_send(message, object_connection);
+
+		if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
+		{
+			g_autoptr(JMessage) reply = NULL;
+
+			reply = j_message_new_reply(message);
+
+			if (j_message_receive(reply, object_connection))
+			{
+				guint32 operations_done;
+
+				operations_done = j_message_get_count(reply);
+
+				for (guint i = 0; i < operations_done; i++)
+				{
+					ret = (j_message_get_4(reply) != 0) && ret;
+				}
+			}
+			else
+			{
+				ret = FALSE;
+			}
+		}
+
+		j_connection_pool_push(J_BACKEND_TYPE_OBJECT, index, object_connection);
+	}
+
+	return ret;
+}
+
 /**
  * Creates a new object.
  *
@@ -946,16 +1588,17 @@ j_object_new(gchar const* namespace, gchar const* name)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JConfiguration* configuration = j_configuration();
 	JObject* object;
 
 	g_return_val_if_fail(namespace != NULL, NULL);
 	g_return_val_if_fail(name != NULL, NULL);
 
 	object = g_slice_new(JObject);
-	object->index = j_helper_hash(name) % j_configuration_get_server_count(configuration, J_BACKEND_TYPE_OBJECT);
+	object->index = j_placement_get_server_index(J_BACKEND_TYPE_OBJECT, name);
 	object->namespace = g_strdup(namespace);
 	object->name = g_strdup(name);
+	object->key = g_strdup_printf("%u:%s/%s", object->index, namespace, name);
+	object->cache = j_object_cache_new();
 	object->ref_count = 1;
 
 	return object;
@@ -992,6 +1635,8 @@ j_object_new_for_index(guint32 index, gchar const* namespace, gchar const* name)
 	object->index = index;
 	object->namespace = g_strdup(namespace);
 	object->name = g_strdup(name);
+	object->key = g_strdup_printf("%u:%s/%s", object->index, namespace, name);
+	object->cache = j_object_cache_new();
 	object->ref_count = 1;
 
 	return object;
@@ -1024,7 +1669,8 @@ j_object_ref(JObject* object)
 
 /**
  * Decreases an object's reference count.
- * When the reference count reaches zero, frees the memory allocated for the object.
+ * When the reference count reaches zero, writes back buffered writes and frees the memory allocated for the object.
+ * Errors during the write-back are only logged, objects should be synced beforehand to be notified of them.
  *
  * \code
  * \endcode
@@ -1040,6 +1686,15 @@ j_object_unref(JObject* object)
 
 	if (g_atomic_int_dec_and_test(&(object->ref_count)))
 	{
+		// There is no caller to report errors to, objects should be synced before being freed
+		if (!j_object_flush(object, FALSE))
+		{
+			g_warning("Could not write back buffered writes of object %s/%s.", object->namespace, object->name);
+		}
+
+		j_object_cache_free(object->cache);
+
+		g_free(object->key);
 		g_free(object->name);
 		g_free(object->namespace);
 
@@ -1053,27 +1708,49 @@ j_object_unref(JObject* object)
  * \code
  * \endcode
  *
- * \param name         A name.
- * \param distribution A distribution.
- * \param batch        A batch.
- *
- * \return A new object. Should be freed with j_object_unref().
+ * \param object An object.
+ * \param batch  A batch.
  **/
 void
 j_object_create(JObject* object, JBatch* batch)
 {
 	J_TRACE_FUNCTION(NULL);
 
+	j_object_create_with_size(object, 0, batch);
+}
+
+/**
+ * Creates an object and reserves space for its expected size.
+ * The size is only a hint and does not change the object's size.
+ *
+ * \code
+ * \endcode
+ *
+ * \param object An object.
+ * \param size   The expected size, 0 if unknown.
+ * \param batch  A batch.
+ **/
+void
+j_object_create_with_size(JObject* object, guint64 size, JBatch* batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JObjectOperation* iop;
 	JOperation* operation;
 
 	g_return_if_fail(object != NULL);
 
+	iop = g_slice_new(JObjectOperation);
+	iop->create.object = j_object_ref(object);
+	iop->create.size = size;
+
 	operation = j_operation_new();
 	// FIXME key = index + namespace
-	operation->key = object;
-	operation->data = j_object_ref(object);
+	operation->key = object->key;
+	operation->data = iop;
 	operation->exec_func = j_object_create_exec;
 	operation->free_func = j_object_create_free;
+	operation->cache_func = j_operation_cache_noop;
 
 	j_batch_add(batch, operation);
 }
@@ -1097,10 +1774,11 @@ j_object_delete(JObject* object, JBatch* batch)
 	g_return_if_fail(object != NULL);
 
 	operation = j_operation_new();
-	operation->key = object;
+	operation->key = object->key;
 	operation->data = j_object_ref(object);
 	operation->exec_func = j_object_delete_exec;
 	operation->free_func = j_object_delete_free;
+	operation->cache_func = j_operation_cache_noop;
 
 	j_batch_add(batch, operation);
 }
@@ -1149,7 +1827,7 @@ j_object_read(JObject* object, gpointer data, guint64 length, guint64 offset, gu
 		iop->read.bytes_read = bytes_read;
 
 		operation = j_operation_new();
-		operation->key = object;
+		operation->key = object->key;
 		operation->data = iop;
 		operation->exec_func = j_object_read_exec;
 		operation->free_func = j_object_read_free;
@@ -1209,12 +1887,15 @@ j_object_write(JObject* object, gconstpointer data, guint64 length, guint64 offs
 		iop->write.length = chunk_size;
 		iop->write.offset = offset;
 		iop->write.bytes_written = bytes_written;
+		iop->write.cached_bytes_written = 0;
 
 		operation = j_operation_new();
-		operation->key = object;
+		operation->key = object->key;
 		operation->data = iop;
 		operation->exec_func = j_object_write_exec;
 		operation->free_func = j_object_write_free;
+		operation->cache_func = j_object_write_cache;
+		operation->cache_size_func = j_object_write_cache_size;
 
 		j_batch_add(batch, operation);
 
@@ -1251,7 +1932,7 @@ j_object_status(JObject* object, gint64* modification_time, guint64* size, JBatc
 	iop->status.size = size;
 
 	operation = j_operation_new();
-	operation->key = object;
+	operation->key = object->key;
 	operation->data = iop;
 	operation->exec_func = j_object_status_exec;
 	operation->free_func = j_object_status_free;
@@ -1282,7 +1963,7 @@ j_object_sync(JObject* object, JBatch* batch)
 	iop->sync.object = j_object_ref(object);
 
 	operation = j_operation_new();
-	operation->key = object;
+	operation->key = object->key;
 	operation->data = iop;
 	operation->exec_func = j_object_sync_exec;
 	operation->free_func = j_object_sync_free;
@@ -1290,6 +1971,39 @@ j_object_sync(JObject* object, JBatch* batch)
 	j_batch_add(batch, operation);
 }
 
+/**
+ * Truncates or extends an object to the given size.
+ *
+ * \code
+ * \endcode
+ *
+ * \param object An object.
+ * \param size   The new size.
+ * \param batch  A batch.
+ **/
+void
+j_object_truncate(JObject* object, guint64 size, JBatch* batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JObjectOperation* iop;
+	JOperation* operation;
+
+	g_return_if_fail(object != NULL);
+
+	iop = g_slice_new(JObjectOperation);
+	iop->truncate.object = j_object_ref(object);
+	iop->truncate.size = size;
+
+	operation = j_operation_new();
+	operation->key = object->key;
+	operation->data = iop;
+	operation->exec_func = j_object_truncate_exec;
+	operation->free_func = j_object_truncate_free;
+
+	j_batch_add(batch, operation);
+}
+
 /**
  * Returns the object backend.
  *
@@ -0,0 +1,889 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2020 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <bson.h>
+
+#include <julea.h>
+
+#include "server.h"
+
+/*
+ * Cursors stream the results of database queries and key-value iterations in pages instead of sending them using a single reply.
+ * Backends might tie their iterators to the thread that created them, for example, SQL backends use per-thread connections and prepared statements.
+ * Each open cursor is therefore driven by a dedicated cursor thread that does not execute any other operations until the cursor has been closed.
+ * Cursor threads are reused for later cursors, which allows backends to keep their per-thread state.
+ * Database cursors read all results and execute their batch before returning the first page, so backends that serialize batches (such as SQLite in single-thread mode) are not blocked while the cursor is open.
+ * If the maximum number of cursor threads is in use, cursors return all results in the first page instead.
+ */
+
+/*
+ * Cursors that have not been used for this long are closed.
+ */
+#define JD_CURSOR_TIMEOUT (60 * G_USEC_PER_SEC)
+
+/*
+ * The maximum number of cursor threads, that is, of cursors that can be open at the same time.
+ */
+#define JD_CURSOR_MAX_THREADS 64
+
+enum JdCursorRequestType
+{
+	JD_CURSOR_REQUEST_OPEN,
+	JD_CURSOR_REQUEST_FETCH,
+	JD_CURSOR_REQUEST_CLOSE,
+	JD_CURSOR_REQUEST_QUIT
+};
+
+typedef enum JdCursorRequestType JdCursorRequestType;
+
+struct JdCursorRequest
+{
+	JdCursorRequestType type;
+
+	/**
+	 * The type of the cursor, only used when opening a cursor.
+	 **/
+	JBackendType backend;
+
+	/**
+	 * The query, only used when opening a cursor.
+	 * Database cursors use the name and selector, key-value cursors use the prefix.
+	 **/
+	JSemantics* semantics;
+	gchar const* namespace;
+	gchar const* name;
+	bson_t const* selector;
+	gchar const* prefix;
+	gboolean keys_only;
+	guint32 page_size;
+
+	/**
+	 * The cursor's ID, set to 0 once all results have been returned.
+	 **/
+	guint64 id;
+
+	/**
+	 * The next page of results.
+	 **/
+	bson_t* page;
+	GError* error;
+
+	/**
+	 * The next page of key-value entries and their number.
+	 **/
+	GByteArray* entries;
+	guint32 count;
+
+	/**
+	 * Whether the request is freed by the cursor thread instead of being waited for.
+	 **/
+	gboolean detached;
+
+	gboolean done;
+	GMutex mutex[1];
+	GCond cond[1];
+};
+
+typedef struct JdCursorRequest JdCursorRequest;
+
+struct JdCursorThread
+{
+	GThread* thread;
+	GAsyncQueue* requests;
+};
+
+typedef struct JdCursorThread JdCursorThread;
+
+struct JdCursor
+{
+	guint64 id;
+	JBackendType backend;
+	JdCursorThread* thread;
+};
+
+typedef struct JdCursor JdCursor;
+
+static GMutex jd_cursor_mutex[1];
+
+/**
+ * The open cursors, indexed by their IDs.
+ **/
+static GHashTable* jd_cursors = NULL;
+
+/**
+ * All cursor threads and the ones not driving a cursor.
+ **/
+static GPtrArray* jd_cursor_threads = NULL;
+static GQueue* jd_cursor_threads_idle = NULL;
+
+static guint64 jd_cursor_next_id = 1;
+
+static JdCursorRequest*
+jd_cursor_request_new(JdCursorRequestType type, gboolean detached)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JdCursorRequest* request;
+
+	request = g_slice_new0(JdCursorRequest);
+	request->type = type;
+	request->detached = detached;
+	request->done = FALSE;
+	g_mutex_init(request->mutex);
+	g_cond_init(request->cond);
+
+	return request;
+}
+
+static void
+jd_cursor_request_free(JdCursorRequest* request)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_clear_error(&(request->error));
+	g_mutex_clear(request->mutex);
+	g_cond_clear(request->cond);
+
+	g_slice_free(JdCursorRequest, request);
+}
+
+static void
+jd_cursor_request_complete(JdCursorRequest* request)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	if (request->detached)
+	{
+		jd_cursor_request_free(request);
+		return;
+	}
+
+	g_mutex_lock(request->mutex);
+	request->done = TRUE;
+	g_cond_signal(request->cond);
+	g_mutex_unlock(request->mutex);
+}
+
+static void
+jd_cursor_request_wait(JdCursorRequest* request)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_mutex_lock(request->mutex);
+
+	while (!request->done)
+	{
+		g_cond_wait(request->cond, request->mutex);
+	}
+
+	g_mutex_unlock(request->mutex);
+}
+
+/**
+ * Returns the next result of a query.
+ *
+ * \private
+ *
+ * \param iterator An iterator.
+ * \param row      A BSON document to store the result in.
+ * \param error    A GError.
+ *
+ * \return TRUE if there was another result, FALSE otherwise.
+ **/
+static gboolean
+jd_cursor_iterate(gpointer iterator, bson_t* row, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	GError* iterate_error = NULL;
+
+	bson_reinit(row);
+
+	if (j_backend_db_iterate(jd_db_backend, iterator, row, &iterate_error))
+	{
+		return TRUE;
+	}
+
+	if (iterate_error != NULL && iterate_error->code == J_BACKEND_DB_ERROR_ITERATOR_NO_MORE_ELEMENTS)
+	{
+		g_error_free(iterate_error);
+	}
+	else
+	{
+		g_propagate_error(error, iterate_error);
+	}
+
+	return FALSE;
+}
+
+/**
+ * Removes a cursor so that it can no longer be fetched from.
+ *
+ * \private
+ *
+ * \param id The cursor's ID.
+ **/
+static void
+jd_cursor_remove(guint64 id)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_mutex_lock(jd_cursor_mutex);
+	g_hash_table_remove(jd_cursors, &id);
+	g_mutex_unlock(jd_cursor_mutex);
+}
+
+/**
+ * Waits for the next request of a cursor.
+ * Requests closing the cursor are completed, as are cursors that have timed out.
+ *
+ * \private
+ *
+ * \param thread The cursor thread.
+ * \param id     The cursor's ID.
+ * \param quit   Set to TRUE if the cursor thread should quit.
+ *
+ * \return The next fetch request or NULL if the cursor has been closed.
+ **/
+static JdCursorRequest*
+jd_cursor_wait(JdCursorThread* thread, guint64 id, gboolean* quit)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JdCursorRequest* request;
+
+	while (TRUE)
+	{
+		request = g_async_queue_timeout_pop(thread->requests, JD_CURSOR_TIMEOUT);
+
+		if (request != NULL)
+		{
+			break;
+		}
+
+		g_mutex_lock(jd_cursor_mutex);
+
+		// Requests are only queued while holding the mutex
+		if (g_async_queue_length(thread->requests) == 0)
+		{
+			g_hash_table_remove(jd_cursors, &id);
+			g_mutex_unlock(jd_cursor_mutex);
+
+			g_debug("Closing cursor %" G_GUINT64_FORMAT " after timeout.", id);
+
+			return NULL;
+		}
+
+		g_mutex_unlock(jd_cursor_mutex);
+	}
+
+	if (request->type == JD_CURSOR_REQUEST_FETCH)
+	{
+		return request;
+	}
+
+	jd_cursor_remove(id);
+
+	*quit = (request->type == JD_CURSOR_REQUEST_QUIT);
+	jd_cursor_request_complete(request);
+
+	return NULL;
+}
+
+/**
+ * Drives a database cursor from opening until closing it.
+ * All results are read before executing the batch, the pages are then returned from memory.
+ *
+ * \private
+ *
+ * \param thread  The cursor thread, might be NULL if all results fit into the first page.
+ * \param request The request opening the cursor.
+ *
+ * \return FALSE if the cursor thread should quit, TRUE otherwise.
+ **/
+static gboolean
+jd_cursor_run_db(JdCursorThread* thread, JdCursorRequest* request)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(GPtrArray) rows = NULL;
+	gpointer batch = NULL;
+	gpointer iterator = NULL;
+	gboolean quit = FALSE;
+	guint64 id;
+	guint32 page_size;
+	guint position = 0;
+
+	rows = g_ptr_array_new_with_free_func((GDestroyNotify)bson_destroy);
+
+	id = request->id;
+	page_size = MAX(request->page_size, 1);
+
+	if (j_backend_db_batch_start(jd_db_backend, request->namespace, request->semantics, &batch, &(request->error)))
+	{
+		if (j_backend_db_query(jd_db_backend, batch, request->name, request->selector, &iterator, &(request->error)))
+		{
+			bson_t* row;
+
+			row = bson_new();
+
+			// Backends only release their iterators once all results have been returned
+			while (jd_cursor_iterate(iterator, row, &(request->error)))
+			{
+				g_ptr_array_add(rows, row);
+				row = bson_new();
+			}
+
+			bson_destroy(row);
+		}
+
+		// Do not block other database operations while the cursor is open
+		j_backend_db_batch_execute(jd_db_backend, batch, (request->error == NULL) ? &(request->error) : NULL);
+	}
+
+	while (request != NULL)
+	{
+		char key_buf[16];
+		char const* key;
+		guint32 count = 0;
+
+		bson_init(request->page);
+
+		while (position < rows->len && count < page_size)
+		{
+			bson_uint32_to_string(count, &key, key_buf, sizeof(key_buf));
+			bson_append_document(request->page, key, -1, g_ptr_array_index(rows, position));
+			count++;
+			position++;
+		}
+
+		if (position == rows->len)
+		{
+			jd_cursor_remove(id);
+
+			request->id = 0;
+			jd_cursor_request_complete(request);
+
+			break;
+		}
+
+		request->id = id;
+		jd_cursor_request_complete(request);
+
+		request = jd_cursor_wait(thread, id, &quit);
+	}
+
+	return !quit;
+}
+
+/**
+ * Drives a key-value cursor from opening until closing it.
+ * Each entry consists of the value's length and the value (unless only keys are requested) followed by the key.
+ *
+ * \private
+ *
+ * \param thread  The cursor thread, might be NULL if all entries fit into the first page.
+ * \param request The request opening the cursor.
+ *
+ * \return FALSE if the cursor thread should quit, TRUE otherwise.
+ **/
+static gboolean
+jd_cursor_run_kv(JdCursorThread* thread, JdCursorRequest* request)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autofree gchar* namespace = NULL;
+	g_autofree gchar* prefix = NULL;
+	gpointer iterator = NULL;
+	gchar const* key = NULL;
+	gconstpointer value = NULL;
+	guint32 len = 0;
+	gboolean has_entry = FALSE;
+	gboolean keys_only;
+	gboolean quit = FALSE;
+	guint64 id;
+	guint32 page_size;
+
+	// The backend might keep references to the namespace and prefix until the cursor is closed
+	namespace = g_strdup(request->namespace);
+	prefix = g_strdup(request->prefix);
+
+	id = request->id;
+	page_size = MAX(request->page_size, 1);
+	keys_only = request->keys_only;
+
+	if (prefix == NULL)
+	{
+		has_entry = j_backend_kv_get_all(jd_kv_backend, namespace, &iterator);
+	}
+	else
+	{
+		has_entry = j_backend_kv_get_by_prefix(jd_kv_backend, namespace, prefix, &iterator);
+	}
+
+	if (has_entry)
+	{
+		has_entry = j_backend_kv_iterate(jd_kv_backend, iterator, &key, &value, &len);
+	}
+
+	while (request != NULL)
+	{
+		request->count = 0;
+
+		// The current entry stays valid until the iterator is advanced
+		while (has_entry && request->count < page_size)
+		{
+			if (!keys_only)
+			{
+				guint32 len_le;
+
+				len_le = GUINT32_TO_LE(len);
+				g_byte_array_append(request->entries, (guint8 const*)&len_le, sizeof(len_le));
+				g_byte_array_append(request->entries, value, len);
+			}
+
+			g_byte_array_append(request->entries, (guint8 const*)key, strlen(key) + 1);
+			request->count++;
+
+			has_entry = j_backend_kv_iterate(jd_kv_backend, iterator, &key, &value, &len);
+		}
+
+		if (!has_entry)
+		{
+			jd_cursor_remove(id);
+
+			request->id = 0;
+			jd_cursor_request_complete(request);
+
+			break;
+		}
+
+		request->id = id;
+		jd_cursor_request_complete(request);
+
+		request = jd_cursor_wait(thread, id, &quit);
+	}
+
+	// Backends only release their iterators once all entries have been returned
+	while (has_entry)
+	{
+		has_entry = j_backend_kv_iterate(jd_kv_backend, iterator, &key, &value, &len);
+	}
+
+	return !quit;
+}
+
+static gpointer
+jd_cursor_thread(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JdCursorThread* thread = data;
+
+	while (TRUE)
+	{
+		JdCursorRequest* request;
+		gboolean ret;
+
+		request = g_async_queue_pop(thread->requests);
+
+		if (request->type == JD_CURSOR_REQUEST_QUIT)
+		{
+			jd_cursor_request_complete(request);
+			break;
+		}
+
+		if (request->type != JD_CURSOR_REQUEST_OPEN)
+		{
+			// The cursor has already been closed
+			if (request->page != NULL)
+			{
+				bson_init(request->page);
+			}
+
+			request->id = 0;
+			g_set_error_literal(&(request->error), J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_ITERATOR_INVALID, "cursor invalid");
+			jd_cursor_request_complete(request);
+
+			continue;
+		}
+
+		if (request->backend == J_BACKEND_TYPE_DB)
+		{
+			ret = jd_cursor_run_db(thread, request);
+		}
+		else
+		{
+			ret = jd_cursor_run_kv(thread, request);
+		}
+
+		if (!ret)
+		{
+			break;
+		}
+
+		g_mutex_lock(jd_cursor_mutex);
+		g_queue_push_tail(jd_cursor_threads_idle, thread);
+		g_mutex_unlock(jd_cursor_mutex);
+	}
+
+	return NULL;
+}
+
+/**
+ * Initializes the cursors.
+ **/
+void
+jd_cursor_init(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(jd_cursors == NULL);
+
+	jd_cursors = g_hash_table_new_full(g_int64_hash, g_int64_equal, NULL, g_free);
+	jd_cursor_threads = g_ptr_array_new();
+	jd_cursor_threads_idle = g_queue_new();
+}
+
+/**
+ * Closes all cursors and stops the cursor threads.
+ **/
+void
+jd_cursor_fini(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(jd_cursors != NULL);
+
+	for (guint i = 0; i < jd_cursor_threads->len; i++)
+	{
+		JdCursorThread* thread = g_ptr_array_index(jd_cursor_threads, i);
+
+		g_async_queue_push(thread->requests, jd_cursor_request_new(JD_CURSOR_REQUEST_QUIT, TRUE));
+	}
+
+	for (guint i = 0; i < jd_cursor_threads->len; i++)
+	{
+		JdCursorThread* thread = g_ptr_array_index(jd_cursor_threads, i);
+
+		g_thread_join(thread->thread);
+		g_async_queue_unref(thread->requests);
+
+		g_slice_free(JdCursorThread, thread);
+	}
+
+	g_ptr_array_unref(jd_cursor_threads);
+	g_queue_free(jd_cursor_threads_idle);
+	g_hash_table_unref(jd_cursors);
+
+	jd_cursor_threads = NULL;
+	jd_cursor_threads_idle = NULL;
+	jd_cursors = NULL;
+}
+
+/**
+ * Opens a cursor on an idle or new cursor thread and waits for the first page.
+ * If the maximum number of cursor threads is in use, all results are returned in the first page.
+ *
+ * \private
+ *
+ * \param request The request opening the cursor.
+ **/
+static void
+jd_cursor_start(JdCursorRequest* request)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JdCursorThread* thread;
+	JdCursor* cursor;
+
+	g_mutex_lock(jd_cursor_mutex);
+
+	thread = g_queue_pop_head(jd_cursor_threads_idle);
+
+	if (thread == NULL && jd_cursor_threads->len >= JD_CURSOR_MAX_THREADS)
+	{
+		g_mutex_unlock(jd_cursor_mutex);
+
+		// Without a cursor, the results have to be returned at once
+		request->id = 0;
+		request->page_size = G_MAXUINT32;
+
+		if (request->backend == J_BACKEND_TYPE_DB)
+		{
+			jd_cursor_run_db(NULL, request);
+		}
+		else
+		{
+			jd_cursor_run_kv(NULL, request);
+		}
+
+		return;
+	}
+
+	if (thread == NULL)
+	{
+		thread = g_slice_new(JdCursorThread);
+		thread->requests = g_async_queue_new();
+		thread->thread = g_thread_new("julea-cursor", jd_cursor_thread, thread);
+
+		g_ptr_array_add(jd_cursor_threads, thread);
+	}
+
+	cursor = g_new(JdCursor, 1);
+	cursor->id = jd_cursor_next_id++;
+	cursor->backend = request->backend;
+	cursor->thread = thread;
+	g_hash_table_insert(jd_cursors, &(cursor->id), cursor);
+
+	request->id = cursor->id;
+	g_async_queue_push(thread->requests, request);
+
+	g_mutex_unlock(jd_cursor_mutex);
+
+	jd_cursor_request_wait(request);
+}
+
+/**
+ * Hands a fetch request to the thread driving a cursor and waits for the next page.
+ *
+ * \private
+ *
+ * \param id      The cursor's ID.
+ * \param backend The cursor's type.
+ * \param request The fetch request.
+ *
+ * \return TRUE if the cursor exists, FALSE otherwise.
+ **/
+static gboolean
+jd_cursor_continue(guint64 id, JBackendType backend, JdCursorRequest* request)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JdCursor* cursor;
+
+	g_mutex_lock(jd_cursor_mutex);
+
+	cursor = g_hash_table_lookup(jd_cursors, &id);
+
+	if (cursor == NULL || cursor->backend != backend)
+	{
+		g_mutex_unlock(jd_cursor_mutex);
+
+		return FALSE;
+	}
+
+	g_async_queue_push(cursor->thread->requests, request);
+
+	g_mutex_unlock(jd_cursor_mutex);
+
+	jd_cursor_request_wait(request);
+
+	return TRUE;
+}
+
+/**
+ * Opens a cursor for a query and returns the first page of results.
+ *
+ * \param semantics A semantics object.
+ * \param namespace The namespace.
+ * \param name      The schema's name.
+ * \param selector  The selector, might be NULL.
+ * \param page_size The maximum number of results per page.
+ * \param page      A BSON document to store the first page in, has to be destroyed by the caller.
+ * \param error     A GError.
+ *
+ * \return The cursor's ID or 0 if all results have been returned.
+ **/
+guint64
+jd_cursor_open(JSemantics* semantics, gchar const* namespace, gchar const* name, bson_t const* selector, guint32 page_size, bson_t* page, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JdCursorRequest* request;
+	guint64 id;
+
+	g_return_val_if_fail(semantics != NULL, 0);
+	g_return_val_if_fail(namespace != NULL, 0);
+	g_return_val_if_fail(name != NULL, 0);
+	g_return_val_if_fail(page != NULL, 0);
+
+	request = jd_cursor_request_new(JD_CURSOR_REQUEST_OPEN, FALSE);
+	request->backend = J_BACKEND_TYPE_DB;
+	request->semantics = semantics;
+	request->namespace = namespace;
+	request->name = name;
+	request->selector = selector;
+	request->page_size = page_size;
+	request->page = page;
+
+	jd_cursor_start(request);
+
+	id = request->id;
+	g_propagate_error(error, g_steal_pointer(&(request->error)));
+	jd_cursor_request_free(request);
+
+	return id;
+}
+
+/**
+ * Returns the next page of results of a cursor.
+ *
+ * \param id    The cursor's ID.
+ * \param page  A BSON document to store the page in, has to be destroyed by the caller.
+ * \param error A GError.
+ *
+ * \return The cursor's ID or 0 if all results have been returned.
+ **/
+guint64
+jd_cursor_fetch(guint64 id, bson_t* page, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JdCursorRequest* request;
+
+	g_return_val_if_fail(page != NULL, 0);
+
+	request = jd_cursor_request_new(JD_CURSOR_REQUEST_FETCH, FALSE);
+	request->page = page;
+
+	if (!jd_cursor_continue(id, J_BACKEND_TYPE_DB, request))
+	{
+		jd_cursor_request_free(request);
+
+		bson_init(page);
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_ITERATOR_INVALID, "cursor invalid");
+
+		return 0;
+	}
+
+	id = request->id;
+	g_propagate_error(error, g_steal_pointer(&(request->error)));
+	jd_cursor_request_free(request);
+
+	return id;
+}
+
+/**
+ * Opens a cursor for iterating over key-value pairs and returns the first page of entries.
+ *
+ * \param namespace The namespace.
+ * \param prefix    The prefix, might be NULL.
+ * \param page_size The maximum number of entries per page.
+ * \param keys_only Whether only the keys should be returned.
+ * \param entries   A byte array to append the first page of entries to.
+ * \param count     Returns the number of entries.
+ *
+ * \return The cursor's ID or 0 if all entries have been returned.
+ **/
+guint64
+jd_cursor_open_kv(gchar const* namespace, gchar const* prefix, guint32 page_size, gboolean keys_only, GByteArray* entries, guint32* count)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JdCursorRequest* request;
+	guint64 id;
+
+	g_return_val_if_fail(namespace != NULL, 0);
+	g_return_val_if_fail(entries != NULL, 0);
+	g_return_val_if_fail(count != NULL, 0);
+
+	request = jd_cursor_request_new(JD_CURSOR_REQUEST_OPEN, FALSE);
+	request->backend = J_BACKEND_TYPE_KV;
+	request->namespace = namespace;
+	request->prefix = prefix;
+	request->keys_only = keys_only;
+	request->page_size = page_size;
+	request->entries = entries;
+
+	jd_cursor_start(request);
+
+	id = request->id;
+	*count = request->count;
+	jd_cursor_request_free(request);
+
+	return id;
+}
+
+/**
+ * Returns the next page of entries of a key-value cursor.
+ *
+ * \param id      The cursor's ID.
+ * \param entries A byte array to append the page of entries to.
+ * \param count   Returns the number of entries.
+ *
+ * \return The cursor's ID or 0 if all entries have been returned.
+ **/
+guint64
+jd_cursor_fetch_kv(guint64 id, GByteArray* entries, guint32* count)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JdCursorRequest* request;
+
+	g_return_val_if_fail(entries != NULL, 0);
+	g_return_val_if_fail(count != NULL, 0);
+
+	*count = 0;
+
+	request = jd_cursor_request_new(JD_CURSOR_REQUEST_FETCH, FALSE);
+	request->entries = entries;
+
+	if (jd_cursor_continue(id, J_BACKEND_TYPE_KV, request))
+	{
+		id = request->id;
+		*count = request->count;
+	}
+	else
+	{
+		id = 0;
+	}
+
+	jd_cursor_request_free(request);
+
+	return id;
+}
+
+/**
+ * Closes a cursor before all results have been returned.
+ * The cursor is closed in the background.
+ *
+ * \param id The cursor's ID.
+ **/
+void
+jd_cursor_close(guint64 id)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JdCursor* cursor;
+
+	g_mutex_lock(jd_cursor_mutex);
+
+	cursor = g_hash_table_lookup(jd_cursors, &id);
+
+	if (cursor != NULL)
+	{
+		g_async_queue_push(cursor->thread->requests, jd_cursor_request_new(JD_CURSOR_REQUEST_CLOSE, TRUE));
+	}
+
+	g_mutex_unlock(jd_cursor_mutex);
+}
@@ -0,0 +1,454 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2020 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <julea-config.h>
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#ifdef HAVE_EPOLL
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#endif
+
+#include <errno.h>
+#include <unistd.h>
+
+#include <julea.h>
+
+#include "server.h"
+
+/*
+ * The event-driven server core uses a fixed number of event loops that multiplex many connections.
+ * Each connection is registered with EPOLLONESHOT, that is, it is disarmed as soon as data arrives.
+ * The connection is then handed to a worker that reads the available data without blocking.
+ * Partially received messages are kept with the connection and the connection is rearmed to wait for the rest.
+ * Once a message has been received completely, the worker handles it and rearms the connection afterwards.
+ * Additional data announced by a message, such as the payload of object writes, is still read by the handler.
+ * This guarantees that only one worker at a time handles a given connection while idle connections do not occupy any threads.
+ *
+ * Multiplexed messages are an exception: The connection is rearmed as soon as such a message has been received.
+ * This allows multiple workers to handle messages of the same connection concurrently and to reply in completion order.
+ */
+
+#ifdef HAVE_EPOLL
+
+struct JdEventLoop
+{
+	GThread* thread;
+
+	gint epoll_fd;
+
+	/**
+	 * Used to wake up the event loop on shutdown.
+	 **/
+	gint event_fd;
+
+	/**
+	 * All connections handled by this event loop.
+	 **/
+	GHashTable* connections;
+	GMutex mutex[1];
+};
+
+typedef struct JdEventLoop JdEventLoop;
+
+struct JdEventConnection
+{
+	GSocketConnection* connection;
+	gint fd;
+
+	JdEventLoop* loop;
+
+	/**
+	 * The message is reused for all messages received via this connection.
+	 **/
+	JMessage* message;
+	JStatistics* statistics;
+
+	gint ref_count;
+};
+
+typedef struct JdEventConnection JdEventConnection;
+
+static JdEventLoop* jd_event_loops = NULL;
+static guint jd_event_loops_n = 0;
+static guint jd_event_loops_next = 0;
+
+static GThreadPool* jd_event_workers = NULL;
+
+static guint64 jd_event_memory_chunk_size = 0;
+
+/*
+ * Memory chunks are allocated per worker instead of per connection to bound memory usage.
+ */
+static GPrivate jd_event_memory_chunk = G_PRIVATE_INIT((GDestroyNotify)jd_memory_chunk_free);
+
+static JdEventConnection*
+jd_event_connection_ref(JdEventConnection* connection)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_atomic_int_inc(&(connection->ref_count));
+
+	return connection;
+}
+
+static void
+jd_event_connection_unref(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JdEventConnection* connection = data;
+
+	if (!g_atomic_int_dec_and_test(&(connection->ref_count)))
+	{
+		return;
+	}
+
+	jd_statistics_merge(connection->statistics);
+
+	j_statistics_free(connection->statistics);
+	j_message_unref(connection->message);
+
+	g_io_stream_close(G_IO_STREAM(connection->connection), NULL, NULL);
+	g_object_unref(connection->connection);
+
+	g_slice_free(JdEventConnection, connection);
+}
+
+static void
+jd_event_connection_close(JdEventConnection* connection)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JdEventLoop* loop = connection->loop;
+
+	epoll_ctl(loop->epoll_fd, EPOLL_CTL_DEL, connection->fd, NULL);
+
+	g_mutex_lock(loop->mutex);
+	// The hash table's destroy function releases the connection.
+	g_hash_table_remove(loop->connections, connection);
+	g_mutex_unlock(loop->mutex);
+}
+
+static gboolean
+jd_event_connection_arm(JdEventConnection* connection, gint op)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	struct epoll_event event;
+
+	event.events = EPOLLIN | EPOLLONESHOT;
+	event.data.ptr = connection;
+
+	return (epoll_ctl(connection->loop->epoll_fd, op, connection->fd, &event) == 0);
+}
+
+static void
+jd_event_worker(gpointer data, gpointer user_data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JdEventConnection* connection = data;
+	JMemoryChunk* memory_chunk;
+	gboolean complete;
+
+	(void)user_data;
+
+	memory_chunk = g_private_get(&jd_event_memory_chunk);
+
+	if (memory_chunk == NULL)
+	{
+		memory_chunk = jd_memory_chunk_new(jd_event_memory_chunk_size);
+		g_private_set(&jd_event_memory_chunk, memory_chunk);
+	}
+
+	// Only read what is available to avoid blocking the worker on slow senders
+	if (!j_message_receive_nonblocking(connection->message, connection->connection, &complete))
+	{
+		jd_event_connection_close(connection);
+		return;
+	}
+
+	// Wait for the rest of the message without occupying the worker
+	if (!complete)
+	{
+		if (!jd_event_connection_arm(connection, EPOLL_CTL_MOD))
+		{
+			jd_event_connection_close(connection);
+		}
+
+		return;
+	}
+
+	// Object writes read additional data from the connection and must not be handled concurrently.
+	if (j_message_get_multiplexed(connection->message) && j_message_get_type(connection->message) != J_MESSAGE_OBJECT_WRITE)
+	{
+		g_autoptr(JMessage) message = NULL;
+		JStatistics* statistics;
+
+		message = connection->message;
+		connection->message = j_message_new(J_MESSAGE_NONE, 0);
+
+		jd_event_connection_ref(connection);
+
+		if (!jd_event_connection_arm(connection, EPOLL_CTL_MOD))
+		{
+			jd_event_connection_close(connection);
+		}
+
+		// The connection's statistics might be in use by other workers.
+		statistics = j_statistics_new(TRUE);
+		jd_handle_message(message, connection->connection, memory_chunk, jd_event_memory_chunk_size, statistics);
+		jd_statistics_merge(statistics);
+		j_statistics_free(statistics);
+
+		jd_event_connection_unref(connection);
+
+		return;
+	}
+
+	jd_handle_message(connection->message, connection->connection, memory_chunk, jd_event_memory_chunk_size, connection->statistics);
+
+	if (!jd_event_connection_arm(connection, EPOLL_CTL_MOD))
+	{
+		jd_event_connection_close(connection);
+	}
+}
+
+static gpointer
+jd_event_loop_thread(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JdEventLoop* loop = data;
+	struct epoll_event events[64];
+	gboolean running = TRUE;
+
+	while (running)
+	{
+		gint events_n;
+
+		events_n = epoll_wait(loop->epoll_fd, events, G_N_ELEMENTS(events), -1);
+
+		if (events_n == -1)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+
+			g_critical("Event loop failed: %s", g_strerror(errno));
+			break;
+		}
+
+		for (gint i = 0; i < events_n; i++)
+		{
+			// The event file descriptor is registered without a connection.
+			if (events[i].data.ptr == NULL)
+			{
+				running = FALSE;
+				continue;
+			}
+
+			g_thread_pool_push(jd_event_workers, events[i].data.ptr, NULL);
+		}
+	}
+
+	return NULL;
+}
+
+#endif
+
+/**
+ * Starts the event-driven server core.
+ *
+ * \param loops             The number of event loops.
+ * \param workers           The number of workers handling messages.
+ * \param memory_chunk_size The size of each worker's memory chunk.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+gboolean
+jd_event_init(guint loops, guint workers, guint64 memory_chunk_size)
+{
+	J_TRACE_FUNCTION(NULL);
+
+#ifdef HAVE_EPOLL
+	g_return_val_if_fail(loops > 0, FALSE);
+	g_return_val_if_fail(workers > 0, FALSE);
+	g_return_val_if_fail(jd_event_loops == NULL, FALSE);
+
+	jd_event_memory_chunk_size = memory_chunk_size;
+	jd_event_workers = g_thread_pool_new(jd_event_worker, NULL, workers, FALSE, NULL);
+
+	jd_event_loops = g_new0(JdEventLoop, loops);
+	jd_event_loops_n = loops;
+
+	for (guint i = 0; i < loops; i++)
+	{
+		JdEventLoop* loop = &(jd_event_loops[i]);
+		struct epoll_event event;
+
+		loop->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+		loop->event_fd = eventfd(0, EFD_CLOEXEC);
+		loop->connections = g_hash_table_new_full(NULL, NULL, jd_event_connection_unref, NULL);
+		g_mutex_init(loop->mutex);
+
+		if (loop->epoll_fd == -1 || loop->event_fd == -1)
+		{
+			g_critical("Could not create event loop: %s", g_strerror(errno));
+			return FALSE;
+		}
+
+		event.events = EPOLLIN;
+		event.data.ptr = NULL;
+
+		if (epoll_ctl(loop->epoll_fd, EPOLL_CTL_ADD, loop->event_fd, &event) == -1)
+		{
+			g_critical("Could not create event loop: %s", g_strerror(errno));
+			return FALSE;
+		}
+
+		loop->thread = g_thread_new("julea-event-loop", jd_event_loop_thread, loop);
+	}
+
+	return TRUE;
+#else
+	(void)loops;
+	(void)workers;
+	(void)memory_chunk_size;
+
+	return FALSE;
+#endif
+}
+
+/**
+ * Stops the event-driven server core and closes all remaining connections.
+ **/
+void
+jd_event_fini(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+#ifdef HAVE_EPOLL
+	if (jd_event_loops == NULL)
+	{
+		return;
+	}
+
+	for (guint i = 0; i < jd_event_loops_n; i++)
+	{
+		JdEventLoop* loop = &(jd_event_loops[i]);
+		guint64 value = 1;
+
+		if (loop->thread != NULL)
+		{
+			if (write(loop->event_fd, &value, sizeof(value)) != sizeof(value))
+			{
+				g_warning("Could not stop event loop: %s", g_strerror(errno));
+			}
+
+			g_thread_join(loop->thread);
+		}
+	}
+
+	// Wait for all workers to finish handling their current messages.
+	g_thread_pool_free(jd_event_workers, FALSE, TRUE);
+	jd_event_workers = NULL;
+
+	for (guint i = 0; i < jd_event_loops_n; i++)
+	{
+		JdEventLoop* loop = &(jd_event_loops[i]);
+
+		g_hash_table_unref(loop->connections);
+		g_mutex_clear(loop->mutex);
+
+		if (loop->event_fd != -1)
+		{
+			close(loop->event_fd);
+		}
+
+		if (loop->epoll_fd != -1)
+		{
+			close(loop->epoll_fd);
+		}
+	}
+
+	g_free(jd_event_loops);
+	jd_event_loops = NULL;
+	jd_event_loops_n = 0;
+#endif
+}
+
+/**
+ * Hands a new connection to one of the event loops.
+ * The event loops are used in a round-robin fashion.
+ *
+ * \param connection A connection.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+gboolean
+jd_event_add_connection(GSocketConnection* connection)
+{
+	J_TRACE_FUNCTION(NULL);
+
+#ifdef HAVE_EPOLL
+	JdEventConnection* event_connection;
+	JdEventLoop* loop;
+	guint index;
+
+	g_return_val_if_fail(connection != NULL, FALSE);
+	g_return_val_if_fail(jd_event_loops != NULL, FALSE);
+
+	index = (guint)g_atomic_int_add(&jd_event_loops_next, 1) % jd_event_loops_n;
+	loop = &(jd_event_loops[index]);
+
+	j_helper_set_nodelay(connection, TRUE);
+	// Replies to multiplexed messages might be sent concurrently.
+	j_message_share_connection(connection);
+
+	event_connection = g_slice_new(JdEventConnection);
+	event_connection->connection = g_object_ref(connection);
+	event_connection->fd = g_socket_get_fd(g_socket_connection_get_socket(connection));
+	event_connection->loop = loop;
+	event_connection->message = j_message_new(J_MESSAGE_NONE, 0);
+	event_connection->statistics = j_statistics_new(TRUE);
+	event_connection->ref_count = 1;
+
+	g_mutex_lock(loop->mutex);
+	g_hash_table_add(loop->connections, event_connection);
+	g_mutex_unlock(loop->mutex);
+
+	if (!jd_event_connection_arm(event_connection, EPOLL_CTL_ADD))
+	{
+		g_warning("Could not add connection to event loop: %s", g_strerror(errno));
+		jd_event_connection_close(event_connection);
+
+		return FALSE;
+	}
+
+	return TRUE;
+#else
+	(void)connection;
+
+	return FALSE;
+#endif
+}
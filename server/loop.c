@@ -22,12 +22,364 @@
 #include <glib.h>
 #include <gio/gio.h>
 
+#include <sys/socket.h>
+
 #include <julea.h>
 
 #include "server.h"
 
 static guint jd_thread_num = 0;
 
+/*
+ * The number of vectors passed to a single recvmsg() call, IOV_MAX is 1024 on Linux.
+ */
+#define JD_VECTORS_MAX 1024
+
+/**
+ * Receives data into multiple buffers.
+ * As many buffers as possible are filled using a single system call.
+ *
+ * \param gsocket A socket.
+ * \param buffers The buffers.
+ * \param lengths The buffers' lengths.
+ * \param count   The number of buffers.
+ *
+ * \return The number of bytes received.
+ **/
+static guint64
+jd_receive_vectors(GSocket* gsocket, gpointer const* buffers, guint64 const* lengths, guint count)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autofree GInputVector* vectors = NULL;
+	guint vectors_first = 0;
+	guint64 bytes_received = 0;
+
+	vectors = g_new(GInputVector, count);
+
+	for (guint i = 0; i < count; i++)
+	{
+		vectors[i].buffer = buffers[i];
+		vectors[i].size = lengths[i];
+	}
+
+	while (vectors_first < count)
+	{
+		gssize nbytes;
+		gint flags = MSG_WAITALL;
+
+		// Skip empty vectors, they would make it impossible to detect a closed connection
+		if (vectors[vectors_first].size == 0)
+		{
+			vectors_first++;
+			continue;
+		}
+
+		nbytes = g_socket_receive_message(gsocket, NULL, vectors + vectors_first, MIN(count - vectors_first, JD_VECTORS_MAX), NULL, NULL, &flags, NULL, NULL);
+
+		if (nbytes <= 0)
+		{
+			break;
+		}
+
+		bytes_received += nbytes;
+
+		// Skip all completely filled vectors and adjust the partially filled one
+		while (vectors_first < count && (gsize)nbytes >= vectors[vectors_first].size)
+		{
+			nbytes -= vectors[vectors_first].size;
+			vectors_first++;
+		}
+
+		if (nbytes > 0)
+		{
+			vectors[vectors_first].buffer = (gchar*)vectors[vectors_first].buffer + nbytes;
+			vectors[vectors_first].size -= nbytes;
+		}
+	}
+
+	return bytes_received;
+}
+
+/**
+ * Handles pending object read operations.
+ * All operations are passed to the backend at once and their data is added to the reply.
+ *
+ * \param object     An object.
+ * \param buffers    The buffers to read the data into.
+ * \param lengths    The operations' lengths.
+ * \param offsets    The operations' offsets.
+ * \param count      The number of operations.
+ * \param reply      A reply.
+ * \param statistics Statistics.
+ **/
+static void
+jd_object_read(gpointer object, gpointer const* buffers, guint64 const* lengths, guint64 const* offsets, guint count, JMessage* reply, JStatistics* statistics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autofree guint64* bytes_read = NULL;
+
+	if (count == 0)
+	{
+		return;
+	}
+
+	bytes_read = g_new(guint64, count);
+
+	j_backend_object_read_batch(jd_object_backend, object, buffers, lengths, offsets, count, bytes_read);
+
+	for (guint i = 0; i < count; i++)
+	{
+		j_statistics_add(statistics, J_STATISTICS_BYTES_READ, bytes_read[i]);
+
+		j_message_add_operation(reply, sizeof(guint64));
+		j_message_append_8(reply, &(bytes_read[i]));
+
+		if (bytes_read[i] > 0)
+		{
+			j_message_add_send(reply, buffers[i], bytes_read[i]);
+		}
+
+		j_statistics_add(statistics, J_STATISTICS_BYTES_SENT, bytes_read[i]);
+	}
+}
+
+/**
+ * Handles pending object write operations.
+ * The operations' data is received using as few system calls as possible and all operations are passed to the backend at once.
+ *
+ * \param object     An object.
+ * \param connection A connection.
+ * \param buffers    The buffers to receive the data into.
+ * \param lengths    The operations' lengths.
+ * \param offsets    The operations' offsets.
+ * \param count      The number of operations.
+ * \param sync       Whether to sync the object afterwards.
+ * \param reply      A reply, can be NULL.
+ * \param statistics Statistics.
+ *
+ * \return TRUE if all data has been received, FALSE otherwise.
+ **/
+static gboolean
+jd_object_write(gpointer object, GSocketConnection* connection, gpointer const* buffers, guint64 const* lengths, guint64 const* offsets, guint count, gboolean sync, JMessage* reply, JStatistics* statistics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autofree guint64* bytes_written = NULL;
+	guint64 bytes_expected = 0;
+	guint64 bytes_received;
+	gboolean ret;
+
+	if (count == 0 && !sync)
+	{
+		return TRUE;
+	}
+
+	bytes_written = g_new0(guint64, count);
+
+	for (guint i = 0; i < count; i++)
+	{
+		bytes_expected += lengths[i];
+	}
+
+	bytes_received = jd_receive_vectors(g_socket_connection_get_socket(connection), buffers, lengths, count);
+	j_statistics_add(statistics, J_STATISTICS_BYTES_RECEIVED, bytes_received);
+
+	ret = (bytes_received == bytes_expected);
+
+	// Partially received buffers must not be passed to the backend, all operations are reported as failed
+	if (ret)
+	{
+		j_backend_object_write_batch(jd_object_backend, object, (gconstpointer const*)buffers, lengths, offsets, count, sync, bytes_written);
+	}
+
+	if (ret && sync)
+	{
+		j_statistics_add(statistics, J_STATISTICS_SYNC, 1);
+	}
+
+	for (guint i = 0; i < count; i++)
+	{
+		j_statistics_add(statistics, J_STATISTICS_BYTES_WRITTEN, bytes_written[i]);
+
+		if (reply != NULL)
+		{
+			j_message_add_operation(reply, sizeof(guint64));
+			j_message_append_8(reply, &(bytes_written[i]));
+		}
+	}
+
+	return ret;
+}
+
+/**
+ * Receives and drops an operation's data.
+ * This is necessary if the data cannot be written but the client has already sent it.
+ *
+ * \param connection  A connection.
+ * \param buffer      A buffer to receive the data into.
+ * \param buffer_size The buffer's size.
+ * \param length      The number of bytes to receive.
+ * \param statistics  Statistics.
+ *
+ * \return TRUE if all data has been received, FALSE otherwise.
+ **/
+static gboolean
+jd_discard(GSocketConnection* connection, gpointer buffer, guint64 buffer_size, guint64 length, JStatistics* statistics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	guint64 bytes_done = 0;
+
+	while (bytes_done < length)
+	{
+		guint64 chunk_length;
+		guint64 bytes_received;
+
+		chunk_length = MIN(length - bytes_done, buffer_size);
+		bytes_received = jd_receive_vectors(g_socket_connection_get_socket(connection), &buffer, &chunk_length, 1);
+		j_statistics_add(statistics, J_STATISTICS_BYTES_RECEIVED, bytes_received);
+
+		if (bytes_received < chunk_length)
+		{
+			return FALSE;
+		}
+
+		bytes_done += chunk_length;
+	}
+
+	return TRUE;
+}
+
+/**
+ * Receives and writes an operation's data in pieces.
+ * This is necessary for operations that do not fit into a buffer.
+ *
+ * \param object        An object.
+ * \param connection    A connection.
+ * \param buffer        A buffer to receive the data into.
+ * \param buffer_size   The buffer's size.
+ * \param length        The number of bytes to receive.
+ * \param offset        The offset to write the data to.
+ * \param bytes_written The number of bytes written.
+ * \param statistics    Statistics.
+ *
+ * \return TRUE if all data has been received, FALSE otherwise.
+ **/
+static gboolean
+jd_object_write_pieces(gpointer object, GSocketConnection* connection, gpointer buffer, guint64 buffer_size, guint64 length, guint64 offset, guint64* bytes_written, JStatistics* statistics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	guint64 bytes_done = 0;
+
+	*bytes_written = 0;
+
+	while (bytes_done < length)
+	{
+		guint64 chunk_length;
+		guint64 bytes_received;
+
+		chunk_length = MIN(length - bytes_done, buffer_size);
+		bytes_received = jd_receive_vectors(g_socket_connection_get_socket(connection), &buffer, &chunk_length, 1);
+		j_statistics_add(statistics, J_STATISTICS_BYTES_RECEIVED, bytes_received);
+
+		if (bytes_received < chunk_length)
+		{
+			return FALSE;
+		}
+
+		// After a short write, the remaining data is only received to keep the connection usable
+		if (*bytes_written == bytes_done)
+		{
+			guint64 nbytes = 0;
+
+			j_backend_object_write(jd_object_backend, object, buffer, chunk_length, offset + bytes_done, &nbytes);
+			j_statistics_add(statistics, J_STATISTICS_BYTES_WRITTEN, nbytes);
+
+			*bytes_written += nbytes;
+		}
+
+		bytes_done += chunk_length;
+	}
+
+	return TRUE;
+}
+
+/**
+ * Creates a new memory chunk and registers it with the object backend.
+ * The memory chunk must only be used by the calling thread.
+ *
+ * \param size The size of the memory chunk.
+ *
+ * \return A new memory chunk. Should be freed with j_memory_chunk_free().
+ **/
+JMemoryChunk*
+jd_memory_chunk_new(guint64 size)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JMemoryChunk* memory_chunk;
+
+	memory_chunk = j_memory_chunk_new(size);
+
+	if (size > 0)
+	{
+		gpointer buffer;
+
+		// Getting the whole chunk returns its start
+		buffer = j_memory_chunk_get(memory_chunk, size);
+
+		if (jd_object_backend != NULL)
+		{
+			j_backend_object_register_buffer(jd_object_backend, buffer, size);
+		}
+
+		// Avoids having to register the buffers for each RMA operation
+		if (j_fabric_is_enabled())
+		{
+			j_fabric_register_buffer(buffer, size);
+		}
+
+		j_memory_chunk_reset(memory_chunk);
+	}
+
+	return memory_chunk;
+}
+
+/**
+ * Frees a memory chunk created with jd_memory_chunk_new().
+ *
+ * \param memory_chunk A memory chunk.
+ **/
+void
+jd_memory_chunk_free(JMemoryChunk* memory_chunk)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gpointer buffer;
+
+	j_memory_chunk_reset(memory_chunk);
+
+	// Getting any part of the chunk after a reset returns its start
+	if ((buffer = j_memory_chunk_get(memory_chunk, 1)) != NULL)
+	{
+		// The buffer must not be freed while it is still registered with the backend's per-thread state
+		if (jd_object_backend != NULL)
+		{
+			j_backend_object_unregister_buffer(jd_object_backend, buffer);
+		}
+
+		if (j_fabric_is_enabled())
+		{
+			j_fabric_deregister_buffer(buffer);
+		}
+	}
+
+	j_memory_chunk_free(memory_chunk);
+}
+
 gboolean
 jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk* memory_chunk, guint64 memory_chunk_size, JStatistics* statistics)
 {
@@ -65,12 +417,21 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 
 			for (i = 0; i < operation_count; i++)
 			{
+				guint64 size;
+
 				path = j_message_get_string(message);
+				size = j_message_get_8(message);
 
 				if (j_backend_object_create(jd_object_backend, namespace, path, &object))
 				{
 					j_statistics_add(statistics, J_STATISTICS_FILES_CREATED, 1);
 
+					// The size is only a hint, failing to reserve space is not an error
+					if (size > 0)
+					{
+						j_backend_object_allocate(jd_object_backend, object, size);
+					}
+
 					if (safety == J_SEMANTICS_SAFETY_STORAGE)
 					{
 						j_backend_object_sync(jd_object_backend, object);
@@ -129,38 +490,65 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 		case J_MESSAGE_OBJECT_READ:
 		{
 			JMessage* reply;
-			gpointer object;
+			g_autofree gpointer* buffers = NULL;
+			g_autofree guint64* lengths = NULL;
+			g_autofree guint64* offsets = NULL;
+			guint buffers_count = 0;
+			gpointer object = NULL;
 
 			namespace = j_message_get_string(message);
 			path = j_message_get_string(message);
 
 			reply = j_message_new_reply(message);
 
-			// FIXME return value
-			j_backend_object_open(jd_object_backend, namespace, path, &object);
+			// Operations on objects that cannot be opened are reported as having read nothing
+			if (!j_backend_object_open(jd_object_backend, namespace, path, &object))
+			{
+				object = NULL;
+			}
+
+			buffers = g_new(gpointer, operation_count);
+			lengths = g_new(guint64, operation_count);
+			offsets = g_new(guint64, operation_count);
 
 			for (i = 0; i < operation_count; i++)
 			{
-				gchar* buf;
 				guint64 length;
 				guint64 offset;
-				guint64 bytes_read = 0;
 
 				length = j_message_get_8(message);
 				offset = j_message_get_8(message);
 
+				if (object == NULL)
+				{
+					guint64 bytes_read = 0;
+
+					j_message_add_operation(reply, sizeof(guint64));
+					j_message_append_8(reply, &bytes_read);
+					continue;
+				}
+
+				// Clients split their operations according to max-operation-size, the length is not trusted otherwise
 				if (length > memory_chunk_size)
 				{
-					// FIXME return proper error
+					guint64 bytes_read = 0;
+
+					// Replies have to be in order, handle all pending operations first
+					jd_object_read(object, buffers, lengths, offsets, buffers_count, reply, statistics);
+					buffers_count = 0;
+
 					j_message_add_operation(reply, sizeof(guint64));
 					j_message_append_8(reply, &bytes_read);
 					continue;
 				}
 
-				buf = j_memory_chunk_get(memory_chunk, length);
+				buffers[buffers_count] = j_memory_chunk_get(memory_chunk, length);
 
-				if (buf == NULL)
+				if (buffers[buffers_count] == NULL)
 				{
+					jd_object_read(object, buffers, lengths, offsets, buffers_count, reply, statistics);
+					buffers_count = 0;
+
 					// FIXME ugly
 					j_message_send(reply, connection);
 					j_message_unref(reply);
@@ -168,25 +556,21 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 					reply = j_message_new_reply(message);
 
 					j_memory_chunk_reset(memory_chunk);
-					buf = j_memory_chunk_get(memory_chunk, length);
+					buffers[buffers_count] = j_memory_chunk_get(memory_chunk, length);
 				}
 
-				j_backend_object_read(jd_object_backend, object, buf, length, offset, &bytes_read);
-				j_statistics_add(statistics, J_STATISTICS_BYTES_READ, bytes_read);
-
-				j_message_add_operation(reply, sizeof(guint64));
-				j_message_append_8(reply, &bytes_read);
+				lengths[buffers_count] = length;
+				offsets[buffers_count] = offset;
+				buffers_count++;
+			}
 
-				if (bytes_read > 0)
-				{
-					j_message_add_send(reply, buf, bytes_read);
-				}
+			if (object != NULL)
+			{
+				jd_object_read(object, buffers, lengths, offsets, buffers_count, reply, statistics);
 
-				j_statistics_add(statistics, J_STATISTICS_BYTES_SENT, bytes_read);
+				j_backend_object_close(jd_object_backend, object);
 			}
 
-			j_backend_object_close(jd_object_backend, object);
-
 			j_message_send(reply, connection);
 			j_message_unref(reply);
 
@@ -196,7 +580,12 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 		case J_MESSAGE_OBJECT_WRITE:
 		{
 			g_autoptr(JMessage) reply = NULL;
-			gpointer object;
+			g_autofree gpointer* buffers = NULL;
+			g_autofree guint64* lengths = NULL;
+			g_autofree guint64* offsets = NULL;
+			guint buffers_count = 0;
+			gpointer object = NULL;
+			gboolean received = TRUE;
 
 			if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
 			{
@@ -206,55 +595,127 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 			namespace = j_message_get_string(message);
 			path = j_message_get_string(message);
 
-			// FIXME return value
-			j_backend_object_open(jd_object_backend, namespace, path, &object);
+			// Operations on objects that cannot be opened are reported as having written nothing
+			if (!j_backend_object_open(jd_object_backend, namespace, path, &object))
+			{
+				object = NULL;
+			}
+
+			buffers = g_new(gpointer, operation_count);
+			lengths = g_new(guint64, operation_count);
+			offsets = g_new(guint64, operation_count);
 
 			for (i = 0; i < operation_count; i++)
 			{
-				GInputStream* input;
-				gchar* buf;
 				guint64 length;
 				guint64 offset;
-				guint64 bytes_written = 0;
 
 				length = j_message_get_8(message);
 				offset = j_message_get_8(message);
 
-				if (length > memory_chunk_size)
+				// After a short receive, the remaining data cannot be received anymore
+				if (!received)
 				{
-					// FIXME return proper error
-					j_message_add_operation(reply, sizeof(guint64));
-					j_message_append_8(reply, &bytes_written);
+					guint64 bytes_written = 0;
+
+					if (reply != NULL)
+					{
+						j_message_add_operation(reply, sizeof(guint64));
+						j_message_append_8(reply, &bytes_written);
+					}
+
 					continue;
 				}
 
-				// Guaranteed to work because memory_chunk is reset below
-				buf = j_memory_chunk_get(memory_chunk, length);
-				g_assert(buf != NULL);
+				if (object == NULL)
+				{
+					guint64 bytes_written = 0;
 
-				input = g_io_stream_get_input_stream(G_IO_STREAM(connection));
-				g_input_stream_read_all(input, buf, length, NULL, NULL, NULL);
-				j_statistics_add(statistics, J_STATISTICS_BYTES_RECEIVED, length);
+					// The data has already been sent and has to be received to keep the connection usable
+					received = jd_discard(connection, j_memory_chunk_get(memory_chunk, memory_chunk_size), memory_chunk_size, length, statistics);
+					j_memory_chunk_reset(memory_chunk);
 
-				j_backend_object_write(jd_object_backend, object, buf, length, offset, &bytes_written);
-				j_statistics_add(statistics, J_STATISTICS_BYTES_WRITTEN, bytes_written);
+					if (reply != NULL)
+					{
+						j_message_add_operation(reply, sizeof(guint64));
+						j_message_append_8(reply, &bytes_written);
+					}
 
-				if (reply != NULL)
+					continue;
+				}
+
+				if (length > memory_chunk_size)
 				{
-					j_message_add_operation(reply, sizeof(guint64));
-					j_message_append_8(reply, &bytes_written);
+					guint64 bytes_written = 0;
+
+					// Replies have to be in order, handle all pending operations first
+					received = jd_object_write(object, connection, buffers, lengths, offsets, buffers_count, FALSE, reply, statistics);
+					j_memory_chunk_reset(memory_chunk);
+					buffers_count = 0;
+
+					// The length is not trusted, the data is received and written in pieces instead of allocating a buffer for it
+					if (received)
+					{
+						received = jd_object_write_pieces(object, connection, j_memory_chunk_get(memory_chunk, memory_chunk_size), memory_chunk_size, length, offset, &bytes_written, statistics);
+						j_memory_chunk_reset(memory_chunk);
+					}
+
+					if (reply != NULL)
+					{
+						j_message_add_operation(reply, sizeof(guint64));
+						j_message_append_8(reply, &bytes_written);
+					}
+
+					continue;
 				}
 
-				j_memory_chunk_reset(memory_chunk);
+				buffers[buffers_count] = j_memory_chunk_get(memory_chunk, length);
+
+				if (buffers[buffers_count] == NULL)
+				{
+					// The memory chunk is full, handle all pending operations to be able to reuse it
+					received = jd_object_write(object, connection, buffers, lengths, offsets, buffers_count, FALSE, reply, statistics);
+					j_memory_chunk_reset(memory_chunk);
+					buffers_count = 0;
+
+					if (!received)
+					{
+						guint64 bytes_written = 0;
+
+						if (reply != NULL)
+						{
+							j_message_add_operation(reply, sizeof(guint64));
+							j_message_append_8(reply, &bytes_written);
+						}
+
+						continue;
+					}
+
+					// Guaranteed to work because memory_chunk has just been reset
+					buffers[buffers_count] = j_memory_chunk_get(memory_chunk, length);
+					g_assert(buffers[buffers_count] != NULL);
+				}
+
+				lengths[buffers_count] = length;
+				offsets[buffers_count] = offset;
+				buffers_count++;
 			}
 
-			if (safety == J_SEMANTICS_SAFETY_STORAGE)
+			// Syncing as part of the last batch allows the backend to overlap it with the writes
+			if (received && object != NULL)
 			{
-				j_backend_object_sync(jd_object_backend, object);
-				j_statistics_add(statistics, J_STATISTICS_SYNC, 1);
+				received = jd_object_write(object, connection, buffers, lengths, offsets, buffers_count, safety == J_SEMANTICS_SAFETY_STORAGE, reply, statistics);
 			}
 
-			j_backend_object_close(jd_object_backend, object);
+			if (!received)
+			{
+				g_warning("Could not receive all data for object %s/%s.", namespace, path);
+			}
+
+			if (object != NULL)
+			{
+				j_backend_object_close(jd_object_backend, object);
+			}
 
 			if (reply != NULL)
 			{
@@ -264,6 +725,119 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 			j_memory_chunk_reset(memory_chunk);
 		}
 		break;
+		case J_MESSAGE_OBJECT_READ_RMA:
+		case J_MESSAGE_OBJECT_WRITE_RMA:
+		{
+			g_autoptr(JMessage) reply = NULL;
+			gboolean write;
+			gboolean have_peer;
+			gpointer buffer;
+			gpointer object = NULL;
+			guint64 peer = 0;
+
+			write = (j_message_get_type(message) == J_MESSAGE_OBJECT_WRITE_RMA);
+
+			// Clients keep their regions registered until they receive the reply, which is therefore always sent
+			reply = j_message_new_reply(message);
+
+			namespace = j_message_get_string(message);
+			path = j_message_get_string(message);
+
+			// The address is part of the message even if the fabric is not available here
+			if (!(have_peer = j_fabric_get_peer(message, &peer)))
+			{
+				g_warning("Could not access libfabric peer for object %s/%s, check that clients and servers use the same fabric provider.", namespace, path);
+			}
+
+			if (have_peer && !j_backend_object_open(jd_object_backend, namespace, path, &object))
+			{
+				object = NULL;
+			}
+
+			// The data is transferred in chunks using the whole (registered) memory chunk
+			buffer = j_memory_chunk_get(memory_chunk, memory_chunk_size);
+
+			for (i = 0; i < operation_count; i++)
+			{
+				guint64 length;
+				guint64 offset;
+				guint64 address;
+				guint64 rkey;
+				guint64 bytes_done = 0;
+				guint32 success;
+
+				length = j_message_get_8(message);
+				offset = j_message_get_8(message);
+				address = j_message_get_8(message);
+				rkey = j_message_get_8(message);
+
+				// Failed transfers are reported explicitly, a short read is not an error otherwise
+				success = (object != NULL && buffer != NULL);
+
+				while (success && bytes_done < length)
+				{
+					guint64 chunk_length;
+					guint64 nbytes = 0;
+
+					chunk_length = MIN(length - bytes_done, memory_chunk_size);
+
+					if (write)
+					{
+						if (!j_fabric_read(peer, buffer, chunk_length, address + bytes_done, rkey))
+						{
+							success = FALSE;
+							break;
+						}
+
+						j_statistics_add(statistics, J_STATISTICS_BYTES_RECEIVED, chunk_length);
+
+						j_backend_object_write(jd_object_backend, object, buffer, chunk_length, offset + bytes_done, &nbytes);
+						j_statistics_add(statistics, J_STATISTICS_BYTES_WRITTEN, nbytes);
+					}
+					else
+					{
+						j_backend_object_read(jd_object_backend, object, buffer, chunk_length, offset + bytes_done, &nbytes);
+						j_statistics_add(statistics, J_STATISTICS_BYTES_READ, nbytes);
+
+						if (nbytes > 0 && !j_fabric_write(peer, buffer, nbytes, address + bytes_done, rkey))
+						{
+							success = FALSE;
+							break;
+						}
+
+						j_statistics_add(statistics, J_STATISTICS_BYTES_SENT, nbytes);
+					}
+
+					bytes_done += nbytes;
+
+					// The end of the object has been reached or the write was short
+					if (nbytes < chunk_length)
+					{
+						break;
+					}
+				}
+
+				j_message_add_operation(reply, sizeof(guint64) + sizeof(guint32));
+				j_message_append_8(reply, &bytes_done);
+				j_message_append_4(reply, &success);
+			}
+
+			if (object != NULL)
+			{
+				if (write && safety == J_SEMANTICS_SAFETY_STORAGE)
+				{
+					j_backend_object_sync(jd_object_backend, object);
+					j_statistics_add(statistics, J_STATISTICS_SYNC, 1);
+				}
+
+				j_backend_object_close(jd_object_backend, object);
+			}
+
+			j_message_send(reply, connection);
+
+			j_memory_chunk_reset(memory_chunk);
+		}
+		break;
 		case J_MESSAGE_OBJECT_STATUS:
 		{
 			g_autoptr(JMessage) reply = NULL;
@@ -280,19 +854,20 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 
 				path = j_message_get_string(message);
 
-				// FIXME return value
-				j_backend_object_open(jd_object_backend, namespace, path, &object);
-
-				if (j_backend_object_status(jd_object_backend, object, &modification_time, &size))
+				// Objects that cannot be opened are reported with zero values
+				if (j_backend_object_open(jd_object_backend, namespace, path, &object))
 				{
-					j_statistics_add(statistics, J_STATISTICS_FILES_STATED, 1);
+					if (j_backend_object_status(jd_object_backend, object, &modification_time, &size))
+					{
+						j_statistics_add(statistics, J_STATISTICS_FILES_STATED, 1);
+					}
+
+					j_backend_object_close(jd_object_backend, object);
 				}
 
 				j_message_add_operation(reply, sizeof(gint64) + sizeof(guint64));
 				j_message_append_8(reply, &modification_time);
 				j_message_append_8(reply, &size);
-
-				j_backend_object_close(jd_object_backend, object);
 			}
 
 			j_message_send(reply, connection);
@@ -333,6 +908,56 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 			}
 		}
 		break;
+		case J_MESSAGE_OBJECT_TRUNCATE:
+		{
+			g_autoptr(JMessage) reply = NULL;
+			gpointer object;
+
+			if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
+			{
+				reply = j_message_new_reply(message);
+			}
+
+			namespace = j_message_get_string(message);
+
+			for (i = 0; i < operation_count; i++)
+			{
+				guint64 size;
+
+				guint32 truncated = 0;
+
+				path = j_message_get_string(message);
+				size = j_message_get_8(message);
+
+				if (j_backend_object_open(jd_object_backend, namespace, path, &object))
+				{
+					if (j_backend_object_truncate(jd_object_backend, object, size))
+					{
+						truncated = 1;
+					}
+
+					if (safety == J_SEMANTICS_SAFETY_STORAGE)
+					{
+						j_backend_object_sync(jd_object_backend, object);
+						j_statistics_add(statistics, J_STATISTICS_SYNC, 1);
+					}
+
+					j_backend_object_close(jd_object_backend, object);
+				}
+
+				if (reply != NULL)
+				{
+					j_message_add_operation(reply, sizeof(guint32));
+					j_message_append_4(reply, &truncated);
+				}
+			}
+
+			if (reply != NULL)
+			{
+				j_message_send(reply, connection);
+			}
+		}
+		break;
 		case J_MESSAGE_STATISTICS:
 		{
 			g_autoptr(JMessage) reply = NULL;
@@ -347,10 +972,16 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 			{
 				g_mutex_lock(jd_statistics_mutex);
 				/* FIXME add statistics of all threads */
+
+				// The backend's statistics are not associated with any specific thread
+				if (jd_object_backend != NULL)
+				{
+					j_backend_object_statistics(jd_object_backend, jd_statistics);
+				}
 			}
 
 			reply = j_message_new_reply(message);
-			j_message_add_operation(reply, 8 * sizeof(guint64));
+			j_message_add_operation(reply, 10 * sizeof(guint64));
 
 			value = j_statistics_get(r_statistics, J_STATISTICS_FILES_CREATED);
 			j_message_append_8(reply, &value);
@@ -368,6 +999,10 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 			j_message_append_8(reply, &value);
 			value = j_statistics_get(r_statistics, J_STATISTICS_BYTES_SENT);
 			j_message_append_8(reply, &value);
+			value = j_statistics_get(r_statistics, J_STATISTICS_HANDLE_CACHE_HITS);
+			j_message_append_8(reply, &value);
+			value = j_statistics_get(r_statistics, J_STATISTICS_HANDLE_CACHE_MISSES);
+			j_message_append_8(reply, &value);
 
 			if (get_all != 0)
 			{
@@ -495,27 +1130,78 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 			namespace = j_message_get_string(message);
 			j_backend_kv_batch_start(jd_kv_backend, namespace, semantics, &batch);
 
-			for (i = 0; i < operation_count; i++)
+			if (j_backend_kv_has_get_many(jd_kv_backend))
 			{
-				gpointer value;
-				guint32 len;
+				g_autofree gchar const** keys = NULL;
+				g_autofree gconstpointer* values = NULL;
+				g_autofree guint32* lens = NULL;
 
-				key = j_message_get_string(message);
+				keys = g_new(gchar const*, operation_count);
+				values = g_new0(gconstpointer, operation_count);
+				lens = g_new0(guint32, operation_count);
+
+				for (i = 0; i < operation_count; i++)
+				{
+					keys[i] = j_message_get_string(message);
+				}
 
-				if (j_backend_kv_get(jd_kv_backend, batch, key, &value, &len))
+				// Looks up all keys at once, values are copied directly into the reply
+				j_backend_kv_get_many(jd_kv_backend, batch, keys, operation_count, values, lens);
+
+				for (i = 0; i < operation_count; i++)
 				{
+					guint32 len = (values[i] != NULL) ? lens[i] : 0;
+
 					j_message_add_operation(reply, 4 + len);
 					j_message_append_4(reply, &len);
-					j_message_append_n(reply, value, len);
 
-					g_free(value);
+					if (len > 0)
+					{
+						j_message_append_n(reply, values[i], len);
+					}
 				}
-				else
+			}
+			else
+			{
+				gboolean get_static;
+
+				// Values are copied directly into the reply if the backend allows it
+				get_static = j_backend_kv_has_get_static(jd_kv_backend);
+
+				for (i = 0; i < operation_count; i++)
 				{
-					guint32 zero = 0;
+					gconstpointer value;
+					gpointer value_copy = NULL;
+					guint32 len;
+					gboolean found;
 
-					j_message_add_operation(reply, 4);
-					j_message_append_4(reply, &zero);
+					key = j_message_get_string(message);
+
+					if (get_static)
+					{
+						found = j_backend_kv_get_static(jd_kv_backend, batch, key, &value, &len);
+					}
+					else
+					{
+						found = j_backend_kv_get(jd_kv_backend, batch, key, &value_copy, &len);
+						value = value_copy;
+					}
+
+					if (found)
+					{
+						j_message_add_operation(reply, 4 + len);
+						j_message_append_4(reply, &len);
+						j_message_append_n(reply, value, len);
+
+						g_free(value_copy);
+					}
+					else
+					{
+						guint32 zero = 0;
+
+						j_message_add_operation(reply, 4);
+						j_message_append_4(reply, &zero);
+					}
 				}
 			}
 
@@ -775,6 +1461,93 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 				j_message_send(reply, connection);
 			}
 			break;
+		case J_MESSAGE_DB_CURSOR_OPEN:
+		case J_MESSAGE_DB_CURSOR_FETCH:
+		{
+			g_autoptr(JMessage) reply = NULL;
+			g_autoptr(GError) error = NULL;
+			bson_t page[1];
+			guint64 id;
+
+			reply = j_message_new_reply(message);
+
+			memcpy(&backend_operation, &j_backend_operation_db_query, sizeof(JBackendOperation));
+
+			if (j_message_get_type(message) == J_MESSAGE_DB_CURSOR_OPEN)
+			{
+				guint32 page_size;
+
+				page_size = j_message_get_4(message);
+				j_backend_operation_from_message_static(message, backend_operation.in_param, backend_operation.in_param_count);
+
+				id = jd_cursor_open(semantics, backend_operation.in_param[0].ptr, backend_operation.in_param[1].ptr, backend_operation.in_param[2].ptr, page_size, page, &error);
+			}
+			else
+			{
+				id = jd_cursor_fetch(j_message_get_8(message), page, &error);
+			}
+
+			backend_operation.out_param[0].ptr = page;
+			backend_operation.out_param[1].ptr = &error;
+
+			j_message_add_operation(reply, sizeof(guint64));
+			j_message_append_8(reply, &id);
+			j_backend_operation_to_message(reply, backend_operation.out_param, backend_operation.out_param_count);
+
+			bson_destroy(page);
+
+			j_message_send(reply, connection);
+		}
+		break;
+		case J_MESSAGE_KV_CURSOR_OPEN:
+		case J_MESSAGE_KV_CURSOR_FETCH:
+		{
+			g_autoptr(JMessage) reply = NULL;
+			g_autoptr(GByteArray) entries = NULL;
+			guint64 id;
+			guint32 count;
+
+			reply = j_message_new_reply(message);
+			entries = g_byte_array_new();
+
+			if (j_message_get_type(message) == J_MESSAGE_KV_CURSOR_OPEN)
+			{
+				gchar const* prefix;
+				guint32 page_size;
+				gboolean keys_only;
+
+				page_size = j_message_get_4(message);
+				keys_only = j_message_get_1(message);
+				namespace = j_message_get_string(message);
+				prefix = j_message_get_string(message);
+
+				id = jd_cursor_open_kv(namespace, (prefix[0] != '\0') ? prefix : NULL, page_size, keys_only, entries, &count);
+			}
+			else
+			{
+				id = jd_cursor_fetch_kv(j_message_get_8(message), entries, &count);
+			}
+
+			j_message_add_operation(reply, sizeof(guint64) + sizeof(guint32));
+			j_message_append_8(reply, &id);
+			j_message_append_4(reply, &count);
+
+			if (entries->len > 0)
+			{
+				j_message_add_operation(reply, entries->len);
+				j_message_append_n(reply, entries->data, entries->len);
+			}
+
+			j_message_send(reply, connection);
+		}
+		break;
+		case J_MESSAGE_DB_CURSOR_CLOSE:
+		case J_MESSAGE_KV_CURSOR_CLOSE:
+			for (i = 0; i < operation_count; i++)
+			{
+				jd_cursor_close(j_message_get_8(message));
+			}
+			break;
 		default:
 			g_warn_if_reached();
 			break;
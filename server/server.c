@@ -23,10 +23,13 @@
 #include <glib-unix.h>
 #include <glib-object.h>
 #include <gio/gio.h>
+#include <gio/gunixsocketaddress.h>
 #include <gmodule.h>
 
+#include <errno.h>
 #include <locale.h>
 #include <string.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 #include <julea.h>
@@ -57,6 +60,37 @@ jd_signal(gpointer data)
 	return FALSE;
 }
 
+void
+jd_statistics_merge(JStatistics* statistics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	guint64 value;
+
+	g_mutex_lock(jd_statistics_mutex);
+
+	value = j_statistics_get(statistics, J_STATISTICS_FILES_CREATED);
+	j_statistics_add(jd_statistics, J_STATISTICS_FILES_CREATED, value);
+	value = j_statistics_get(statistics, J_STATISTICS_FILES_DELETED);
+	j_statistics_add(jd_statistics, J_STATISTICS_FILES_DELETED, value);
+	value = j_statistics_get(statistics, J_STATISTICS_SYNC);
+	j_statistics_add(jd_statistics, J_STATISTICS_SYNC, value);
+	value = j_statistics_get(statistics, J_STATISTICS_BYTES_READ);
+	j_statistics_add(jd_statistics, J_STATISTICS_BYTES_READ, value);
+	value = j_statistics_get(statistics, J_STATISTICS_BYTES_WRITTEN);
+	j_statistics_add(jd_statistics, J_STATISTICS_BYTES_WRITTEN, value);
+	value = j_statistics_get(statistics, J_STATISTICS_BYTES_RECEIVED);
+	j_statistics_add(jd_statistics, J_STATISTICS_BYTES_RECEIVED, value);
+	value = j_statistics_get(statistics, J_STATISTICS_BYTES_SENT);
+	j_statistics_add(jd_statistics, J_STATISTICS_BYTES_SENT, value);
+	value = j_statistics_get(statistics, J_STATISTICS_HANDLE_CACHE_HITS);
+	j_statistics_add(jd_statistics, J_STATISTICS_HANDLE_CACHE_HITS, value);
+	value = j_statistics_get(statistics, J_STATISTICS_HANDLE_CACHE_MISSES);
+	j_statistics_add(jd_statistics, J_STATISTICS_HANDLE_CACHE_MISSES, value);
+
+	g_mutex_unlock(jd_statistics_mutex);
+}
+
 static gboolean
 jd_on_run(GThreadedSocketService* service, GSocketConnection* connection, GObject* source_object, gpointer user_data)
 {
@@ -73,9 +107,15 @@ jd_on_run(GThreadedSocketService* service, GSocketConnection* connection, GObjec
 
 	j_helper_set_nodelay(connection, TRUE);
 
+	// Zero-copy sends are only supported for TCP.
+	if (j_configuration_get_zerocopy(jd_configuration) && G_IS_TCP_CONNECTION(connection))
+	{
+		j_message_enable_zerocopy(connection);
+	}
+
 	statistics = j_statistics_new(TRUE);
 	memory_chunk_size = j_configuration_get_max_operation_size(jd_configuration);
-	memory_chunk = j_memory_chunk_new(memory_chunk_size);
+	memory_chunk = jd_memory_chunk_new(memory_chunk_size);
 
 	message = j_message_new(J_MESSAGE_NONE, 0);
 
@@ -84,31 +124,30 @@ jd_on_run(GThreadedSocketService* service, GSocketConnection* connection, GObjec
 		jd_handle_message(message, connection, memory_chunk, memory_chunk_size, statistics);
 	}
 
-	{
-		guint64 value;
+	jd_statistics_merge(statistics);
+
+	jd_memory_chunk_free(memory_chunk);
+	j_statistics_free(statistics);
+
+	return TRUE;
+}
 
-		g_mutex_lock(jd_statistics_mutex);
+static gboolean
+jd_on_incoming(GSocketService* service, GSocketConnection* connection, GObject* source_object, gpointer user_data)
+{
+	J_TRACE_FUNCTION(NULL);
 
-		value = j_statistics_get(statistics, J_STATISTICS_FILES_CREATED);
-		j_statistics_add(jd_statistics, J_STATISTICS_FILES_CREATED, value);
-		value = j_statistics_get(statistics, J_STATISTICS_FILES_DELETED);
-		j_statistics_add(jd_statistics, J_STATISTICS_FILES_DELETED, value);
-		value = j_statistics_get(statistics, J_STATISTICS_SYNC);
-		j_statistics_add(jd_statistics, J_STATISTICS_SYNC, value);
-		value = j_statistics_get(statistics, J_STATISTICS_BYTES_READ);
-		j_statistics_add(jd_statistics, J_STATISTICS_BYTES_READ, value);
-		value = j_statistics_get(statistics, J_STATISTICS_BYTES_WRITTEN);
-		j_statistics_add(jd_statistics, J_STATISTICS_BYTES_WRITTEN, value);
-		value = j_statistics_get(statistics, J_STATISTICS_BYTES_RECEIVED);
-		j_statistics_add(jd_statistics, J_STATISTICS_BYTES_RECEIVED, value);
-		value = j_statistics_get(statistics, J_STATISTICS_BYTES_SENT);
-		j_statistics_add(jd_statistics, J_STATISTICS_BYTES_SENT, value);
+	(void)service;
+	(void)source_object;
+	(void)user_data;
 
-		g_mutex_unlock(jd_statistics_mutex);
+	// Zero-copy sends are only supported for TCP.
+	if (j_configuration_get_zerocopy(jd_configuration) && G_IS_TCP_CONNECTION(connection))
+	{
+		j_message_enable_zerocopy(connection);
 	}
 
-	j_memory_chunk_free(memory_chunk);
-	j_statistics_free(statistics);
+	jd_event_add_connection(connection);
 
 	return TRUE;
 }
@@ -197,6 +236,72 @@ jd_is_server_for_backend(gchar const* host, gint port, JBackendType backend_type
 	return FALSE;
 }
 
+/**
+ * Prepares the Unix domain socket used by local clients.
+ * The socket's directory is created if necessary and stale sockets are removed.
+ *
+ * \param path The socket's path.
+ *
+ * \return TRUE if the socket can be created, FALSE otherwise.
+ **/
+static gboolean
+jd_local_socket_prepare(gchar const* path)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autofree gchar* dir = NULL;
+	GStatBuf buf;
+
+	dir = g_path_get_dirname(path);
+
+	if (g_mkdir_with_parents(dir, 0700) != 0)
+	{
+		g_warning("Cannot create %s, local clients will use TCP: %s", dir, g_strerror(errno));
+		return FALSE;
+	}
+
+	// Other users must not be able to replace the socket
+	if (g_lstat(dir, &buf) != 0 || !S_ISDIR(buf.st_mode) || buf.st_uid != getuid() || (buf.st_mode & 0077) != 0)
+	{
+		g_warning("%s is accessible by other users, local clients will use TCP.", dir);
+		return FALSE;
+	}
+
+	if (g_lstat(path, &buf) != 0)
+	{
+		return TRUE;
+	}
+
+	// Only remove stale sockets left behind by servers that did not shut down cleanly
+	if (!S_ISSOCK(buf.st_mode) || buf.st_uid != getuid())
+	{
+		g_warning("%s is not a socket owned by this user, local clients will use TCP.", path);
+		return FALSE;
+	}
+
+	return (g_unlink(path) == 0);
+}
+
+/**
+ * Removes the Unix domain socket used by local clients.
+ *
+ * \param path    The socket's path.
+ * \param created The socket's status after it has been created.
+ **/
+static void
+jd_local_socket_remove(gchar const* path, GStatBuf const* created)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	GStatBuf buf;
+
+	// The socket might have been replaced in the meantime
+	if (g_lstat(path, &buf) == 0 && buf.st_dev == created->st_dev && buf.st_ino == created->st_ino)
+	{
+		g_unlink(path);
+	}
+}
+
 int
 main(int argc, char** argv)
 {
@@ -205,6 +310,8 @@ main(int argc, char** argv)
 	gboolean opt_daemon = FALSE;
 	g_autofree gchar* opt_host = NULL;
 	gint opt_port = 4711;
+	gint opt_event_loops = 0;
+	gint opt_workers = 0;
 
 	JTrace* trace;
 	GError* error = NULL;
@@ -224,12 +331,17 @@ main(int argc, char** argv)
 	gchar const* db_component;
 	g_autofree gchar* db_path = NULL;
 	g_autofree gchar* port_str = NULL;
+	g_autofree gchar* local_socket_path = NULL;
+	g_autoptr(GSocketAddress) local_address = NULL;
+	GStatBuf local_socket_stat;
 	guint listen_retries = 0;
 
 	GOptionEntry entries[] = {
 		{ "daemon", 0, 0, G_OPTION_ARG_NONE, &opt_daemon, "Run as daemon", NULL },
 		{ "host", 0, 0, G_OPTION_ARG_STRING, &opt_host, "Override host name", "hostname" },
 		{ "port", 0, 0, G_OPTION_ARG_INT, &opt_port, "Port to use", "4711" },
+		{ "event-loops", 0, 0, G_OPTION_ARG_INT, &opt_event_loops, "Number of event loops to use (0 uses one thread per connection)", "0" },
+		{ "workers", 0, 0, G_OPTION_ARG_INT, &opt_workers, "Number of workers handling messages when using event loops (0 uses the number of processors)", "0" },
 		{ NULL, 0, 0, 0, NULL, NULL, NULL }
 	};
 
@@ -263,7 +375,29 @@ main(int argc, char** argv)
 		opt_host = g_strdup(hostname);
 	}
 
-	socket_service = g_threaded_socket_service_new(-1);
+	if (opt_event_loops < 0 || opt_workers < 0)
+	{
+		g_warning("The number of event loops and workers must not be negative.");
+		return 1;
+	}
+
+#ifndef HAVE_EPOLL
+	if (opt_event_loops > 0)
+	{
+		g_warning("Event loops are not supported on this platform, using one thread per connection.");
+		opt_event_loops = 0;
+	}
+#endif
+
+	if (opt_event_loops > 0)
+	{
+		socket_service = g_socket_service_new();
+	}
+	else
+	{
+		socket_service = g_threaded_socket_service_new(-1);
+	}
+
 	g_socket_listener_set_backlog(G_SOCKET_LISTENER(socket_service), 128);
 
 	while (TRUE)
@@ -293,6 +427,34 @@ main(int argc, char** argv)
 		break;
 	}
 
+	// Clients running on the same host connect via a Unix domain socket.
+	local_socket_path = j_helper_get_local_socket_path(opt_port);
+
+	if (!jd_local_socket_prepare(local_socket_path))
+	{
+		g_clear_pointer(&local_socket_path, g_free);
+	}
+	else
+	{
+		local_address = g_unix_socket_address_new(local_socket_path);
+
+		if (!g_socket_listener_add_address(G_SOCKET_LISTENER(socket_service), local_address, G_SOCKET_TYPE_STREAM, G_SOCKET_PROTOCOL_DEFAULT, NULL, NULL, &error))
+		{
+			if (error != NULL)
+			{
+				g_warning("Cannot listen on %s, local clients will use TCP: %s", local_socket_path, error->message);
+				g_clear_error(&error);
+			}
+
+			g_clear_pointer(&local_socket_path, g_free);
+		}
+		else if (g_lstat(local_socket_path, &local_socket_stat) != 0)
+		{
+			// Without knowing the socket's identity, it cannot be removed safely
+			g_clear_pointer(&local_socket_path, g_free);
+		}
+	}
+
 	j_trace_init("julea-server");
 
 	trace = j_trace_enter(G_STRFUNC, NULL);
@@ -359,11 +521,40 @@ main(int argc, char** argv)
 		g_debug("Initialized db backend %s.", db_backend);
 	}
 
+	if (jd_kv_backend != NULL || jd_db_backend != NULL)
+	{
+		jd_cursor_init();
+	}
+
+	if (!j_fabric_init(jd_configuration))
+	{
+		g_warning("Could not initialize fabric, clients using RMA will not be able to transfer object data.");
+	}
+
 	jd_statistics = j_statistics_new(FALSE);
 	g_mutex_init(jd_statistics_mutex);
 
+	if (opt_event_loops > 0)
+	{
+		if (opt_workers == 0)
+		{
+			opt_workers = g_get_num_processors();
+		}
+
+		if (!jd_event_init(opt_event_loops, opt_workers, j_configuration_get_max_operation_size(jd_configuration)))
+		{
+			g_warning("Could not initialize event loops.");
+			return 1;
+		}
+
+		g_signal_connect(socket_service, "incoming", G_CALLBACK(jd_on_incoming), NULL);
+	}
+	else
+	{
+		g_signal_connect(socket_service, "run", G_CALLBACK(jd_on_run), NULL);
+	}
+
 	g_socket_service_start(socket_service);
-	g_signal_connect(socket_service, "run", G_CALLBACK(jd_on_run), NULL);
 
 	main_loop = g_main_loop_new(NULL, FALSE);
 
@@ -375,9 +566,26 @@ main(int argc, char** argv)
 
 	g_socket_service_stop(socket_service);
 
+	if (local_socket_path != NULL)
+	{
+		jd_local_socket_remove(local_socket_path, &local_socket_stat);
+	}
+
+	if (opt_event_loops > 0)
+	{
+		jd_event_fini();
+	}
+
+	j_fabric_fini();
+
 	g_mutex_clear(jd_statistics_mutex);
 	j_statistics_free(jd_statistics);
 
+	if (jd_kv_backend != NULL || jd_db_backend != NULL)
+	{
+		jd_cursor_fini();
+	}
+
 	if (jd_db_backend != NULL)
 	{
 		j_backend_db_fini(jd_db_backend);
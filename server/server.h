@@ -34,6 +34,23 @@ G_GNUC_INTERNAL extern JBackend* jd_object_backend;
 G_GNUC_INTERNAL extern JBackend* jd_kv_backend;
 G_GNUC_INTERNAL extern JBackend* jd_db_backend;
 
+G_GNUC_INTERNAL void jd_statistics_merge(JStatistics*);
+
+G_GNUC_INTERNAL JMemoryChunk* jd_memory_chunk_new(guint64);
+G_GNUC_INTERNAL void jd_memory_chunk_free(JMemoryChunk*);
+
 G_GNUC_INTERNAL gboolean jd_handle_message(JMessage*, GSocketConnection*, JMemoryChunk*, guint64, JStatistics*);
 
+G_GNUC_INTERNAL void jd_cursor_init(void);
+G_GNUC_INTERNAL void jd_cursor_fini(void);
+G_GNUC_INTERNAL guint64 jd_cursor_open(JSemantics*, gchar const*, gchar const*, bson_t const*, guint32, bson_t*, GError**);
+G_GNUC_INTERNAL guint64 jd_cursor_fetch(guint64, bson_t*, GError**);
+G_GNUC_INTERNAL guint64 jd_cursor_open_kv(gchar const*, gchar const*, guint32, gboolean, GByteArray*, guint32*);
+G_GNUC_INTERNAL guint64 jd_cursor_fetch_kv(guint64, GByteArray*, guint32*);
+G_GNUC_INTERNAL void jd_cursor_close(guint64);
+
+G_GNUC_INTERNAL gboolean jd_event_init(guint, guint, guint64);
+G_GNUC_INTERNAL void jd_event_fini(void);
+G_GNUC_INTERNAL gboolean jd_event_add_connection(GSocketConnection*);
+
 #endif
@@ -0,0 +1,398 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2020 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <julea-config.h>
+
+#include <glib.h>
+#include <gmodule.h>
+
+#include <string.h>
+
+#ifdef HAVE_LMDB
+#include <lmdb.h>
+#endif
+
+#include <julea.h>
+
+#include "test.h"
+
+/*
+ * A small map makes sure that it has to be grown during the tests.
+ */
+#define TEST_LMDB_OPTIONS ":map-size=1"
+
+#define TEST_LMDB_VALUE_SIZE (64 * 1024)
+
+static gboolean
+test_lmdb_load(gchar const* path, gchar const* options, GModule** module, JBackend** backend)
+{
+	g_autofree gchar* backend_path = NULL;
+
+	backend_path = g_strconcat(path, options, NULL);
+
+	return test_backend_load("lmdb", J_BACKEND_TYPE_KV, backend_path, module, backend);
+}
+
+static void
+test_lmdb_unload(gchar* path, GModule* module, JBackend* backend)
+{
+	if (backend != NULL)
+	{
+		test_backend_unload(module, backend);
+	}
+
+	test_tmp_dir_remove(path);
+}
+
+static void
+test_lmdb_put_large(JBackend* backend, gchar const* namespace, guint n)
+{
+	g_autoptr(JSemantics) semantics = NULL;
+	g_autoptr(GPtrArray) keys = NULL;
+	g_autoptr(GPtrArray) values = NULL;
+	gpointer batch = NULL;
+
+	semantics = j_semantics_new(J_SEMANTICS_TEMPLATE_DEFAULT);
+	keys = g_ptr_array_new_with_free_func(g_free);
+	values = g_ptr_array_new_with_free_func(g_free);
+
+	g_assert_true(j_backend_kv_batch_start(backend, namespace, semantics, &batch));
+
+	// Keys and values have to stay valid until the batch has been executed
+	for (guint i = 0; i < n; i++)
+	{
+		gchar* key;
+		gchar* value;
+
+		key = g_strdup_printf("large-%03u", i);
+		g_ptr_array_add(keys, key);
+
+		value = g_malloc(TEST_LMDB_VALUE_SIZE);
+		memset(value, i, TEST_LMDB_VALUE_SIZE);
+		g_ptr_array_add(values, value);
+
+		g_assert_true(j_backend_kv_put(backend, batch, key, value, TEST_LMDB_VALUE_SIZE));
+	}
+
+	g_assert_true(j_backend_kv_batch_execute(backend, batch));
+}
+
+static void
+test_lmdb_grow(void)
+{
+	guint const n = 64;
+
+	g_autoptr(JSemantics) semantics = NULL;
+	GModule* module = NULL;
+	JBackend* backend = NULL;
+	gchar* path = NULL;
+	gpointer batch = NULL;
+
+	path = test_tmp_dir_new("lmdb");
+
+	if (!test_lmdb_load(path, TEST_LMDB_OPTIONS, &module, &backend))
+	{
+		test_lmdb_unload(path, module, backend);
+		return;
+	}
+
+	// The batch does not fit into the initial map, so it has to be replayed after growing it
+	test_lmdb_put_large(backend, "test", n);
+
+	semantics = j_semantics_new(J_SEMANTICS_TEMPLATE_DEFAULT);
+
+	g_assert_true(j_backend_kv_batch_start(backend, "test", semantics, &batch));
+
+	for (guint i = 0; i < n; i++)
+	{
+		g_autofree gchar* key = NULL;
+		g_autofree gpointer value = NULL;
+		guint32 len = 0;
+
+		key = g_strdup_printf("large-%03u", i);
+
+		g_assert_true(j_backend_kv_get(backend, batch, key, &value, &len));
+		g_assert_cmpuint(len, ==, TEST_LMDB_VALUE_SIZE);
+		g_assert_cmpuint(((guchar*)value)[0], ==, i);
+		g_assert_cmpuint(((guchar*)value)[len - 1], ==, i);
+	}
+
+	g_assert_true(j_backend_kv_batch_execute(backend, batch));
+
+	test_lmdb_unload(path, module, backend);
+}
+
+static void
+test_lmdb_append(void)
+{
+	guint const n = 10;
+
+	g_autoptr(JSemantics) semantics = NULL;
+	g_autoptr(GPtrArray) keys = NULL;
+	GModule* module = NULL;
+	JBackend* backend = NULL;
+	gchar* path = NULL;
+	gpointer batch = NULL;
+	gpointer iterator = NULL;
+	gchar const* key = NULL;
+	gconstpointer value = NULL;
+	guint32 len = 0;
+	guint count = 0;
+
+	path = test_tmp_dir_new("lmdb");
+
+	if (!test_lmdb_load(path, "", &module, &backend))
+	{
+		test_lmdb_unload(path, module, backend);
+		return;
+	}
+
+	semantics = j_semantics_new(J_SEMANTICS_TEMPLATE_DEFAULT);
+	keys = g_ptr_array_new_with_free_func(g_free);
+
+	g_assert_true(j_backend_kv_batch_start(backend, "test", semantics, &batch));
+
+	// Increasing keys are appended, the smaller ones afterwards have to fall back to regular puts
+	for (guint i = n; i < 2 * n; i++)
+	{
+		g_ptr_array_add(keys, g_strdup_printf("key-%03u", i));
+	}
+
+	for (guint i = 0; i < n; i++)
+	{
+		g_ptr_array_add(keys, g_strdup_printf("key-%03u", i));
+	}
+
+	// Existing keys must be overwritten
+	g_ptr_array_add(keys, g_strdup_printf("key-%03u", 2 * n - 1));
+
+	for (guint i = 0; i < keys->len; i++)
+	{
+		gchar const* k = g_ptr_array_index(keys, i);
+
+		g_assert_true(j_backend_kv_put(backend, batch, k, k, strlen(k) + 1));
+	}
+
+	g_assert_true(j_backend_kv_batch_execute(backend, batch));
+
+	g_assert_true(j_backend_kv_get_all(backend, "test", &iterator));
+
+	while (j_backend_kv_iterate(backend, iterator, &key, &value, &len))
+	{
+		g_autofree gchar* expected = NULL;
+
+		expected = g_strdup_printf("key-%03u", count);
+
+		g_assert_cmpstr(key, ==, expected);
+		g_assert_cmpstr(value, ==, expected);
+		g_assert_cmpuint(len, ==, strlen(expected) + 1);
+
+		count++;
+	}
+
+	g_assert_cmpuint(count, ==, 2 * n);
+
+	test_lmdb_unload(path, module, backend);
+}
+
+static void
+test_lmdb_iterate_grow(void)
+{
+	guint const n = 64;
+
+	gchar const* keys[] = { "a", "b", NULL };
+
+	GModule* module = NULL;
+	JBackend* backend = NULL;
+	gchar* path = NULL;
+	gpointer iterator = NULL;
+	gchar const* key = NULL;
+	gconstpointer value = NULL;
+	guint32 len = 0;
+	guint count = 0;
+
+	path = test_tmp_dir_new("lmdb");
+
+	if (!test_lmdb_load(path, TEST_LMDB_OPTIONS, &module, &backend))
+	{
+		test_lmdb_unload(path, module, backend);
+		return;
+	}
+
+	test_backend_kv_put_keys(backend, "iterate", keys);
+
+	g_assert_true(j_backend_kv_get_all(backend, "iterate", &iterator));
+	g_assert_true(j_backend_kv_iterate(backend, iterator, &key, &value, &len));
+	g_assert_cmpstr(key, ==, "a");
+
+	// Growing the map while an iterator is open must not block
+	test_lmdb_put_large(backend, "test", n);
+
+	// The current entry has to stay valid after the map has been grown
+	g_assert_cmpstr(key, ==, "a");
+	g_assert_cmpstr(value, ==, "a");
+	count++;
+
+	while (j_backend_kv_iterate(backend, iterator, &key, &value, &len))
+	{
+		g_assert_cmpstr(key, ==, "b");
+		g_assert_cmpstr(value, ==, "b");
+		count++;
+	}
+
+	g_assert_cmpuint(count, ==, 2);
+
+	test_lmdb_unload(path, module, backend);
+}
+
+static void
+test_lmdb_max_dbs(void)
+{
+	g_autoptr(JSemantics) semantics = NULL;
+	GModule* module = NULL;
+	JBackend* backend = NULL;
+	gchar* path = NULL;
+	gpointer batch = NULL;
+
+	path = test_tmp_dir_new("lmdb");
+
+	if (!test_lmdb_load(path, ":max-dbs=2", &module, &backend))
+	{
+		test_lmdb_unload(path, module, backend);
+		return;
+	}
+
+	semantics = j_semantics_new(J_SEMANTICS_TEMPLATE_DEFAULT);
+
+	g_assert_true(j_backend_kv_batch_start(backend, "test-1", semantics, &batch));
+	g_assert_true(j_backend_kv_batch_execute(backend, batch));
+	g_assert_true(j_backend_kv_batch_start(backend, "test-2", semantics, &batch));
+	g_assert_true(j_backend_kv_batch_execute(backend, batch));
+
+	g_test_expect_message("JULEA", G_LOG_LEVEL_CRITICAL, "*max-dbs*");
+	g_assert_false(j_backend_kv_batch_start(backend, "test-3", semantics, &batch));
+	g_test_assert_expected_messages();
+
+	test_lmdb_unload(path, module, backend);
+}
+
+#ifdef HAVE_LMDB
+static void
+test_lmdb_put_raw(MDB_txn* txn, MDB_dbi dbi, gchar const* key, gchar const* value)
+{
+	MDB_val m_key;
+	MDB_val m_value;
+
+	m_key.mv_size = strlen(key) + 1;
+	m_key.mv_data = (gpointer)key;
+	m_value.mv_size = strlen(value) + 1;
+	m_value.mv_data = (gpointer)value;
+
+	g_assert_cmpint(mdb_put(txn, dbi, &m_key, &m_value, 0), ==, 0);
+}
+
+static void
+test_lmdb_migrate(void)
+{
+	g_autoptr(JSemantics) semantics = NULL;
+	GModule* module = NULL;
+	JBackend* backend = NULL;
+	gchar* path = NULL;
+	MDB_env* env = NULL;
+	MDB_txn* txn = NULL;
+	MDB_dbi dbi;
+	gpointer batch = NULL;
+	gpointer iterator = NULL;
+	gpointer value = NULL;
+	gchar const* key = NULL;
+	gconstpointer iterate_value = NULL;
+	guint32 len = 0;
+	guint count = 0;
+
+	path = test_tmp_dir_new("lmdb");
+
+	// Create a database using the previous layout
+	g_assert_cmpint(mdb_env_create(&env), ==, 0);
+	g_assert_cmpint(mdb_env_open(env, path, 0, 0600), ==, 0);
+	g_assert_cmpint(mdb_txn_begin(env, NULL, 0, &txn), ==, 0);
+	g_assert_cmpint(mdb_dbi_open(txn, NULL, 0, &dbi), ==, 0);
+
+	test_lmdb_put_raw(txn, dbi, "test:a", "1");
+	test_lmdb_put_raw(txn, dbi, "test:b:c", "2");
+	test_lmdb_put_raw(txn, dbi, "other:a", "3");
+
+	g_assert_cmpint(mdb_txn_commit(txn), ==, 0);
+	mdb_env_close(env);
+
+	if (!test_lmdb_load(path, "", &module, &backend))
+	{
+		test_lmdb_unload(path, module, backend);
+		return;
+	}
+
+	semantics = j_semantics_new(J_SEMANTICS_TEMPLATE_DEFAULT);
+
+	g_assert_true(j_backend_kv_batch_start(backend, "test", semantics, &batch));
+
+	g_assert_true(j_backend_kv_get(backend, batch, "a", &value, &len));
+	g_assert_cmpstr(value, ==, "1");
+	g_clear_pointer(&value, g_free);
+
+	// Only the first colon separates the namespace from the key
+	g_assert_true(j_backend_kv_get(backend, batch, "b:c", &value, &len));
+	g_assert_cmpstr(value, ==, "2");
+	g_clear_pointer(&value, g_free);
+
+	g_assert_true(j_backend_kv_batch_execute(backend, batch));
+
+	g_assert_true(j_backend_kv_get_all(backend, "other", &iterator));
+
+	while (j_backend_kv_iterate(backend, iterator, &key, &iterate_value, &len))
+	{
+		g_assert_cmpstr(key, ==, "a");
+		g_assert_cmpstr(iterate_value, ==, "3");
+		count++;
+	}
+
+	g_assert_cmpuint(count, ==, 1);
+
+	// Migrating again must not change anything
+	test_backend_unload(module, backend);
+	g_assert_true(test_lmdb_load(path, "", &module, &backend));
+
+	g_assert_true(j_backend_kv_batch_start(backend, "test", semantics, &batch));
+	g_assert_true(j_backend_kv_get(backend, batch, "a", &value, &len));
+	g_assert_cmpstr(value, ==, "1");
+	g_clear_pointer(&value, g_free);
+	g_assert_true(j_backend_kv_batch_execute(backend, batch));
+
+	test_lmdb_unload(path, module, backend);
+}
+#endif
+
+void
+test_backend_kv_lmdb(void)
+{
+	g_test_add_func("/backend/kv/lmdb/grow", test_lmdb_grow);
+	g_test_add_func("/backend/kv/lmdb/append", test_lmdb_append);
+	g_test_add_func("/backend/kv/lmdb/iterate_grow", test_lmdb_iterate_grow);
+	g_test_add_func("/backend/kv/lmdb/max_dbs", test_lmdb_max_dbs);
+#ifdef HAVE_LMDB
+	g_test_add_func("/backend/kv/lmdb/migrate", test_lmdb_migrate);
+#endif
+}
@@ -0,0 +1,241 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2020 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <julea-config.h>
+
+#include <glib.h>
+#include <gmodule.h>
+
+#include <string.h>
+
+#ifdef HAVE_ROCKSDB
+#include <rocksdb/c.h>
+#endif
+
+#include <julea.h>
+
+#include "test.h"
+
+/*
+ * Enables all options, the prefix length is shorter than some of the prefixes used for iterating.
+ */
+#define TEST_ROCKSDB_OPTIONS ":block-cache=8:bloom-bits=10:write-buffer=4:background-jobs=2:prefix-length=4"
+
+static gchar*
+test_rocksdb_path(gchar const* dir)
+{
+	return g_build_filename(dir, "rocksdb", NULL);
+}
+
+static gboolean
+test_rocksdb_load(gchar const* dir, gchar const* options, GModule** module, JBackend** backend)
+{
+	g_autofree gchar* path = NULL;
+	g_autofree gchar* backend_path = NULL;
+
+	path = test_rocksdb_path(dir);
+	backend_path = g_strconcat(path, options, NULL);
+
+	return test_backend_load("rocksdb", J_BACKEND_TYPE_KV, backend_path, module, backend);
+}
+
+static void
+test_rocksdb_unload(gchar* dir, GModule* module, JBackend* backend)
+{
+	if (backend != NULL)
+	{
+		test_backend_unload(module, backend);
+	}
+
+	test_tmp_dir_remove(dir);
+}
+
+static void
+test_rocksdb_delete(void)
+{
+	gchar const* keys[] = { "a", NULL };
+
+	g_autoptr(JSemantics) semantics = NULL;
+	GModule* module = NULL;
+	JBackend* backend = NULL;
+	gchar* dir = NULL;
+	gpointer batch = NULL;
+
+	dir = test_tmp_dir_new("rocksdb");
+
+	if (!test_rocksdb_load(dir, "", &module, &backend))
+	{
+		test_rocksdb_unload(dir, module, backend);
+		return;
+	}
+
+	semantics = j_semantics_new(J_SEMANTICS_TEMPLATE_DEFAULT);
+
+	// The namespace's column family does not exist yet when the batch is started
+	g_assert_true(j_backend_kv_batch_start(backend, "test", semantics, &batch));
+
+	test_backend_kv_put_keys(backend, "test", keys);
+	g_assert_true(test_backend_kv_exists(backend, "test", "a"));
+
+	g_assert_true(j_backend_kv_delete(backend, batch, "a"));
+	g_assert_true(j_backend_kv_batch_execute(backend, batch));
+
+	g_assert_false(test_backend_kv_exists(backend, "test", "a"));
+
+	// Deleting from namespaces that have never been written to succeeds
+	g_assert_true(j_backend_kv_batch_start(backend, "empty", semantics, &batch));
+	g_assert_true(j_backend_kv_delete(backend, batch, "a"));
+	g_assert_true(j_backend_kv_batch_execute(backend, batch));
+
+	test_rocksdb_unload(dir, module, backend);
+}
+
+static void
+test_rocksdb_options(void)
+{
+	gchar const* keys[] = { "a", "abcd", "abcde", "abcdf", "abce", "b", NULL };
+	gchar const* other_keys[] = { "abcde", NULL };
+
+	GModule* module = NULL;
+	JBackend* backend = NULL;
+	gchar* dir = NULL;
+
+	dir = test_tmp_dir_new("rocksdb");
+
+	if (!test_rocksdb_load(dir, TEST_ROCKSDB_OPTIONS, &module, &backend))
+	{
+		test_rocksdb_unload(dir, module, backend);
+		return;
+	}
+
+	test_backend_kv_put_keys(backend, "test", keys);
+	test_backend_kv_put_keys(backend, "other", other_keys);
+
+	for (guint i = 0; keys[i] != NULL; i++)
+	{
+		g_assert_true(test_backend_kv_exists(backend, "test", keys[i]));
+	}
+
+	g_assert_false(test_backend_kv_exists(backend, "test", "c"));
+
+	// Prefixes shorter than the prefix length have to see all keys
+	g_assert_cmpuint(test_backend_kv_count_prefix(backend, "test", NULL), ==, 6);
+	g_assert_cmpuint(test_backend_kv_count_prefix(backend, "test", "a"), ==, 5);
+	g_assert_cmpuint(test_backend_kv_count_prefix(backend, "test", "abc"), ==, 4);
+
+	// Longer prefixes use the prefix bloom filters
+	g_assert_cmpuint(test_backend_kv_count_prefix(backend, "test", "abcd"), ==, 3);
+	g_assert_cmpuint(test_backend_kv_count_prefix(backend, "test", "abcde"), ==, 1);
+	g_assert_cmpuint(test_backend_kv_count_prefix(backend, "test", "abcg"), ==, 0);
+
+	// Namespaces are stored in separate column families
+	g_assert_cmpuint(test_backend_kv_count_prefix(backend, "other", NULL), ==, 1);
+	g_assert_cmpuint(test_backend_kv_count_prefix(backend, "missing", NULL), ==, 0);
+
+	// Column families have to be opened again
+	test_backend_unload(module, backend);
+	g_assert_true(test_rocksdb_load(dir, ":bloom-bits=0", &module, &backend));
+
+	g_assert_true(test_backend_kv_exists(backend, "test", "abcde"));
+	g_assert_true(test_backend_kv_exists(backend, "other", "abcde"));
+	g_assert_cmpuint(test_backend_kv_count_prefix(backend, "test", "abcd"), ==, 3);
+
+	test_rocksdb_unload(dir, module, backend);
+}
+
+#ifdef HAVE_ROCKSDB
+static void
+test_rocksdb_put_raw(rocksdb_t* db, rocksdb_writeoptions_t* write_options, gchar const* key, gchar const* value)
+{
+	g_autofree gchar* error = NULL;
+
+	rocksdb_put(db, write_options, key, strlen(key) + 1, value, strlen(value) + 1, &error);
+	g_assert_null(error);
+}
+
+static void
+test_rocksdb_migrate(void)
+{
+	gchar const* keys[] = { "c", NULL };
+
+	g_autofree gchar* path = NULL;
+	g_autofree gchar* error = NULL;
+	GModule* module = NULL;
+	JBackend* backend = NULL;
+	gchar* dir = NULL;
+	rocksdb_options_t* options;
+	rocksdb_writeoptions_t* write_options;
+	rocksdb_t* db;
+
+	dir = test_tmp_dir_new("rocksdb");
+
+	path = test_rocksdb_path(dir);
+
+	// Create a database using the previous layout
+	options = rocksdb_options_create();
+	rocksdb_options_set_create_if_missing(options, 1);
+	write_options = rocksdb_writeoptions_create();
+
+	db = rocksdb_open(options, path, &error);
+	g_assert_null(error);
+	g_assert_nonnull(db);
+
+	test_rocksdb_put_raw(db, write_options, "test:a", "a");
+	test_rocksdb_put_raw(db, write_options, "test:b:c", "b:c");
+	test_rocksdb_put_raw(db, write_options, "other:a", "a");
+
+	rocksdb_close(db);
+	rocksdb_writeoptions_destroy(write_options);
+	rocksdb_options_destroy(options);
+
+	if (!test_rocksdb_load(dir, "", &module, &backend))
+	{
+		test_rocksdb_unload(dir, module, backend);
+		return;
+	}
+
+	g_assert_true(test_backend_kv_exists(backend, "test", "a"));
+	// Only the first colon separates the namespace from the key
+	g_assert_true(test_backend_kv_exists(backend, "test", "b:c"));
+	g_assert_true(test_backend_kv_exists(backend, "other", "a"));
+
+	g_assert_cmpuint(test_backend_kv_count_prefix(backend, "test", NULL), ==, 2);
+	g_assert_cmpuint(test_backend_kv_count_prefix(backend, "other", NULL), ==, 1);
+
+	// New entries must not be migrated again
+	test_backend_kv_put_keys(backend, "test", keys);
+
+	test_backend_unload(module, backend);
+	g_assert_true(test_rocksdb_load(dir, "", &module, &backend));
+
+	g_assert_cmpuint(test_backend_kv_count_prefix(backend, "test", NULL), ==, 3);
+	g_assert_cmpuint(test_backend_kv_count_prefix(backend, "other", NULL), ==, 1);
+
+	test_rocksdb_unload(dir, module, backend);
+}
+#endif
+
+void
+test_backend_kv_rocksdb(void)
+{
+	g_test_add_func("/backend/kv/rocksdb/delete", test_rocksdb_delete);
+	g_test_add_func("/backend/kv/rocksdb/options", test_rocksdb_options);
+#ifdef HAVE_ROCKSDB
+	g_test_add_func("/backend/kv/rocksdb/migrate", test_rocksdb_migrate);
+#endif
+}
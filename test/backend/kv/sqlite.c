@@ -0,0 +1,275 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2020 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <julea-config.h>
+
+#include <glib.h>
+#include <gmodule.h>
+
+#ifdef HAVE_SQLITE
+#include <sqlite3.h>
+#endif
+
+#include <julea.h>
+
+#include "test.h"
+
+#define TEST_SQLITE_THREADS 4
+
+static gchar*
+test_sqlite_path(gchar const* dir)
+{
+	return g_build_filename(dir, "kv.db", NULL);
+}
+
+static gboolean
+test_sqlite_load(gchar const* dir, GModule** module, JBackend** backend)
+{
+	g_autofree gchar* path = NULL;
+
+	path = test_sqlite_path(dir);
+
+	return test_backend_load("sqlite", J_BACKEND_TYPE_KV, path, module, backend);
+}
+
+static void
+test_sqlite_unload(gchar* dir, GModule* module, JBackend* backend)
+{
+	if (backend != NULL)
+	{
+		test_backend_unload(module, backend);
+	}
+
+	test_tmp_dir_remove(dir);
+}
+
+static void
+test_sqlite_prefix(void)
+{
+	gchar const* keys[] = { "a", "a%", "a%b", "a_", "a_b", "ab", "axb", "a\xc3\xa4", "b", NULL };
+	gchar const* other_keys[] = { "a%c", NULL };
+
+	GModule* module = NULL;
+	JBackend* backend = NULL;
+	gchar* dir = NULL;
+
+	dir = test_tmp_dir_new("sqlite");
+
+	if (!test_sqlite_load(dir, &module, &backend))
+	{
+		test_sqlite_unload(dir, module, backend);
+		return;
+	}
+
+	test_backend_kv_put_keys(backend, "test", keys);
+	test_backend_kv_put_keys(backend, "other", other_keys);
+
+	// Prefixes must not be treated as patterns
+	g_assert_cmpuint(test_backend_kv_count_prefix(backend, "test", "a%"), ==, 2);
+	g_assert_cmpuint(test_backend_kv_count_prefix(backend, "test", "a_"), ==, 2);
+	g_assert_cmpuint(test_backend_kv_count_prefix(backend, "test", "a%b"), ==, 1);
+
+	// Keys containing multi-byte characters are still smaller than the upper bound
+	g_assert_cmpuint(test_backend_kv_count_prefix(backend, "test", "a"), ==, 8);
+
+	g_assert_cmpuint(test_backend_kv_count_prefix(backend, "test", "c"), ==, 0);
+	g_assert_cmpuint(test_backend_kv_count_prefix(backend, "other", "a%"), ==, 1);
+
+	test_sqlite_unload(dir, module, backend);
+}
+
+struct TestSQLiteThreadData
+{
+	JBackend* backend;
+	guint index;
+};
+
+typedef struct TestSQLiteThreadData TestSQLiteThreadData;
+
+static gpointer
+test_sqlite_threads_thread(gpointer data)
+{
+	TestSQLiteThreadData* thread_data = data;
+	g_autoptr(JSemantics) semantics = NULL;
+	g_autofree gchar* namespace = NULL;
+
+	semantics = j_semantics_new(J_SEMANTICS_TEMPLATE_DEFAULT);
+	namespace = g_strdup_printf("thread-%u", thread_data->index);
+
+	// Each batch uses the thread's connection and its cached statements
+	for (guint i = 0; i < 100; i++)
+	{
+		g_autofree gchar* key = NULL;
+		g_autofree gpointer value = NULL;
+		gpointer batch = NULL;
+		guint32 len = 0;
+
+		key = g_strdup_printf("key-%u", i);
+
+		g_assert_true(j_backend_kv_batch_start(thread_data->backend, namespace, semantics, &batch));
+		g_assert_true(j_backend_kv_put(thread_data->backend, batch, key, &i, sizeof(i)));
+		g_assert_true(j_backend_kv_batch_execute(thread_data->backend, batch));
+
+		g_assert_true(j_backend_kv_batch_start(thread_data->backend, namespace, semantics, &batch));
+		g_assert_true(j_backend_kv_get(thread_data->backend, batch, key, &value, &len));
+		g_assert_cmpuint(len, ==, sizeof(i));
+		g_assert_cmpuint(*(guint*)value, ==, i);
+		g_assert_true(j_backend_kv_batch_execute(thread_data->backend, batch));
+
+		// The server uses separate batches for reads and writes
+		if (i % 2 == 0)
+		{
+			g_assert_true(j_backend_kv_batch_start(thread_data->backend, namespace, semantics, &batch));
+			g_assert_true(j_backend_kv_delete(thread_data->backend, batch, key));
+			g_assert_true(j_backend_kv_batch_execute(thread_data->backend, batch));
+		}
+	}
+
+	return NULL;
+}
+
+static void
+test_sqlite_threads(void)
+{
+	guint const n = TEST_SQLITE_THREADS;
+
+	g_autoptr(JSemantics) semantics = NULL;
+	GModule* module = NULL;
+	JBackend* backend = NULL;
+	gchar* dir = NULL;
+	GThread* threads[TEST_SQLITE_THREADS];
+	TestSQLiteThreadData thread_data[TEST_SQLITE_THREADS];
+
+	dir = test_tmp_dir_new("sqlite");
+
+	if (!test_sqlite_load(dir, &module, &backend))
+	{
+		test_sqlite_unload(dir, module, backend);
+		return;
+	}
+
+	for (guint i = 0; i < n; i++)
+	{
+		thread_data[i].backend = backend;
+		thread_data[i].index = i;
+		threads[i] = g_thread_new("test-sqlite", test_sqlite_threads_thread, &thread_data[i]);
+	}
+
+	for (guint i = 0; i < n; i++)
+	{
+		g_thread_join(threads[i]);
+	}
+
+	semantics = j_semantics_new(J_SEMANTICS_TEMPLATE_DEFAULT);
+
+	// Changes made using other threads' connections have to be visible
+	for (guint i = 0; i < n; i++)
+	{
+		g_autofree gchar* namespace = NULL;
+		gpointer batch = NULL;
+
+		namespace = g_strdup_printf("thread-%u", i);
+
+		g_assert_true(j_backend_kv_batch_start(backend, namespace, semantics, &batch));
+
+		for (guint j = 0; j < 100; j++)
+		{
+			g_autofree gchar* key = NULL;
+			g_autofree gpointer value = NULL;
+			guint32 len = 0;
+
+			key = g_strdup_printf("key-%u", j);
+
+			g_assert_true(j_backend_kv_get(backend, batch, key, &value, &len) == (j % 2 == 1));
+		}
+
+		g_assert_true(j_backend_kv_batch_execute(backend, batch));
+	}
+
+	test_sqlite_unload(dir, module, backend);
+}
+
+#ifdef HAVE_SQLITE
+static void
+test_sqlite_migrate(void)
+{
+	g_autoptr(JSemantics) semantics = NULL;
+	g_autofree gchar* path = NULL;
+	GModule* module = NULL;
+	JBackend* backend = NULL;
+	gchar* dir = NULL;
+	sqlite3* db = NULL;
+	sqlite3_stmt* stmt = NULL;
+	gpointer batch = NULL;
+	gpointer value = NULL;
+	guint32 len = 0;
+
+	dir = test_tmp_dir_new("sqlite");
+
+	path = test_sqlite_path(dir);
+
+	// Create a database using the previous table
+	g_assert_cmpint(sqlite3_open(path, &db), ==, SQLITE_OK);
+	g_assert_cmpint(sqlite3_exec(db,
+				     "CREATE TABLE julea (namespace TEXT NOT NULL, key TEXT NOT NULL, value BLOB NOT NULL);"
+				     "INSERT INTO julea (namespace, key, value) VALUES ('test', 'a', x'3100');"
+				     "INSERT INTO julea (namespace, key, value) VALUES ('other', 'a', x'3200');",
+				     NULL, NULL, NULL),
+			==, SQLITE_OK);
+	sqlite3_close(db);
+
+	if (!test_sqlite_load(dir, &module, &backend))
+	{
+		test_sqlite_unload(dir, module, backend);
+		return;
+	}
+
+	semantics = j_semantics_new(J_SEMANTICS_TEMPLATE_DEFAULT);
+
+	g_assert_true(j_backend_kv_batch_start(backend, "test", semantics, &batch));
+	g_assert_true(j_backend_kv_get(backend, batch, "a", &value, &len));
+	g_assert_cmpstr(value, ==, "1");
+	g_clear_pointer(&value, g_free);
+	g_assert_true(j_backend_kv_batch_execute(backend, batch));
+
+	g_assert_true(j_backend_kv_batch_start(backend, "other", semantics, &batch));
+	g_assert_true(j_backend_kv_get(backend, batch, "a", &value, &len));
+	g_assert_cmpstr(value, ==, "2");
+	g_clear_pointer(&value, g_free);
+	g_assert_true(j_backend_kv_batch_execute(backend, batch));
+
+	// The previous table has to be removed
+	g_assert_cmpint(sqlite3_open(path, &db), ==, SQLITE_OK);
+	g_assert_cmpint(sqlite3_prepare_v2(db, "SELECT name FROM sqlite_master WHERE type = 'table' AND name = 'julea';", -1, &stmt, NULL), ==, SQLITE_OK);
+	g_assert_cmpint(sqlite3_step(stmt), ==, SQLITE_DONE);
+	sqlite3_finalize(stmt);
+	sqlite3_close(db);
+
+	test_sqlite_unload(dir, module, backend);
+}
+#endif
+
+void
+test_backend_kv_sqlite(void)
+{
+	g_test_add_func("/backend/kv/sqlite/prefix", test_sqlite_prefix);
+	g_test_add_func("/backend/kv/sqlite/threads", test_sqlite_threads);
+#ifdef HAVE_SQLITE
+	g_test_add_func("/backend/kv/sqlite/migrate", test_sqlite_migrate);
+#endif
+}
@@ -0,0 +1,274 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2010-2020 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <julea-config.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <gmodule.h>
+
+#include <julea.h>
+
+#include "test.h"
+
+/*
+ * A small limit makes sure that objects are evicted from the handle cache during the tests.
+ */
+#define TEST_POSIX_OPTIONS ":max-fds=16"
+
+#define TEST_POSIX_THREADS 4
+
+static gboolean
+test_posix_load(gchar** path, GModule** module, JBackend** backend)
+{
+	g_autofree gchar* backend_path = NULL;
+
+	*path = g_dir_make_tmp("julea-test-posix-XXXXXX", NULL);
+	g_assert_nonnull(*path);
+
+	backend_path = g_strconcat(*path, TEST_POSIX_OPTIONS, NULL);
+
+	return test_backend_load("posix", J_BACKEND_TYPE_OBJECT, backend_path, module, backend);
+}
+
+static void
+test_posix_unload(gchar* path, GModule* module, JBackend* backend)
+{
+	g_autofree gchar* namespace_path = NULL;
+
+	if (backend != NULL)
+	{
+		test_backend_unload(module, backend);
+	}
+
+	namespace_path = g_build_filename(path, "test", NULL);
+	g_rmdir(namespace_path);
+	g_rmdir(path);
+
+	g_free(path);
+}
+
+static void
+test_posix_cache(void)
+{
+	GModule* module = NULL;
+	JBackend* backend = NULL;
+	gchar* path = NULL;
+	gpointer object1 = NULL;
+	gpointer object2 = NULL;
+	gchar buffer[4] = { 0 };
+	guint64 nbytes = 0;
+
+	if (!test_posix_load(&path, &module, &backend))
+	{
+		test_posix_unload(path, module, backend);
+		return;
+	}
+
+	g_assert_true(j_backend_object_create(backend, "test", "cache", &object1));
+	g_assert_true(j_backend_object_write(backend, object1, "abc", 3, 0, &nbytes));
+	g_assert_cmpuint(nbytes, ==, 3);
+
+	// Concurrent users share the same handle
+	g_assert_true(j_backend_object_open(backend, "test", "cache", &object2));
+	g_assert_true(object1 == object2);
+
+	g_assert_true(j_backend_object_close(backend, object1));
+
+	g_assert_true(j_backend_object_read(backend, object2, buffer, 3, 0, &nbytes));
+	g_assert_cmpuint(nbytes, ==, 3);
+	g_assert_cmpstr(buffer, ==, "abc");
+
+	g_assert_true(j_backend_object_close(backend, object2));
+
+	// Objects without users stay open
+	g_assert_true(j_backend_object_open(backend, "test", "cache", &object2));
+	g_assert_true(object1 == object2);
+	g_assert_true(j_backend_object_delete(backend, object2));
+
+	test_posix_unload(path, module, backend);
+}
+
+static void
+test_posix_evict(void)
+{
+	guint const n = 100;
+
+	GModule* module = NULL;
+	JBackend* backend = NULL;
+	gchar* path = NULL;
+
+	if (!test_posix_load(&path, &module, &backend))
+	{
+		test_posix_unload(path, module, backend);
+		return;
+	}
+
+	for (guint i = 0; i < n; i++)
+	{
+		g_autofree gchar* name = NULL;
+		gpointer object = NULL;
+		guint64 nbytes = 0;
+
+		name = g_strdup_printf("evict-%u", i);
+
+		g_assert_true(j_backend_object_create(backend, "test", name, &object));
+		g_assert_true(j_backend_object_write(backend, object, &i, sizeof(i), 0, &nbytes));
+		g_assert_true(j_backend_object_close(backend, object));
+	}
+
+	// Evicted objects have to be reopened transparently
+	for (guint i = 0; i < n; i++)
+	{
+		g_autofree gchar* name = NULL;
+		gpointer object = NULL;
+		guint64 nbytes = 0;
+		guint value = 0;
+
+		name = g_strdup_printf("evict-%u", i);
+
+		g_assert_true(j_backend_object_open(backend, "test", name, &object));
+		g_assert_true(j_backend_object_read(backend, object, &value, sizeof(value), 0, &nbytes));
+		g_assert_cmpuint(nbytes, ==, sizeof(value));
+		g_assert_cmpuint(value, ==, i);
+		g_assert_true(j_backend_object_delete(backend, object));
+	}
+
+	test_posix_unload(path, module, backend);
+}
+
+static void
+test_posix_delete(void)
+{
+	GModule* module = NULL;
+	JBackend* backend = NULL;
+	gchar* path = NULL;
+	gpointer object1 = NULL;
+	gpointer object2 = NULL;
+	guint64 nbytes = 0;
+
+	if (!test_posix_load(&path, &module, &backend))
+	{
+		test_posix_unload(path, module, backend);
+		return;
+	}
+
+	g_assert_true(j_backend_object_create(backend, "test", "delete", &object1));
+	g_assert_true(j_backend_object_open(backend, "test", "delete", &object2));
+	g_assert_true(j_backend_object_delete(backend, object2));
+
+	// Other users can still access the deleted object
+	g_assert_true(j_backend_object_write(backend, object1, "abc", 3, 0, &nbytes));
+	g_assert_cmpuint(nbytes, ==, 3);
+
+	// The deleted object must not be found in the cache anymore
+	g_assert_false(j_backend_object_open(backend, "test", "delete", &object2));
+	j_backend_object_close(backend, object2);
+
+	g_assert_true(j_backend_object_close(backend, object1));
+
+	g_assert_false(j_backend_object_open(backend, "test", "delete", &object2));
+	j_backend_object_close(backend, object2);
+
+	test_posix_unload(path, module, backend);
+}
+
+struct TestPosixThreadData
+{
+	JBackend* backend;
+	gboolean delete;
+};
+
+typedef struct TestPosixThreadData TestPosixThreadData;
+
+static gpointer
+test_posix_concurrent_thread(gpointer data)
+{
+	TestPosixThreadData* thread_data = data;
+
+	for (guint i = 0; i < 1000; i++)
+	{
+		gpointer object = NULL;
+
+		if (thread_data->delete)
+		{
+			if (j_backend_object_create(thread_data->backend, "test", "concurrent", &object))
+			{
+				j_backend_object_delete(thread_data->backend, object);
+			}
+			else
+			{
+				j_backend_object_close(thread_data->backend, object);
+			}
+		}
+		else
+		{
+			j_backend_object_open(thread_data->backend, "test", "concurrent", &object);
+			j_backend_object_close(thread_data->backend, object);
+		}
+	}
+
+	return NULL;
+}
+
+static void
+test_posix_concurrent(void)
+{
+	guint const n = TEST_POSIX_THREADS;
+
+	GModule* module = NULL;
+	JBackend* backend = NULL;
+	gchar* path = NULL;
+	GThread* threads[TEST_POSIX_THREADS];
+	TestPosixThreadData thread_data[TEST_POSIX_THREADS];
+	gpointer object = NULL;
+
+	if (!test_posix_load(&path, &module, &backend))
+	{
+		test_posix_unload(path, module, backend);
+		return;
+	}
+
+	// Half of the threads create and delete the object, the other half opens it
+	for (guint i = 0; i < n; i++)
+	{
+		thread_data[i].backend = backend;
+		thread_data[i].delete = (i % 2 == 0);
+		threads[i] = g_thread_new("test-posix", test_posix_concurrent_thread, &thread_data[i]);
+	}
+
+	for (guint i = 0; i < n; i++)
+	{
+		g_thread_join(threads[i]);
+	}
+
+	// Every create has been followed by a delete, so no file descriptor for the object may have been cached
+	g_assert_false(j_backend_object_open(backend, "test", "concurrent", &object));
+	j_backend_object_close(backend, object);
+
+	test_posix_unload(path, module, backend);
+}
+
+void
+test_backend_object_posix(void)
+{
+	g_test_add_func("/backend/object/posix/cache", test_posix_cache);
+	g_test_add_func("/backend/object/posix/evict", test_posix_evict);
+	g_test_add_func("/backend/object/posix/delete", test_posix_delete);
+	g_test_add_func("/backend/object/posix/concurrent", test_posix_concurrent);
+}
@@ -20,13 +20,22 @@
 
 #include <glib.h>
 
+#include <string.h>
+
 #include <julea.h>
 #include <julea-item.h>
+#include <julea-kv.h>
+#include <julea-object.h>
 
 #include "test.h"
 
 static gint test_batch_flag;
 
+static GMutex test_batch_log_mutex;
+static GString* test_batch_log = NULL;
+static gint test_batch_running = 0;
+static gint test_batch_running_max = 0;
+
 static void
 on_operation_completed(JBatch* batch, gboolean ret, gpointer user_data)
 {
@@ -37,6 +46,70 @@ on_operation_completed(JBatch* batch, gboolean ret, gpointer user_data)
 	g_atomic_int_set(&test_batch_flag, 1);
 }
 
+/**
+ * Logs the key and the number of operations of each execution, chains might be executed concurrently.
+ **/
+static gboolean
+test_batch_log_exec(gchar type, JList* operations)
+{
+	gchar const* key = j_list_get_first(operations);
+	gint running;
+
+	running = g_atomic_int_add(&test_batch_running, 1) + 1;
+
+	g_mutex_lock(&test_batch_log_mutex);
+	g_string_append_printf(test_batch_log, "%s:%c%u;", key, type, j_list_length(operations));
+	test_batch_running_max = MAX(test_batch_running_max, running);
+	g_mutex_unlock(&test_batch_log_mutex);
+
+	// Give concurrently executed chains a chance to overlap
+	g_usleep(G_USEC_PER_SEC / 100);
+
+	g_atomic_int_add(&test_batch_running, -1);
+
+	return TRUE;
+}
+
+static gboolean
+test_batch_exec_a(JList* operations, JSemantics* semantics)
+{
+	(void)semantics;
+
+	return test_batch_log_exec('a', operations);
+}
+
+static gboolean
+test_batch_exec_b(JList* operations, JSemantics* semantics)
+{
+	(void)semantics;
+
+	return test_batch_log_exec('b', operations);
+}
+
+static void
+test_batch_add_logged(JBatch* batch, gchar const* key, JOperationExecFunc exec_func)
+{
+	JOperation* operation;
+
+	operation = j_operation_new();
+	operation->key = key;
+	operation->data = (gpointer)key;
+	operation->exec_func = exec_func;
+
+	j_batch_add(batch, operation);
+}
+
+static JBatch*
+test_batch_new_for_ordering(JSemanticsOrdering ordering)
+{
+	g_autoptr(JSemantics) semantics = NULL;
+
+	semantics = j_semantics_new(J_SEMANTICS_TEMPLATE_DEFAULT);
+	j_semantics_set(semantics, J_SEMANTICS_ORDERING, ordering);
+
+	return j_batch_new(semantics);
+}
+
 static void
 test_batch_new_free(void)
 {
@@ -115,6 +188,257 @@ test_batch_execute_async(void)
 	_test_batch_execute(TRUE);
 }
 
+static void
+test_batch_execute_queue(void)
+{
+	g_autoptr(JBatchQueue) queue = NULL;
+	JBatch* batch;
+	guint n = 0;
+	gboolean ret;
+
+	queue = j_batch_queue_new();
+
+	g_assert_null(j_batch_queue_wait(queue, &ret));
+
+	for (guint i = 0; i < 10; i++)
+	{
+		g_autoptr(JCollection) collection = NULL;
+		g_autofree gchar* name = NULL;
+
+		batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+		name = g_strdup_printf("test-queue-%u", i);
+
+		collection = j_collection_create(name, batch);
+		j_collection_delete(collection, batch);
+
+		j_batch_execute_queue(batch, queue);
+		j_batch_unref(batch);
+	}
+
+	while ((batch = j_batch_queue_wait(queue, &ret)) != NULL)
+	{
+		g_assert_true(ret);
+		j_batch_unref(batch);
+		n++;
+	}
+
+	g_assert_cmpuint(n, ==, 10);
+	g_assert_cmpuint(j_batch_queue_get_pending(queue), ==, 0);
+	g_assert_null(j_batch_queue_poll(queue, &ret));
+}
+
+static gpointer
+test_batch_queue_waiter(gpointer data)
+{
+	JBatchQueue* queue = data;
+	JBatch* batch;
+	guint n = 0;
+	gboolean ret;
+
+	while ((batch = j_batch_queue_wait(queue, &ret)) != NULL)
+	{
+		g_assert_true(ret);
+		j_batch_unref(batch);
+		n++;
+	}
+
+	return GUINT_TO_POINTER(n);
+}
+
+static void
+test_batch_execute_queue_waiters(void)
+{
+	g_autoptr(JBatchQueue) queue = NULL;
+	GThread* threads[4];
+	guint n = 0;
+
+	queue = j_batch_queue_new();
+
+	for (guint i = 0; i < 10; i++)
+	{
+		g_autoptr(JBatch) batch = NULL;
+		g_autoptr(JCollection) collection = NULL;
+		g_autofree gchar* name = NULL;
+
+		batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+		name = g_strdup_printf("test-queue-waiters-%u", i);
+
+		collection = j_collection_create(name, batch);
+		j_collection_delete(collection, batch);
+
+		j_batch_execute_queue(batch, queue);
+	}
+
+	// Waiters racing for the last batches must not block forever
+	for (guint i = 0; i < G_N_ELEMENTS(threads); i++)
+	{
+		threads[i] = g_thread_new("test-batch-queue-waiter", test_batch_queue_waiter, queue);
+	}
+
+	for (guint i = 0; i < G_N_ELEMENTS(threads); i++)
+	{
+		n += GPOINTER_TO_UINT(g_thread_join(threads[i]));
+	}
+
+	g_assert_cmpuint(n, ==, 10);
+	g_assert_cmpuint(j_batch_queue_get_pending(queue), ==, 0);
+}
+
+static void
+test_batch_execute_relaxed(void)
+{
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JSemantics) semantics = NULL;
+	g_autoptr(JKV) kv1 = NULL;
+	g_autoptr(JKV) kv2 = NULL;
+	g_autoptr(JObject) object = NULL;
+	gchar buf[5] = "1234";
+	gchar out[5] = { 0 };
+	gpointer value = NULL;
+	guint32 value_len = 0;
+	guint64 bytes_written = 0;
+	guint64 bytes_read = 0;
+	gboolean ret;
+
+	semantics = j_semantics_new(J_SEMANTICS_TEMPLATE_DEFAULT);
+	j_semantics_set(semantics, J_SEMANTICS_ORDERING, J_SEMANTICS_ORDERING_RELAXED);
+	batch = j_batch_new(semantics);
+
+	kv1 = j_kv_new_for_index(0, "test", "test-batch-relaxed-1");
+	kv2 = j_kv_new_for_index(0, "test", "test-batch-relaxed-2");
+	object = j_object_new("test", "test-batch-relaxed");
+
+	// Operations with different keys are independent and can be reordered.
+	j_kv_put(kv1, g_strdup("1"), 2, g_free, batch);
+	j_object_create(object, batch);
+	j_kv_put(kv2, g_strdup("2"), 2, g_free, batch);
+	j_object_write(object, buf, 4, 0, &bytes_written, batch);
+	j_kv_get(kv1, &value, &value_len, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(bytes_written, ==, 4);
+	g_assert_cmpuint(value_len, ==, 2);
+	g_assert_cmpstr(value, ==, "1");
+
+	j_object_read(object, out, 4, 0, &bytes_read, batch);
+	j_object_delete(object, batch);
+	j_kv_delete(kv1, batch);
+	j_kv_delete(kv2, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(bytes_read, ==, 4);
+	g_assert_cmpstr(out, ==, "1234");
+
+	g_free(value);
+}
+
+static void
+test_batch_execute_relaxed_handles(void)
+{
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JObject) object1 = NULL;
+	g_autoptr(JObject) object2 = NULL;
+	gint64 modification_time = 0;
+	guint64 size = 0;
+	gboolean ret;
+
+	batch = test_batch_new_for_ordering(J_SEMANTICS_ORDERING_RELAXED);
+
+	object1 = j_object_new("test", "test-batch-relaxed-handles");
+	object2 = j_object_new("test", "test-batch-relaxed-handles");
+
+	// Both handles refer to the same object, so the second create must not be merged with the first one.
+	j_object_create(object1, batch);
+	j_object_delete(object2, batch);
+	j_object_create(object1, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	j_object_status(object2, &modification_time, &size, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	j_object_delete(object2, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
+static void
+test_batch_plan_relaxed(void)
+{
+	g_autoptr(JBatch) batch = NULL;
+	g_autofree gchar* key = NULL;
+	gboolean ret;
+
+	batch = test_batch_new_for_ordering(J_SEMANTICS_ORDERING_RELAXED);
+	// Keys are compared by value
+	key = g_strdup("x");
+
+	test_batch_log = g_string_new(NULL);
+
+	// Independent operations of the same type are merged
+	test_batch_add_logged(batch, "x", test_batch_exec_a);
+	test_batch_add_logged(batch, "y", test_batch_exec_a);
+	test_batch_add_logged(batch, key, test_batch_exec_a);
+	test_batch_add_logged(batch, "y", test_batch_exec_a);
+	test_batch_add_logged(batch, "x", test_batch_exec_a);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_nonnull(strstr(test_batch_log->str, "x:a3;"));
+	g_assert_nonnull(strstr(test_batch_log->str, "y:a2;"));
+	g_assert_cmpuint(test_batch_log->len, ==, strlen("x:a3;y:a2;"));
+
+	g_string_truncate(test_batch_log, 0);
+
+	// Dependent operations of different types keep their order
+	test_batch_add_logged(batch, "x", test_batch_exec_a);
+	test_batch_add_logged(batch, "x", test_batch_exec_b);
+	test_batch_add_logged(batch, "x", test_batch_exec_a);
+	test_batch_add_logged(batch, "x", test_batch_exec_b);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpstr(test_batch_log->str, ==, "x:a1;x:b1;x:a1;x:b1;");
+
+	g_string_free(test_batch_log, TRUE);
+	test_batch_log = NULL;
+}
+
+static void
+test_batch_plan_semi_relaxed(void)
+{
+	g_autoptr(JBatch) batch = NULL;
+	gboolean ret;
+
+	batch = test_batch_new_for_ordering(J_SEMANTICS_ORDERING_SEMI_RELAXED);
+
+	test_batch_log = g_string_new(NULL);
+	test_batch_running_max = 0;
+
+	// Only adjacent operations are merged
+	test_batch_add_logged(batch, "x", test_batch_exec_a);
+	test_batch_add_logged(batch, "x", test_batch_exec_a);
+	test_batch_add_logged(batch, "y", test_batch_exec_a);
+	test_batch_add_logged(batch, "x", test_batch_exec_a);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpstr(test_batch_log->str, ==, "x:a2;y:a1;x:a1;");
+
+	g_string_truncate(test_batch_log, 0);
+
+	// Operations with different keys are not executed concurrently
+	for (guint i = 0; i < 8; i++)
+	{
+		test_batch_add_logged(batch, (i % 2 == 0) ? "x" : "y", test_batch_exec_a);
+	}
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpint(test_batch_running_max, ==, 1);
+
+	g_string_free(test_batch_log, TRUE);
+	test_batch_log = NULL;
+}
+
 void
 test_core_batch(void)
 {
@@ -122,4 +446,10 @@ test_core_batch(void)
 	g_test_add_func("/core/batch/semantics", test_batch_semantics);
 	g_test_add_func("/core/batch/execute", test_batch_execute);
 	g_test_add_func("/core/batch/execute_async", test_batch_execute_async);
+	g_test_add_func("/core/batch/execute_queue", test_batch_execute_queue);
+	g_test_add_func("/core/batch/execute_queue_waiters", test_batch_execute_queue_waiters);
+	g_test_add_func("/core/batch/execute_relaxed", test_batch_execute_relaxed);
+	g_test_add_func("/core/batch/execute_relaxed_handles", test_batch_execute_relaxed_handles);
+	g_test_add_func("/core/batch/plan_relaxed", test_batch_plan_relaxed);
+	g_test_add_func("/core/batch/plan_semi_relaxed", test_batch_plan_semi_relaxed);
 }
@@ -0,0 +1,84 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2010-2020 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <julea.h>
+
+#include "test.h"
+
+static void
+test_connection_pool_pop_push(void)
+{
+	JStatistics* statistics;
+	gpointer connection;
+	gpointer reused;
+	guint64 created;
+
+	connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, 0);
+	g_assert_nonnull(connection);
+
+	j_connection_pool_push(J_BACKEND_TYPE_OBJECT, 0, connection);
+
+	statistics = j_connection_pool_get_statistics(J_BACKEND_TYPE_OBJECT, 0);
+	created = j_statistics_get(statistics, J_STATISTICS_CONNECTIONS_CREATED);
+	g_assert_cmpuint(created, >=, 1);
+	j_statistics_free(statistics);
+
+	// Idle connections are reused instead of establishing new ones
+	reused = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, 0);
+	g_assert_nonnull(reused);
+	j_connection_pool_push(J_BACKEND_TYPE_OBJECT, 0, reused);
+
+	statistics = j_connection_pool_get_statistics(J_BACKEND_TYPE_OBJECT, 0);
+	g_assert_cmpuint(j_statistics_get(statistics, J_STATISTICS_CONNECTIONS_CREATED), ==, created);
+	j_statistics_free(statistics);
+}
+
+static void
+test_connection_pool_send_receive(void)
+{
+	gchar get_all = 0;
+
+	// Requests have to succeed regardless of whether connections are pooled or multiplexed
+	for (guint i = 0; i < 2; i++)
+	{
+		g_autoptr(JMessage) message = NULL;
+		g_autoptr(JMessage) reply = NULL;
+		gboolean ret;
+
+		message = j_message_new(J_MESSAGE_STATISTICS, sizeof(gchar));
+		j_message_add_operation(message, 0);
+		j_message_append_1(message, &get_all);
+
+		reply = j_message_new_reply(message);
+		ret = j_connection_pool_send_receive(J_BACKEND_TYPE_OBJECT, 0, message, reply);
+
+		g_assert_true(ret);
+		g_assert_cmpuint(j_message_get_count(reply), ==, 1);
+	}
+}
+
+void
+test_core_connection_pool(void)
+{
+	g_test_add_func("/core/connection-pool/pop_push", test_connection_pool_pop_push);
+	g_test_add_func("/core/connection-pool/send_receive", test_connection_pool_send_receive);
+}
@@ -0,0 +1,197 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2020 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <julea-config.h>
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <string.h>
+
+#include <julea.h>
+
+#include <jfabric.h>
+#include <jmessage.h>
+
+#include "test.h"
+
+// Messages have to be sent to be able to read what has been appended
+static JMessage*
+test_fabric_transmit(JMessage* message)
+{
+	g_autoptr(GOutputStream) output = NULL;
+	g_autoptr(GInputStream) input = NULL;
+	JMessage* received;
+
+	output = g_memory_output_stream_new(NULL, 0, g_realloc, g_free);
+	input = g_memory_input_stream_new();
+
+	g_assert_true(j_message_write(message, output));
+
+	g_memory_input_stream_add_data(
+		G_MEMORY_INPUT_STREAM(input),
+		g_memory_output_stream_get_data(G_MEMORY_OUTPUT_STREAM(output)),
+		g_memory_output_stream_get_data_size(G_MEMORY_OUTPUT_STREAM(output)),
+		NULL);
+
+	received = j_message_new(J_MESSAGE_NONE, 0);
+	g_assert_true(j_message_read(received, input));
+
+	return received;
+}
+
+static void
+test_fabric_get_peer_disabled(void)
+{
+	g_autoptr(JMessage) message = NULL;
+	g_autoptr(JMessage) received = NULL;
+	gchar const address[] = "peer";
+	guint32 address_length = sizeof(address);
+	guint64 marker = 42;
+	guint64 peer = 0;
+
+	if (j_fabric_is_enabled())
+	{
+		g_test_skip("The fabric transport is enabled.");
+		return;
+	}
+
+	// Servers without a usable fabric still have to parse the rest of the message
+	message = j_message_new(J_MESSAGE_NONE, sizeof(guint32) + sizeof(address) + sizeof(guint64));
+	j_message_append_4(message, &address_length);
+	j_message_append_n(message, address, sizeof(address));
+	j_message_append_8(message, &marker);
+
+	received = test_fabric_transmit(message);
+
+	g_assert_false(j_fabric_get_peer(received, &peer));
+	g_assert_cmpuint(j_message_get_8(received), ==, 42);
+}
+
+static void
+test_fabric_rma(void)
+{
+	guint const n = 4096;
+
+	g_autoptr(JMessage) message = NULL;
+	g_autoptr(JMessage) received = NULL;
+	g_autofree gchar* local = NULL;
+	g_autofree gchar* remote = NULL;
+	JFabricRegion* region;
+	gboolean initialized = FALSE;
+	guint64 address;
+	guint64 key;
+	guint64 peer = 0;
+
+	if (!j_fabric_is_enabled())
+	{
+		g_autoptr(GKeyFile) key_file = NULL;
+		JConfiguration* configuration;
+		GLogLevelFlags fatal;
+		gchar const* servers[] = { "localhost", NULL };
+
+		key_file = g_key_file_new();
+		g_key_file_set_string(key_file, "core", "fabric-provider", "sockets");
+		g_key_file_set_string_list(key_file, "servers", "object", servers, 1);
+		g_key_file_set_string_list(key_file, "servers", "kv", servers, 1);
+		g_key_file_set_string_list(key_file, "servers", "db", servers, 1);
+		g_key_file_set_string(key_file, "object", "backend", "null");
+		g_key_file_set_string(key_file, "object", "component", "server");
+		g_key_file_set_string(key_file, "object", "path", "");
+		g_key_file_set_string(key_file, "kv", "backend", "null");
+		g_key_file_set_string(key_file, "kv", "component", "server");
+		g_key_file_set_string(key_file, "kv", "path", "");
+		g_key_file_set_string(key_file, "db", "backend", "null");
+		g_key_file_set_string(key_file, "db", "component", "server");
+		g_key_file_set_string(key_file, "db", "path", "");
+
+		configuration = j_configuration_new_for_data(key_file);
+		g_assert_nonnull(configuration);
+
+		// The provider might not be available, which is reported as a warning
+		fatal = g_log_set_always_fatal(G_LOG_FATAL_MASK);
+		initialized = j_fabric_init(configuration);
+		g_log_set_always_fatal(fatal);
+
+		j_configuration_unref(configuration);
+
+		if (!initialized)
+		{
+			g_test_skip("The libfabric sockets provider is not available.");
+			return;
+		}
+	}
+
+	local = g_malloc(n);
+	remote = g_malloc0(n);
+
+	memset(local, 'a', n);
+
+	// Use the local endpoint as the peer, the server side uses the same functions
+	message = j_message_new(J_MESSAGE_NONE, j_fabric_get_address_length() + 2 * sizeof(guint64));
+	j_fabric_append_address(message);
+
+	region = j_fabric_region_new(remote, n, J_FABRIC_ACCESS_WRITE);
+	g_assert_nonnull(region);
+	j_fabric_region_append(region, message);
+
+	received = test_fabric_transmit(message);
+
+	g_assert_true(j_fabric_get_peer(received, &peer));
+	address = j_message_get_8(received);
+	key = j_message_get_8(received);
+
+	g_assert_true(j_fabric_write(peer, local, n, address, key));
+	g_assert_cmpmem(local, n, remote, n);
+
+	j_fabric_region_free(region);
+
+	memset(local, 0, n);
+	memset(remote, 'b', n);
+
+	// Regions used for writes only allow peers to read them
+	region = j_fabric_region_new(remote, n, J_FABRIC_ACCESS_READ);
+	g_assert_nonnull(region);
+
+	j_message_unref(g_steal_pointer(&message));
+	j_message_unref(g_steal_pointer(&received));
+
+	message = j_message_new(J_MESSAGE_NONE, 2 * sizeof(guint64));
+	j_fabric_region_append(region, message);
+
+	received = test_fabric_transmit(message);
+	address = j_message_get_8(received);
+	key = j_message_get_8(received);
+
+	g_assert_true(j_fabric_read(peer, local, n, address, key));
+	g_assert_cmpmem(local, n, remote, n);
+
+	j_fabric_region_free(region);
+
+	if (initialized)
+	{
+		j_fabric_fini();
+	}
+}
+
+void
+test_core_fabric(void)
+{
+	g_test_add_func("/core/fabric/get_peer_disabled", test_fabric_get_peer_disabled);
+	g_test_add_func("/core/fabric/rma", test_fabric_rma);
+}
@@ -23,6 +23,8 @@
 
 #include <string.h>
 
+#include <sys/socket.h>
+
 #include <julea.h>
 
 #include <jmessage.h>
@@ -190,6 +192,152 @@ test_message_semantics(void)
 	g_assert_cmpint(j_semantics_get(semantics, J_SEMANTICS_SECURITY), ==, j_semantics_get(msg_semantics, J_SEMANTICS_SECURITY));
 }
 
+static JMessage*
+test_message_lookup(guint32 id, gpointer data)
+{
+	GHashTable* replies = data;
+
+	return g_hash_table_lookup(replies, GUINT_TO_POINTER(id));
+}
+
+static void
+test_message_multiplexed(void)
+{
+	g_autoptr(JMessage) message_1 = NULL;
+	g_autoptr(JMessage) message_2 = NULL;
+	g_autoptr(JMessage) reply_send_1 = NULL;
+	g_autoptr(JMessage) reply_send_2 = NULL;
+	g_autoptr(JMessage) reply_recv_1 = NULL;
+	g_autoptr(JMessage) reply_recv_2 = NULL;
+	g_autoptr(JSemantics) semantics = NULL;
+	g_autoptr(GHashTable) replies = NULL;
+	g_autoptr(GOutputStream) output = NULL;
+	g_autoptr(GInputStream) input = NULL;
+	JMessage* reply;
+	gboolean ret;
+	guint32 dummy_1 = 23;
+	guint32 dummy_2 = 42;
+
+	output = g_memory_output_stream_new(NULL, 0, g_realloc, g_free);
+	input = g_memory_input_stream_new();
+	replies = g_hash_table_new(NULL, NULL);
+
+	message_1 = j_message_new(J_MESSAGE_KV_GET, 0);
+	message_2 = j_message_new(J_MESSAGE_KV_GET, 0);
+	g_assert_cmpuint(j_message_get_id(message_1), !=, j_message_get_id(message_2));
+
+	semantics = j_semantics_new(J_SEMANTICS_TEMPLATE_DEFAULT);
+
+	g_assert_false(j_message_get_multiplexed(message_1));
+	j_message_set_multiplexed(message_1);
+	g_assert_true(j_message_get_multiplexed(message_1));
+	j_message_set_semantics(message_1, semantics);
+	g_assert_true(j_message_get_multiplexed(message_1));
+
+	reply_send_1 = j_message_new_reply(message_1);
+	reply_send_2 = j_message_new_reply(message_2);
+	g_assert_cmpuint(j_message_get_id(reply_send_1), ==, j_message_get_id(message_1));
+
+	j_message_append_4(reply_send_1, &dummy_1);
+	j_message_append_4(reply_send_2, &dummy_2);
+
+	/* Send the replies out of order */
+	ret = j_message_write(reply_send_2, output);
+	g_assert_true(ret);
+	ret = j_message_write(reply_send_1, output);
+	g_assert_true(ret);
+
+	g_memory_input_stream_add_data(
+		G_MEMORY_INPUT_STREAM(input),
+		g_memory_output_stream_get_data(G_MEMORY_OUTPUT_STREAM(output)),
+		g_memory_output_stream_get_data_size(G_MEMORY_OUTPUT_STREAM(output)),
+		NULL);
+
+	reply_recv_1 = j_message_new_reply(message_1);
+	reply_recv_2 = j_message_new_reply(message_2);
+
+	g_hash_table_insert(replies, GUINT_TO_POINTER(j_message_get_id(message_1)), reply_recv_1);
+	g_hash_table_insert(replies, GUINT_TO_POINTER(j_message_get_id(message_2)), reply_recv_2);
+
+	ret = j_message_read_multiplexed(input, test_message_lookup, replies, &reply);
+	g_assert_true(ret);
+	g_assert_true(reply == reply_recv_2);
+	g_assert_cmpuint(j_message_get_4(reply), ==, 42);
+
+	ret = j_message_read_multiplexed(input, test_message_lookup, replies, &reply);
+	g_assert_true(ret);
+	g_assert_true(reply == reply_recv_1);
+	g_assert_cmpuint(j_message_get_4(reply), ==, 23);
+}
+
+static void
+test_message_receive_nonblocking(void)
+{
+	g_autoptr(JMessage) message_send = NULL;
+	g_autoptr(JMessage) message_recv = NULL;
+	g_autoptr(GOutputStream) output = NULL;
+	g_autoptr(GSocket) socket_send = NULL;
+	g_autoptr(GSocket) socket_recv = NULL;
+	g_autoptr(GSocketConnection) connection_recv = NULL;
+	gchar const* data;
+	gsize data_size;
+	gboolean complete;
+	gboolean ret;
+	gint fds[2];
+	guint32 dummy = 42;
+
+	ret = (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+	g_assert_true(ret);
+
+	socket_send = g_socket_new_from_fd(fds[0], NULL);
+	g_assert_nonnull(socket_send);
+	socket_recv = g_socket_new_from_fd(fds[1], NULL);
+	g_assert_nonnull(socket_recv);
+	connection_recv = g_socket_connection_factory_create_connection(socket_recv);
+
+	output = g_memory_output_stream_new(NULL, 0, g_realloc, g_free);
+
+	message_send = j_message_new(J_MESSAGE_NONE, 4);
+	j_message_add_operation(message_send, 4);
+	j_message_append_4(message_send, &dummy);
+
+	ret = j_message_write(message_send, output);
+	g_assert_true(ret);
+
+	data = g_memory_output_stream_get_data(G_MEMORY_OUTPUT_STREAM(output));
+	data_size = g_memory_output_stream_get_data_size(G_MEMORY_OUTPUT_STREAM(output));
+	g_assert_cmpuint(data_size, >, 10);
+
+	message_recv = j_message_new(J_MESSAGE_NONE, 0);
+
+	// Nothing has been sent yet
+	ret = j_message_receive_nonblocking(message_recv, connection_recv, &complete);
+	g_assert_true(ret);
+	g_assert_false(complete);
+
+	// Only part of the header has been sent
+	g_assert_cmpint(g_socket_send(socket_send, data, 10, NULL, NULL), ==, 10);
+
+	ret = j_message_receive_nonblocking(message_recv, connection_recv, &complete);
+	g_assert_true(ret);
+	g_assert_false(complete);
+
+	g_assert_cmpint(g_socket_send(socket_send, data + 10, data_size - 10, NULL, NULL), ==, data_size - 10);
+
+	ret = j_message_receive_nonblocking(message_recv, connection_recv, &complete);
+	g_assert_true(ret);
+	g_assert_true(complete);
+	g_assert_cmpuint(j_message_get_count(message_recv), ==, 1);
+	g_assert_cmpuint(j_message_get_4(message_recv), ==, 42);
+
+	// Closed connections are reported as errors
+	g_socket_close(socket_send, NULL);
+
+	ret = j_message_receive_nonblocking(message_recv, connection_recv, &complete);
+	g_assert_false(ret);
+	g_assert_false(complete);
+}
+
 void
 test_core_message(void)
 {
@@ -199,4 +347,6 @@ test_core_message(void)
 	g_test_add_func("/core/message/append", test_message_append);
 	g_test_add_func("/core/message/write_read", test_message_write_read);
 	g_test_add_func("/core/message/semantics", test_message_semantics);
+	g_test_add_func("/core/message/multiplexed", test_message_multiplexed);
+	g_test_add_func("/core/message/receive_nonblocking", test_message_receive_nonblocking);
 }
@@ -0,0 +1,143 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2020 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <julea.h>
+
+#include "test.h"
+
+#define TEST_PLACEMENT_KEYS 10000
+
+static JPlacement*
+test_placement_new(JPlacementType type, guint32 server_count)
+{
+	JPlacement* placement;
+
+	placement = j_placement_new(type, 128);
+
+	for (guint32 i = 0; i < server_count; i++)
+	{
+		g_autofree gchar* name = NULL;
+
+		name = g_strdup_printf("server%u:4711", i);
+		j_placement_add_server(placement, name, 1);
+	}
+
+	return placement;
+}
+
+static void
+test_placement_add_server(JPlacementType type)
+{
+	g_autoptr(JPlacement) placement = NULL;
+	g_autoptr(JPlacement) placement_grown = NULL;
+	guint moved = 0;
+
+	placement = test_placement_new(type, 4);
+	placement_grown = test_placement_new(type, 5);
+
+	for (guint i = 0; i < TEST_PLACEMENT_KEYS; i++)
+	{
+		g_autofree gchar* key = NULL;
+		guint32 index;
+		guint32 index_grown;
+
+		key = g_strdup_printf("/collection/item-%u", i);
+
+		index = j_placement_get_index(placement, key);
+		index_grown = j_placement_get_index(placement_grown, key);
+
+		g_assert_cmpuint(index, <, 4);
+		g_assert_cmpuint(index_grown, <, 5);
+
+		if (index != index_grown)
+		{
+			// Keys must only move to the new server
+			g_assert_cmpuint(index_grown, ==, 4);
+			moved++;
+		}
+	}
+
+	// Ideally, a fifth of the keys moves
+	g_assert_cmpuint(moved, >, TEST_PLACEMENT_KEYS / 10);
+	g_assert_cmpuint(moved, <, TEST_PLACEMENT_KEYS * 3 / 10);
+}
+
+static void
+test_placement_modulo(void)
+{
+	g_autoptr(JPlacement) placement = NULL;
+
+	placement = test_placement_new(J_PLACEMENT_MODULO, 3);
+
+	for (guint i = 0; i < 100; i++)
+	{
+		g_autofree gchar* key = NULL;
+
+		key = g_strdup_printf("key-%u", i);
+
+		g_assert_cmpuint(j_placement_get_index(placement, key), ==, j_helper_hash(key) % 3);
+	}
+}
+
+static void
+test_placement_ring(void)
+{
+	test_placement_add_server(J_PLACEMENT_RING);
+}
+
+static void
+test_placement_jump(void)
+{
+	test_placement_add_server(J_PLACEMENT_JUMP);
+}
+
+static void
+test_placement_ring_weights(void)
+{
+	g_autoptr(JPlacement) placement = NULL;
+	guint counts[2] = { 0, 0 };
+
+	placement = j_placement_new(J_PLACEMENT_RING, 128);
+	j_placement_add_server(placement, "server0:4711", 1);
+	j_placement_add_server(placement, "server1:4711", 3);
+
+	for (guint i = 0; i < TEST_PLACEMENT_KEYS; i++)
+	{
+		g_autofree gchar* key = NULL;
+
+		key = g_strdup_printf("/collection/item-%u", i);
+		counts[j_placement_get_index(placement, key)]++;
+	}
+
+	// The second server should receive about three times as many keys
+	g_assert_cmpuint(counts[1], >, 2 * counts[0]);
+	g_assert_cmpuint(counts[1], <, 4 * counts[0]);
+}
+
+void
+test_core_placement(void)
+{
+	g_test_add_func("/core/placement/modulo", test_placement_modulo);
+	g_test_add_func("/core/placement/ring", test_placement_ring);
+	g_test_add_func("/core/placement/ring_weights", test_placement_ring_weights);
+	g_test_add_func("/core/placement/jump", test_placement_jump);
+}
@@ -233,6 +233,518 @@ test_db_entry_insert_update_delete(void)
 	g_assert_true(ret);
 }
 
+static void
+test_db_entry_shard_key(void)
+{
+	guint const n = 100;
+
+	gchar const* file = "demo.bp";
+
+	g_autoptr(GError) error = NULL;
+	g_autoptr(JBatch) batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	g_autoptr(JDBEntry) delete_entry = NULL;
+	g_autoptr(JDBIterator) iterator = NULL;
+	g_autoptr(JDBSchema) schema = NULL;
+	g_autoptr(JDBSelector) selector = NULL;
+	gboolean ret;
+	guint entries = 0;
+
+	schema = j_db_schema_new("test-ns", "test-shard", &error);
+	g_assert_nonnull(schema);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_field(schema, "string-0", J_DB_TYPE_STRING, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_field(schema, "uint-0", J_DB_TYPE_UINT64, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_set_shard_key(schema, "uint-0", &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_create(schema, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	for (guint i = 0; i < n; i++)
+	{
+		g_autoptr(JDBEntry) entry = NULL;
+		guint64 value = i;
+
+		entry = j_db_entry_new(schema, &error);
+		g_assert_nonnull(entry);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_set_field(entry, "string-0", file, strlen(file), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_set_field(entry, "uint-0", &value, sizeof(value), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		// FIXME Do not pass error, will not exist anymore when batch is executed
+		ret = j_db_entry_insert(entry, batch, NULL);
+		g_assert_true(ret);
+	}
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	selector = j_db_selector_new(schema, J_DB_SELECTOR_MODE_AND, &error);
+	g_assert_nonnull(selector);
+	g_assert_no_error(error);
+
+	ret = j_db_selector_add_field(selector, "string-0", J_DB_SELECTOR_OPERATOR_EQ, file, strlen(file), &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	// Queries are sent to all shards and their results are merged
+	iterator = j_db_iterator_new(schema, selector, &error);
+	g_assert_nonnull(iterator);
+	g_assert_no_error(error);
+
+	while (j_db_iterator_next(iterator, NULL))
+	{
+		entries++;
+	}
+
+	g_assert_cmpuint(entries, ==, n);
+
+	delete_entry = j_db_entry_new(schema, &error);
+	g_assert_nonnull(delete_entry);
+	g_assert_no_error(error);
+
+	ret = j_db_entry_delete(delete_entry, selector, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_delete(schema, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+}
+
+static void
+test_db_entry_shard_key_id(void)
+{
+	guint const n = 10;
+
+	gchar const* file = "demo.bp";
+
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GHashTable) ids = NULL;
+	g_autoptr(JBatch) batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	g_autoptr(JDBEntry) delete_entry = NULL;
+	g_autoptr(JDBIterator) iterator = NULL;
+	g_autoptr(JDBSchema) schema = NULL;
+	g_autoptr(JDBSchema) schema_get = NULL;
+	g_autoptr(JDBSelector) selector = NULL;
+	g_autoptr(JDBSelector) selector_id = NULL;
+	JDBEntry* entries[10];
+	gboolean ret;
+	guint32 deleted_id = 0;
+	guint found = 0;
+
+	ids = g_hash_table_new(NULL, NULL);
+
+	schema = j_db_schema_new("test-ns", "test-shard-id", &error);
+	g_assert_nonnull(schema);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_field(schema, "string-0", J_DB_TYPE_STRING, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_field(schema, "uint-0", J_DB_TYPE_UINT64, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_set_shard_key(schema, "uint-0", &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_create(schema, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	for (guint i = 0; i < n; i++)
+	{
+		guint64 value = i;
+
+		entries[i] = j_db_entry_new(schema, &error);
+		g_assert_nonnull(entries[i]);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_set_field(entries[i], "string-0", file, strlen(file), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_set_field(entries[i], "uint-0", &value, sizeof(value), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_insert(entries[i], batch, NULL);
+		g_assert_true(ret);
+	}
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	// IDs are unique across all shards
+	for (guint i = 0; i < n; i++)
+	{
+		g_autofree guint32* id = NULL;
+		guint64 length;
+
+		ret = j_db_entry_get_id(entries[i], (gpointer*)&id, &length, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+		g_assert_cmpuint(length, ==, sizeof(guint32));
+
+		g_assert_false(g_hash_table_contains(ids, GUINT_TO_POINTER(*id)));
+		g_hash_table_add(ids, GUINT_TO_POINTER(*id));
+
+		if (i == 0)
+		{
+			deleted_id = *id;
+		}
+
+		j_db_entry_unref(entries[i]);
+	}
+
+	// The fetched schema contains the _id field
+	schema_get = j_db_schema_new("test-ns", "test-shard-id", &error);
+	g_assert_nonnull(schema_get);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_set_shard_key(schema_get, "uint-0", &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_get(schema_get, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	// Deleting by ID only affects the entry with this ID, not the entries with the same server-local ID on other shards
+	selector_id = j_db_selector_new(schema_get, J_DB_SELECTOR_MODE_AND, &error);
+	g_assert_nonnull(selector_id);
+	g_assert_no_error(error);
+
+	ret = j_db_selector_add_field(selector_id, "_id", J_DB_SELECTOR_OPERATOR_EQ, &deleted_id, sizeof(deleted_id), &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	delete_entry = j_db_entry_new(schema_get, &error);
+	g_assert_nonnull(delete_entry);
+	g_assert_no_error(error);
+
+	ret = j_db_entry_delete(delete_entry, selector_id, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	selector = j_db_selector_new(schema_get, J_DB_SELECTOR_MODE_AND, &error);
+	g_assert_nonnull(selector);
+	g_assert_no_error(error);
+
+	ret = j_db_selector_add_field(selector, "string-0", J_DB_SELECTOR_OPERATOR_EQ, file, strlen(file), &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	iterator = j_db_iterator_new(schema_get, selector, &error);
+	g_assert_nonnull(iterator);
+	g_assert_no_error(error);
+
+	while (j_db_iterator_next(iterator, NULL))
+	{
+		g_autofree guint32* id = NULL;
+		JDBType type;
+		guint64 length;
+
+		ret = j_db_iterator_get_field(iterator, "_id", &type, (gpointer*)&id, &length, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		// Query results use the same IDs as inserts
+		g_assert_true(g_hash_table_contains(ids, GUINT_TO_POINTER(*id)));
+		g_assert_cmpuint(*id, !=, deleted_id);
+
+		found++;
+	}
+
+	g_assert_cmpuint(found, ==, n - 1);
+
+	ret = j_db_entry_delete(delete_entry, selector, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_delete(schema_get, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+}
+
+static void
+test_db_entry_update_cached(void)
+{
+	guint const n = 4;
+
+	g_autoptr(GError) error = NULL;
+	g_autoptr(JBatch) batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	g_autoptr(JBatch) cached_batch = NULL;
+	g_autoptr(JDBSchema) schema = NULL;
+	g_autoptr(JDBIterator) iterator = NULL;
+	g_autoptr(JSemantics) semantics = NULL;
+	gboolean ret;
+	guint entries = 0;
+
+	semantics = j_semantics_new(J_SEMANTICS_TEMPLATE_DEFAULT);
+	j_semantics_set(semantics, J_SEMANTICS_PERSISTENCY, J_SEMANTICS_PERSISTENCY_EVENTUAL);
+	cached_batch = j_batch_new(semantics);
+
+	schema = j_db_schema_new("test-ns", "test-update-cached", &error);
+	g_assert_nonnull(schema);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_field(schema, "uint-0", J_DB_TYPE_UINT64, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_field(schema, "uint-1", J_DB_TYPE_UINT64, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_create(schema, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	for (guint64 i = 0; i < n; i++)
+	{
+		g_autoptr(JDBEntry) entry = NULL;
+
+		entry = j_db_entry_new(schema, &error);
+		g_assert_nonnull(entry);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_set_field(entry, "uint-0", &i, sizeof(i), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_set_field(entry, "uint-1", &i, sizeof(i), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		// FIXME Do not pass error, will not exist anymore when batch is executed
+		ret = j_db_entry_insert(entry, batch, NULL);
+		g_assert_true(ret);
+	}
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	for (guint64 i = 0; i < n; i++)
+	{
+		g_autoptr(JDBEntry) entry = NULL;
+		g_autoptr(JDBSelector) selector = NULL;
+		guint64 value = i + n;
+
+		entry = j_db_entry_new(schema, &error);
+		g_assert_nonnull(entry);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_set_field(entry, "uint-1", &value, sizeof(value), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		selector = j_db_selector_new(schema, J_DB_SELECTOR_MODE_AND, &error);
+		g_assert_nonnull(selector);
+		g_assert_no_error(error);
+
+		ret = j_db_selector_add_field(selector, "uint-0", J_DB_SELECTOR_OPERATOR_EQ, &i, sizeof(i), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		// The entry and the selector are freed before the cached operation is executed
+		ret = j_db_entry_update(entry, selector, cached_batch, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		ret = j_batch_execute(cached_batch);
+		g_assert_true(ret);
+	}
+
+	// Iterators use batches with the default semantics, which flush the cache
+	iterator = j_db_iterator_new(schema, NULL, &error);
+	g_assert_nonnull(iterator);
+	g_assert_no_error(error);
+
+	while (j_db_iterator_next(iterator, NULL))
+	{
+		g_autofree guint64* uint_0 = NULL;
+		g_autofree guint64* uint_1 = NULL;
+		JDBType type;
+		guint64 len;
+
+		ret = j_db_iterator_get_field(iterator, "uint-0", &type, (gpointer*)&uint_0, &len, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		ret = j_db_iterator_get_field(iterator, "uint-1", &type, (gpointer*)&uint_1, &len, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		g_assert_cmpuint(*uint_1, ==, *uint_0 + n);
+
+		entries++;
+	}
+
+	g_assert_cmpuint(entries, ==, n);
+
+	ret = j_db_schema_delete(schema, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+}
+
+static void
+test_db_iterator_pages(void)
+{
+	// Larger than the default page size
+	guint const n = 2500;
+
+	gchar const* file = "demo.bp";
+
+	g_autoptr(GError) error = NULL;
+	g_autoptr(JBatch) batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	g_autoptr(JDBEntry) delete_entry = NULL;
+	g_autoptr(JDBSchema) schema = NULL;
+	g_autoptr(JDBSelector) selector = NULL;
+	gboolean ret;
+
+	schema = j_db_schema_new("test-ns", "test-pages", &error);
+	g_assert_nonnull(schema);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_field(schema, "string-0", J_DB_TYPE_STRING, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_field(schema, "uint-0", J_DB_TYPE_UINT64, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_create(schema, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	for (guint i = 0; i < n; i++)
+	{
+		g_autoptr(JDBEntry) entry = NULL;
+		guint64 value = i;
+
+		entry = j_db_entry_new(schema, &error);
+		g_assert_nonnull(entry);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_set_field(entry, "string-0", file, strlen(file), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_set_field(entry, "uint-0", &value, sizeof(value), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		// FIXME Do not pass error, will not exist anymore when batch is executed
+		ret = j_db_entry_insert(entry, batch, NULL);
+		g_assert_true(ret);
+	}
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	selector = j_db_selector_new(schema, J_DB_SELECTOR_MODE_AND, &error);
+	g_assert_nonnull(selector);
+	g_assert_no_error(error);
+
+	ret = j_db_selector_add_field(selector, "string-0", J_DB_SELECTOR_OPERATOR_EQ, file, strlen(file), &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	{
+		g_autoptr(JDBIterator) iterator = NULL;
+		guint entries = 0;
+
+		iterator = j_db_iterator_new(schema, selector, &error);
+		g_assert_nonnull(iterator);
+		g_assert_no_error(error);
+
+		while (j_db_iterator_next(iterator, NULL))
+		{
+			entries++;
+		}
+
+		g_assert_cmpuint(entries, ==, n);
+	}
+
+	{
+		g_autoptr(JDBIterator) iterator = NULL;
+
+		iterator = j_db_iterator_new(schema, selector, &error);
+		g_assert_nonnull(iterator);
+		g_assert_no_error(error);
+
+		// Freeing an iterator before all results have been fetched closes its cursors
+		ret = j_db_iterator_next(iterator, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+	}
+
+	delete_entry = j_db_entry_new(schema, &error);
+	g_assert_nonnull(delete_entry);
+	g_assert_no_error(error);
+
+	ret = j_db_entry_delete(delete_entry, selector, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_delete(schema, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+}
+
 static void
 schema_create(void)
 {
@@ -540,5 +1052,9 @@ test_db_db(void)
 	g_test_add_func("/db/schema/create_delete", test_db_schema_create_delete);
 	g_test_add_func("/db/entry/new_free", test_db_entry_new_free);
 	g_test_add_func("/db/entry/insert_update_delete", test_db_entry_insert_update_delete);
+	g_test_add_func("/db/entry/shard_key", test_db_entry_shard_key);
+	g_test_add_func("/db/entry/shard_key_id", test_db_entry_shard_key_id);
+	g_test_add_func("/db/entry/update_cached", test_db_entry_update_cached);
+	g_test_add_func("/db/iterator/pages", test_db_iterator_pages);
 	g_test_add_func("/db/all", test_db_all);
 }
@@ -180,9 +180,98 @@ test_kv_iterator_next_get(void)
 	g_assert_true(ret);
 }
 
+static void
+test_kv_iterator_pages(void)
+{
+	// More than the default page size to make sure entries are fetched using multiple requests
+	guint const n = 2500;
+
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JBatch) delete_batch = NULL;
+	gboolean ret;
+
+	guint kvs = 0;
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	delete_batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+
+	for (guint i = 0; i < n; i++)
+	{
+		g_autoptr(JKV) kv = NULL;
+
+		g_autofree gchar* key = NULL;
+		gchar* value = NULL;
+
+		key = g_strdup_printf("test-key-pages-%d", i);
+		value = g_strdup_printf("test-value-%d", i);
+		kv = j_kv_new("test-ns", key);
+		j_kv_put(kv, value, strlen(value) + 1, g_free, batch);
+		j_kv_delete(kv, delete_batch);
+	}
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	{
+		g_autoptr(JKVIterator) iterator = NULL;
+
+		iterator = j_kv_iterator_new("test-ns", "test-key-pages-");
+
+		while (j_kv_iterator_next(iterator))
+		{
+			gchar const* key;
+			gconstpointer value;
+			guint32 len;
+
+			key = j_kv_iterator_get(iterator, &value, &len);
+			g_assert_true(g_str_has_prefix(key, "test-key-pages-"));
+			g_assert_true(g_str_has_prefix(value, "test-value-"));
+			g_assert_cmpuint(len, ==, strlen(value) + 1);
+			kvs++;
+		}
+	}
+
+	g_assert_cmpuint(kvs, ==, n);
+
+	kvs = 0;
+
+	{
+		g_autoptr(JKVIterator) iterator = NULL;
+
+		iterator = j_kv_iterator_new_keys("test-ns", "test-key-pages-");
+
+		while (j_kv_iterator_next(iterator))
+		{
+			gchar const* key;
+			gconstpointer value;
+			guint32 len;
+
+			key = j_kv_iterator_get(iterator, &value, &len);
+			g_assert_true(g_str_has_prefix(key, "test-key-pages-"));
+			g_assert_null(value);
+			g_assert_cmpuint(len, ==, 0);
+			kvs++;
+		}
+	}
+
+	g_assert_cmpuint(kvs, ==, n);
+
+	{
+		g_autoptr(JKVIterator) iterator = NULL;
+
+		// Iterators that are freed early have to release their cursors
+		iterator = j_kv_iterator_new("test-ns", "test-key-pages-");
+		g_assert_true(j_kv_iterator_next(iterator));
+	}
+
+	ret = j_batch_execute(delete_batch);
+	g_assert_true(ret);
+}
+
 void
 test_kv_kv_iterator(void)
 {
 	g_test_add_func("/kv/kv-iterator/new_free", test_kv_iterator_new_free);
 	g_test_add_func("/kv/kv-iterator/next_get", test_kv_iterator_next_get);
+	g_test_add_func("/kv/kv-iterator/pages", test_kv_iterator_pages);
 }
@@ -213,6 +213,150 @@ test_kv_get_callback(void)
 	g_assert_cmpuint(num_callbacks, ==, 1);
 }
 
+static void
+test_kv_get_many(void)
+{
+	g_autoptr(JBatch) batch = NULL;
+	gchar const* keys[] = { "test-kv-get-many-1", "test-kv-get-many-2", "test-kv-get-many-missing", "test-kv-get-many-1" };
+	gpointer values[G_N_ELEMENTS(keys)];
+	guint32 value_lens[G_N_ELEMENTS(keys)];
+	gboolean ret;
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+
+	for (guint i = 0; i < 2; i++)
+	{
+		g_autoptr(JKV) kv = NULL;
+
+		kv = j_kv_new("test", keys[i]);
+		j_kv_put(kv, g_strdup(keys[i]), strlen(keys[i]) + 1, g_free, batch);
+	}
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	j_kv_get_many("test", keys, G_N_ELEMENTS(keys), values, value_lens, batch);
+	ret = j_batch_execute(batch);
+	g_assert_false(ret);
+
+	g_assert_cmpstr(values[0], ==, keys[0]);
+	g_assert_cmpuint(value_lens[0], ==, strlen(keys[0]) + 1);
+	g_assert_cmpstr(values[1], ==, keys[1]);
+	g_assert_cmpuint(value_lens[1], ==, strlen(keys[1]) + 1);
+	g_assert_null(values[2]);
+	g_assert_cmpuint(value_lens[2], ==, 0);
+	g_assert_cmpstr(values[3], ==, keys[0]);
+
+	for (guint i = 0; i < G_N_ELEMENTS(keys); i++)
+	{
+		g_free(values[i]);
+	}
+
+	for (guint i = 0; i < 2; i++)
+	{
+		g_autoptr(JKV) kv = NULL;
+
+		kv = j_kv_new("test", keys[i]);
+		j_kv_delete(kv, batch);
+	}
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
+static void
+test_kv_get_many_relaxed(void)
+{
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JSemantics) semantics = NULL;
+	gchar const* keys[] = { "test-kv-get-many-relaxed-1", "test-kv-get-many-relaxed-2", "test-kv-get-many-relaxed-3" };
+	gpointer values[G_N_ELEMENTS(keys)];
+	guint32 value_lens[G_N_ELEMENTS(keys)];
+	gboolean ret;
+
+	semantics = j_semantics_new(J_SEMANTICS_TEMPLATE_DEFAULT);
+	j_semantics_set(semantics, J_SEMANTICS_ORDERING, J_SEMANTICS_ORDERING_RELAXED);
+	batch = j_batch_new(semantics);
+
+	// The gets have to observe the puts before them and must not observe the deletes after them
+	for (guint i = 0; i < G_N_ELEMENTS(keys); i++)
+	{
+		g_autoptr(JKV) kv = NULL;
+
+		kv = j_kv_new("test", keys[i]);
+		j_kv_put(kv, g_strdup(keys[i]), strlen(keys[i]) + 1, g_free, batch);
+	}
+
+	j_kv_get_many("test", keys, G_N_ELEMENTS(keys), values, value_lens, batch);
+
+	for (guint i = 0; i < G_N_ELEMENTS(keys); i++)
+	{
+		g_autoptr(JKV) kv = NULL;
+
+		kv = j_kv_new("test", keys[i]);
+		j_kv_delete(kv, batch);
+	}
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	for (guint i = 0; i < G_N_ELEMENTS(keys); i++)
+	{
+		g_assert_cmpstr(values[i], ==, keys[i]);
+		g_assert_cmpuint(value_lens[i], ==, strlen(keys[i]) + 1);
+		g_free(values[i]);
+	}
+
+	j_kv_get_many("test", keys, G_N_ELEMENTS(keys), values, value_lens, batch);
+	ret = j_batch_execute(batch);
+	g_assert_false(ret);
+
+	for (guint i = 0; i < G_N_ELEMENTS(keys); i++)
+	{
+		g_assert_null(values[i]);
+	}
+}
+
+static void
+test_kv_put_cached(void)
+{
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JBatch) cached_batch = NULL;
+	g_autoptr(JKV) kv = NULL;
+	g_autoptr(JSemantics) semantics = NULL;
+	g_autofree gchar* get_value = NULL;
+	gchar value[] = "kv-value";
+	guint32 get_len = 0;
+	gboolean ret;
+
+	semantics = j_semantics_new(J_SEMANTICS_TEMPLATE_DEFAULT);
+	j_semantics_set(semantics, J_SEMANTICS_PERSISTENCY, J_SEMANTICS_PERSISTENCY_EVENTUAL);
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	cached_batch = j_batch_new(semantics);
+
+	kv = j_kv_new("test", "test-kv-put-cached");
+	g_assert_nonnull(kv);
+
+	j_kv_put(kv, value, sizeof(value), NULL, cached_batch);
+	ret = j_batch_execute(cached_batch);
+	g_assert_true(ret);
+
+	// The value has been copied by the operation cache
+	memset(value, 0, sizeof(value));
+
+	j_kv_get(kv, (gpointer)&get_value, &get_len, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	g_assert_cmpstr(get_value, ==, "kv-value");
+	g_assert_cmpuint(get_len, ==, strlen("kv-value") + 1);
+
+	j_kv_delete(kv, cached_batch);
+	ret = j_batch_execute(cached_batch);
+	g_assert_true(ret);
+}
+
 void
 test_kv_kv(void)
 {
@@ -222,4 +366,7 @@ test_kv_kv(void)
 	g_test_add_func("/kv/kv/put_update", test_kv_put_update);
 	g_test_add_func("/kv/kv/get", test_kv_get);
 	g_test_add_func("/kv/kv/get_callback", test_kv_get_callback);
+	g_test_add_func("/kv/kv/get_many", test_kv_get_many);
+	g_test_add_func("/kv/kv/get_many_relaxed", test_kv_get_many_relaxed);
+	g_test_add_func("/kv/kv/put_cached", test_kv_put_cached);
 }
@@ -234,6 +234,92 @@ test_object_sync(void)
 	g_assert_true(ret);
 }
 
+static void
+test_object_create_with_size(void)
+{
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JDistribution) distribution = NULL;
+	g_autoptr(JDistributedObject) object = NULL;
+	g_autofree gchar* buffer = NULL;
+	guint64 nbytes = 0;
+	guint64 size = 0;
+	gboolean ret;
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	buffer = g_malloc0(42);
+
+	distribution = j_distribution_new(J_DISTRIBUTION_ROUND_ROBIN);
+	object = j_distributed_object_new("test", "test-distributed-object-create-with-size", distribution);
+	g_assert_true(object != NULL);
+
+	j_distributed_object_create_with_size(object, 4 * 1024 * 1024, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	// The size is only a hint and does not change the object's size
+	j_distributed_object_status(object, NULL, &size, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(size, ==, 0);
+
+	j_distributed_object_write(object, buffer, 42, 0, &nbytes, batch);
+	j_distributed_object_status(object, NULL, &size, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, 42);
+	g_assert_cmpuint(size, ==, 42);
+
+	j_distributed_object_delete(object, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
+static void
+test_object_truncate(void)
+{
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JDistribution) distribution = NULL;
+	g_autoptr(JDistributedObject) object = NULL;
+	g_autofree gchar* buffer = NULL;
+	guint64 nbytes = 0;
+	guint64 size = 0;
+	gboolean ret;
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	buffer = g_malloc(100);
+	memset(buffer, 'j', 100);
+
+	distribution = j_distribution_new(J_DISTRIBUTION_ROUND_ROBIN);
+	object = j_distributed_object_new("test", "test-distributed-object-truncate", distribution);
+	g_assert_true(object != NULL);
+
+	j_distributed_object_create(object, batch);
+	j_distributed_object_write(object, buffer, 42, 0, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, 42);
+
+	j_distributed_object_truncate(object, 10, batch);
+	j_distributed_object_status(object, NULL, &size, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(size, ==, 10);
+
+	// Extending an object fills it with zeroes
+	j_distributed_object_truncate(object, 100, batch);
+	j_distributed_object_read(object, buffer, 100, 0, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, 100);
+	g_assert_cmpint(buffer[9], ==, 'j');
+	g_assert_cmpint(buffer[10], ==, 0);
+	g_assert_cmpint(buffer[99], ==, 0);
+
+	j_distributed_object_delete(object, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
 void
 test_object_distributed_object(void)
 {
@@ -242,4 +328,6 @@ test_object_distributed_object(void)
 	g_test_add_func("/object/distributed-object/read_write", test_object_read_write);
 	g_test_add_func("/object/distributed-object/status", test_object_status);
 	g_test_add_func("/object/distributed-object/sync", test_object_sync);
+	g_test_add_func("/object/distributed-object/create_with_size", test_object_create_with_size);
+	g_test_add_func("/object/distributed-object/truncate", test_object_truncate);
 }
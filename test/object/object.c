@@ -223,6 +223,150 @@ test_object_sync(void)
 	g_assert_true(ret);
 }
 
+static void
+test_object_create_with_size(void)
+{
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JObject) object = NULL;
+	g_autofree gchar* buffer = NULL;
+	guint64 nbytes = 0;
+	guint64 size = 0;
+	gboolean ret;
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	buffer = g_malloc0(42);
+
+	object = j_object_new("test", "test-object-create-with-size");
+	g_assert_true(object != NULL);
+
+	j_object_create_with_size(object, 1024 * 1024, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	// The size is only a hint and does not change the object's size
+	j_object_status(object, NULL, &size, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(size, ==, 0);
+
+	j_object_write(object, buffer, 42, 0, &nbytes, batch);
+	j_object_status(object, NULL, &size, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, 42);
+	g_assert_cmpuint(size, ==, 42);
+
+	j_object_delete(object, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
+static void
+test_object_truncate(void)
+{
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JObject) object = NULL;
+	g_autoptr(JObject) missing_object = NULL;
+	g_autofree gchar* buffer = NULL;
+	guint64 nbytes = 0;
+	guint64 size = 0;
+	gboolean ret;
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	buffer = g_malloc(100);
+	memset(buffer, 'j', 100);
+
+	object = j_object_new("test", "test-object-truncate");
+	g_assert_true(object != NULL);
+
+	j_object_create(object, batch);
+	j_object_write(object, buffer, 42, 0, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, 42);
+
+	j_object_truncate(object, 10, batch);
+	j_object_status(object, NULL, &size, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(size, ==, 10);
+
+	// Extending an object fills it with zeroes
+	j_object_truncate(object, 100, batch);
+	j_object_read(object, buffer, 100, 0, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, 100);
+	g_assert_cmpint(buffer[9], ==, 'j');
+	g_assert_cmpint(buffer[10], ==, 0);
+	g_assert_cmpint(buffer[99], ==, 0);
+
+	j_object_delete(object, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	// Truncating objects that do not exist fails
+	missing_object = j_object_new("test", "test-object-truncate-missing");
+	j_object_truncate(missing_object, 10, batch);
+	ret = j_batch_execute(batch);
+	g_assert_false(ret);
+}
+
+static void
+test_object_write_behind(void)
+{
+	guint const n = 100;
+
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JObject) object = NULL;
+	g_autoptr(JSemantics) semantics = NULL;
+	g_autofree gchar* buffer = NULL;
+	guint64 nbytes = 0;
+	guint64 size = 0;
+	gboolean ret;
+
+	semantics = j_semantics_new(J_SEMANTICS_TEMPLATE_DEFAULT);
+	j_semantics_set(semantics, J_SEMANTICS_PERSISTENCY, J_SEMANTICS_PERSISTENCY_EVENTUAL);
+	batch = j_batch_new(semantics);
+	buffer = g_malloc0(n);
+
+	object = j_object_new("test", "test-object-write-behind");
+	g_assert_true(object != NULL);
+
+	j_object_create(object, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	for (guint i = 0; i < n; i++)
+	{
+		gchar c = 'a' + (i % 26);
+
+		j_object_write(object, &c, 1, i, &nbytes, batch);
+		ret = j_batch_execute(batch);
+		g_assert_true(ret);
+		g_assert_cmpuint(nbytes, ==, 1);
+	}
+
+	j_object_status(object, NULL, &size, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(size, ==, n);
+
+	j_object_read(object, buffer, n, 0, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, n);
+
+	for (guint i = 0; i < n; i++)
+	{
+		g_assert_cmpint(buffer[i], ==, 'a' + (i % 26));
+	}
+
+	j_object_delete(object, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
 void
 test_object_object(void)
 {
@@ -231,4 +375,7 @@ test_object_object(void)
 	g_test_add_func("/object/object/read_write", test_object_read_write);
 	g_test_add_func("/object/object/status", test_object_status);
 	g_test_add_func("/object/object/sync", test_object_sync);
+	g_test_add_func("/object/object/create_with_size", test_object_create_with_size);
+	g_test_add_func("/object/object/truncate", test_object_truncate);
+	g_test_add_func("/object/object/write_behind", test_object_write_behind);
 }
@@ -19,13 +19,275 @@
 #include <julea-config.h>
 
 #include <glib.h>
+#include <glib/gstdio.h>
 
 #include <locale.h>
+#include <string.h>
 
 #include <julea.h>
 
 #include "test.h"
 
+/**
+ * Loads and initializes a server backend.
+ * Backends that have not been built are skipped, since loading them would cause a warning.
+ *
+ * \param name    The backend's name.
+ * \param type    The backend's type.
+ * \param path    The path passed to the backend.
+ * \param module  Returns the backend's module.
+ * \param backend Returns the backend.
+ *
+ * \return TRUE if the backend could be loaded, FALSE otherwise.
+ **/
+gboolean
+test_backend_load(gchar const* name, JBackendType type, gchar const* path, GModule** module, JBackend** backend)
+{
+	g_autofree gchar* module_name = NULL;
+	g_autofree gchar* module_path = NULL;
+	gchar const* backend_path;
+	gchar const* type_str = NULL;
+	gboolean ret = FALSE;
+
+	switch (type)
+	{
+		case J_BACKEND_TYPE_OBJECT:
+			type_str = "object";
+			break;
+		case J_BACKEND_TYPE_KV:
+			type_str = "kv";
+			break;
+		case J_BACKEND_TYPE_DB:
+			type_str = "db";
+			break;
+		default:
+			g_assert_not_reached();
+	}
+
+	backend_path = JULEA_BACKEND_PATH;
+
+#ifdef JULEA_DEBUG
+	// Mirrors j_backend_load(), which only respects the environment in debug builds
+	if (g_getenv("JULEA_BACKEND_PATH") != NULL)
+	{
+		backend_path = g_getenv("JULEA_BACKEND_PATH");
+	}
+#endif
+
+	module_name = g_strdup_printf("%s-%s", type_str, name);
+	module_path = g_module_build_path(backend_path, module_name);
+
+	if (!g_file_test(module_path, G_FILE_TEST_EXISTS))
+	{
+		g_test_skip("Backend has not been built");
+		return FALSE;
+	}
+
+	g_assert_true(j_backend_load_server(name, "server", type, module, backend));
+	g_assert_nonnull(*module);
+	g_assert_nonnull(*backend);
+
+	switch (type)
+	{
+		case J_BACKEND_TYPE_OBJECT:
+			ret = j_backend_object_init(*backend, path);
+			break;
+		case J_BACKEND_TYPE_KV:
+			ret = j_backend_kv_init(*backend, path);
+			break;
+		case J_BACKEND_TYPE_DB:
+			ret = j_backend_db_init(*backend, path);
+			break;
+		default:
+			g_assert_not_reached();
+	}
+
+	g_assert_true(ret);
+
+	return ret;
+}
+
+/**
+ * Finalizes and unloads a backend loaded with test_backend_load().
+ *
+ * \param module  The backend's module.
+ * \param backend The backend.
+ **/
+void
+test_backend_unload(GModule* module, JBackend* backend)
+{
+	switch (backend->type)
+	{
+		case J_BACKEND_TYPE_OBJECT:
+			j_backend_object_fini(backend);
+			break;
+		case J_BACKEND_TYPE_KV:
+			j_backend_kv_fini(backend);
+			break;
+		case J_BACKEND_TYPE_DB:
+			j_backend_db_fini(backend);
+			break;
+		default:
+			g_assert_not_reached();
+	}
+
+	g_module_close(module);
+}
+
+/**
+ * Creates a temporary directory, for instance, to store a backend's data.
+ *
+ * \param name A name that is included in the directory's name.
+ *
+ * \return The directory's path. Should be removed with test_tmp_dir_remove().
+ **/
+gchar*
+test_tmp_dir_new(gchar const* name)
+{
+	g_autofree gchar* tmpl = NULL;
+	gchar* dir;
+
+	tmpl = g_strdup_printf("julea-test-%s-XXXXXX", name);
+	dir = g_dir_make_tmp(tmpl, NULL);
+	g_assert_nonnull(dir);
+
+	return dir;
+}
+
+/**
+ * Removes a directory created with test_tmp_dir_new() including its contents and frees its path.
+ *
+ * \param dir The directory's path.
+ **/
+void
+test_tmp_dir_remove(gchar* dir)
+{
+	GDir* tmp_dir;
+
+	if ((tmp_dir = g_dir_open(dir, 0, NULL)) != NULL)
+	{
+		gchar const* name;
+
+		while ((name = g_dir_read_name(tmp_dir)) != NULL)
+		{
+			gchar* path;
+
+			path = g_build_filename(dir, name, NULL);
+
+			if (g_file_test(path, G_FILE_TEST_IS_DIR) && !g_file_test(path, G_FILE_TEST_IS_SYMLINK))
+			{
+				// Frees path
+				test_tmp_dir_remove(path);
+			}
+			else
+			{
+				g_unlink(path);
+				g_free(path);
+			}
+		}
+
+		g_dir_close(tmp_dir);
+	}
+
+	g_rmdir(dir);
+	g_free(dir);
+}
+
+/**
+ * Stores keys in a key-value backend, using each key as its own value.
+ *
+ * \param backend   A key-value backend.
+ * \param namespace A namespace.
+ * \param keys      A NULL-terminated array of keys.
+ **/
+void
+test_backend_kv_put_keys(JBackend* backend, gchar const* namespace, gchar const* const* keys)
+{
+	g_autoptr(JSemantics) semantics = NULL;
+	gpointer batch = NULL;
+
+	semantics = j_semantics_new(J_SEMANTICS_TEMPLATE_DEFAULT);
+
+	g_assert_true(j_backend_kv_batch_start(backend, namespace, semantics, &batch));
+
+	for (guint i = 0; keys[i] != NULL; i++)
+	{
+		g_assert_true(j_backend_kv_put(backend, batch, keys[i], keys[i], strlen(keys[i]) + 1));
+	}
+
+	g_assert_true(j_backend_kv_batch_execute(backend, batch));
+}
+
+/**
+ * Checks whether a key stored with test_backend_kv_put_keys() exists.
+ *
+ * \param backend   A key-value backend.
+ * \param namespace A namespace.
+ * \param key       A key.
+ *
+ * \return TRUE if the key exists, FALSE otherwise.
+ **/
+gboolean
+test_backend_kv_exists(JBackend* backend, gchar const* namespace, gchar const* key)
+{
+	g_autoptr(JSemantics) semantics = NULL;
+	g_autofree gpointer value = NULL;
+	gpointer batch = NULL;
+	guint32 len = 0;
+	gboolean ret;
+
+	semantics = j_semantics_new(J_SEMANTICS_TEMPLATE_DEFAULT);
+
+	g_assert_true(j_backend_kv_batch_start(backend, namespace, semantics, &batch));
+
+	if ((ret = j_backend_kv_get(backend, batch, key, &value, &len)))
+	{
+		g_assert_cmpstr(value, ==, key);
+		g_assert_cmpuint(len, ==, strlen(key) + 1);
+	}
+
+	g_assert_true(j_backend_kv_batch_execute(backend, batch));
+
+	return ret;
+}
+
+/**
+ * Counts the keys stored with test_backend_kv_put_keys() that start with a prefix.
+ *
+ * \param backend   A key-value backend.
+ * \param namespace A namespace.
+ * \param prefix    A prefix, NULL counts all keys.
+ *
+ * \return The number of keys.
+ **/
+guint
+test_backend_kv_count_prefix(JBackend* backend, gchar const* namespace, gchar const* prefix)
+{
+	gpointer iterator = NULL;
+	gchar const* key = NULL;
+	gconstpointer value = NULL;
+	guint32 len = 0;
+	guint count = 0;
+
+	if (prefix == NULL)
+	{
+		g_assert_true(j_backend_kv_get_all(backend, namespace, &iterator));
+	}
+	else
+	{
+		g_assert_true(j_backend_kv_get_by_prefix(backend, namespace, prefix, &iterator));
+	}
+
+	while (j_backend_kv_iterate(backend, iterator, &key, &value, &len))
+	{
+		g_assert_true(prefix == NULL || g_str_has_prefix(key, prefix));
+		g_assert_cmpstr(value, ==, key);
+		count++;
+	}
+
+	return count;
+}
+
 int
 main(int argc, char** argv)
 {
@@ -41,14 +303,23 @@ main(int argc, char** argv)
 	test_core_batch();
 	test_core_cache();
 	test_core_configuration();
+	test_core_connection_pool();
 	test_core_credentials();
 	test_core_distribution();
+	test_core_fabric();
 	test_core_list();
 	test_core_list_iterator();
 	test_core_memory_chunk();
 	test_core_message();
+	test_core_placement();
 	test_core_semantics();
 
+	// Backends
+	test_backend_kv_lmdb();
+	test_backend_kv_rocksdb();
+	test_backend_kv_sqlite();
+	test_backend_object_posix();
+
 	// Object client
 	test_object_distributed_object();
 	test_object_object();
@@ -19,18 +19,41 @@
 #ifndef JULEA_TEST_T
 #define JULEA_TEST_T
 
+#include <glib.h>
+#include <gmodule.h>
+
+#include <julea.h>
+
+gboolean test_backend_load(gchar const*, JBackendType, gchar const*, GModule**, JBackend**);
+void test_backend_unload(GModule*, JBackend*);
+
+gchar* test_tmp_dir_new(gchar const*);
+void test_tmp_dir_remove(gchar*);
+
+void test_backend_kv_put_keys(JBackend*, gchar const*, gchar const* const*);
+gboolean test_backend_kv_exists(JBackend*, gchar const*, gchar const*);
+guint test_backend_kv_count_prefix(JBackend*, gchar const*, gchar const*);
+
 void test_core_background_operation(void);
 void test_core_batch(void);
 void test_core_cache(void);
 void test_core_configuration(void);
+void test_core_connection_pool(void);
 void test_core_credentials(void);
 void test_core_distribution(void);
+void test_core_fabric(void);
 void test_core_list(void);
 void test_core_list_iterator(void);
 void test_core_memory_chunk(void);
 void test_core_message(void);
+void test_core_placement(void);
 void test_core_semantics(void);
 
+void test_backend_kv_lmdb(void);
+void test_backend_kv_rocksdb(void);
+void test_backend_kv_sqlite(void);
+void test_backend_object_posix(void);
+
 void test_object_distributed_object(void);
 void test_object_object(void);
 
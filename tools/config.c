@@ -42,8 +42,22 @@ static gchar const* opt_db_backend = NULL;
 static gchar const* opt_db_component = NULL;
 static gchar const* opt_db_path = NULL;
 static gint64 opt_max_operation_size = 0;
+static gboolean opt_zerocopy = FALSE;
 static gint opt_max_connections = 0;
 static gint64 opt_stripe_size = 0;
+static gboolean opt_multiplex = FALSE;
+static gint64 opt_read_ahead = 0;
+static gint64 opt_write_behind = 0;
+static gint opt_connection_warm_up = 0;
+static gint opt_connection_idle_timeout = 0;
+static gchar const* opt_fabric_provider = NULL;
+static gchar const* opt_placement = NULL;
+static gint opt_placement_virtual_nodes = 0;
+static gint opt_db_page_size = 0;
+static gint opt_kv_page_size = 0;
+static gchar const* opt_object_weights = NULL;
+static gchar const* opt_kv_weights = NULL;
+static gchar const* opt_db_weights = NULL;
 
 static gchar**
 string_split(gchar const* string)
@@ -63,6 +77,30 @@ string_split(gchar const* string)
 	return arr;
 }
 
+static void
+set_weights(GKeyFile* key_file, gchar const* key, gchar const* string)
+{
+	g_auto(GStrv) weights_str = NULL;
+	g_autofree gint* weights = NULL;
+	guint len;
+
+	if (string == NULL)
+	{
+		return;
+	}
+
+	weights_str = string_split(string);
+	len = g_strv_length(weights_str);
+	weights = g_new(gint, len);
+
+	for (guint i = 0; i < len; i++)
+	{
+		weights[i] = g_ascii_strtoll(weights_str[i], NULL, 10);
+	}
+
+	g_key_file_set_integer_list(key_file, "servers", key, weights, len);
+}
+
 static gboolean
 read_config(gchar* path)
 {
@@ -105,11 +143,35 @@ write_config(gchar* path)
 
 	key_file = g_key_file_new();
 	g_key_file_set_int64(key_file, "core", "max-operation-size", opt_stripe_size);
+	g_key_file_set_boolean(key_file, "core", "zerocopy", opt_zerocopy);
+
+	if (opt_fabric_provider != NULL)
+	{
+		g_key_file_set_string(key_file, "core", "fabric-provider", opt_fabric_provider);
+	}
+
 	g_key_file_set_integer(key_file, "clients", "max-connections", opt_max_connections);
 	g_key_file_set_int64(key_file, "clients", "stripe-size", opt_stripe_size);
+	g_key_file_set_boolean(key_file, "clients", "multiplex", opt_multiplex);
+	g_key_file_set_int64(key_file, "clients", "read-ahead", opt_read_ahead);
+	g_key_file_set_int64(key_file, "clients", "write-behind", opt_write_behind);
+	g_key_file_set_integer(key_file, "clients", "connection-warm-up", opt_connection_warm_up);
+	g_key_file_set_integer(key_file, "clients", "connection-idle-timeout", opt_connection_idle_timeout);
+
+	if (opt_placement != NULL)
+	{
+		g_key_file_set_string(key_file, "clients", "placement", opt_placement);
+	}
+
+	g_key_file_set_integer(key_file, "clients", "placement-virtual-nodes", opt_placement_virtual_nodes);
+	g_key_file_set_integer(key_file, "clients", "db-page-size", opt_db_page_size);
+	g_key_file_set_integer(key_file, "clients", "kv-page-size", opt_kv_page_size);
 	g_key_file_set_string_list(key_file, "servers", "object", (gchar const* const*)servers_object, g_strv_length(servers_object));
 	g_key_file_set_string_list(key_file, "servers", "kv", (gchar const* const*)servers_kv, g_strv_length(servers_kv));
 	g_key_file_set_string_list(key_file, "servers", "db", (gchar const* const*)servers_db, g_strv_length(servers_db));
+	set_weights(key_file, "object-weights", opt_object_weights);
+	set_weights(key_file, "kv-weights", opt_kv_weights);
+	set_weights(key_file, "db-weights", opt_db_weights);
 	g_key_file_set_string(key_file, "object", "backend", opt_object_backend);
 	g_key_file_set_string(key_file, "object", "component", opt_object_component);
 	g_key_file_set_string(key_file, "object", "path", opt_object_path);
@@ -165,8 +227,22 @@ main(gint argc, gchar** argv)
 		{ "db-component", 0, 0, G_OPTION_ARG_STRING, &opt_db_component, "Database component to use", "client|server" },
 		{ "db-path", 0, 0, G_OPTION_ARG_STRING, &opt_db_path, "Database path to use", "/path/to/storage" },
 		{ "max-operation-size", 0, 0, G_OPTION_ARG_INT64, &opt_max_operation_size, "Maximum size of an operation", "0" },
+		{ "zerocopy", 0, 0, G_OPTION_ARG_NONE, &opt_zerocopy, "Use zero-copy sends for large messages", NULL },
+		{ "fabric-provider", 0, 0, G_OPTION_ARG_STRING, &opt_fabric_provider, "libfabric provider to use for object data", "sockets|verbs;ofi_rxm|…" },
 		{ "max-connections", 0, 0, G_OPTION_ARG_INT, &opt_max_connections, "Maximum number of connections", "0" },
 		{ "stripe-size", 0, 0, G_OPTION_ARG_INT64, &opt_stripe_size, "Default stripe size", "0" },
+		{ "multiplex", 0, 0, G_OPTION_ARG_NONE, &opt_multiplex, "Multiplex concurrent requests over a single connection", NULL },
+		{ "read-ahead", 0, 0, G_OPTION_ARG_INT64, &opt_read_ahead, "Read-ahead window for sequential object reads", "0" },
+		{ "write-behind", 0, 0, G_OPTION_ARG_INT64, &opt_write_behind, "Buffer size for collecting small object writes", "0" },
+		{ "connection-warm-up", 0, 0, G_OPTION_ARG_INT, &opt_connection_warm_up, "Number of connections opened per server on startup", "0" },
+		{ "connection-idle-timeout", 0, 0, G_OPTION_ARG_INT, &opt_connection_idle_timeout, "Seconds after which idle connections are checked and closed", "0" },
+		{ "placement", 0, 0, G_OPTION_ARG_STRING, &opt_placement, "Placement used to map keys to servers", "modulo|ring|jump" },
+		{ "placement-virtual-nodes", 0, 0, G_OPTION_ARG_INT, &opt_placement_virtual_nodes, "Virtual nodes per server used by the ring placement", "0" },
+		{ "db-page-size", 0, 0, G_OPTION_ARG_INT, &opt_db_page_size, "Number of database query results fetched per request", "0" },
+		{ "kv-page-size", 0, 0, G_OPTION_ARG_INT, &opt_kv_page_size, "Number of key-value pairs fetched per request when iterating", "0" },
+		{ "object-weights", 0, 0, G_OPTION_ARG_STRING, &opt_object_weights, "Object server weights to use", "1,2,1" },
+		{ "kv-weights", 0, 0, G_OPTION_ARG_STRING, &opt_kv_weights, "Key-value server weights to use", "1,2,1" },
+		{ "db-weights", 0, 0, G_OPTION_ARG_STRING, &opt_db_weights, "Database server weights to use", "1,2,1" },
 		{ NULL, 0, 0, 0, NULL, NULL, NULL }
 	};
 
@@ -193,7 +269,12 @@ main(gint argc, gchar** argv)
 	    || (!opt_read && (opt_servers_object == NULL || opt_servers_kv == NULL || opt_servers_db == NULL || opt_object_backend == NULL || opt_object_component == NULL || opt_object_path == NULL || opt_kv_backend == NULL || opt_kv_component == NULL || opt_kv_path == NULL || opt_db_backend == NULL || opt_db_component == NULL || opt_db_path == NULL))
 	    || opt_max_operation_size < 0
 	    || opt_max_connections < 0
-	    || opt_stripe_size < 0)
+	    || opt_stripe_size < 0
+	    || opt_connection_warm_up < 0
+	    || opt_connection_idle_timeout < 0
+	    || opt_placement_virtual_nodes < 0
+	    || opt_db_page_size < 0
+	    || opt_kv_page_size < 0)
 	{
 		g_autofree gchar* help = NULL;
 
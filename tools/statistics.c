@@ -49,6 +49,8 @@ print_statistics(JStatistics* statistics)
 	g_print("  %s written\n", size_written);
 	g_print("  %s received\n", size_received);
 	g_print("  %s sent\n", size_sent);
+	g_print("  %" G_GUINT64_FORMAT " handle cache hits\n", j_statistics_get(statistics, J_STATISTICS_HANDLE_CACHE_HITS));
+	g_print("  %" G_GUINT64_FORMAT " handle cache misses\n", j_statistics_get(statistics, J_STATISTICS_HANDLE_CACHE_MISSES));
 
 	g_free(size_read);
 	g_free(size_written);
@@ -63,6 +65,7 @@ main(int argc, char** argv)
 	g_autoptr(JMessage) message = NULL;
 	JStatistics* statistics_total;
 	gchar get_all;
+	gint ret = 0;
 
 	(void)argc;
 	(void)argv;
@@ -86,6 +89,14 @@ main(int argc, char** argv)
 		guint64 value;
 
 		connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, i);
+
+		if (connection == NULL)
+		{
+			g_printerr("Data server %d cannot be reached\n", i);
+			ret = 1;
+			continue;
+		}
+
 		statistics = j_statistics_new(FALSE);
 
 		j_message_send(message, connection);
@@ -125,6 +136,14 @@ main(int argc, char** argv)
 		j_statistics_add(statistics, J_STATISTICS_BYTES_SENT, value);
 		j_statistics_add(statistics_total, J_STATISTICS_BYTES_SENT, value);
 
+		value = j_message_get_8(reply);
+		j_statistics_add(statistics, J_STATISTICS_HANDLE_CACHE_HITS, value);
+		j_statistics_add(statistics_total, J_STATISTICS_HANDLE_CACHE_HITS, value);
+
+		value = j_message_get_8(reply);
+		j_statistics_add(statistics, J_STATISTICS_HANDLE_CACHE_MISSES, value);
+		j_statistics_add(statistics_total, J_STATISTICS_HANDLE_CACHE_MISSES, value);
+
 		g_print("Data server %d\n", i);
 		print_statistics(statistics);
 
@@ -146,5 +165,5 @@ main(int argc, char** argv)
 
 	j_statistics_free(statistics_total);
 
-	return 0;
+	return ret;
 }